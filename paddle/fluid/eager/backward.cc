@@ -21,9 +21,11 @@
 #include "paddle/fluid/eager/autograd_meta.h"
 #include "paddle/fluid/eager/grad_node_info.h"
 #include "paddle/fluid/eager/grad_tensor_holder.h"
+#include "paddle/fluid/eager/parallel_backward.h"
 #include "paddle/fluid/eager/utils.h"
 #include "paddle/fluid/platform/enforce.h"
 #include "paddle/fluid/platform/errors.h"
+#include "paddle/fluid/platform/place.h"
 #include "paddle/fluid/platform/profiler.h"
 #include "paddle/fluid/platform/profiler/event_tracing.h"
 #include "paddle/phi/kernels/autotune/switch_autotune.h"
@@ -578,6 +580,10 @@ std::vector<paddle::experimental::Tensor> RunBackward(
   std::deque<GradNodeBase*> orig_queue;
   std::unordered_map<GradNodeBase*, std::unique_ptr<GradTensorHolder>>
       node_input_buffers_dict;
+  // The parallel backward only runs plain backward of CPU tensors
+  bool run_parallel =
+      !is_general_grad && !create_graph && IsParallelBackwardEnabled();
+  std::vector<std::shared_ptr<GradNodeBase>> start_nodes;
   for (size_t i = 0; i < tensors.size(); i++) {
     const paddle::experimental::Tensor& tensor = tensors[i];
 
@@ -623,6 +629,10 @@ std::vector<paddle::experimental::Tensor> RunBackward(
               << " of grad node: " << grad_node->name();
       node_input_buffers_dict[grad_node] =
           std::make_unique<GradTensorHolder>(grad_node->InputMeta());
+      start_nodes.push_back(shared_grad_node);
+    }
+    if (!paddle::platform::is_cpu_place(tensor.place())) {
+      run_parallel = false;
     }
     bool copy_from_grad_t =
         grad_tensors.size() > 0 && grad_tensors[i].initialized();
@@ -662,6 +672,12 @@ std::vector<paddle::experimental::Tensor> RunBackward(
     GeneralGrad::Instance().ReconstructBackwardGraph(orig_queue);
   }
 
+  if (run_parallel && !start_nodes.empty() &&
+      RunParallelBackward(
+          start_nodes, &node_input_buffers_dict, retain_graph)) {
+    return {};
+  }
+
   VLOG(3) << "Update In degree Map for backward";
   // 3. Compute in_degree for each node
   std::unordered_map<GradNodeBase*, int> node_in_degree_map =
@@ -14,6 +14,8 @@
 
 #pragma once
 
+#include <mutex>
+
 #include "paddle/fluid/eager/grad_node_info.h"
 
 namespace egr {
@@ -37,16 +39,20 @@ class GradTensorHolder {
     }
   }
 
-  GradTensorHolder(const GradTensorHolder& other) = default;
+  GradTensorHolder(const GradTensorHolder& other) : buffer_(other.buffer_) {}
 
   explicit GradTensorHolder(
       paddle::small_vector<std::vector<paddle::experimental::Tensor>,
                            kSlotSmallVectorSize>&& inputs)
       : buffer_(std::move(inputs)) {}
 
-  GradTensorHolder& operator=(const GradTensorHolder& other) = default;
+  GradTensorHolder& operator=(const GradTensorHolder& other) {
+    buffer_ = other.buffer_;
+    return *this;
+  }
 
-  // Create new tensor and copy tensor->impl
+  // Create new tensor and copy tensor->impl. Thread safe, the parallel
+  // backward accumulates the grads of several nodes into one holder at once.
   void add(size_t slot_id,
            size_t rank,
            const paddle::experimental::Tensor& t,
@@ -73,6 +79,7 @@ class GradTensorHolder {
   paddle::small_vector<std::vector<paddle::experimental::Tensor>,
                        kSlotSmallVectorSize>
       buffer_;
+  std::mutex mutex_;
 };
 
 }  // namespace egr
@@ -0,0 +1,335 @@
+// Copyright (c) 2022 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "paddle/fluid/eager/parallel_backward.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <exception>
+#include <map>
+#include <mutex>
+#include <string>
+#include <utility>
+
+#include "gflags/gflags.h"
+#include "glog/logging.h"
+#include "paddle/fluid/framework/new_executor/workqueue/workqueue.h"
+#include "paddle/fluid/platform/enforce.h"
+#include "paddle/fluid/platform/errors.h"
+#include "paddle/fluid/platform/profiler/event_tracing.h"
+
+DECLARE_int32(eager_backward_num_threads);
+
+namespace egr {
+
+namespace {
+
+// Set on the threads of the pool, so that a backward started by a grad node
+// runs serially rather than waiting on the pool it occupies.
+thread_local bool in_parallel_backward = false;
+
+/*
+ * The nodes reachable from the start nodes of a backward, in the order they
+ * are first reached, their in-degrees, and for each node the indices of the
+ * nodes its edges lead to, in the order of its OutputMeta, -1 for the edges
+ * leading nowhere. on_cpu tells whether all the grads of the nodes are on
+ * the CPU.
+ * **/
+struct BackwardGraph {
+  std::vector<std::weak_ptr<GradNodeBase>> start_nodes;
+  std::vector<GradNodeBase*> nodes;
+  std::vector<int> in_degree;
+  std::vector<std::vector<int64_t>> next_nodes;
+  bool on_cpu{true};
+
+  bool Matches(
+      const std::vector<std::shared_ptr<GradNodeBase>>& start_nodes) const {
+    if (start_nodes.size() != this->start_nodes.size()) return false;
+    for (size_t i = 0; i < start_nodes.size(); ++i) {
+      if (this->start_nodes[i].lock() != start_nodes[i]) return false;
+    }
+    return true;
+  }
+};
+
+// Whether the grads of the slots are on the CPU, or on no place for the
+// slots the forward did not set.
+bool IsOnCpu(const paddle::small_vector<std::vector<GradSlotMeta>,
+                                        kSlotSmallVectorSize>& metas) {
+  for (const auto& meta_list : metas) {
+    for (const GradSlotMeta& meta : meta_list) {
+      auto type = meta.GetPlace().GetType();
+      if (type != phi::AllocationType::CPU &&
+          type != phi::AllocationType::UNDEFINED) {
+        return false;
+      }
+    }
+  }
+  return true;
+}
+
+std::unique_ptr<BackwardGraph> BuildBackwardGraph(
+    const std::vector<std::shared_ptr<GradNodeBase>>& start_nodes) {
+  auto graph = std::make_unique<BackwardGraph>();
+  std::unordered_map<GradNodeBase*, int64_t> index;
+  auto visit = [&graph, &index](GradNodeBase* node) {
+    auto it = index.find(node);
+    if (it != index.end()) return it->second;
+    int64_t id = static_cast<int64_t>(graph->nodes.size());
+    index.emplace(node, id);
+    graph->nodes.push_back(node);
+    graph->in_degree.push_back(0);
+    return id;
+  };
+  for (const auto& node : start_nodes) {
+    graph->start_nodes.emplace_back(node);
+    visit(node.get());
+  }
+  // The nodes grow while they are visited, breadth first.
+  for (size_t k = 0; k < graph->nodes.size(); ++k) {
+    const auto& metas = graph->nodes[k]->OutputMeta();
+    graph->on_cpu = graph->on_cpu && IsOnCpu(graph->nodes[k]->InputMeta()) &&
+                    IsOnCpu(metas);
+    std::vector<int64_t> next_nodes;
+    for (const auto& meta_list : metas) {
+      for (const GradSlotMeta& meta : meta_list) {
+        GradNodeBase* next_node = meta.GetEdge().GetMutableGradNode().get();
+        if (!next_node) {
+          next_nodes.push_back(-1);
+          continue;
+        }
+        int64_t next_id = visit(next_node);
+        ++graph->in_degree[next_id];
+        next_nodes.push_back(next_id);
+      }
+    }
+    graph->next_nodes.push_back(std::move(next_nodes));
+  }
+  return graph;
+}
+
+const BackwardGraph& GetBackwardGraph(
+    const std::vector<std::shared_ptr<GradNodeBase>>& start_nodes) {
+  // The edges of a node are set when the forward creates it, so the graph
+  // reachable from alive start nodes never changes.
+  thread_local std::unique_ptr<BackwardGraph> cached_graph;
+  if (cached_graph && cached_graph->Matches(start_nodes)) {
+    VLOG(6) << "Reuse the cached backward graph of "
+            << cached_graph->nodes.size() << " nodes.";
+  } else {
+    cached_graph = BuildBackwardGraph(start_nodes);
+  }
+  return *cached_graph;
+}
+
+paddle::framework::WorkQueue* GetBackwardWorkQueue(int num_threads) {
+  static std::mutex mutex;
+  // Leaked, a pool is shared by the backward of every thread and must not be
+  // joined while the process exits.
+  static auto* queues =
+      new std::map<int, std::unique_ptr<paddle::framework::WorkQueue>>();
+  std::lock_guard<std::mutex> guard(mutex);
+  auto& queue = (*queues)[num_threads];
+  if (!queue) {
+    queue = paddle::framework::CreateMultiThreadedWorkQueue(
+        paddle::framework::WorkQueueOptions("EagerBackward",
+                                            num_threads,
+                                            /*allow_spinning=*/true,
+                                            /*track_task=*/false));
+  }
+  return queue.get();
+}
+
+class ParallelBackwardRunner {
+ public:
+  ParallelBackwardRunner(
+      const BackwardGraph& graph,
+      std::unordered_map<GradNodeBase*, std::unique_ptr<GradTensorHolder>>*
+          input_buffers,
+      bool retain_graph,
+      paddle::framework::WorkQueue* queue)
+      : graph_(graph),
+        retain_graph_(retain_graph),
+        queue_(queue),
+        pending_(new std::atomic<int>[graph.nodes.size()]),
+        buffers_(graph.nodes.size()) {
+    // All holders are built up front, the threads only add into them.
+    for (size_t k = 0; k < graph_.nodes.size(); ++k) {
+      pending_[k] = graph_.in_degree[k];
+      auto it = input_buffers->find(graph_.nodes[k]);
+      if (it != input_buffers->end()) {
+        buffers_[k] = std::move(it->second);
+      } else {
+        buffers_[k] =
+            std::make_unique<GradTensorHolder>(graph_.nodes[k]->InputMeta());
+      }
+    }
+  }
+
+  void Run() {
+    std::vector<size_t> ready;
+    for (size_t k = 0; k < graph_.start_nodes.size(); ++k) {
+      if (pending_[k] == 0) ready.push_back(k);
+    }
+    if (ready.empty()) return;
+    num_running_ = ready.size();
+    for (size_t k : ready) {
+      Dispatch(k);
+    }
+    std::unique_lock<std::mutex> lock(mutex_);
+    finished_cv_.wait(lock, [this] { return num_running_ == 0; });
+    if (error_) std::rethrow_exception(error_);
+  }
+
+ private:
+  void Dispatch(size_t k) {
+    queue_->AddTask([this, k] {
+      in_parallel_backward = true;
+      RunFrom(k);
+      in_parallel_backward = false;
+    });
+  }
+
+  // Runs node k, then one of the nodes it made ready on the same thread and
+  // so on, dispatching the others.
+  void RunFrom(size_t k) {
+    std::vector<size_t> ready;
+    for (int64_t next = static_cast<int64_t>(k); next >= 0;) {
+      ready.clear();
+      if (!failed_) {
+        try {
+          RunNode(next, &ready);
+        } catch (...) {
+          std::lock_guard<std::mutex> guard(mutex_);
+          if (!error_) error_ = std::current_exception();
+          failed_ = true;
+        }
+      }
+      next = -1;
+      for (size_t ready_k : ready) {
+        if (next < 0) {
+          next = static_cast<int64_t>(ready_k);
+        } else {
+          ++num_running_;
+          Dispatch(ready_k);
+        }
+      }
+    }
+    // Under the lock, Run() returns and destroys the runner only after it.
+    std::lock_guard<std::mutex> guard(mutex_);
+    if (--num_running_ == 0) {
+      finished_cv_.notify_all();
+    }
+  }
+
+  void RunNode(size_t k, std::vector<size_t>* ready) {
+    GradNodeBase* node = graph_.nodes[k];
+    VLOG(6) << "Running GradNode:" << node->name();
+    paddle::platform::RecordEvent node_record_event(
+        std::string(node->name()),
+        paddle::platform::TracerEventType::Operator,
+        1);
+
+    std::unique_ptr<GradTensorHolder> node_input_buffer =
+        std::move(buffers_[k]);
+    EnforceGradNodeHasInput(node);
+    paddle::small_vector<std::vector<paddle::experimental::Tensor>,
+                         kSlotSmallVectorSize>
+        grad_output_tensors = (*node)(node_input_buffer->Buffers(),
+                                      /*create_graph=*/false,
+                                      /*is_new_grad=*/false);
+    if (!retain_graph_) {
+      node->ClearTensorWrappers();
+    }
+    node_input_buffer.reset();
+
+    const paddle::small_vector<std::vector<GradSlotMeta>, kSlotSmallVectorSize>&
+        metas = node->OutputMeta();
+    PADDLE_ENFORCE(metas.size() == grad_output_tensors.size() || metas.empty(),
+                   paddle::platform::errors::Fatal(
+                       "Number of edges should be either empty ( for leaf node "
+                       ") or the same as number of output grad tensors, but we "
+                       "got edges size is: %d, grad_output size is: %d",
+                       metas.size(),
+                       grad_output_tensors.size()));
+    const std::vector<int64_t>& next_nodes = graph_.next_nodes[k];
+    size_t e = 0;
+    for (size_t i = 0; i < metas.size(); i++) {
+      for (size_t j = 0; j < metas[i].size(); j++, e++) {
+        int64_t next = next_nodes[e];
+        // As in the serial backward, the edges of the slots without grads
+        // do not count down the in-degree, so a node reached only through
+        // them never runs.
+        if (next < 0 || grad_output_tensors[i].empty()) continue;
+        PADDLE_ENFORCE_LT(
+            j,
+            grad_output_tensors[i].size(),
+            paddle::platform::errors::Fatal(
+                "Rank of grad_output_tensors should be less than "
+                "grad_output_tensors[i].size(), which is: %d. This error "
+                "may indicate autoprune or autograd api error. ",
+                grad_output_tensors[i].size()));
+        auto edge_rank = metas[i][j].GetEdge().GetEdgeRankInfo();
+        buffers_[next]->add(edge_rank.first,
+                            edge_rank.second,
+                            grad_output_tensors[i][j],
+                            /*create_graph=*/false);
+        if (pending_[next].fetch_sub(1) == 1) {
+          ready->push_back(static_cast<size_t>(next));
+        }
+      }
+    }
+  }
+
+  const BackwardGraph& graph_;
+  const bool retain_graph_;
+  paddle::framework::WorkQueue* queue_;
+  std::unique_ptr<std::atomic<int>[]> pending_;
+  std::vector<std::unique_ptr<GradTensorHolder>> buffers_;
+
+  std::atomic<size_t> num_running_{0};
+  std::atomic<bool> failed_{false};
+  std::mutex mutex_;
+  std::condition_variable finished_cv_;
+  std::exception_ptr error_;
+};
+
+}  // namespace
+
+bool IsParallelBackwardEnabled() {
+  return FLAGS_eager_backward_num_threads > 1 && !in_parallel_backward;
+}
+
+bool RunParallelBackward(
+    const std::vector<std::shared_ptr<GradNodeBase>>& start_nodes,
+    std::unordered_map<GradNodeBase*, std::unique_ptr<GradTensorHolder>>*
+        input_buffers,
+    bool retain_graph) {
+  const BackwardGraph& graph = GetBackwardGraph(start_nodes);
+  if (!graph.on_cpu) {
+    VLOG(3) << "Run Backward serially, some grads are not on the CPU";
+    return false;
+  }
+  VLOG(3) << "Run Backward on " << FLAGS_eager_backward_num_threads
+          << " threads";
+  ParallelBackwardRunner runner(
+      graph,
+      input_buffers,
+      retain_graph,
+      GetBackwardWorkQueue(FLAGS_eager_backward_num_threads));
+  runner.Run();
+  return true;
+}
+
+}  // namespace egr
@@ -0,0 +1,55 @@
+// Copyright (c) 2022 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+#include "paddle/fluid/eager/grad_node_info.h"
+#include "paddle/fluid/eager/grad_tensor_holder.h"
+
+namespace egr {
+
+// Defined in backward.cc.
+void EnforceGradNodeHasInput(GradNodeBase* node);
+
+// Whether FLAGS_eager_backward_num_threads asks for the parallel backward
+// and the calling thread is not running a grad node of one already.
+bool IsParallelBackwardEnabled();
+
+/*
+ * Runs the grad nodes reachable from start_nodes, the independent ready
+ * nodes concurrently on a work-stealing pool of
+ * FLAGS_eager_backward_num_threads threads.
+ *
+ * input_buffers holds the grads fed to the start nodes. The topology of the
+ * graph (its nodes, their in-degrees and the nodes each edge leads to) is
+ * cached per thread while the start nodes are alive, so that a backward
+ * run again over the same graph does not traverse it again. The first
+ * exception thrown by a node is rethrown on the calling thread once the
+ * running nodes finished.
+ *
+ * Only plain backward is supported: no create_graph and no inputs. Returns
+ * false, running nothing, if the grads of a reachable node are not all on
+ * the CPU.
+ * **/
+bool RunParallelBackward(
+    const std::vector<std::shared_ptr<GradNodeBase>>& start_nodes,
+    std::unordered_map<GradNodeBase*, std::unique_ptr<GradTensorHolder>>*
+        input_buffers,
+    bool retain_graph);
+
+}  // namespace egr
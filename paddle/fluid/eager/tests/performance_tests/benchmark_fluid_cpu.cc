@@ -43,6 +43,8 @@ PD_DECLARE_KERNEL(add_grad, CPU, ALL_LAYOUT);
 PD_DECLARE_KERNEL(sum, CPU, ALL_LAYOUT);
 PD_DECLARE_KERNEL(sum_grad, CPU, ALL_LAYOUT);
 
+DECLARE_bool(dygraph_dispatch_cache);
+
 namespace paddle {
 namespace imperative {
 
@@ -235,6 +237,46 @@ TEST(Benchmark, FluidMLPCPU) {
   }
 }
 
+TEST(Benchmark, FluidDispatchOverheadCPU) {
+  // Prepare Device Contexts
+  platform::CPUPlace place;
+  eager_test::InitEnv(place);
+
+  // A small tensor, so that the time is spent dispatching the ops
+  std::shared_ptr<imperative::VarBase> X(new imperative::VarBase(true, "X"));
+  auto* x_tensor = X->MutableVar()->GetMutable<framework::LoDTensor>();
+  x_tensor->Resize(phi::make_ddim({2, 2}));
+  x_tensor->mutable_data<float>(place);
+
+  framework::AttributeMap attrs;
+  attrs["scale"] = 2.0f;
+  attrs["bias"] = 3.0f;
+  attrs["bias_after_scale"] = true;
+
+  const size_t num_ops = 10000;
+  for (bool use_cache : {false, true}) {
+    FLAGS_dygraph_dispatch_cache = use_cache;
+    imperative::Tracer tracer;
+    imperative::NameVarBaseMap ins = {{"X", {X}}};
+    auto t_start = std::chrono::high_resolution_clock::now();
+    for (size_t i = 0; i < num_ops; i++) {
+      imperative::NameVarBaseMap outs = {
+          {"Out",
+           {std::shared_ptr<imperative::VarBase>(
+               new imperative::VarBase(true, "Out"))}}};
+      tracer.TraceOp<VarBase>(
+          "scale", ins, outs, attrs, place, false /* trace_backward */);
+    }
+    auto t_end = std::chrono::high_resolution_clock::now();
+    double elapsed_time_us =
+        std::chrono::duration<double, std::micro>(t_end - t_start).count();
+    std::cout << "Dispatch cache " << (use_cache ? "on" : "off")
+              << ", per op: " << elapsed_time_us / num_ops << " us"
+              << std::endl;
+  }
+  FLAGS_dygraph_dispatch_cache = true;
+}
+
 }  // namespace imperative
 }  // namespace paddle
 
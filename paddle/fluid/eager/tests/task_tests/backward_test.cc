@@ -25,6 +25,7 @@
 #include "paddle/fluid/eager/autograd_meta.h"
 #include "paddle/fluid/eager/grad_node_info.h"
 #include "paddle/fluid/eager/tests/test_utils.h"
+#include "paddle/fluid/framework/scope_guard.h"
 #include "paddle/phi/core/dense_tensor.h"
 #include "paddle/phi/core/kernel_registry.h"
 #include "paddle/phi/core/tensor_meta.h"
@@ -32,6 +33,8 @@
 PD_DECLARE_KERNEL(full, CPU, ALL_LAYOUT);
 PD_DECLARE_KERNEL(add, CPU, ALL_LAYOUT);
 
+DECLARE_int32(eager_backward_num_threads);
+
 namespace egr {
 
 TEST(Backward, SingleNodeEmptyGrad) {
@@ -343,4 +346,74 @@ TEST(Backward, WithAccumulation) {
   eager_test::CompareGradTensorWithValue<float>(leaf_tensor, 2500.0);
 }
 
+TEST(Backward, ParallelWithAccumulation) {
+  // Prepare Device Contexts
+  eager_test::InitEnv(paddle::platform::CPUPlace());
+  int num_threads = FLAGS_eager_backward_num_threads;
+  DEFINE_PADDLE_SCOPE_GUARD(
+      [num_threads] { FLAGS_eager_backward_num_threads = num_threads; });
+  FLAGS_eager_backward_num_threads = 4;
+
+  // Prepare Inputs
+  paddle::framework::DDim ddim = phi::make_ddim({4, 16, 16, 32});
+
+  // Create Target Tensors, each with its own scale node, all of the nodes
+  // leading to one node accumulating into the leaf
+  const int num_targets = 8;
+  std::vector<paddle::experimental::Tensor> target_tensors;
+  for (int i = 0; i < num_targets; i++) {
+    target_tensors.emplace_back(
+        egr_utils_api::CreateTensorWithValue(ddim,
+                                             paddle::platform::CPUPlace(),
+                                             phi::DataType::FLOAT32,
+                                             phi::DataLayout::NCHW,
+                                             1.0 /*value*/,
+                                             false /*is_leaf*/));
+  }
+
+  paddle::experimental::Tensor leaf_tensor;
+  {
+    auto sum_node_ptr = std::make_shared<GradNodeScale>(1, 1);
+    sum_node_ptr->SetAttributes_scale(2.0 /*scale*/);
+    sum_node_ptr->SetDefaultGradInOutMeta();
+    for (int i = 0; i < num_targets; i++) {
+      auto node_ptr = std::make_shared<GradNodeScale>(1, 1);
+      node_ptr->SetAttributes_scale(i + 1.0 /*scale*/);
+      node_ptr->SetDefaultGradInOutMeta();
+      AutogradMeta* auto_grad_meta =
+          EagerUtils::autograd_meta(&(target_tensors[i]));
+      auto_grad_meta->SetGradNode(
+          std::dynamic_pointer_cast<GradNodeBase>(node_ptr));
+      auto_grad_meta->SetSingleOutRankWithSlot(0, 0);
+      auto_grad_meta->SetStopGradient(false);
+
+      // Connect Node_i -> SumNode via Edge
+      auto tmp_tensor = paddle::experimental::Tensor();
+      auto* meta = EagerUtils::autograd_meta(&tmp_tensor);
+      meta->SetStopGradient(false);
+      meta->SetSingleOutRankWithSlot(0, 0);
+      meta->SetGradNode(sum_node_ptr);
+      node_ptr->SetGradOutMeta(tmp_tensor, 0);
+    }
+
+    AutogradMeta* auto_grad_meta = EagerUtils::autograd_meta(&leaf_tensor);
+    // Connect Tensor and AccumulationNode via AutoGradMeta
+    auto acc_node_ptr =
+        std::make_shared<egr::GradNodeAccumulation>(auto_grad_meta);
+    auto_grad_meta->SetGradNode(
+        std::dynamic_pointer_cast<GradNodeBase>(acc_node_ptr));
+    auto_grad_meta->SetSingleOutRankWithSlot(0, 0);
+    auto_grad_meta->SetStopGradient(false);
+    sum_node_ptr->SetGradOutMeta(leaf_tensor, 0);
+  }
+
+  // (1 + 2 + ... + 8) * 2
+  Backward(target_tensors, {}, /*retain_graph=*/true);
+  eager_test::CompareGradTensorWithValue<float>(leaf_tensor, 72.0);
+
+  // Runs again over the cached graph and accumulates into the leaf
+  Backward(target_tensors, {});
+  eager_test::CompareGradTensorWithValue<float>(leaf_tensor, 144.0);
+}
+
 }  // namespace egr
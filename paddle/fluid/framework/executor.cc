@@ -17,6 +17,7 @@ limitations under the License. */
 #include <memory>
 
 #include "paddle/fluid/framework/feed_fetch_method.h"
+#include "paddle/fluid/framework/scope_guard.h"
 #include "paddle/fluid/framework/trainer_desc.pb.h"
 #include "paddle/fluid/framework/trainer_factory.h"
 #include "paddle/fluid/operators/controlflow/conditional_block_op_helper.h"
@@ -65,6 +66,12 @@ void ExecutorPrepareContext::PrepareUnusedVars(
   unused_vars_ = GetUnusedVars(prog_.Block(block_id_), ops_, keep_vars);
 }
 
+void ExecutorPrepareContext::PrepareVarSlots() {
+  for (auto& op : ops_) {
+    op->CompileVarSlots(var_slot_map_.get());
+  }
+}
+
 ExecutorPrepareContext::~ExecutorPrepareContext() {
   VLOG(5) << "destroy ExecutorPrepareContext";
 }
@@ -425,6 +432,7 @@ std::unique_ptr<ExecutorPrepareContext> Executor::Prepare(
     ctx->ops_.push_back(OpRegistry::CreateOp(*op_desc));
   }
   ctx->PrepareUnusedVars(skip_ref_cnt_vars, force_disable_gc);
+  ctx->PrepareVarSlots();
   return ctx;
 }
 
@@ -459,6 +467,7 @@ std::vector<std::shared_ptr<ExecutorPrepareContext>> Executor::Prepare(
     } else {
       ctx->PrepareUnusedVars(skip_ref_cnt_vars[idx], force_disable_gc);
     }
+    ctx->PrepareVarSlots();
     result.push_back(std::shared_ptr<ExecutorPrepareContext>(ctx));
     ++idx;
   }
@@ -501,7 +510,11 @@ void Executor::RunPartialPreparedContext(ExecutorPrepareContext* ctx,
           platform::errors::Unimplemented("No GPU gc found in CPU/XPU paddle"));
 #endif
     } else if (platform::is_cpu_place(place_)) {
-      gc.reset(new CPUGarbageCollector(place_, max_memory_size));
+      if (IsAsyncCPUGarbageCollectionEnabled()) {
+        gc.reset(new AsyncCPUGarbageCollector(place_));
+      } else {
+        gc.reset(new CPUGarbageCollector(place_, max_memory_size));
+      }
     } else if (platform::is_xpu_place(place_)) {
 #ifdef PADDLE_WITH_XPU
       gc.reset(new XPUGarbageCollector(place_, max_memory_size));
@@ -561,13 +574,21 @@ void Executor::RunPartialPreparedContext(ExecutorPrepareContext* ctx,
     }
   }
 
-  for (int64_t i = start_op_index; i < end_op_index; ++i) {
-    auto& op = ctx->ops_[i];
-    op->Run(*local_scope, place_);
-    if (gc) {
-      platform::RecordEvent record(
-          "CheckGC", platform::TracerEventType::UserDefined, 10);
-      DeleteUnusedTensors(*local_scope, op.get(), ctx->unused_vars_, gc.get());
+  {
+    // The ops read their variables by slot, looked up once for the run.
+    local_scope->SetSlotTable(
+        std::make_shared<VarSlotTable>(ctx->var_slot_map_, *local_scope));
+    DEFINE_PADDLE_SCOPE_GUARD(
+        [local_scope] { local_scope->SetSlotTable(nullptr); });
+    for (int64_t i = start_op_index; i < end_op_index; ++i) {
+      auto& op = ctx->ops_[i];
+      op->Run(*local_scope, place_);
+      if (gc) {
+        platform::RecordEvent record(
+            "CheckGC", platform::TracerEventType::UserDefined, 10);
+        DeleteUnusedTensors(
+            *local_scope, op.get(), ctx->unused_vars_, gc.get());
+      }
     }
   }
 
@@ -26,6 +26,7 @@ limitations under the License. */
 #include "paddle/fluid/framework/program_desc.h"
 #include "paddle/fluid/framework/scope.h"
 #include "paddle/fluid/framework/tensor.h"
+#include "paddle/fluid/framework/var_slot_table.h"
 #include "paddle/fluid/platform/device_context.h"
 
 namespace paddle {
@@ -44,6 +45,9 @@ struct ExecutorPrepareContext {
   void PrepareUnusedVars(const std::vector<std::string>& keep_vars,
                          bool force_disable_gc = false);
 
+  // Compiles the variables of the ops to the slots of var_slot_map_.
+  void PrepareVarSlots();
+
   const framework::ProgramDesc& prog_;
   const size_t block_id_;
 
@@ -52,6 +56,8 @@ struct ExecutorPrepareContext {
   std::unordered_map<const OperatorBase*, std::vector<std::string>>
       unused_vars_;
   bool force_disable_gc_{false};
+
+  std::shared_ptr<VarSlotMap> var_slot_map_{std::make_shared<VarSlotMap>()};
 };
 
 class Executor {
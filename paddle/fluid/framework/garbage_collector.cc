@@ -12,7 +12,13 @@
 // See the License for the specific language governing permissions and
 // limitations under the License.
 
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>  // NOLINT
+#include <cstdlib>
 #include <functional>
+#include <thread>  // NOLINT
+#include <vector>
 #if defined(PADDLE_WITH_CUDA) || defined(PADDLE_WITH_HIP)
 #include "paddle/fluid/platform/cuda_device_guard.h"
 #endif
@@ -23,6 +29,7 @@
 DECLARE_double(eager_delete_tensor_gb);
 DECLARE_double(memory_fraction_of_eager_deletion);
 DECLARE_bool(fast_eager_deletion_mode);
+DECLARE_bool(async_cpu_garbage_collection);
 
 namespace paddle {
 namespace framework {
@@ -45,6 +52,173 @@ void CPUGarbageCollector::ClearCallback(const std::function<void()> &callback) {
   callback();
 }
 
+// The background thread of AsyncCPUGarbageCollector, shared by all the
+// collectors, since Executor creates one for each run. It is stopped at
+// exit, after freeing the garbage left, before the static objects it frees
+// the garbage to are destroyed.
+class GarbageReclaimer {
+ public:
+  static GarbageReclaimer &Instance() {
+    // Never destroyed, so that the collectors may add garbage at exit, which
+    // is freed at once by the adding thread after the stop.
+    static GarbageReclaimer *reclaimer = [] {
+      auto *reclaimer = new GarbageReclaimer();
+      // Run before the destructors of the static objects constructed before,
+      // like the device contexts and the allocators.
+      std::atexit([] { GarbageReclaimer::Instance().Stop(); });
+      return reclaimer;
+    }();
+    return *reclaimer;
+  }
+
+  void Push(const std::function<void()> &callback) {
+    if (stopped_.load(std::memory_order_acquire)) {
+      callback();
+      return;
+    }
+    auto *list = LocalList();
+    auto *node = new Node{callback, list->head.load(std::memory_order_relaxed)};
+    while (!list->head.compare_exchange_weak(node->next, node)) {
+    }
+    list->pushed.store(list->pushed.load(std::memory_order_relaxed) + 1,
+                       std::memory_order_release);
+    // Only the push making the garbage non-empty wakes the reclaimer up,
+    // under the lock so that the wakeup is not lost.
+    if (!has_garbage_.load() && !has_garbage_.exchange(true)) {
+      std::lock_guard<std::mutex> guard(mutex_);
+      cv_.notify_one();
+    }
+  }
+
+  void Wait() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    std::vector<std::pair<std::shared_ptr<ThreadList>, size_t>> targets;
+    for (auto &list : lists_) {
+      targets.emplace_back(list, list->pushed.load(std::memory_order_acquire));
+    }
+    reclaimed_cv_.wait(lock, [&targets] {
+      for (auto &target : targets) {
+        if (target.first->reclaimed < target.second) return false;
+      }
+      return true;
+    });
+  }
+
+ private:
+  struct Node {
+    std::function<void()> callback;
+    Node *next;
+  };
+
+  struct ThreadList {
+    std::atomic<Node *> head{nullptr};
+    std::atomic<size_t> pushed{0};  // written by the owner thread only
+    size_t reclaimed{0};            // guarded by mutex_
+  };
+
+  GarbageReclaimer() : thread_([this] { Loop(); }) {}
+
+  // Joins the thread and frees the garbage it left.
+  void Stop() {
+    {
+      std::lock_guard<std::mutex> guard(mutex_);
+      stopping_ = true;
+    }
+    cv_.notify_one();
+    thread_.join();
+    stopped_.store(true, std::memory_order_release);
+    // Also frees the garbage pushed before stopped_ was seen.
+    Reclaim();
+  }
+
+  ThreadList *LocalList() {
+    thread_local std::shared_ptr<ThreadList> list;
+    if (list == nullptr) {
+      list = std::make_shared<ThreadList>();
+      std::lock_guard<std::mutex> guard(mutex_);
+      lists_.push_back(list);
+    }
+    return list.get();
+  }
+
+  void Loop() {
+    while (true) {
+      {
+        std::unique_lock<std::mutex> lock(mutex_);
+        cv_.wait(lock, [this] { return has_garbage_.load() || stopping_; });
+        if (stopping_) return;
+        has_garbage_ = false;
+      }
+      Reclaim();
+    }
+  }
+
+  // Frees the garbage pushed so far. Run by one thread at a time, the
+  // background thread or Stop after joining it.
+  void Reclaim() {
+    std::vector<std::pair<ThreadList *, Node *>> batch;
+    {
+      std::lock_guard<std::mutex> guard(mutex_);
+      // The lists are only erased by Reclaim.
+      for (auto &list : lists_) {
+        auto *nodes = list->head.exchange(nullptr);
+        if (nodes) batch.emplace_back(list.get(), nodes);
+      }
+    }
+
+    std::vector<size_t> counts(batch.size(), 0);
+    for (size_t i = 0; i < batch.size(); ++i) {
+      for (auto *node = batch[i].second; node != nullptr;) {
+        node->callback();
+        auto *next = node->next;
+        delete node;
+        node = next;
+        ++counts[i];
+      }
+    }
+
+    {
+      std::lock_guard<std::mutex> guard(mutex_);
+      for (size_t i = 0; i < batch.size(); ++i) {
+        batch[i].first->reclaimed += counts[i];
+      }
+      // Erase the lists of the exited threads once released.
+      lists_.erase(std::remove_if(lists_.begin(),
+                                  lists_.end(),
+                                  [](const std::shared_ptr<ThreadList> &l) {
+                                    return l.use_count() == 1 &&
+                                           l->reclaimed == l->pushed;
+                                  }),
+                   lists_.end());
+    }
+    reclaimed_cv_.notify_all();
+  }
+
+  std::mutex mutex_;
+  std::condition_variable cv_;
+  std::condition_variable reclaimed_cv_;
+  std::atomic<bool> has_garbage_{false};
+  bool stopping_{false};  // guarded by mutex_
+  std::atomic<bool> stopped_{false};
+  std::vector<std::shared_ptr<ThreadList>> lists_;
+  std::thread thread_;
+};
+
+AsyncCPUGarbageCollector::AsyncCPUGarbageCollector(
+    const platform::CPUPlace &place)
+    : GarbageCollector(place, 0) {
+  GarbageReclaimer::Instance();
+}
+
+void AsyncCPUGarbageCollector::Wait() const {
+  GarbageReclaimer::Instance().Wait();
+}
+
+void AsyncCPUGarbageCollector::ClearCallback(
+    const std::function<void()> &callback) {
+  GarbageReclaimer::Instance().Push(callback);
+}
+
 #ifdef PADDLE_WITH_XPU
 XPUGarbageCollector::XPUGarbageCollector(const platform::XPUPlace &place,
                                          size_t max_memory_size)
@@ -264,6 +438,10 @@ int64_t GetEagerDeletionThreshold() {
 
 bool IsFastEagerDeletionModeEnabled() { return FLAGS_fast_eager_deletion_mode; }
 
+bool IsAsyncCPUGarbageCollectionEnabled() {
+  return FLAGS_async_cpu_garbage_collection;
+}
+
 void SetEagerDeletionMode(double threshold, double fraction, bool fast_mode) {
   FLAGS_eager_delete_tensor_gb = threshold;
   FLAGS_memory_fraction_of_eager_deletion = fraction;
@@ -67,6 +67,23 @@ class CPUGarbageCollector : public GarbageCollector {
   void ClearCallback(const std::function<void()> &callback) override;
 };
 
+// A CPU garbage collector releasing the garbage on a background thread.
+// Each compute thread pushes its garbage into a lock-free list of its own,
+// and the background thread takes the lists and releases them in batches,
+// so the compute threads neither free memory nor contend on a lock. The
+// garbage is handed over as soon as it is added, the batching of the
+// background thread taking the place of max_memory_size.
+class AsyncCPUGarbageCollector : public GarbageCollector {
+ public:
+  explicit AsyncCPUGarbageCollector(const platform::CPUPlace &place);
+
+  // Waits until the garbage added before by any thread is released.
+  void Wait() const override;
+
+ protected:
+  void ClearCallback(const std::function<void()> &callback) override;
+};
+
 #ifdef PADDLE_WITH_XPU
 class XPUGarbageCollector : public GarbageCollector {
  public:
@@ -280,6 +297,7 @@ void GarbageCollector::Add(Container &&objs, Callback &&callback) {
 
 int64_t GetEagerDeletionThreshold();
 bool IsFastEagerDeletionModeEnabled();
+bool IsAsyncCPUGarbageCollectionEnabled();
 
 void SetEagerDeletionMode(double threshold, double fraction, bool fast_mode);
 
@@ -0,0 +1,66 @@
+/* Copyright (c) 2022 PaddlePaddle Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License. */
+
+#include "paddle/fluid/framework/garbage_collector.h"
+
+#include <atomic>
+#include <memory>
+#include <thread>  // NOLINT
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "paddle/fluid/platform/init.h"
+
+namespace paddle {
+namespace framework {
+
+static std::atomic<int> released_num{0};
+
+static void ReleaseGarbage(phi::Allocation* allocation) { ++released_num; }
+
+TEST(AsyncCPUGarbageCollector, Release) {
+  InitDevices();
+  platform::CPUPlace place;
+  AsyncCPUGarbageCollector gc(place);
+
+  const int kThreadNum = 8;
+  const int kGarbageNum = 1000;
+  std::vector<std::thread> threads;
+  for (int i = 0; i < kThreadNum; ++i) {
+    threads.emplace_back([&gc, &place] {
+      for (int j = 0; j < kGarbageNum; ++j) {
+        GarbageCollector::GarbageQueue garbages;
+        garbages.push_back(std::make_shared<memory::Allocation>(
+            nullptr, 1, &ReleaseGarbage, place));
+        gc.Add(std::move(garbages));
+      }
+    });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  gc.Wait();
+  EXPECT_EQ(released_num, kThreadNum * kGarbageNum);
+
+  // The garbage of the threads still running is released too.
+  GarbageCollector::GarbageQueue garbages;
+  garbages.push_back(
+      std::make_shared<memory::Allocation>(nullptr, 1, &ReleaseGarbage, place));
+  gc.Add(std::move(garbages));
+  gc.Wait();
+  EXPECT_EQ(released_num, kThreadNum * kGarbageNum + 1);
+}
+
+}  // namespace framework
+}  // namespace paddle
@@ -0,0 +1,326 @@
+/* Copyright (c) 2022 PaddlePaddle Authors. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License. */
+
+#include "paddle/fluid/framework/ir/elementwise_chain_fuse_pass.h"
+
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include "paddle/fluid/framework/ir/fusion_group/subgraph.h"
+#include "paddle/fluid/framework/ir/graph_pattern_detector.h"
+#include "paddle/fluid/framework/ir/subgraph_detector.h"
+#include "paddle/fluid/framework/op_proto_maker.h"
+
+namespace paddle {
+namespace framework {
+namespace ir {
+
+namespace {
+
+bool IsBinaryOp(const std::string& type) {
+  static const std::unordered_set<std::string> types = {"elementwise_add",
+                                                        "elementwise_sub",
+                                                        "elementwise_mul",
+                                                        "elementwise_div",
+                                                        "elementwise_max",
+                                                        "elementwise_min"};
+  return types.count(type) > 0;
+}
+
+bool IsUnaryOp(const std::string& type) {
+  static const std::unordered_set<std::string> types = {
+      "relu", "sigmoid", "tanh", "sqrt", "square", "exp", "scale"};
+  return types.count(type) > 0;
+}
+
+Node* FindVar(const std::vector<Node*>& vars, const std::string& name) {
+  for (auto* var : vars) {
+    if (var && var->IsVar() && var->Var() && var->Name() == name) {
+      return var;
+    }
+  }
+  return nullptr;
+}
+
+// Whether args holds a single variable for each of names and nothing for
+// the other arguments, like the ScaleTensor of scale.
+bool HasOnlyArgs(const VariableNameMap& args,
+                 const std::vector<std::string>& names) {
+  std::unordered_set<std::string> names_set(names);
+  for (auto& arg : args) {
+    size_t expected = names_set.count(arg.first) ? 1U : 0U;
+    if (arg.second.size() != expected) return false;
+  }
+  for (auto& name : names) {
+    if (args.count(name) == 0) return false;
+  }
+  return true;
+}
+
+// Only the first dimension may be unknown, so that two shapes equal at
+// compile time differ at most in the batch at run time.
+bool IsSupportedShape(const std::vector<int64_t>& shape) {
+  if (shape.empty()) return false;
+  for (size_t i = 1; i < shape.size(); ++i) {
+    if (shape[i] <= 0) return false;
+  }
+  return shape[0] > 0 || shape[0] == -1;
+}
+
+// Whether y is broadcast to x along the trailing dimensions of x, which
+// fusion_elementwise_chain supports.
+bool IsTrailingBroadcast(const std::vector<int64_t>& x_shape,
+                         const std::vector<int64_t>& y_shape,
+                         int axis) {
+  bool is_scalar = true;
+  for (auto dim : y_shape) {
+    if (dim != 1) is_scalar = false;
+  }
+  if (is_scalar) return true;
+  if (y_shape.size() > x_shape.size()) return false;
+  int pre = static_cast<int>(x_shape.size() - y_shape.size());
+  if (axis != -1 && axis != pre) return false;
+  for (size_t i = 0; i < y_shape.size(); ++i) {
+    if (y_shape[i] <= 0 || y_shape[i] != x_shape[pre + i]) return false;
+  }
+  return true;
+}
+
+bool IsFloatTensor(const Node* var, proto::VarType::Type* dtype) {
+  if (var->Var()->GetType() != proto::VarType::LOD_TENSOR) return false;
+  *dtype = var->Var()->GetDataType();
+  return *dtype == proto::VarType::FP32 || *dtype == proto::VarType::FP64;
+}
+
+bool IsFusibleOp(const Node* n) {
+  if (!(n && n->IsOp() && n->Op())) return false;
+  auto* op = n->Op();
+  bool is_binary = IsBinaryOp(op->Type());
+  if (!is_binary && !IsUnaryOp(op->Type())) return false;
+  if (op->GetAttrIfExists<bool>("use_mkldnn")) return false;
+  std::vector<std::string> input_args = {"X"};
+  if (is_binary) input_args.push_back("Y");
+  if (!HasOnlyArgs(op->Inputs(), input_args) ||
+      !HasOnlyArgs(op->Outputs(), {"Out"})) {
+    return false;
+  }
+
+  Node* x = FindVar(n->inputs, op->Input("X")[0]);
+  Node* out = FindVar(n->outputs, op->Output("Out")[0]);
+  Node* y = is_binary ? FindVar(n->inputs, op->Input("Y")[0]) : nullptr;
+  if (!x || !out || (is_binary && !y)) return false;
+
+  proto::VarType::Type x_dtype, out_dtype, y_dtype;
+  if (!IsFloatTensor(x, &x_dtype) || !IsFloatTensor(out, &out_dtype) ||
+      x_dtype != out_dtype) {
+    return false;
+  }
+  std::vector<int64_t> x_shape = x->Var()->GetShape();
+  if (!IsSupportedShape(x_shape) || out->Var()->GetShape() != x_shape) {
+    return false;
+  }
+  if (is_binary) {
+    if (!IsFloatTensor(y, &y_dtype) || y_dtype != x_dtype) return false;
+    std::vector<int64_t> y_shape = y->Var()->GetShape();
+    int axis =
+        op->HasAttr("axis") ? PADDLE_GET_CONST(int, op->GetAttr("axis")) : -1;
+    if (!IsSupportedShape(y_shape) ||
+        (y_shape != x_shape && !IsTrailingBroadcast(x_shape, y_shape, axis))) {
+      return false;
+    }
+  }
+  return true;
+}
+
+int ExtractOpRole(fusion_group::SubGraph* subgraph) {
+  std::unordered_set<int> op_roles;
+  std::string attr_name = OpProtoAndCheckerMaker::OpRoleAttrName();
+  for (auto* n : subgraph->Nodes()) {
+    if (n && n->IsOp() && n->Op() && n->Op()->HasAttr(attr_name)) {
+      op_roles.insert(PADDLE_GET_CONST(int, n->Op()->GetAttr(attr_name)));
+    }
+  }
+  if (op_roles.size() == 1U) {
+    return *(op_roles.begin());
+  }
+  return static_cast<int>(OpRole::kNotSpecified);
+}
+
+}  // namespace
+
+void ElementwiseChainFusePass::ApplyImpl(ir::Graph* graph) const {
+  PADDLE_ENFORCE_NOT_NULL(
+      graph, platform::errors::InvalidArgument("Graph cannot be nullptr."));
+  FusePassBase::Init(name_scope_, graph);
+
+  std::vector<std::vector<Node*>> subgraphs =
+      SubgraphDetector(graph, IsFusibleOp)();
+  int found_count = 0;
+  for (auto& nodes : subgraphs) {
+    fusion_group::SubGraph subgraph(
+        /*type=*/0,
+        /*func_name=*/"",
+        /*save_intermediate_out=*/false,
+        std::unordered_set<Node*>(nodes.begin(), nodes.end()));
+    if (subgraph.IsValid(/*min_subgraph_size=*/2) &&
+        InsertFusionOp(graph, &subgraph)) {
+      ++found_count;
+    }
+  }
+  AddStatis(found_count);
+}
+
+bool ElementwiseChainFusePass::InsertFusionOp(
+    Graph* graph, fusion_group::SubGraph* subgraph) const {
+  const std::vector<Node*>& input_vars = subgraph->GetInputVarNodes();
+  const std::vector<Node*>& output_vars = subgraph->GetOutputVarNodes(false);
+
+  // The ids of the values, the inputs followed by the results of the ops.
+  std::unordered_map<Node*, int> var_ids;
+  std::vector<std::string> input_names;
+  std::unordered_set<std::string> input_names_set;
+  for (auto* n : input_vars) {
+    var_ids[n] = static_cast<int>(input_names.size());
+    input_names.push_back(n->Name());
+    input_names_set.insert(n->Name());
+  }
+  int num_ins = static_cast<int>(input_names.size());
+
+  std::vector<std::string> op_types;
+  std::vector<int> operands;
+  std::vector<float> scales;
+  std::vector<float> biases;
+  std::vector<int64_t> shape;
+  for (auto* n : subgraph->SortedNodes()) {
+    if (!(n && n->IsOp() && n->Op())) continue;
+    auto* op = n->Op();
+    Node* out = FindVar(n->outputs, op->Output("Out")[0]);
+    // The results are computed on the same tiles, so they are all of the
+    // same shape.
+    if (op_types.empty()) {
+      shape = out->Var()->GetShape();
+    } else if (out->Var()->GetShape() != shape) {
+      VLOG(3) << "The results of the elementwise ops are of different shapes, "
+                 "skip fusing them.";
+      return false;
+    }
+
+    for (auto* arg : {"X", "Y"}) {
+      if (op->Inputs().count(arg) == 0) {
+        operands.push_back(-1);
+        continue;
+      }
+      Node* var = FindVar(n->inputs, op->Input(arg)[0]);
+      auto it = var_ids.find(var);
+      PADDLE_ENFORCE_NE(it,
+                        var_ids.end(),
+                        platform::errors::PreconditionNotMet(
+                            "Input(%s) of %s is neither an input of the "
+                            "fused ops nor computed before it.",
+                            arg,
+                            op->Type()));
+      operands.push_back(it->second);
+    }
+
+    float scale = 1.0f;
+    float bias = 0.0f;
+    if (op->Type() == "scale") {
+      if (op->HasAttr("scale")) {
+        scale = PADDLE_GET_CONST(float, op->GetAttr("scale"));
+      }
+      if (op->HasAttr("bias")) {
+        bias = PADDLE_GET_CONST(float, op->GetAttr("bias"));
+      }
+      if (op->HasAttr("bias_after_scale") &&
+          !PADDLE_GET_CONST(bool, op->GetAttr("bias_after_scale"))) {
+        bias *= scale;
+      }
+    }
+    scales.push_back(scale);
+    biases.push_back(bias);
+
+    var_ids[out] = num_ins + static_cast<int>(op_types.size());
+    op_types.push_back(op->Type());
+  }
+
+  int shape_input = -1;
+  for (int i = 0; i < num_ins; ++i) {
+    if (input_vars[i]->Var()->GetShape() == shape) {
+      shape_input = i;
+      break;
+    }
+  }
+  if (shape_input < 0) {
+    VLOG(3) << "No input of the elementwise ops is of the shape of their "
+               "results, skip fusing them.";
+    return false;
+  }
+
+  std::vector<std::string> output_names;
+  std::vector<int> out_ids;
+  for (auto* n : output_vars) {
+    // The tiles of an output written in place would be read again as the
+    // input after they are overwritten.
+    if (input_names_set.count(n->Name())) {
+      VLOG(3) << "Output " << n->Name() << " of the elementwise ops is also "
+              << "their input, skip fusing them.";
+      return false;
+    }
+    output_names.push_back(n->Name());
+    out_ids.push_back(var_ids.at(n));
+  }
+
+  OpDesc op_desc;
+  op_desc.SetType("fusion_elementwise_chain");
+  op_desc.SetInput("Inputs", input_names);
+  op_desc.SetOutput("Outs", output_names);
+  op_desc.SetAttr("op_types", op_types);
+  op_desc.SetAttr("op_operands", operands);
+  op_desc.SetAttr("op_scales", scales);
+  op_desc.SetAttr("op_biases", biases);
+  op_desc.SetAttr("out_ids", out_ids);
+  op_desc.SetAttr("shape_input", shape_input);
+  op_desc.SetAttr(OpProtoAndCheckerMaker::OpRoleAttrName(),
+                  ExtractOpRole(subgraph));
+
+  Node* fusion_node = graph->CreateOpNode(&op_desc);
+  std::unordered_set<Node*> external_nodes;
+  for (auto* in : input_vars) {
+    IR_NODE_LINK_TO(in, fusion_node);
+    external_nodes.insert(in);
+  }
+  for (auto* out : output_vars) {
+    IR_NODE_LINK_TO(fusion_node, out);
+    external_nodes.insert(out);
+  }
+
+  std::unordered_set<const Node*> internal_nodes;
+  for (auto* n : subgraph->Nodes()) {
+    if (external_nodes.find(n) == external_nodes.end()) {
+      internal_nodes.insert(n);
+    }
+  }
+  GraphSafeRemoveNodes(graph, internal_nodes);
+  VLOG(3) << "Fuse " << op_types.size() << " elementwise ops into "
+          << "fusion_elementwise_chain.";
+  return true;
+}
+
+}  // namespace ir
+}  // namespace framework
+}  // namespace paddle
+
+REGISTER_PASS(elementwise_chain_fuse_pass,
+              paddle::framework::ir::ElementwiseChainFusePass);
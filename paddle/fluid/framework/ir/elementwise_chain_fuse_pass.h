@@ -0,0 +1,49 @@
+/* Copyright (c) 2022 PaddlePaddle Authors. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License. */
+
+#pragma once
+
+#include <string>
+
+#include "paddle/fluid/framework/ir/fuse_pass_base.h"
+#include "paddle/fluid/framework/ir/graph.h"
+
+namespace paddle {
+namespace framework {
+namespace ir {
+
+namespace fusion_group {
+class SubGraph;
+}  // namespace fusion_group
+
+/**
+ * Fuse the connected elementwise_add/sub/mul/div/max/min, relu, sigmoid,
+ * tanh, sqrt, square, exp and scale ops on float tensors of the same shape
+ * into a fusion_elementwise_chain op, which computes them in one pass over
+ * the data on the CPU. The Y of a binary op may also be broadcast along the
+ * trailing dimensions of its X.
+ */
+class ElementwiseChainFusePass : public FusePassBase {
+ protected:
+  void ApplyImpl(ir::Graph* graph) const override;
+
+  const std::string name_scope_{"elementwise_chain_fuse"};
+
+ private:
+  bool InsertFusionOp(Graph* graph, fusion_group::SubGraph* subgraph) const;
+};
+
+}  // namespace ir
+}  // namespace framework
+}  // namespace paddle
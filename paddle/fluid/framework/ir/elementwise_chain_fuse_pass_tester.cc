@@ -0,0 +1,105 @@
+/* Copyright (c) 2022 PaddlePaddle Authors. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License. */
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+
+#include "paddle/fluid/framework/ir/elementwise_chain_fuse_pass.h"
+#include "paddle/fluid/framework/ir/pass_tester_helper.h"
+
+namespace paddle {
+namespace framework {
+namespace ir {
+
+std::unique_ptr<Graph> ApplyPass(const ProgramDesc& program) {
+  std::unique_ptr<Graph> graph(new Graph(program));
+  auto pass = PassRegistry::Instance().Get("elementwise_chain_fuse_pass");
+  VLOG(3) << DebugString(graph);
+  graph.reset(pass->Apply(graph.release()));
+  VLOG(3) << DebugString(graph);
+  return graph;
+}
+
+TEST(ElementwiseChainFusePass, chain) {
+  // inputs                     operator            output
+  // --------------------------------------------------------
+  // (x, y)                     elementwise_mul  -> tmp_0
+  // (tmp_0, b)                 elementwise_add  -> tmp_1
+  // tmp_1                      relu             -> tmp_2
+  // tmp_2                      scale            -> tmp_3
+  // (tmp_1, w)                 mul              -> tmp_4
+  //
+  // b is broadcast along the last dimension, tmp_1 is used by mul.
+  Layers layers;
+  std::vector<int64_t> shape = {-1, 32};
+  auto* x = layers.data("x", shape);
+  auto* y = layers.data("y", shape);
+  auto* b = layers.data("b", {32}, true);
+  auto* w = layers.data("w", {32, 16}, true);
+  auto* tmp_0 = layers.elementwise_mul(x, y);
+  auto* tmp_1 = layers.elementwise_add(tmp_0, b);
+  auto* tmp_2 = layers.relu(tmp_1);
+  auto* tmp_3 = layers.scale(tmp_2, 2.0f, 0.5f, false);
+  layers.mul(tmp_1, w);
+  for (auto* var : {tmp_0, tmp_1, tmp_2, tmp_3}) {
+    var->SetShape(shape);
+  }
+
+  auto graph = ApplyPass(layers.main_program());
+  EXPECT_EQ(GetNumOpNodes(graph, "elementwise_mul"), 0);
+  EXPECT_EQ(GetNumOpNodes(graph, "elementwise_add"), 0);
+  EXPECT_EQ(GetNumOpNodes(graph, "relu"), 0);
+  EXPECT_EQ(GetNumOpNodes(graph, "scale"), 0);
+  EXPECT_EQ(GetNumOpNodes(graph, "mul"), 1);
+
+  auto fused_nodes = GetOpNodes(graph, "fusion_elementwise_chain");
+  ASSERT_EQ(fused_nodes.size(), 1UL);
+  auto* op = fused_nodes[0]->Op();
+  EXPECT_EQ(op->Input("Inputs").size(), 3UL);
+  // tmp_1 is used by mul and tmp_3 by nothing, tmp_0 and tmp_2 are removed.
+  std::vector<std::string> outs = op->Output("Outs");
+  std::sort(outs.begin(), outs.end());
+  EXPECT_EQ(outs, std::vector<std::string>({tmp_1->Name(), tmp_3->Name()}));
+  // scale(x + bias) is computed as scale * x + scale * bias.
+  auto biases = PADDLE_GET_CONST(std::vector<float>, op->GetAttr("op_biases"));
+  EXPECT_FLOAT_EQ(biases.back(), 1.0f);
+}
+
+TEST(ElementwiseChainFusePass, unsupported) {
+  // The broadcast of y along the first dimension and the int64 tensors are
+  // not supported, leaving single ops that are not fused.
+  Layers layers;
+  auto* x = layers.data("x", {8, 32});
+  auto* y = layers.data("y", {8, 1});
+  auto* tmp_0 = layers.elementwise_add(x, y, nullptr, 0);
+  auto* tmp_1 = layers.relu(tmp_0);
+  auto* i = layers.data("i", {8, 32}, false, proto::VarType::INT64);
+  auto* tmp_2 = layers.relu(i);
+  tmp_0->SetShape({8, 32});
+  tmp_1->SetShape({8, 32});
+  tmp_2->SetShape({8, 32});
+  tmp_2->SetDataType(proto::VarType::INT64);
+
+  auto graph = ApplyPass(layers.main_program());
+  EXPECT_EQ(GetNumOpNodes(graph, "fusion_elementwise_chain"), 0);
+  EXPECT_EQ(GetNumOpNodes(graph, "elementwise_add"), 1);
+  EXPECT_EQ(GetNumOpNodes(graph, "relu"), 2);
+}
+
+}  // namespace ir
+}  // namespace framework
+}  // namespace paddle
+
+USE_PASS(elementwise_chain_fuse_pass);
@@ -14,12 +14,23 @@
 
 #include "paddle/fluid/framework/ir/graph_pattern_detector.h"
 
+#include <exception>
+#include <thread>
+#include <tuple>
+
 #include "paddle/fluid/framework/ir/graph_traits.h"
 #include "paddle/fluid/framework/ir/graph_viz_pass.h"
 #include "paddle/fluid/framework/operator.h"
 #include "paddle/fluid/platform/enforce.h"
 #include "paddle/fluid/string/pretty_log.h"
 
+PADDLE_DEFINE_EXPORTED_int32(
+    graph_pattern_detector_num_threads,
+    1,
+    "The number of threads the GraphPatternDetector tells the candidate "
+    "nodes of a PDNode on, when there are many. The tellers of all the "
+    "patterns run must then be thread safe.");
+
 namespace paddle {
 namespace framework {
 namespace ir {
@@ -107,16 +118,114 @@ void GraphPatternDetector::operator()(Graph *graph,
   }
 }
 
+namespace {
+
+// The candidates told on a thread at least, fewer are told serially.
+constexpr size_t kMinNodesPerThread = 1024;
+
+// Whether pdnode tells each node, on up to
+// FLAGS_graph_pattern_detector_num_threads threads.
+std::vector<char> TellNodes(const PDNode &pdnode,
+                            const std::vector<Node *> &nodes) {
+  std::vector<char> hits(nodes.size(), 0);
+  auto tell = [&pdnode, &nodes, &hits](size_t begin, size_t end) {
+    for (size_t i = begin; i < end; ++i) {
+      hits[i] = pdnode.Tell(nodes[i]);
+    }
+  };
+  size_t num_threads = std::min<size_t>(
+      std::max(FLAGS_graph_pattern_detector_num_threads, 1),
+      nodes.size() / kMinNodesPerThread);
+  if (num_threads <= 1) {
+    tell(0, nodes.size());
+    return hits;
+  }
+  size_t chunk = (nodes.size() + num_threads - 1) / num_threads;
+  std::vector<std::exception_ptr> errors(num_threads);
+  auto run = [&tell, &errors, &nodes, chunk](size_t t) {
+    try {
+      tell(std::min(t * chunk, nodes.size()),
+           std::min((t + 1) * chunk, nodes.size()));
+    } catch (...) {
+      errors[t] = std::current_exception();
+    }
+  };
+  std::vector<std::thread> threads;
+  for (size_t t = 1; t < num_threads; ++t) {
+    threads.emplace_back(run, t);
+  }
+  run(0);
+  for (auto &thread : threads) {
+    thread.join();
+  }
+  for (auto &error : errors) {
+    if (error) std::rethrow_exception(error);
+  }
+  return hits;
+}
+
+}  // namespace
+
+std::vector<Node *> GraphPatternDetector::CandidateNodes(
+    const PDNode &pdnode,
+    const std::vector<Node *> &nodes,
+    const std::unordered_map<std::string, std::vector<Node *>> &ops_by_type) {
+  // A teller replaces the asserts.
+  if (pdnode.teller_ || pdnode.candidates_ == PDNode::Candidates::kAll) {
+    return nodes;
+  }
+  std::vector<Node *> candidates;
+  for (const auto &op_type : pdnode.candidate_op_types_) {
+    auto it = ops_by_type.find(op_type);
+    if (it == ops_by_type.end()) continue;
+    for (Node *op : it->second) {
+      switch (pdnode.candidates_) {
+        case PDNode::Candidates::kOps:
+          candidates.push_back(op);
+          break;
+        case PDNode::Candidates::kOpInputs:
+          candidates.insert(
+              candidates.end(), op->inputs.begin(), op->inputs.end());
+          break;
+        default:
+          candidates.insert(
+              candidates.end(), op->outputs.begin(), op->outputs.end());
+          break;
+      }
+    }
+  }
+  std::sort(candidates.begin(),
+            candidates.end(),
+            [](Node *a, Node *b) { return a->id() < b->id(); });
+  candidates.erase(std::unique(candidates.begin(), candidates.end()),
+                   candidates.end());
+  return candidates;
+}
+
 bool GraphPatternDetector::MarkPDNodesInGraph(const ir::Graph &graph) {
   VLOG(3) << "mark pdnodes in graph";
   if (graph.Nodes().empty()) return false;
 
-  for (auto &node : GraphTraits::DFS(graph)) {
-    for (const auto &pdnode : pattern_.nodes()) {
-      if (pdnode->Tell(&node)) {
-        VLOG(4) << "Node " << node.Name() << " marked as " << pdnode->name();
-        pdnodes2nodes_[pdnode.get()].insert(&node);
-      }
+  // The ops are indexed by their types, so that the PDNodes asserting the
+  // type of an op, or of the ops a var links to, only tell the nodes around
+  // the ops of this type. The index is built again for each pattern, the
+  // passes run before rewrote the graph.
+  std::vector<Node *> nodes(graph.Nodes().begin(), graph.Nodes().end());
+  std::unordered_map<std::string, std::vector<Node *>> ops_by_type;
+  for (Node *node : nodes) {
+    if (node->IsOp() && node->Op()) {
+      ops_by_type[node->Op()->Type()].push_back(node);
+    }
+  }
+  for (const auto &pdnode : pattern_.nodes()) {
+    std::vector<Node *> candidates =
+        CandidateNodes(*pdnode, nodes, ops_by_type);
+    std::vector<char> hits = TellNodes(*pdnode, candidates);
+    for (size_t i = 0; i < candidates.size(); ++i) {
+      if (!hits[i]) continue;
+      VLOG(4) << "Node " << candidates[i]->Name() << " marked as "
+              << pdnode->name();
+      pdnodes2nodes_[pdnode.get()].insert(candidates[i]);
     }
   }
   // Check to early stop if some PDNode can't find matched Node.
@@ -190,16 +299,6 @@ struct HitGroup {
   std::set<Node *> nodes_;
 };
 
-// Tell whether Node a links to b.
-bool IsNodesLink(Node *a, Node *b) {
-  for (auto *node : a->outputs) {
-    if (b == node) {
-      return true;
-    }
-  }
-  return false;
-}
-
 std::vector<GraphPatternDetector::subgraph_t>
 GraphPatternDetector::DetectPatterns() {
   // Init empty subgraphs.
@@ -229,26 +328,62 @@ GraphPatternDetector::DetectPatterns() {
     auto &cur_groups = bi_records[1 - (step++ % 2)];
     cur_groups.clear();
     if (pre_groups.empty()) break;
-    // source -> target
-    for (Node *source : pdnodes2nodes_[edge.first]) {
-      for (Node *target : pdnodes2nodes_[edge.second]) {
-        VLOG(8) << "check " << source->id() << " -- " << target->id();
-        // TODO(Superjomn) add some prune strategies.
-        for (const auto &group : pre_groups) {
-          if (IsNodesLink(source, target)) {
-            HitGroup new_group = group;
-            bool flag = new_group.Match(source, edge.first) &&
-                        new_group.Match(target, edge.second);
-            if (flag) {
-              new_group.Register(source, edge.first);
-              new_group.Register(target, edge.second);
-              cur_groups.push_back(new_group);
-              // TODO(Superjomn) need to unique
-            }
-          }
+    // source -> target. Rather than checking every marked source and target
+    // for each group, the links of the nodes a group bound, or else of the
+    // marked sources, are walked. The hits are then ordered by the source,
+    // the target and the group, as checking them all would.
+    auto &sources = pdnodes2nodes_[edge.first];
+    auto &targets = pdnodes2nodes_[edge.second];
+    std::vector<std::tuple<Node *, Node *, size_t>> hits;
+    auto add_source = [&](Node *source, size_t k) {
+      for (Node *target : source->outputs) {
+        if (targets.count(target)) hits.emplace_back(source, target, k);
+      }
+    };
+    for (size_t k = 0; k < pre_groups.size(); ++k) {
+      const auto &roles = pre_groups[k].roles;
+      auto source_it = roles.find(edge.first);
+      auto target_it = roles.find(edge.second);
+      if (source_it != roles.end()) {
+        if (sources.count(source_it->second)) add_source(source_it->second, k);
+      } else if (target_it != roles.end()) {
+        Node *target = target_it->second;
+        if (!targets.count(target)) continue;
+        for (Node *source : target->inputs) {
+          if (sources.count(source)) hits.emplace_back(source, target, k);
+        }
+      } else {
+        for (Node *source : sources) {
+          add_source(source, k);
         }
       }
     }
+    std::sort(hits.begin(),
+              hits.end(),
+              [](const std::tuple<Node *, Node *, size_t> &a,
+                 const std::tuple<Node *, Node *, size_t> &b) {
+                return std::make_tuple(std::get<0>(a)->id(),
+                                       std::get<1>(a)->id(),
+                                       std::get<2>(a)) <
+                       std::make_tuple(std::get<0>(b)->id(),
+                                       std::get<1>(b)->id(),
+                                       std::get<2>(b));
+              });
+    hits.erase(std::unique(hits.begin(), hits.end()), hits.end());
+    for (const auto &hit : hits) {
+      Node *source = std::get<0>(hit);
+      Node *target = std::get<1>(hit);
+      VLOG(8) << "check " << source->id() << " -- " << target->id();
+      HitGroup new_group = pre_groups[std::get<2>(hit)];
+      bool flag = new_group.Match(source, edge.first) &&
+                  new_group.Match(target, edge.second);
+      if (flag) {
+        new_group.Register(source, edge.first);
+        new_group.Register(target, edge.second);
+        cur_groups.push_back(new_group);
+        // TODO(Superjomn) need to unique
+      }
+    }
     VLOG(3) << "step " << step << " get records: " << cur_groups.size();
     for (auto &group : cur_groups) {
       for (auto &item : group.roles) {
@@ -409,12 +544,21 @@ PDNode &PDNode::LinksFrom(const std::vector<PDNode *> &others) {
   return *this;
 }
 
+void PDNode::SetCandidates(Candidates candidates,
+                           const std::unordered_set<std::string> &op_types) {
+  // Asserts only narrow the nodes, the first one is enough.
+  if (candidates_ != Candidates::kAll) return;
+  candidates_ = candidates;
+  candidate_op_types_ = op_types;
+}
+
 PDNode *PDNode::assert_is_op() {
   asserts_.emplace_back([](Node *x) { return x && x->IsOp(); });
   return this;
 }
 
 PDNode *PDNode::assert_is_op(const std::string &op_type) {
+  SetCandidates(Candidates::kOps, {op_type});
   asserts_.emplace_back([op_type](Node *x) {
     return x && x->IsOp() && x->Op()->Type() == op_type;
   });
@@ -476,6 +620,7 @@ PDNode *PDNode::assert_is_op_nth_input(const std::string &op_type,
 PDNode *PDNode::assert_is_op_nth_output(const std::string &op_type,
                                         const std::string &argument,
                                         int nth) {
+  SetCandidates(Candidates::kOpOutputs, {op_type});
   assert_is_var();
   asserts_.emplace_back([=](Node *x) {
     for (auto *op : x->inputs) {
@@ -489,6 +634,7 @@ PDNode *PDNode::assert_is_op_nth_output(const std::string &op_type,
 }
 
 PDNode *PDNode::assert_is_only_input_of_op(const std::string &op_type) {
+  SetCandidates(Candidates::kOpInputs, {op_type});
   assert_is_var();
   asserts_.emplace_back([=](Node *x) {
     for (auto *op : x->outputs) {
@@ -503,6 +649,7 @@ PDNode *PDNode::assert_is_only_input_of_op(const std::string &op_type) {
 }
 
 PDNode *PDNode::assert_is_only_output_of_op(const std::string &op_type) {
+  SetCandidates(Candidates::kOpOutputs, {op_type});
   assert_is_var();
   asserts_.emplace_back([=](Node *x) {
     for (auto *op : x->inputs) {
@@ -517,6 +664,7 @@ PDNode *PDNode::assert_is_only_output_of_op(const std::string &op_type) {
 }
 
 PDNode *PDNode::assert_is_op_output(const std::string &op_type) {
+  SetCandidates(Candidates::kOpOutputs, {op_type});
   assert_is_var();
   asserts_.emplace_back([=](Node *x) {
     for (auto *op : x->inputs) {
@@ -537,6 +685,7 @@ PDNode *PDNode::assert_is_op_output(const std::string &op_type,
 }
 
 PDNode *PDNode::assert_is_op_input(const std::string &op_type) {
+  SetCandidates(Candidates::kOpInputs, {op_type});
   assert_is_var();
   asserts_.emplace_back([=](Node *x) {
     for (auto *op : x->outputs) {
@@ -594,6 +743,7 @@ PDNode *PDNode::assert_more(PDNode::teller_t &&teller) {
 }
 
 PDNode *PDNode::assert_is_ops(const std::unordered_set<std::string> &op_types) {
+  SetCandidates(Candidates::kOps, op_types);
   asserts_.emplace_back([op_types](Node *x) {
     return x && x->IsOp() && op_types.count(x->Op()->Type());
   });
@@ -621,6 +771,7 @@ PDNode *PDNode::assert_is_ops_nth_output(
     const std::unordered_set<std::string> &op_types,
     const std::string &argument,
     int nth) {
+  SetCandidates(Candidates::kOpOutputs, op_types);
   assert_is_var();
   asserts_.emplace_back([=](Node *x) {
     for (auto *op : x->inputs) {
@@ -634,6 +785,7 @@ PDNode *PDNode::assert_is_ops_nth_output(
 }
 PDNode *PDNode::assert_is_ops_output(
     const std::unordered_set<std::string> &op_types) {
+  SetCandidates(Candidates::kOpOutputs, op_types);
   assert_is_var();
   asserts_.emplace_back([=](Node *x) {
     for (auto *op : x->inputs) {
@@ -656,6 +808,7 @@ PDNode *PDNode::assert_is_ops_output(
 
 PDNode *PDNode::assert_is_ops_input(
     const std::unordered_set<std::string> &op_types) {
+  SetCandidates(Candidates::kOpInputs, op_types);
   assert_is_var();
   asserts_.emplace_back([=](Node *x) {
     for (auto *op : x->outputs) {
@@ -678,6 +831,7 @@ PDNode *PDNode::assert_is_ops_input(
 
 PDNode *PDNode::assert_is_only_input_of_ops(
     const std::unordered_set<std::string> &op_types) {
+  SetCandidates(Candidates::kOpInputs, op_types);
   assert_is_var();
   asserts_.emplace_back([=](Node *x) {
     for (auto *op : x->outputs) {
@@ -693,6 +847,7 @@ PDNode *PDNode::assert_is_only_input_of_ops(
 
 PDNode *PDNode::assert_is_only_output_of_ops(
     const std::unordered_set<std::string> &op_types) {
+  SetCandidates(Candidates::kOpOutputs, op_types);
   assert_is_var();
   asserts_.emplace_back([=](Node *x) {
     for (auto *op : x->inputs) {
@@ -188,7 +188,14 @@ struct PDNode {
 
   PDNode(PDNode&& other) = default;
 
+  // Which nodes of a graph can match, as told by the first assert on the type
+  // of this op, or of the ops this var links to.
+  enum class Candidates { kAll, kOps, kOpInputs, kOpOutputs };
+  void SetCandidates(Candidates candidates,
+                     const std::unordered_set<std::string>& op_types);
+
   friend class PDPattern;
+  friend class GraphPatternDetector;
 
   // Will removed latter.
   teller_t teller_;
@@ -197,6 +204,8 @@ struct PDNode {
   std::string name_;
   Type type_;
   Role role_{Role::kUnknown};
+  Candidates candidates_{Candidates::kAll};
+  std::unordered_set<std::string> candidate_op_types_;
 };
 
 /*
@@ -338,7 +347,15 @@ class GraphPatternDetector {
   // Mark the nodes that fits the pattern.
   bool MarkPDNodesInGraph(const ir::Graph& graph);
 
-  // Detect all the pattern and output the hit records.
+  // The nodes pdnode may match: the ops of the types it asserted, or the
+  // vars linking to them, all the nodes if it asserted no op type.
+  static std::vector<Node*> CandidateNodes(
+      const PDNode& pdnode,
+      const std::vector<Node*>& nodes,
+      const std::unordered_map<std::string, std::vector<Node*>>& ops_by_type);
+
+  // Detect all the pattern and output the hit records. Each edge extends the
+  // records along the links of the nodes they already bound.
   std::vector<subgraph_t> DetectPatterns();
 
   // Remove duplicate patterns.
@@ -361,6 +378,7 @@ class GraphPatternDetector {
 #ifdef PADDLE_WITH_TESTING
   FRIEND_TEST(GraphPatternDetecter, MarkPDNodesInGraph);
   FRIEND_TEST(GraphPatternDetecter, DetectPatterns);
+  FRIEND_TEST(GraphPatternDetecter, OpTypeCandidates);
 #endif
 
  private:
@@ -15,6 +15,9 @@
 #include <gtest/gtest.h>
 
 #include "paddle/fluid/framework/ir/graph_pattern_detector.h"
+#include "paddle/fluid/framework/scope_guard.h"
+
+DECLARE_int32(graph_pattern_detector_num_threads);
 
 namespace paddle {
 namespace framework {
@@ -207,6 +210,70 @@ TEST(GraphPatternDetector, IntermediateCheck) {
   ASSERT_EQ(count, 1);
 }
 
+TEST(GraphPatternDetecter, OpTypeCandidates) {
+  // x -> mul -> y -> relu -> z, repeated enough to tell them on threads.
+  const size_t n = 4096;
+  ProgramDesc program;
+  auto* block = program.MutableBlock(0);
+  for (size_t i = 0; i < n; ++i) {
+    std::string x = "x" + std::to_string(i);
+    std::string y = "y" + std::to_string(i);
+    std::string z = "z" + std::to_string(i);
+    block->Var(x);
+    block->Var(y);
+    block->Var(z);
+    auto* mul = block->AppendOp();
+    mul->SetType("mul");
+    mul->SetInput("X", {x});
+    mul->SetOutput("Out", {y});
+    auto* relu = block->AppendOp();
+    relu->SetType("relu");
+    relu->SetInput("X", {y});
+    relu->SetOutput("Out", {z});
+  }
+  Graph graph(program);
+
+  int saved_num_threads = FLAGS_graph_pattern_detector_num_threads;
+  DEFINE_PADDLE_SCOPE_GUARD([saved_num_threads] {
+    FLAGS_graph_pattern_detector_num_threads = saved_num_threads;
+  });
+  for (int num_threads : {1, 4}) {
+    FLAGS_graph_pattern_detector_num_threads = num_threads;
+    GraphPatternDetector detector;
+    auto* mul = detector.mutable_pattern()->NewNode("mul")->assert_is_op("mul");
+    auto* y = detector.mutable_pattern()
+                  ->NewNode("y")
+                  ->assert_is_op_output("mul", "Out")
+                  ->assert_is_op_input("relu", "X")
+                  ->AsIntermediate();
+    auto* relu =
+        detector.mutable_pattern()->NewNode("relu")->assert_is_op("relu");
+    y->LinksFrom({mul}).LinksTo({relu});
+
+    // Only the nodes around the ops of the asserted types are candidates.
+    std::vector<Node*> nodes(graph.Nodes().begin(), graph.Nodes().end());
+    std::unordered_map<std::string, std::vector<Node*>> ops_by_type;
+    for (Node* node : nodes) {
+      if (node->IsOp()) ops_by_type[node->Op()->Type()].push_back(node);
+    }
+    EXPECT_EQ(GraphPatternDetector::CandidateNodes(*mul, nodes, ops_by_type)
+                  .size(),
+              n);
+    EXPECT_EQ(
+        GraphPatternDetector::CandidateNodes(*y, nodes, ops_by_type).size(),
+        n);
+
+    size_t count = 0;
+    detector(&graph,
+             [&](const GraphPatternDetector::subgraph_t& g, Graph* graph) {
+               EXPECT_EQ(g.at(mul)->outputs[0], g.at(y));
+               EXPECT_EQ(g.at(relu)->inputs[0], g.at(y));
+               ++count;
+             });
+    EXPECT_EQ(count, n);
+  }
+}
+
 }  // namespace ir
 }  // namespace framework
 }  // namespace paddle
@@ -48,11 +48,22 @@ void NaiveExecutor::Run() {
   platform::RegisterModelLayout(ops_, place_);
 #endif
   platform::ScopedFlushDenormal flush;
+  auto table = scope_->slot_table();
+  if (table == nullptr || table->map() != var_slot_map_.get()) {
+    scope_->SetSlotTable(
+        std::make_shared<VarSlotTable>(var_slot_map_, *scope_));
+  }
   for (auto &op : ops_) {
     VLOG(4) << std::this_thread::get_id() << " run "
             << op->DebugStringEx(scope_) << " on scope " << scope_;
     op->SetIsCalledByExecutor(false);
+    for (auto &func : input_hookfuncs_) {
+      func(op.get());
+    }
     op->Run(*scope_, place_);
+    for (auto &func : hookfuncs_) {
+      func(op.get());
+    }
   }
 }
 
@@ -112,6 +123,7 @@ void NaiveExecutor::CreateOps(const ProgramDesc &desc,
       continue;
     }
     ops_.emplace_back(OpRegistry::CreateOp(*op_desc));
+    ops_.back()->CompileVarSlots(var_slot_map_.get());
   }
 }
 
@@ -137,6 +149,18 @@ void NaiveExecutor::CleanFeedFetchOps() {
   ops_.swap(ops);
 }
 
+void NaiveExecutor::RegisterOutputHook(const HookFunc &hookfunc) {
+  hookfuncs_.push_back(hookfunc);
+}
+
+void NaiveExecutor::ClearOutputHooks() { hookfuncs_.clear(); }
+
+void NaiveExecutor::RegisterInputHook(const HookFunc &hookfunc) {
+  input_hookfuncs_.push_back(hookfunc);
+}
+
+void NaiveExecutor::ClearInputHooks() { input_hookfuncs_.clear(); }
+
 NaiveExecutor::~NaiveExecutor() {
 #ifdef PADDLE_WITH_MKLDNN
   // Clear mkl-dnn cache,
@@ -14,6 +14,7 @@
 
 #pragma once
 
+#include <functional>
 #include <memory>
 #include <string>
 #include <vector>
@@ -21,6 +22,7 @@
 #include "paddle/fluid/framework/operator.h"
 #include "paddle/fluid/framework/program_desc.h"
 #include "paddle/fluid/framework/scope.h"
+#include "paddle/fluid/framework/var_slot_table.h"
 #include "paddle/fluid/platform/device_context.h"
 #include "paddle/fluid/platform/place.h"
 
@@ -40,6 +42,8 @@ class Scope;
 
 class NaiveExecutor {
  public:
+  using HookFunc = std::function<void(OperatorBase*)>;
+
   explicit NaiveExecutor(const platform::Place& place) : place_(place) {}
 
   ~NaiveExecutor();
@@ -72,6 +76,18 @@ class NaiveExecutor {
 
   void ResetTrtOps(int num);
 
+  // Register a function called after each operator runs, e.g. to observe the
+  // intermediate tensors before they are reused by the memory optimization.
+  void RegisterOutputHook(const HookFunc& hookfunc);
+
+  void ClearOutputHooks();
+
+  // Register a function called before each operator runs, e.g. to time the
+  // operators together with the output hooks.
+  void RegisterInputHook(const HookFunc& hookfunc);
+
+  void ClearInputHooks();
+
  protected:
   void CreateOps(const ProgramDesc& desc,
                  int block_id,
@@ -82,6 +98,12 @@ class NaiveExecutor {
   // Catch the required resource to avoid recreate.
   std::vector<std::unique_ptr<OperatorBase>> ops_;
   Scope* scope_;
+  // The variables of ops_, resolved in scope_ on the first run and then each
+  // time scope_ changes.
+  std::shared_ptr<VarSlotMap> var_slot_map_{std::make_shared<VarSlotMap>()};
+
+  std::vector<HookFunc> hookfuncs_;
+  std::vector<HookFunc> input_hookfuncs_;
 };
 
 }  // namespace framework
@@ -14,6 +14,7 @@
 
 #include "paddle/fluid/framework/new_executor/executor_statistics.h"
 
+#include <algorithm>
 #include <fstream>
 #include <functional>
 #include <map>
@@ -34,6 +35,11 @@ PADDLE_DEFINE_EXPORTED_string(static_executor_perfstat_filepath,
                               "FLAGS_static_executor_perfstat_filepath "
                               "enables performance statistics for the static "
                               "graph executor.");
+PADDLE_DEFINE_EXPORTED_string(static_executor_timeline_filepath,
+                              "",
+                              "FLAGS_static_executor_timeline_filepath "
+                              "enables the timeline of the instructions of "
+                              "the static graph executor.");
 
 namespace paddle {
 namespace framework {
@@ -631,5 +637,52 @@ void StaticGraphExecutorPerfStatistics(
   }
 }
 
+bool IsStaticGraphExecutorTimelineEnabled() {
+  return !FLAGS_static_executor_timeline_filepath.empty();
+}
+
+void StaticGraphExecutorTimeline(
+    const std::vector<InstructionTimeline>& timeline) {
+  if (timeline.empty()) {
+    return;
+  }
+  const auto& filepath = FLAGS_static_executor_timeline_filepath;
+  std::ofstream ofs;
+  ofs.open(filepath, std::ofstream::out | std::ofstream::trunc);
+  if (!ofs) {
+    LOG(WARNING) << "Unable to open file " << filepath << " for writing data.";
+    return;
+  }
+  uint64_t begin_ns = timeline[0].ready_ns;
+  for (const auto& item : timeline) {
+    begin_ns = std::min(begin_ns, item.ready_ns);
+  }
+  ofs << "[";
+  for (size_t idx = 0; idx < timeline.size(); ++idx) {
+    const auto& item = timeline[idx];
+    ofs << platform::string_format(std::string(R"JSON(
+  {
+    "instruction" : %zu,
+    "op type" : "%s",
+    "thread" : %llu,
+    "ready time(ns)" : %llu,
+    "wait time(ns)" : %llu,
+    "execution time(ns)" : %llu
+  },)JSON"),
+                                   idx,
+                                   item.op_type.c_str(),
+                                   item.thread_id,
+                                   item.ready_ns - begin_ns,
+                                   item.start_ns - item.ready_ns,
+                                   item.end_ns - item.start_ns);
+  }
+  ofs.seekp(-1, std::ios_base::end);
+  ofs << "]";
+  if (ofs) {
+    VLOG(4) << "writing the executor timeline to " << filepath;
+  }
+  ofs.close();
+}
+
 }  // namespace framework
 }  // namespace paddle
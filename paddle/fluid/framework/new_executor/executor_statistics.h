@@ -14,7 +14,10 @@
 
 #pragma once
 
+#include <cstdint>
 #include <memory>
+#include <string>
+#include <vector>
 
 #include "paddle/fluid/platform/profiler/event_node.h"
 
@@ -24,5 +27,22 @@ namespace framework {
 void StaticGraphExecutorPerfStatistics(
     std::shared_ptr<const platform::NodeTrees> profiling_data);
 
+// The times of an instruction in a run of the InterpreterCore: when it got
+// ready, when it started and ended running, and the thread it ran on.
+struct InstructionTimeline {
+  std::string op_type;
+  uint64_t ready_ns = 0;
+  uint64_t start_ns = 0;
+  uint64_t end_ns = 0;
+  uint64_t thread_id = 0;
+};
+
+bool IsStaticGraphExecutorTimelineEnabled();
+
+// Writes the wait and execution times of the instructions of the last run
+// to FLAGS_static_executor_timeline_filepath.
+void StaticGraphExecutorTimeline(
+    const std::vector<InstructionTimeline>& timeline);
+
 }  // namespace framework
 }  // namespace paddle
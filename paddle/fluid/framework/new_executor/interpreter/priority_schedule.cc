@@ -0,0 +1,86 @@
+// Copyright (c) 2022 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "paddle/fluid/framework/new_executor/interpreter/priority_schedule.h"
+
+#include <algorithm>
+
+#include "paddle/fluid/platform/enforce.h"
+
+namespace paddle {
+namespace framework {
+namespace interpreter {
+
+std::vector<double> ComputeUpwardRank(
+    const std::vector<std::vector<size_t>>& downstream,
+    const std::vector<double>& costs) {
+  size_t op_num = downstream.size();
+  PADDLE_ENFORCE_EQ(
+      costs.size(),
+      op_num,
+      platform::errors::InvalidArgument(
+          "The number of the costs (%d) must be equal to the number of the "
+          "instructions (%d).",
+          costs.size(),
+          op_num));
+
+  // Visit the instructions in topological order, and rank them in the
+  // reverse order, after all their downstream instructions.
+  std::vector<size_t> upstream_count(op_num, 0);
+  for (auto& ids : downstream) {
+    for (size_t id : ids) {
+      ++upstream_count[id];
+    }
+  }
+  std::vector<size_t> order;
+  order.reserve(op_num);
+  for (size_t i = 0; i < op_num; ++i) {
+    if (upstream_count[i] == 0) {
+      order.push_back(i);
+    }
+  }
+  for (size_t k = 0; k < order.size(); ++k) {
+    for (size_t id : downstream[order[k]]) {
+      if (--upstream_count[id] == 0) {
+        order.push_back(id);
+      }
+    }
+  }
+  PADDLE_ENFORCE_EQ(order.size(),
+                    op_num,
+                    platform::errors::PreconditionNotMet(
+                        "The dependences of the instructions have a cycle."));
+
+  std::vector<double> rank(op_num, 0.);
+  for (auto it = order.rbegin(); it != order.rend(); ++it) {
+    double max_downstream = 0.;
+    for (size_t id : downstream[*it]) {
+      max_downstream = std::max(max_downstream, rank[id]);
+    }
+    rank[*it] = costs[*it] + max_downstream;
+  }
+  return rank;
+}
+
+void SortByPriority(const std::vector<double>& priority,
+                    std::vector<size_t>* ids) {
+  std::stable_sort(
+      ids->begin(), ids->end(), [&priority](size_t a, size_t b) {
+        return priority[a] > priority[b];
+      });
+}
+
+}  // namespace interpreter
+}  // namespace framework
+}  // namespace paddle
@@ -0,0 +1,70 @@
+// Copyright (c) 2022 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// This file provides the critical path scheduling of the Interpretercore.
+// Each instruction is given the upward rank, the estimated time of the
+// longest path from its start to the end of the program, and of the ready
+// instructions, the ones of higher rank are run first, so that the
+// instructions on the critical path are not delayed by the ones off it.
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <queue>
+#include <tuple>
+#include <vector>
+
+namespace paddle {
+namespace framework {
+namespace interpreter {
+
+// Returns the upward rank of each instruction: its cost plus the largest
+// upward rank of its downstream instructions.
+std::vector<double> ComputeUpwardRank(
+    const std::vector<std::vector<size_t>>& downstream,
+    const std::vector<double>& costs);
+
+// Sorts the instruction ids by descending priority, keeping the order of
+// the ones of equal priority.
+void SortByPriority(const std::vector<double>& priority,
+                    std::vector<size_t>* ids);
+
+// The ready instructions to be run by a thread. The one of the highest
+// priority is popped first, and the ones of equal priority in FIFO order.
+class ReadyInstructionQueue {
+ public:
+  explicit ReadyInstructionQueue(const std::vector<double>* priority)
+      : priority_(priority) {}
+
+  bool empty() const { return queue_.empty(); }
+
+  void push(size_t id) { queue_.emplace((*priority_)[id], --seq_, id); }
+
+  size_t pop() {
+    size_t id = std::get<2>(queue_.top());
+    queue_.pop();
+    return id;
+  }
+
+ private:
+  const std::vector<double>* priority_;  // not owned
+  // Decreasing, so that the earlier pushed of equal priority is greater.
+  int64_t seq_{0};
+  std::priority_queue<std::tuple<double, int64_t, size_t>> queue_;
+};
+
+}  // namespace interpreter
+}  // namespace framework
+}  // namespace paddle
@@ -0,0 +1,59 @@
+// Copyright (c) 2022 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "paddle/fluid/framework/new_executor/interpreter/priority_schedule.h"
+
+#include <vector>
+
+#include "gtest/gtest.h"
+
+namespace paddle {
+namespace framework {
+namespace interpreter {
+
+TEST(PrioritySchedule, UpwardRank) {
+  // 0 -> 1 -> 3, 0 -> 2 -> 3, 4 alone, and 1 costs more than 2.
+  std::vector<std::vector<size_t>> downstream = {{1, 2}, {3}, {3}, {}, {}};
+  std::vector<double> costs = {1., 5., 2., 1., 3.};
+  auto rank = ComputeUpwardRank(downstream, costs);
+  std::vector<double> expected = {7., 6., 3., 1., 3.};
+  EXPECT_EQ(rank, expected);
+
+  std::vector<size_t> ids = {2, 4, 1, 3};
+  SortByPriority(rank, &ids);
+  std::vector<size_t> sorted = {1, 2, 4, 3};
+  EXPECT_EQ(ids, sorted);
+
+  downstream[3].push_back(0);
+  EXPECT_ANY_THROW(ComputeUpwardRank(downstream, costs));
+}
+
+TEST(PrioritySchedule, ReadyInstructionQueue) {
+  std::vector<double> priority = {1., 3., 1., 2., 1.};
+  ReadyInstructionQueue queue(&priority);
+  for (size_t id : {4, 0, 3, 2, 1}) {
+    queue.push(id);
+  }
+  std::vector<size_t> popped;
+  while (!queue.empty()) {
+    popped.push_back(queue.pop());
+  }
+  // The ones of equal priority are popped in FIFO order.
+  std::vector<size_t> expected = {1, 3, 4, 0, 2};
+  EXPECT_EQ(popped, expected);
+}
+
+}  // namespace interpreter
+}  // namespace framework
+}  // namespace paddle
@@ -0,0 +1,117 @@
+// Copyright (c) 2022 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "paddle/fluid/framework/new_executor/interpreter/static_memory_plan.h"
+
+#include <algorithm>
+
+namespace paddle {
+namespace framework {
+namespace interpreter {
+
+std::vector<int> AssignBufferSlots(
+    const std::vector<VarLifetime>& vars,
+    const std::vector<std::vector<bool>>& op_happens_before,
+    size_t* slot_num) {
+  std::vector<int> var_slot(vars.size(), -1);
+
+  // visit the vars in the order of their first writers
+  std::vector<size_t> order;
+  for (size_t i = 0; i < vars.size(); ++i) {
+    if (vars[i].planned && !vars[i].writers.empty()) {
+      order.push_back(i);
+    }
+  }
+  auto FirstWriter = [&vars](size_t var) {
+    return *std::min_element(vars[var].writers.begin(),
+                             vars[var].writers.end());
+  };
+  std::stable_sort(order.begin(), order.end(), [&](size_t a, size_t b) {
+    return FirstWriter(a) < FirstWriter(b);
+  });
+
+  auto EndsBefore = [&](size_t prev, size_t var) {
+    for (auto user : vars[prev].last_users) {
+      for (auto writer : vars[var].writers) {
+        if (!op_happens_before[user][writer]) {
+          return false;
+        }
+      }
+    }
+    return true;
+  };
+
+  // the last var and the largest size of each slot
+  std::vector<size_t> slot_last_var;
+  std::vector<size_t> slot_size;
+  for (auto var : order) {
+    int best = -1;
+    for (size_t slot = 0; slot < slot_last_var.size(); ++slot) {
+      if (!EndsBefore(slot_last_var[slot], var)) {
+        continue;
+      }
+      if (best == -1) {
+        best = static_cast<int>(slot);
+        continue;
+      }
+      bool fits = slot_size[slot] >= vars[var].size_hint;
+      bool best_fits = slot_size[best] >= vars[var].size_hint;
+      if (fits ? (!best_fits || slot_size[slot] < slot_size[best])
+               : (!best_fits && slot_size[slot] > slot_size[best])) {
+        best = static_cast<int>(slot);
+      }
+    }
+    if (best == -1) {
+      best = static_cast<int>(slot_last_var.size());
+      slot_last_var.push_back(var);
+      slot_size.push_back(vars[var].size_hint);
+    } else {
+      slot_last_var[best] = var;
+      slot_size[best] = std::max(slot_size[best], vars[var].size_hint);
+    }
+    var_slot[var] = best;
+  }
+  *slot_num = slot_last_var.size();
+  return var_slot;
+}
+
+void BufferSlots::Lend(int slot, phi::DenseTensor* tensor) {
+  auto& buffer = buffers_[slot];
+  if (tensor->Holder() == nullptr && buffer != nullptr &&
+      buffer.use_count() == 1) {
+    tensor->set_offset(0);
+    tensor->ResetHolder(buffer);
+  }
+}
+
+void BufferSlots::Keep(int slot, const phi::DenseTensor& tensor) {
+  auto& holder = tensor.Holder();
+  if (holder != nullptr && holder != buffers_[slot] &&
+      holder.use_count() == 1) {
+    buffers_[slot] = holder;
+  }
+}
+
+void BufferSlots::Return(int slot, phi::DenseTensor* tensor) {
+  auto holder = tensor->MoveMemoryHolder();
+  auto& buffer = buffers_[slot];
+  // held by the slot, the tensor and something else
+  if (holder != nullptr && holder == buffer && holder.use_count() > 2) {
+    buffer.reset();
+  }
+}
+
+}  // namespace interpreter
+}  // namespace framework
+}  // namespace paddle
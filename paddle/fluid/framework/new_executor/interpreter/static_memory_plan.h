@@ -0,0 +1,80 @@
+// Copyright (c) 2022 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// This file provides the static memory plan of the Interpretercore. Instead
+// of freeing the tensors at the end of their lifetimes and allocating them
+// again in the next step, the tensors are assigned ahead of time to buffer
+// slots shared by the tensors of disjoint lifetimes, and the buffers are
+// kept across steps, so that a program of stable shapes does no allocation
+// after its first steps.
+
+#pragma once
+
+#include <memory>
+#include <vector>
+
+#include "paddle/phi/core/allocator.h"
+#include "paddle/phi/core/dense_tensor.h"
+
+namespace paddle {
+namespace framework {
+namespace interpreter {
+
+// The lifetime of a var in a step: the ops writing it, and the last ops
+// using its buffer, after which it is freed.
+struct VarLifetime {
+  bool planned{false};
+  std::vector<size_t> writers;
+  std::vector<size_t> last_users;
+  size_t size_hint{0};  // bytes, estimated from the VarDesc
+};
+
+// Assigns the planned vars to buffer slots. A var may take the slot of
+// another var only if all the last users of the other var happen before
+// all the writers of the var. Of the slots it may take, a var takes the
+// smallest one large enough, or else the largest one. Returns the slot of
+// each var, or -1 for the vars not planned.
+std::vector<int> AssignBufferSlots(
+    const std::vector<VarLifetime>& vars,
+    const std::vector<std::vector<bool>>& op_happens_before,
+    size_t* slot_num);
+
+// The buffers of the slots, kept across steps.
+//
+// A buffer is lent to a tensor before its first writer runs, and taken
+// back after its last users. A buffer shared with any tensor but the one
+// it was lent to, as a kernel sharing its input with its output does, is
+// never lent again, so a buffer is only reused when nothing refers to it.
+class BufferSlots {
+ public:
+  explicit BufferSlots(size_t slot_num) : buffers_(slot_num) {}
+
+  // Lends the buffer of the slot to the tensor about to be written, if
+  // the tensor has no buffer and the slot has a free one.
+  void Lend(int slot, phi::DenseTensor* tensor);
+
+  // Keeps the buffer allocated by the writer of the tensor, if the slot
+  // has none or too small a one and the tensor is its only owner.
+  void Keep(int slot, const phi::DenseTensor& tensor);
+
+  // Takes the buffer back from the tensor at the end of its lifetime.
+  void Return(int slot, phi::DenseTensor* tensor);
+
+ private:
+  std::vector<std::shared_ptr<phi::Allocation>> buffers_;
+};
+
+}  // namespace interpreter
+}  // namespace framework
+}  // namespace paddle
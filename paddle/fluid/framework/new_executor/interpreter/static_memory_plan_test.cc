@@ -0,0 +1,110 @@
+// Copyright (c) 2022 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "paddle/fluid/framework/new_executor/interpreter/static_memory_plan.h"
+
+#include <memory>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+namespace paddle {
+namespace framework {
+namespace interpreter {
+
+// Returns the happens before relation of the ops of the edges.
+static std::vector<std::vector<bool>> HappensBefore(
+    size_t op_num, const std::vector<std::pair<size_t, size_t>>& edges) {
+  std::vector<std::vector<bool>> hb(op_num, std::vector<bool>(op_num));
+  for (auto& edge : edges) {
+    hb[edge.first][edge.second] = true;
+  }
+  for (size_t k = 0; k < op_num; ++k) {
+    for (size_t i = 0; i < op_num; ++i) {
+      for (size_t j = 0; j < op_num; ++j) {
+        hb[i][j] = hb[i][j] || (hb[i][k] && hb[k][j]);
+      }
+    }
+  }
+  return hb;
+}
+
+TEST(StaticMemoryPlan, AssignBufferSlots) {
+  // op0 -> op1 -> op3 -> op4 and op0 -> op2 -> op3, where op1 and op2 may
+  // run in parallel.
+  auto hb = HappensBefore(5, {{0, 1}, {0, 2}, {1, 3}, {2, 3}, {3, 4}});
+  std::vector<VarLifetime> vars(7);
+  // op0 -> op1, op2
+  vars[0] = {true, {0}, {1, 2}, 100};
+  // op1 -> op3 and op2 -> op3, written while var0 is alive
+  vars[1] = {true, {1}, {3}, 100};
+  vars[2] = {true, {2}, {3}, 400};
+  // op3 -> op4, after var0 only
+  vars[3] = {true, {3}, {4}, 300};
+  // not planned
+  vars[4] = {false, {4}, {4}, 100};
+  // written by op4, after var1 and var2
+  vars[5] = {true, {4}, {4}, 500};
+  vars[6] = {true, {4}, {4}, 50};
+
+  size_t slot_num = 0;
+  auto slots = AssignBufferSlots(vars, hb, &slot_num);
+  std::vector<int> expected = {0, 1, 2, 0, -1, 2, 1};
+  EXPECT_EQ(slots, expected);
+  EXPECT_EQ(slot_num, 3UL);
+}
+
+static std::shared_ptr<phi::Allocation> NewBuffer(std::vector<char>* data) {
+  return std::make_shared<phi::Allocation>(
+      data->data(), data->size(), phi::CPUPlace());
+}
+
+TEST(StaticMemoryPlan, BufferSlots) {
+  BufferSlots slots(1);
+  std::vector<char> data0(64), data1(64);
+  phi::DenseTensor a, b, c;
+
+  // The slot keeps the buffer the first tensor allocated, and lends it to
+  // the next one.
+  a.ResetHolder(NewBuffer(&data0));
+  slots.Keep(0, a);
+  slots.Return(0, &a);
+  EXPECT_EQ(a.Holder(), nullptr);
+  slots.Lend(0, &b);
+  ASSERT_NE(b.Holder(), nullptr);
+  EXPECT_EQ(b.Holder()->ptr(), data0.data());
+
+  // A lent buffer is not lent again.
+  slots.Lend(0, &c);
+  EXPECT_EQ(c.Holder(), nullptr);
+
+  // A buffer shared with another tensor is dropped by the slot.
+  c.ShareBufferWith(b);
+  slots.Return(0, &b);
+  slots.Lend(0, &a);
+  EXPECT_EQ(a.Holder(), nullptr);
+
+  // A new buffer is kept only if the tensor is its only owner.
+  a.ResetHolder(NewBuffer(&data1));
+  slots.Keep(0, c);
+  slots.Keep(0, a);
+  slots.Return(0, &a);
+  slots.Lend(0, &b);
+  ASSERT_NE(b.Holder(), nullptr);
+  EXPECT_EQ(b.Holder()->ptr(), data1.data());
+}
+
+}  // namespace interpreter
+}  // namespace framework
+}  // namespace paddle
@@ -14,8 +14,10 @@
 
 #include "paddle/fluid/framework/new_executor/interpretercore.h"
 
+#include <cstdlib>
 #include <unordered_set>
 
+#include "paddle/fluid/framework/data_type.h"
 #include "paddle/fluid/framework/details/nan_inf_utils.h"
 #include "paddle/fluid/framework/details/share_tensor_buffer_functor.h"
 #include "paddle/fluid/framework/new_executor/garbage_collector/event_garbage_collector.h"
@@ -38,6 +40,17 @@ PADDLE_DEFINE_EXPORTED_bool(new_executor_use_local_scope,
                             true,
                             "Use local_scope in new executor(especially used "
                             "in UT), can turn off for better performance");
+PADDLE_DEFINE_EXPORTED_bool(new_executor_use_priority_schedule,
+                            true,
+                            "Run the ready instructions of new executor on "
+                            "CPU in the order of the estimated time of their "
+                            "longest path to the end of the program");
+PADDLE_DEFINE_EXPORTED_bool(new_executor_use_static_memory_plan,
+                            false,
+                            "Assign the tensors of new executor on CPU to "
+                            "buffers reused across steps ahead of time, "
+                            "instead of freeing them by gc, for the programs "
+                            "of stable shapes");
 
 DECLARE_bool(check_nan_inf);
 DECLARE_bool(benchmark);
@@ -51,6 +64,9 @@ namespace framework {
 // NOTE(Aurelius84): Need a better strategy to determine it.
 static constexpr size_t kHostNumThreads = 4;
 static constexpr size_t kDeviceNumThreads = 1;
+// The runs between two measures of the costs of the instructions, which
+// change with the shapes of the inputs.
+static constexpr size_t kInstrCostMeasureInterval = 1000;
 
 bool IsInterpretercoreFastGCEnabled() {
   return memory::allocation::AllocatorFacade::Instance()
@@ -85,6 +101,7 @@ InterpreterCore::InterpreterCore(const platform::Place& place,
   completion_notifier_ = main_thread_blocker_.RegisterEvent(kTaskCompletion);
 
   create_local_scope_ = FLAGS_new_executor_use_local_scope;
+  measure_instr_costs_ = UsePrioritySchedule();
   VLOG(4) << "create_local_scope_ is " << create_local_scope_;
 
   if (create_local_scope_) {
@@ -127,9 +144,14 @@ interpreter::CostInfo InterpreterCore::DryRun(
     // until the second step run.
     async_work_queue_ = GetWorkQueue();
 
+    measure_instr_costs_ = true;
     ExecuteInstructionList(vec_instruction_);
     platform::DeviceContextPool::Instance().Get(place_)->Wait();
   }
+  cost_info.instr_time.reserve(timeline_.size());
+  for (auto& item : timeline_) {
+    cost_info.instr_time.push_back((item.end_ns - item.start_ns) / 1e6);
+  }
 
   if (create_local_scope_) {
     ClearLoDTensorArrayInLocalScope();
@@ -344,6 +366,35 @@ void InterpreterCore::BuildOperatorDependences() {
       dependecy_count_[inst_id]++;
     }
   }
+
+  // rank the instructions by the number of instructions on their longest
+  // path until their costs are measured in the first run
+  BuildInstructionPriority(std::vector<double>(op_nums, 1.));
+}
+
+bool InterpreterCore::UsePrioritySchedule() const {
+  // The host time of the instructions on the devices is only the time of
+  // their launch, which is no estimate of their cost.
+  return FLAGS_new_executor_use_priority_schedule &&
+         platform::is_cpu_place(place_);
+}
+
+void InterpreterCore::BuildInstructionPriority(
+    const std::vector<double>& costs) {
+  if (!UsePrioritySchedule()) {
+    instr_priority_.assign(vec_instruction_.size(), 0.);
+    return;
+  }
+  std::vector<std::vector<size_t>> downstream(vec_instruction_.size());
+  for (size_t i = 0; i < vec_instruction_.size(); ++i) {
+    auto& next_instr = vec_instruction_[i].NextInstructions();
+    for (auto* ids : {&next_instr.DirectRunIds(),
+                      &next_instr.EventRunIds(),
+                      &next_instr.SyncRunIds()}) {
+      downstream[i].insert(downstream[i].end(), ids->begin(), ids->end());
+    }
+  }
+  instr_priority_ = interpreter::ComputeUpwardRank(downstream, costs);
 }
 
 // At the end of each step, the holder of Tensor in LoDTensorArray is null.
@@ -497,6 +548,8 @@ void InterpreterCore::Convert(
     BuildInplace();
   }
 
+  BuildStaticMemoryPlan();
+
   // prepare for the first time.
   std::promise<std::unique_ptr<AtomicVectorSizeT>> deps_promise =
       std::promise<std::unique_ptr<AtomicVectorSizeT>>();
@@ -510,6 +563,102 @@ void InterpreterCore::Convert(
       interpreter::PrepareAtomicVarRef(var_scope_.VecMetaInfo()));
 }
 
+void InterpreterCore::BuildStaticMemoryPlan() {
+  if (!FLAGS_new_executor_use_static_memory_plan ||
+      !platform::is_cpu_place(place_)) {
+    return;
+  }
+  auto var_num = var_scope_.VarSize();
+  std::vector<interpreter::VarLifetime> vars(var_num);
+  // the vars sharing their buffers with other vars are left to gc
+  std::vector<bool> shares_buffer(var_num, false);
+  std::unordered_set<const Variable*> inplace_vars;
+  for (size_t op_idx = 0; op_idx < vec_instruction_.size(); ++op_idx) {
+    auto& instr = vec_instruction_[op_idx];
+    for (auto& pair : instr.InplaceInfo()) {
+      inplace_vars.insert(pair.first);
+      inplace_vars.insert(pair.second);
+    }
+    for (auto& pair : instr.InplaceBackMap()) {
+      shares_buffer[pair.first] = true;
+      shares_buffer[pair.second] = true;
+    }
+    auto& op_type = instr.OpBase()->Type();
+    bool is_share_op = op_type == "share_buffer" || op_type == "share_data";
+    for (auto& item : instr.Outputs()) {
+      for (auto id : item.second) {
+        if (id == kEmptyVarIndex) {
+          continue;
+        }
+        vars[id].writers.push_back(op_idx);
+        shares_buffer[id] = shares_buffer[id] || is_share_op;
+      }
+    }
+    if (is_share_op) {
+      for (auto& item : instr.Inputs()) {
+        for (auto id : item.second) {
+          if (id != kEmptyVarIndex) {
+            shares_buffer[id] = true;
+          }
+        }
+      }
+    }
+  }
+  for (auto& item : last_live_ops_) {
+    vars[item.first].last_users.assign(item.second.begin(),
+                                       item.second.end());
+  }
+
+  for (size_t id = 0; id < var_num; ++id) {
+    auto& var = vars[id];
+    auto* var_desc = var_scope_.VarDesc(id);
+    auto* variable = var_scope_.VarRef(id);
+    if (shares_buffer[id] || var.writers.empty() || var.last_users.empty() ||
+        var_desc == nullptr || var_desc->Persistable() ||
+        var_scope_.GetVarSikpInplace(id) || variable == nullptr ||
+        !variable->IsType<LoDTensor>() || inplace_vars.count(variable)) {
+      continue;
+    }
+    // a writer after the last users would write the buffer lent to the
+    // next var of the slot
+    bool is_written_in_lifetime = true;
+    for (auto writer : var.writers) {
+      for (auto user : var.last_users) {
+        if (writer != user && !op_happens_before_[writer][user]) {
+          is_written_in_lifetime = false;
+        }
+      }
+    }
+    if (!is_written_in_lifetime) {
+      continue;
+    }
+    var.planned = true;
+    int64_t numel = 1;
+    for (auto dim : var_desc->GetShape()) {
+      numel *= std::abs(dim);
+    }
+    var.size_hint = numel * framework::SizeOfType(var_desc->GetDataType());
+  }
+
+  size_t slot_num = 0;
+  var_buffer_slot_ =
+      interpreter::AssignBufferSlots(vars, op_happens_before_, &slot_num);
+  buffer_slots_.reset(new interpreter::BufferSlots(slot_num));
+  instr_planned_outputs_.assign(vec_instruction_.size(), {});
+  size_t planned_num = 0;
+  for (size_t id = 0; id < var_num; ++id) {
+    if (var_buffer_slot_[id] == -1) {
+      continue;
+    }
+    ++planned_num;
+    for (auto writer : vars[id].writers) {
+      instr_planned_outputs_[writer].push_back(id);
+    }
+  }
+  VLOG(4) << "Static memory plan: " << planned_num << " of " << var_num
+          << " vars in " << slot_num << " buffer slots";
+}
+
 void InterpreterCore::BuildSkipShareLoDInfo() {
   for (size_t i = 0; i < vec_instruction_.size(); ++i) {
     bool can_skip_lod = true;
@@ -670,20 +819,39 @@ void InterpreterCore::ExecuteInstructionList(
       async_work_queue_->PrepareAtomicVarRef(var_scope_.VecMetaInfo());
   record_prepare.End();
 
+  if (UsePrioritySchedule() &&
+      ++runs_since_cost_measure_ >= kInstrCostMeasureInterval) {
+    measure_instr_costs_ = true;
+  }
+  record_timeline_ =
+      measure_instr_costs_ || IsStaticGraphExecutorTimelineEnabled();
+  if (record_timeline_) {
+    timeline_.assign(vec_instr.size(), InstructionTimeline());
+  }
+
   exception_holder_.Clear();
 
+  std::vector<size_t> ready_ops;
   for (size_t i = 0; i < dependecy_count_.size(); ++i) {
     if (dependecy_count_[i] == 0) {
-      async_work_queue_->AddTask(vec_instr.at(i).KernelType(),
-                                 [this,
-                                  i,
-                                  atomic_deps = atomic_deps.get(),
-                                  atomic_var_ref = atomic_var_ref.get()] {
-                                   RunInstructionAsync(
-                                       i, atomic_deps, atomic_var_ref);
-                                 });
+      ready_ops.push_back(i);
     }
   }
+  interpreter::SortByPriority(instr_priority_, &ready_ops);
+  uint64_t ready_ns = record_timeline_ ? platform::PosixInNsec() : 0;
+  for (auto i : ready_ops) {
+    if (record_timeline_) {
+      timeline_[i].ready_ns = ready_ns;
+    }
+    async_work_queue_->AddTask(vec_instr.at(i).KernelType(),
+                               [this,
+                                i,
+                                atomic_deps = atomic_deps.get(),
+                                atomic_var_ref = atomic_var_ref.get()] {
+                                 RunInstructionAsync(
+                                     i, atomic_deps, atomic_var_ref);
+                               });
+  }
 
   auto event_name = main_thread_blocker_.WaitEvent();
   VLOG(1) << "main_thread_blocker_(" << &main_thread_blocker_
@@ -705,11 +873,30 @@ void InterpreterCore::ExecuteInstructionList(
     VLOG(4) << "clear ok";
     exception_holder_.ReThrow();
   }
+
+  if (record_timeline_) {
+    if (measure_instr_costs_) {
+      // rank the instructions by their host time measured in this run
+      std::vector<double> costs(timeline_.size());
+      for (size_t i = 0; i < timeline_.size(); ++i) {
+        costs[i] = timeline_[i].end_ns - timeline_[i].start_ns;
+      }
+      BuildInstructionPriority(costs);
+      measure_instr_costs_ = false;
+      runs_since_cost_measure_ = 0;
+    }
+    if (IsStaticGraphExecutorTimelineEnabled()) {
+      for (size_t i = 0; i < timeline_.size(); ++i) {
+        timeline_[i].op_type = vec_instr[i].OpBase()->Type();
+      }
+      StaticGraphExecutorTimeline(timeline_);
+    }
+  }
 }
 
 void InterpreterCore::RunNextInstructions(
     const Instruction& instr,
-    std::queue<size_t>* reserved_next_ops,
+    interpreter::ReadyInstructionQueue* reserved_next_ops,
     std::vector<std::atomic<size_t>>* atomic_deps,
     std::vector<std::atomic<size_t>>* atomic_var_ref) {
   platform::RecordEvent record(
@@ -717,23 +904,39 @@ void InterpreterCore::RunNextInstructions(
   VLOG(4) << "atomic 1:" << atomic_deps;
   auto& next_instr = instr.NextInstructions();
 
-  auto IsReady = [atomic_deps](size_t next_id) {
+  auto IsReady = [this, atomic_deps](size_t next_id) {
     VLOG(4) << "atomic:" << atomic_deps << " op_id: " << next_id
             << ", remain deps: " << (*atomic_deps)[next_id];
-    return (*atomic_deps)[next_id].fetch_sub(1, std::memory_order_relaxed) == 1;
+    bool is_ready =
+        (*atomic_deps)[next_id].fetch_sub(1, std::memory_order_relaxed) == 1;
+    if (is_ready && record_timeline_) {
+      timeline_[next_id].ready_ns = platform::PosixInNsec();
+    }
+    return is_ready;
   };
 
+  // move the ops into other threads, the ones of higher priority first
+  auto AddTasks = [this, atomic_deps, atomic_var_ref](
+                      std::vector<size_t>* ready_ops) {
+    interpreter::SortByPriority(instr_priority_, ready_ops);
+    for (auto next_id : *ready_ops) {
+      async_work_queue_->AddTask(
+          vec_instruction_[next_id].KernelType(),
+          [this, next_id, atomic_deps, atomic_var_ref] {
+            RunInstructionAsync(next_id, atomic_deps, atomic_var_ref);
+          });
+    }
+  };
+
+  std::vector<size_t> ready_ops;
   if (instr.KernelType() == OpFuncType::kQueueAsync) {
     // move all sync_ops into other threads
     for (auto next_id : next_instr.SyncRunIds()) {
       if (IsReady(next_id)) {
-        async_work_queue_->AddTask(
-            vec_instruction_[next_id].KernelType(),
-            [this, next_id, atomic_deps, atomic_var_ref]() {
-              RunInstructionAsync(next_id, atomic_deps, atomic_var_ref);
-            });
+        ready_ops.push_back(next_id);
       }
     }
+    AddTasks(&ready_ops);
     // keep all async_ops running in current thread
     for (auto next_id : next_instr.DirectRunIds()) {
       if (IsReady(next_id)) {
@@ -749,32 +952,26 @@ void InterpreterCore::RunNextInstructions(
     // move async_ops into async_thread
     for (auto next_id : next_instr.EventRunIds()) {
       if (IsReady(next_id)) {
-        async_work_queue_->AddTask(
-            vec_instruction_[next_id].KernelType(),
-            [this, next_id, atomic_deps, atomic_var_ref] {
-              RunInstructionAsync(next_id, atomic_deps, atomic_var_ref);
-            });
+        ready_ops.push_back(next_id);
       }
     }
+    AddTasks(&ready_ops);
+    ready_ops.clear();
     auto direct_run_ops = interpreter::merge_vector(next_instr.SyncRunIds(),
                                                     next_instr.DirectRunIds());
-    size_t first_op = 0;
     for (auto next_id : direct_run_ops) {
       if (IsReady(next_id)) {
-        // only keep one op running in current thread
-        if (first_op == 0) {
-          first_op = next_id;
-          continue;
-        }
-        // move rest ops into other threads
-        async_work_queue_->AddTask(
-            vec_instruction_[next_id].KernelType(),
-            [this, next_id, atomic_deps, atomic_var_ref] {
-              RunInstructionAsync(next_id, atomic_deps, atomic_var_ref);
-            });
+        ready_ops.push_back(next_id);
       }
     }
-    if (first_op != 0) reserved_next_ops->push(first_op);
+    if (!ready_ops.empty()) {
+      interpreter::SortByPriority(instr_priority_, &ready_ops);
+      // only keep the op of the highest priority running in current thread
+      reserved_next_ops->push(ready_ops.front());
+      // move rest ops into other threads
+      ready_ops.erase(ready_ops.begin());
+      AddTasks(&ready_ops);
+    }
   }
 }
 
@@ -782,11 +979,10 @@ void InterpreterCore::RunInstructionAsync(
     size_t instr_id,
     std::vector<std::atomic<size_t>>* atomic_deps,
     std::vector<std::atomic<size_t>>* atomic_var_ref) {
-  std::queue<size_t> ready_ops;
+  interpreter::ReadyInstructionQueue ready_ops(&instr_priority_);
   ready_ops.push(instr_id);
   while (!ready_ops.empty()) {
-    instr_id = ready_ops.front();
-    ready_ops.pop();
+    instr_id = ready_ops.pop();
     auto& instr_node = vec_instruction_.at(instr_id);
     VLOG(5) << __func__ << " OP id:" << instr_node.Id()
             << " name:" << instr_node.OpBase()->Type() << " type:"
@@ -802,7 +998,27 @@ void InterpreterCore::RunInstructionAsync(
     try {
       interpreter::WaitEvent(instr_node, place_);
 
+      if (buffer_slots_) {
+        for (auto var_id : instr_planned_outputs_[instr_id]) {
+          buffer_slots_->Lend(
+              var_buffer_slot_[var_id],
+              var_scope_.VarRef(var_id)->GetMutable<LoDTensor>());
+        }
+      }
+      if (record_timeline_) {
+        timeline_[instr_id].start_ns = platform::PosixInNsec();
+        timeline_[instr_id].thread_id = platform::GetCurrentThreadStdId();
+      }
       RunInstruction(instr_node);
+      if (record_timeline_) {
+        timeline_[instr_id].end_ns = platform::PosixInNsec();
+      }
+      if (buffer_slots_) {
+        for (auto var_id : instr_planned_outputs_[instr_id]) {
+          buffer_slots_->Keep(var_buffer_slot_[var_id],
+                              var_scope_.VarRef(var_id)->Get<LoDTensor>());
+        }
+      }
 
 #if defined(PADDLE_WITH_CUDA) || defined(PADDLE_WITH_HIP)
       RecordStreamForGC(instr_node);
@@ -960,6 +1176,14 @@ void InterpreterCore::CheckGC(
     if (var_scope.VarDesc(var_id) && var_scope.VarDesc(var_id)->Persistable()) {
       continue;
     }
+    if (is_ready && buffer_slots_ && var_buffer_slot_[var_id] != -1) {
+      VLOG(6) << "Return the buffer of variable with name : "
+              << var_scope.GetNameById(var_id);
+      buffer_slots_->Return(
+          var_buffer_slot_[var_id],
+          var_scope_.VarRef(var_id)->GetMutable<LoDTensor>());
+      continue;
+    }
     if (is_ready) {
       VLOG(6) << "Async delete variable with name : "
               << var_scope.GetNameById(var_id);
@@ -21,7 +21,10 @@
 
 #include "paddle/fluid/framework/details/exception_holder.h"
 #include "paddle/fluid/framework/new_executor/event_manager.h"
+#include "paddle/fluid/framework/new_executor/executor_statistics.h"
 #include "paddle/fluid/framework/new_executor/garbage_collector/garbage_collector.h"
+#include "paddle/fluid/framework/new_executor/interpreter/priority_schedule.h"
+#include "paddle/fluid/framework/new_executor/interpreter/static_memory_plan.h"
 #include "paddle/fluid/framework/new_executor/interpretercore_util.h"
 #include "paddle/fluid/framework/new_executor/new_executor_defs.h"
 #include "paddle/fluid/framework/new_executor/profiler.h"
@@ -69,6 +72,12 @@ class InterpreterCore {
 
   void BuildOperatorDependences();
 
+  bool UsePrioritySchedule() const;
+
+  void BuildInstructionPriority(const std::vector<double>& costs);
+
+  void BuildStaticMemoryPlan();
+
   void ClearLoDTensorArrayInLocalScope();
 
   void Convert(std::vector<paddle::framework::OpFuncNode>* op_func_nodes);
@@ -91,10 +100,11 @@ class InterpreterCore {
   void RunInstructionAsync(size_t instr_id,
                            std::vector<std::atomic<size_t>>* atomic_deps,
                            std::vector<std::atomic<size_t>>* atomic_var_ref);
-  void RunNextInstructions(const Instruction& instr_id,
-                           std::queue<size_t>* reserved_next_ops,
-                           std::vector<std::atomic<size_t>>* atomic_deps,
-                           std::vector<std::atomic<size_t>>* atomic_var_ref);
+  void RunNextInstructions(
+      const Instruction& instr_id,
+      interpreter::ReadyInstructionQueue* reserved_next_ops,
+      std::vector<std::atomic<size_t>>* atomic_deps,
+      std::vector<std::atomic<size_t>>* atomic_var_ref);
 
   void BuildSkipShareLoDInfo();
 
@@ -125,6 +135,16 @@ class InterpreterCore {
   std::map<size_t, std::set<size_t>> last_live_ops_;
 
   std::vector<size_t> dependecy_count_;
+  // the upward rank of each instruction, by which the ready instructions
+  // are run, see priority_schedule.h
+  std::vector<double> instr_priority_;
+  // time the instructions in the next run, to rank them by their costs
+  bool measure_instr_costs_{false};
+  size_t runs_since_cost_measure_{0};
+  // the timeline of the instructions in the current run, recorded if the
+  // costs are measured or the timeline is exported
+  bool record_timeline_{false};
+  std::vector<InstructionTimeline> timeline_;
   std::atomic<size_t> unfinished_op_numer_{0};
   std::vector<std::vector<size_t>> input_var2op_info_;
 
@@ -140,6 +160,12 @@ class InterpreterCore {
   std::shared_ptr<EventsWaiter::EventNotifier> completion_notifier_{nullptr};
 
   std::unique_ptr<InterpreterCoreGarbageCollector> gc_;
+  // the static memory plan, see static_memory_plan.h: the buffer slot of
+  // each var, or -1 for the vars freed by gc_, and the planned outputs of
+  // each instruction
+  std::unique_ptr<interpreter::BufferSlots> buffer_slots_;
+  std::vector<int> var_buffer_slot_;
+  std::vector<std::vector<size_t>> instr_planned_outputs_;
   std::vector<paddle::platform::DeviceEvent> gc_event_;
 
   std::future<std::unique_ptr<AtomicVectorSizeT>> atomic_deps_;
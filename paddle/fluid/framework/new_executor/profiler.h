@@ -13,6 +13,8 @@
 // limitations under the License.
 
 #pragma once
+#include <vector>
+
 #include "paddle/fluid/framework/tensor.h"
 #include "paddle/fluid/framework/variable.h"
 #include "paddle/fluid/platform/device/gpu/gpu_info.h"
@@ -22,8 +24,9 @@ namespace paddle {
 namespace framework {
 namespace interpreter {
 struct CostInfo {
-  double total_time{0.};          // ms
-  size_t device_memory_bytes{0};  // total allocated memory size
+  double total_time{0.};           // ms
+  size_t device_memory_bytes{0};   // total allocated memory size
+  std::vector<double> instr_time;  // ms, host time of each instruction
 };
 
 class ProfilerGuard {
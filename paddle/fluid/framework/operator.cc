@@ -204,6 +204,24 @@ RuntimeContext::RuntimeContext(const VariableNameMap& innames,
   }
 }
 
+RuntimeContext::RuntimeContext(const OpVarSlots& slots,
+                               const VarSlotTable& table) {
+  for (auto& slot_item : slots.inputs) {
+    std::vector<Variable*>& input_vars = inputs[slot_item.first];
+    input_vars.reserve(slot_item.second.size());
+    for (int slot : slot_item.second) {
+      input_vars.push_back(slot < 0 ? nullptr : table.Get(slot));
+    }
+  }
+  for (auto& slot_item : slots.outputs) {
+    std::vector<Variable*>& output_vars = outputs[slot_item.first];
+    output_vars.reserve(slot_item.second.size());
+    for (int slot : slot_item.second) {
+      output_vars.push_back(slot < 0 ? nullptr : table.Get(slot));
+    }
+  }
+}
+
 void OperatorBase::Run(const Scope& scope, const platform::Place& place) {
   try {
     VLOG(4) << place << " " << DebugStringEx(&scope);
@@ -289,6 +307,35 @@ void OperatorBase::Run(const Scope& scope, const platform::Place& place) {
   }
 }
 
+void OperatorBase::CompileVarSlots(VarSlotMap* map) {
+  // The empty names, which the scopes never hold, get slot -1.
+  auto compile = [map](const VariableNameMap& names,
+                       std::vector<std::pair<std::string, std::vector<int>>>*
+                           slots) {
+    slots->reserve(names.size());
+    for (auto& name_item : names) {
+      std::vector<int> item_slots;
+      item_slots.reserve(name_item.second.size());
+      for (auto& name : name_item.second) {
+        item_slots.push_back(name == kEmptyVarName ? -1 : map->Add(name));
+      }
+      slots->emplace_back(name_item.first, std::move(item_slots));
+    }
+  };
+  var_slots_.reset(new OpVarSlots());
+  var_slots_->map = map;
+  compile(inputs_, &var_slots_->inputs);
+  compile(outputs_, &var_slots_->outputs);
+}
+
+const OpVarSlots* OperatorBase::VarSlotsIn(const VarSlotTable* table) const {
+  if (var_slots_ == nullptr || table == nullptr ||
+      table->map() != var_slots_->map) {
+    return nullptr;
+  }
+  return var_slots_.get();
+}
+
 bool OperatorBase::HasInputs(const std::string& name) const {
   return inputs_.find(name) != inputs_.end();
 }
@@ -1414,8 +1461,16 @@ void OperatorWithKernel::RunImpl(const Scope& scope,
     all_kernels_must_compute_runtime_shape_ = true;
   const Scope* cur_scope = &scope;
   if (!enable_cache_runtime_context_) {
-    RuntimeContext ctx(Inputs(), Outputs(), scope);
-    RunImpl(scope, place, &ctx);
+    // The table is held for the run, in case the scope detaches it.
+    auto table = scope.slot_table();
+    const OpVarSlots* slots = VarSlotsIn(table.get());
+    if (slots != nullptr) {
+      RuntimeContext ctx(*slots, *table);
+      RunImpl(scope, place, &ctx);
+    } else {
+      RuntimeContext ctx(Inputs(), Outputs(), scope);
+      RunImpl(scope, place, &ctx);
+    }
     pre_scope_ = cur_scope;
   } else if (run_phi_kernel_ && impl_ != nullptr && !need_prepare_data_ &&
              !need_prepare_phi_data_) {
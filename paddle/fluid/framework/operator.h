@@ -36,6 +36,7 @@ limitations under the License. */
 #include "paddle/fluid/framework/selected_rows_utils.h"
 #include "paddle/fluid/framework/tensor.h"
 #include "paddle/fluid/framework/unused_var_check.h"
+#include "paddle/fluid/framework/var_slot_table.h"
 #include "paddle/fluid/memory/malloc.h"
 #include "paddle/fluid/platform/device_context.h"
 
@@ -140,6 +141,9 @@ class RuntimeContext {
                  const VariableValueMap& outvars)
       : inputs(invars), outputs(outvars) {}
 
+  /// The variables of the slots of an op in a table of its map.
+  RuntimeContext(const OpVarSlots& slots, const VarSlotTable& table);
+
   VariableValueMap inputs;
   VariableValueMap outputs;
 };
@@ -229,6 +233,15 @@ class OperatorBase {
 
   void SetIsCalledByExecutor(bool x) { run_by_executor_ = x; }
 
+  /// Compiles the names of the inputs and outputs to slots of the map, so
+  /// that running in a scope holding a VarSlotTable of the map reads the
+  /// variables by slot.
+  void CompileVarSlots(VarSlotMap* map);
+
+  /// The slots of the variables of the op, if compiled, in the slot table,
+  /// if it is one of the same map.
+  const OpVarSlots* VarSlotsIn(const VarSlotTable* table) const;
+
   virtual void RuntimeInferShape(const Scope& scope,
                                  const platform::Place& place,
                                  const RuntimeContext& ctx) const {}
@@ -257,6 +270,8 @@ class OperatorBase {
   // Whether this operator executes in an Executor.
   bool run_by_executor_{true};
 
+  std::unique_ptr<OpVarSlots> var_slots_;
+
  private:
   void GenerateTemporaryNames();
   void CheckAllInputOutputSet() const;
@@ -574,7 +574,11 @@ ir::Graph *ParallelExecutorPrivate::ApplyMemoryOptimizePass(ir::Graph *graph) {
           "Please recompile or reinstall Paddle with CustomDevice support."));
 #endif
     } else if (platform::is_cpu_place(place)) {
-      gc.reset(new CPUGarbageCollector(place, max_memory_size));
+      if (IsAsyncCPUGarbageCollectionEnabled()) {
+        gc.reset(new AsyncCPUGarbageCollector(place));
+      } else {
+        gc.reset(new CPUGarbageCollector(place, max_memory_size));
+      }
       VLOG(10) << "Created GarbageCollector at " << place;
     } else {
       PADDLE_THROW(platform::errors::PreconditionNotMet(
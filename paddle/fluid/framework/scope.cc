@@ -16,6 +16,7 @@ limitations under the License. */
 
 #include "glog/logging.h"
 #include "paddle/fluid/framework/threadpool.h"
+#include "paddle/fluid/framework/var_slot_table.h"
 
 DECLARE_bool(benchmark);
 
@@ -63,10 +64,15 @@ Variable* Scope::Var(const std::string& name) {
   // NOTE(xiongkun03): add {} here to unlock. With {}, scope
   // will do callback after unlock.
   Variable* ret = nullptr;
+  bool created = false;
   {
     SCOPE_VARS_WRITER_LOCK
+    size_t num_vars = vars_.size();
     ret = VarInternal(name);
+    created = vars_.size() != num_vars;
   }
+  // The new variable may hide one of an ancestor in the tables of the kids.
+  if (created) DropKidSlotTables();
   return ret;
 }
 
@@ -180,6 +186,7 @@ void Scope::EraseVars(const std::vector<std::string>& var_names) {
       }
     }
   }
+  DropSlotTables();
 }
 
 void Scope::Rename(const std::string& origin_name,
@@ -188,6 +195,7 @@ void Scope::Rename(const std::string& origin_name,
     SCOPE_VARS_WRITER_LOCK
     RenameInternal(origin_name, new_name);
   }
+  DropSlotTables();
 }
 
 std::string Scope::Rename(const std::string& origin_name) const {
@@ -196,6 +204,7 @@ std::string Scope::Rename(const std::string& origin_name) const {
     SCOPE_VARS_WRITER_LOCK
     RenameInternal(origin_name, new_name);
   }
+  DropSlotTables();
   return new_name;
 }
 
@@ -204,6 +213,8 @@ Variable* Scope::VarInternal(const std::string& name) {
   if (v != nullptr) return v;
   v = new Variable();
   vars_.emplace(name, std::unique_ptr<Variable>(v));
+  // The new variable may hide one of an ancestor in the table.
+  slot_table_.reset();
   VLOG(3) << "Create variable " << name;
   return v;
 }
@@ -224,6 +235,33 @@ const Scope* Scope::FindScopeInternal(const std::string& name) const {
   return (parent_ == nullptr) ? nullptr : parent_->FindScope(name);
 }
 
+std::shared_ptr<const VarSlotTable> Scope::slot_table() const {
+  SCOPE_VARS_READER_LOCK
+  return slot_table_;
+}
+
+void Scope::SetSlotTable(std::shared_ptr<const VarSlotTable> table) const {
+  SCOPE_VARS_WRITER_LOCK
+  slot_table_ = std::move(table);
+}
+
+void Scope::DropKidSlotTables() const {
+  SCOPE_KIDS_READER_LOCK
+  for (Scope* kid : kids_) {
+    kid->DropSlotTables();
+  }
+}
+
+void Scope::DropSlotTables() const {
+  // The kids are visited with the variables unlocked, since FindVar of a
+  // kid locks its variables and then those of its parent.
+  {
+    SCOPE_VARS_WRITER_LOCK
+    slot_table_.reset();
+  }
+  DropKidSlotTables();
+}
+
 void Scope::RenameInternal(const std::string& origin_name,
                            const std::string& new_name) const {
   auto origin_it = vars_.find(origin_name);
@@ -260,14 +298,17 @@ Variable* Scope::FindVarLocally(const std::string& name) const {
 }
 
 void Scope::EraseVarsExcept(const std::unordered_set<Variable*>& vars) {
-  SCOPE_VARS_WRITER_LOCK
-  for (auto iter = vars_.begin(); iter != vars_.end();) {
-    if (vars.count(iter->second.get()) != 0) {
-      ++iter;
-    } else {
-      vars_.erase(iter++);
+  {
+    SCOPE_VARS_WRITER_LOCK
+    for (auto iter = vars_.begin(); iter != vars_.end();) {
+      if (vars.count(iter->second.get()) != 0) {
+        ++iter;
+      } else {
+        vars_.erase(iter++);
+      }
     }
   }
+  DropSlotTables();
 }
 
 std::string GenScopeTreeDebugInfo(Scope* root) {
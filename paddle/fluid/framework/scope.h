@@ -33,6 +33,7 @@ extern "C" {
 namespace paddle {
 namespace framework {
 class Variable;
+class VarSlotTable;
 }  // namespace framework
 }  // namespace paddle
 
@@ -134,6 +135,13 @@ class Scope : public ScopeBase {
   // Rename variable to a new name and return the new name
   std::string Rename(const std::string& origin_name) const;
 
+  /// The variables of the program run in this scope by slot, if the
+  /// executor compiled them. Creating, erasing or renaming variables in
+  /// the scope or its ancestors detaches it.
+  std::shared_ptr<const VarSlotTable> slot_table() const;
+
+  void SetSlotTable(std::shared_ptr<const VarSlotTable> table) const;
+
  protected:
   struct KeyHasher {
     std::size_t operator()(const std::string& key) const {
@@ -151,6 +159,13 @@ class Scope : public ScopeBase {
   // Called by Var.
   Variable* VarInternal(const std::string& name);
 
+  // Detaches the slot tables of the kids and their descendants, which may
+  // hold variables of this scope.
+  void DropKidSlotTables() const;
+
+  // Detaches the slot tables of this scope and its descendants.
+  void DropSlotTables() const;
+
   // Called by FindScope.
   const Scope* FindScopeInternal(const Variable* var) const;
 
@@ -171,6 +186,8 @@ class Scope : public ScopeBase {
   mutable std::list<Scope*> kids_;
   const Scope* parent_{nullptr};
 
+  mutable std::shared_ptr<const VarSlotTable> slot_table_;
+
   DISABLE_COPY_AND_ASSIGN(Scope);
 
 #ifndef PADDLE_ON_INFERENCE
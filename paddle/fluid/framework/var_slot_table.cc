@@ -0,0 +1,55 @@
+/* Copyright (c) 2022 PaddlePaddle Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License. */
+
+#include "paddle/fluid/framework/var_slot_table.h"
+
+#include <utility>
+
+#include "paddle/fluid/framework/scope.h"
+
+namespace paddle {
+namespace framework {
+
+int VarSlotMap::Add(const std::string& name) {
+  auto it = slots_.find(name);
+  if (it != slots_.end()) {
+    return it->second;
+  }
+  int slot = static_cast<int>(names_.size());
+  slots_.emplace(name, slot);
+  names_.push_back(name);
+  return slot;
+}
+
+int VarSlotMap::Find(const std::string& name) const {
+  auto it = slots_.find(name);
+  return it == slots_.end() ? -1 : it->second;
+}
+
+VarSlotTable::VarSlotTable(std::shared_ptr<const VarSlotMap> map,
+                           const Scope& scope)
+    : map_(std::move(map)), scope_(scope) {
+  vars_.reserve(map_->size());
+  for (size_t i = 0; i < map_->size(); ++i) {
+    vars_.push_back(scope.FindVar(map_->Name(i)));
+  }
+}
+
+Variable* VarSlotTable::Get(int slot) const {
+  Variable* var = vars_[slot];
+  return var != nullptr ? var : scope_.FindVar(map_->Name(slot));
+}
+
+}  // namespace framework
+}  // namespace paddle
@@ -0,0 +1,91 @@
+/* Copyright (c) 2022 PaddlePaddle Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License. */
+
+#pragma once
+
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace paddle {
+namespace framework {
+
+class Scope;
+class Variable;
+
+/**
+ * @brief The names of the variables of a program compiled to dense slots.
+ *
+ * The executors compile the names of the inputs and outputs of their ops
+ * once, when they prepare a block, so that running an op reads its
+ * variables from a VarSlotTable by slot rather than looking their names up
+ * in the scope and its ancestors.
+ */
+class VarSlotMap {
+ public:
+  /// The slot of the name, added if the name is new.
+  int Add(const std::string& name);
+
+  /// The slot of the name, or -1.
+  int Find(const std::string& name) const;
+
+  const std::string& Name(int slot) const { return names_[slot]; }
+
+  size_t size() const { return names_.size(); }
+
+ private:
+  std::unordered_map<std::string, int> slots_;
+  std::vector<std::string> names_;
+};
+
+/// The slots of the inputs and the outputs of an op, in the order of its
+/// VariableNameMaps.
+struct OpVarSlots {
+  const VarSlotMap* map{nullptr};
+  std::vector<std::pair<std::string, std::vector<int>>> inputs;
+  std::vector<std::pair<std::string, std::vector<int>>> outputs;
+};
+
+/**
+ * @brief The variables of the slots of a VarSlotMap in a scope.
+ *
+ * The names are looked up once, when the table is built, and Get() is a
+ * plain read of an array without lock. The executor building the table
+ * attaches it to the scope, which detaches it when the variables of the
+ * scope or of its ancestors change.
+ */
+class VarSlotTable {
+ public:
+  VarSlotTable(std::shared_ptr<const VarSlotMap> map, const Scope& scope);
+
+  const VarSlotMap* map() const { return map_.get(); }
+
+  const Scope& scope() const { return scope_; }
+
+  /// The variable of the slot, looked up again in the scope if it did not
+  /// exist when the table was built.
+  Variable* Get(int slot) const;
+
+ private:
+  // Shared with the executor, so that a table left in a scope never
+  // matches the map of another executor.
+  std::shared_ptr<const VarSlotMap> map_;
+  const Scope& scope_;
+  std::vector<Variable*> vars_;
+};
+
+}  // namespace framework
+}  // namespace paddle
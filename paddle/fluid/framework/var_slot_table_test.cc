@@ -0,0 +1,102 @@
+/* Copyright (c) 2022 PaddlePaddle Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License. */
+
+#include "paddle/fluid/framework/var_slot_table.h"
+
+#include <memory>
+
+#include "gtest/gtest.h"
+#include "paddle/fluid/framework/scope.h"
+
+using paddle::framework::Scope;
+using paddle::framework::Variable;
+using paddle::framework::VarSlotMap;
+using paddle::framework::VarSlotTable;
+
+TEST(VarSlotMap, Add) {
+  VarSlotMap map;
+  EXPECT_EQ(0, map.Add("a"));
+  EXPECT_EQ(1, map.Add("b"));
+  EXPECT_EQ(0, map.Add("a"));
+  EXPECT_EQ(1, map.Find("b"));
+  EXPECT_EQ(-1, map.Find("c"));
+  EXPECT_EQ("b", map.Name(1));
+  EXPECT_EQ(2UL, map.size());
+}
+
+TEST(VarSlotTable, Get) {
+  auto map = std::make_shared<VarSlotMap>();
+  int a = map->Add("a");
+  int b = map->Add("b");
+  int c = map->Add("c");
+
+  Scope s;
+  Scope& ss = s.NewScope();
+  Variable* va = s.Var("a");
+  Variable* vb = ss.Var("b");
+  VarSlotTable table(map, ss);
+  EXPECT_EQ(va, table.Get(a));
+  EXPECT_EQ(vb, table.Get(b));
+  EXPECT_EQ(nullptr, table.Get(c));
+
+  // The variables missing when the table was built are looked up again.
+  Variable* vc = ss.Var("c");
+  EXPECT_EQ(vc, table.Get(c));
+}
+
+TEST(VarSlotTable, Detach) {
+  auto map = std::make_shared<VarSlotMap>();
+  map->Add("a");
+
+  Scope s;
+  s.Var("a");
+  s.SetSlotTable(std::make_shared<VarSlotTable>(map, s));
+  EXPECT_EQ(map.get(), s.slot_table()->map());
+  s.Var("a");
+  EXPECT_NE(nullptr, s.slot_table());
+
+  // Creating, renaming or erasing variables detaches the table.
+  s.Var("b");
+  EXPECT_EQ(nullptr, s.slot_table());
+  s.SetSlotTable(std::make_shared<VarSlotTable>(map, s));
+  s.Rename("b", "c");
+  EXPECT_EQ(nullptr, s.slot_table());
+  s.SetSlotTable(std::make_shared<VarSlotTable>(map, s));
+  s.EraseVars({"c"});
+  EXPECT_EQ(nullptr, s.slot_table());
+}
+
+TEST(VarSlotTable, DetachFromAncestor) {
+  auto map = std::make_shared<VarSlotMap>();
+  map->Add("a");
+
+  Scope s;
+  Scope& ss = s.NewScope();
+  Scope& sss = ss.NewScope();
+  s.Var("a");
+  sss.SetSlotTable(std::make_shared<VarSlotTable>(map, sss));
+  auto table = sss.slot_table();
+  EXPECT_EQ(table.get(), sss.slot_table().get());
+
+  // The tables of the descendants may hold the variables of the ancestors.
+  s.EraseVars({"a"});
+  EXPECT_EQ(nullptr, sss.slot_table());
+  // A copy taken before stays valid.
+  EXPECT_EQ(map.get(), table->map());
+
+  s.Var("a");
+  sss.SetSlotTable(std::make_shared<VarSlotTable>(map, sss));
+  ss.Var("a");
+  EXPECT_EQ(nullptr, sss.slot_table());
+}
@@ -0,0 +1,92 @@
+// Copyright (c) 2022 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "paddle/fluid/imperative/dispatch_cache.h"
+
+#include <functional>
+
+namespace paddle {
+namespace imperative {
+
+namespace {
+
+struct AttributeHasher {
+  size_t operator()(const paddle::blank&) const { return 0; }
+
+  template <typename T>
+  size_t operator()(const T& value) const {
+    return std::hash<T>()(value);
+  }
+
+  template <typename T>
+  size_t operator()(const std::vector<T>& values) const {
+    size_t hash = values.size();
+    for (const auto& value : values) {
+      hash = DispatchHashCombine(hash, (*this)(static_cast<T>(value)));
+    }
+    return hash;
+  }
+};
+
+struct AttributeEmptinessHasher {
+  template <typename T>
+  size_t operator()(const T&) const {
+    return 0;
+  }
+
+  template <typename T>
+  size_t operator()(const std::vector<T>& values) const {
+    return values.empty();
+  }
+};
+
+}  // namespace
+
+size_t DispatchVarKey::Hash() const {
+  size_t hash = std::hash<int>()(type);
+  hash = DispatchHashCombine(hash, std::hash<int>()(dtype));
+  hash = DispatchHashCombine(hash, std::hash<int>()(layout));
+  hash = DispatchHashCombine(hash, place);
+  hash = DispatchHashCombine(hash, std::hash<int>()(rank));
+  return DispatchHashCombine(hash, (initialized << 1) | empty);
+}
+
+size_t HashDispatchAttrs(const framework::AttributeMap& attrs) {
+  // The order of an unordered_map is not part of its value, so the hashes
+  // of the attributes are summed.
+  size_t hash = 0;
+  for (const auto& pair : attrs) {
+    if (!IsDispatchAttr(pair.second)) continue;
+    size_t value_hash = 0;
+    if (IsDispatchEmptinessAttr(pair.second)) {
+      value_hash = DispatchHashCombine(
+          pair.second.index(),
+          paddle::visit(AttributeEmptinessHasher(), pair.second));
+    } else {
+      value_hash = DispatchHashCombine(
+          pair.second.index(), paddle::visit(AttributeHasher(), pair.second));
+    }
+    hash += DispatchHashCombine(std::hash<std::string>()(pair.first),
+                                value_hash);
+  }
+  return hash;
+}
+
+DygraphDispatchCache& DygraphDispatchCache::Instance() {
+  thread_local DygraphDispatchCache cache;
+  return cache;
+}
+
+}  // namespace imperative
+}  // namespace paddle
@@ -0,0 +1,317 @@
+// Copyright (c) 2022 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <memory>
+#include <string>
+#include <typeinfo>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "paddle/fluid/framework/lod_tensor.h"
+#include "paddle/fluid/framework/op_info.h"
+#include "paddle/fluid/framework/op_kernel_type.h"
+#include "paddle/fluid/framework/operator.h"
+#include "paddle/fluid/framework/type_defs.h"
+#include "paddle/fluid/imperative/type_defs.h"
+#include "paddle/phi/core/compat/arg_map_context.h"
+#include "paddle/phi/core/kernel_factory.h"
+#include "paddle/phi/core/selected_rows.h"
+
+namespace paddle {
+namespace imperative {
+
+/**
+ * @brief What PreparedOp::Prepare chose to run an op: its kernel type, and
+ * either the phi kernel with its signature or the fluid kernel.
+ */
+struct DispatchResult {
+  explicit DispatchResult(const framework::OpKernelType& kernel_type)
+      : kernel_type(kernel_type) {}
+
+  framework::OpKernelType kernel_type;
+  const phi::ArgumentMappingFn* arg_map_fn{nullptr};
+  const phi::KernelSignature* default_kernel_signature{nullptr};
+  phi::KernelSignature kernel_signature;
+  // Exactly one of them is set, both point into the kernel registries.
+  const phi::Kernel* phi_kernel{nullptr};
+  const framework::OperatorWithKernel::OpKernelFunc* func{nullptr};
+};
+
+/// The properties of a variable the choice of the kernel of an op depends
+/// on: GetExpectedKernelType reads the data types, layouts and places of
+/// the inputs, and some ops whether they are empty or their ranks.
+struct DispatchVarKey {
+  int type{-1};
+  int dtype{-1};
+  int layout{-1};
+  uint32_t place{0};
+  int rank{-1};
+  bool initialized{false};
+  bool empty{true};
+
+  bool operator==(const DispatchVarKey& other) const {
+    return type == other.type && dtype == other.dtype &&
+           layout == other.layout && place == other.place &&
+           rank == other.rank && initialized == other.initialized &&
+           empty == other.empty;
+  }
+
+  size_t Hash() const;
+};
+
+/// The key of the variable, false for the types besides LoDTensor and
+/// SelectedRows, whose choice is not cached.
+template <typename VarType>
+bool MakeDispatchVarKey(const std::shared_ptr<VarType>& var,
+                        DispatchVarKey* key) {
+  *key = DispatchVarKey();
+  if (var == nullptr) return true;
+  const framework::Variable& variable = var->Var();
+  if (!variable.IsInitialized()) {
+    key->type = -2;
+    return true;
+  }
+  key->type = variable.Type();
+  const phi::DenseTensor* tensor = nullptr;
+  if (variable.IsType<framework::LoDTensor>()) {
+    tensor = &variable.Get<framework::LoDTensor>();
+  } else if (variable.IsType<phi::SelectedRows>()) {
+    tensor = &variable.Get<phi::SelectedRows>().value();
+  } else {
+    return false;
+  }
+  key->dtype = static_cast<int>(tensor->dtype());
+  key->layout = static_cast<int>(tensor->layout());
+  key->initialized = tensor->IsInitialized();
+  if (key->initialized) key->place = tensor->place().HashValue();
+  key->rank = tensor->dims().size();
+  key->empty = tensor->numel() == 0;
+  return true;
+}
+
+inline size_t DispatchHashCombine(size_t seed, size_t value) {
+  return seed ^ (value + 0x9e3779b9 + (seed << 6) + (seed >> 2));
+}
+
+/// Whether the choice of the kernel of an op may depend on the attribute.
+/// The float attributes, like the scale of scale, only feed the computation
+/// and often differ for every call, so they are left out of the key rather
+/// than churning the cache.
+inline bool IsDispatchAttr(const framework::Attribute& attr) {
+  return attr.type() != typeid(float);
+}
+
+/// Whether only the emptiness of the attribute is part of the key. The
+/// values of the floating point vectors feed the computation too, but
+/// whether they are given may choose the kernel: the argument mapping of
+/// set_value picks its signature from the empty one of fp32_values and
+/// fp64_values.
+inline bool IsDispatchEmptinessAttr(const framework::Attribute& attr) {
+  return attr.type() == typeid(std::vector<float>) ||
+         attr.type() == typeid(std::vector<double>);
+}
+
+/// Whether two attributes kept by IsDispatchAttr choose the same kernel.
+inline bool DispatchAttrsEqual(const framework::Attribute& lhs,
+                               const framework::Attribute& rhs) {
+  if (lhs.index() != rhs.index()) return false;
+  if (lhs.type() == typeid(std::vector<float>)) {
+    return PADDLE_GET_CONST(std::vector<float>, lhs).empty() ==
+           PADDLE_GET_CONST(std::vector<float>, rhs).empty();
+  }
+  if (lhs.type() == typeid(std::vector<double>)) {
+    return PADDLE_GET_CONST(std::vector<double>, lhs).empty() ==
+           PADDLE_GET_CONST(std::vector<double>, rhs).empty();
+  }
+  return lhs == rhs;
+}
+
+/// The hash of the attributes IsDispatchAttr keeps.
+size_t HashDispatchAttrs(const framework::AttributeMap& attrs);
+
+/**
+ * @brief The kernel choices of the ops a thread ran in dygraph.
+ *
+ * An op run again with inputs and outputs of the same types, data types,
+ * layouts, places and ranks, with the same attributes on the same place,
+ * runs the kernel chosen the first time: PreparedOp::Prepare then skips
+ * GetExpectedKernelType, the argument mapping and the kernel lookups. Only
+ * the attributes of IsDispatchAttr are compared and kept in an entry, and
+ * of the floating point vectors only whether they are empty.
+ * Looking a choice up hashes the op and compares it with the entries of its
+ * hash without copying anything. The cache is per thread and is cleared
+ * when it grows over kMaxSize.
+ */
+class DygraphDispatchCache {
+ public:
+  static constexpr size_t kMaxSize = 4096;
+
+  static DygraphDispatchCache& Instance();
+
+  template <typename VarMap>
+  const DispatchResult* Find(const framework::OperatorBase& op,
+                             const platform::Place& place,
+                             const VarMap& ins,
+                             const VarMap& outs,
+                             const framework::AttributeMap& attrs) const {
+    size_t hash = 0;
+    if (!Hash(op, place, ins, outs, attrs, &hash)) return nullptr;
+    auto it = entries_.find(hash);
+    if (it == entries_.end()) return nullptr;
+    for (const auto& entry : it->second) {
+      if (entry->Matches(op, place, ins, outs, attrs)) {
+        return &entry->result;
+      }
+    }
+    return nullptr;
+  }
+
+  template <typename VarMap>
+  void Insert(const framework::OperatorBase& op,
+              const platform::Place& place,
+              const VarMap& ins,
+              const VarMap& outs,
+              const framework::AttributeMap& attrs,
+              DispatchResult&& result) {
+    size_t hash = 0;
+    if (!Hash(op, place, ins, outs, attrs, &hash)) return;
+    if (size_ >= kMaxSize) Clear();
+    auto entry = std::make_unique<Entry>(std::move(result));
+    entry->op_info = &op.Info();
+    entry->place = place;
+    BuildVarKeys(ins, &entry->ins);
+    BuildVarKeys(outs, &entry->outs);
+    for (const auto& pair : attrs) {
+      if (IsDispatchAttr(pair.second)) entry->attrs.insert(pair);
+    }
+    entries_[hash].push_back(std::move(entry));
+    ++size_;
+  }
+
+  size_t size() const { return size_; }
+
+  void Clear() {
+    entries_.clear();
+    size_ = 0;
+  }
+
+ private:
+  using VarKeys =
+      std::vector<std::pair<std::string, std::vector<DispatchVarKey>>>;
+
+  struct Entry {
+    explicit Entry(DispatchResult&& result) : result(std::move(result)) {}
+
+    template <typename VarMap>
+    bool Matches(const framework::OperatorBase& op,
+                 const platform::Place& place,
+                 const VarMap& ins,
+                 const VarMap& outs,
+                 const framework::AttributeMap& attrs) const {
+      return op_info == &op.Info() && place == this->place &&
+             VarKeysMatch(this->ins, ins) && VarKeysMatch(this->outs, outs) &&
+             AttrsMatch(attrs);
+    }
+
+    bool AttrsMatch(const framework::AttributeMap& attrs) const {
+      size_t num_attrs = 0;
+      for (const auto& pair : attrs) {
+        if (!IsDispatchAttr(pair.second)) continue;
+        auto it = this->attrs.find(pair.first);
+        if (it == this->attrs.end() ||
+            !DispatchAttrsEqual(it->second, pair.second)) {
+          return false;
+        }
+        ++num_attrs;
+      }
+      return num_attrs == this->attrs.size();
+    }
+
+    const framework::OpInfo* op_info{nullptr};
+    platform::Place place;
+    VarKeys ins;
+    VarKeys outs;
+    // The attributes of IsDispatchAttr.
+    framework::AttributeMap attrs;
+    DispatchResult result;
+  };
+
+  template <typename VarMap>
+  static bool VarKeysMatch(const VarKeys& keys, const VarMap& vars) {
+    if (keys.size() != vars.size()) return false;
+    auto key_it = keys.begin();
+    DispatchVarKey var_key;
+    for (const auto& pair : vars) {
+      if (key_it->first != pair.first ||
+          key_it->second.size() != pair.second.size()) {
+        return false;
+      }
+      for (size_t i = 0; i < pair.second.size(); ++i) {
+        MakeDispatchVarKey(pair.second[i], &var_key);
+        if (!(var_key == key_it->second[i])) return false;
+      }
+      ++key_it;
+    }
+    return true;
+  }
+
+  template <typename VarMap>
+  static void BuildVarKeys(const VarMap& vars, VarKeys* keys) {
+    keys->reserve(vars.size());
+    for (const auto& pair : vars) {
+      std::vector<DispatchVarKey> var_keys(pair.second.size());
+      for (size_t i = 0; i < pair.second.size(); ++i) {
+        MakeDispatchVarKey(pair.second[i], &var_keys[i]);
+      }
+      keys->emplace_back(pair.first, std::move(var_keys));
+    }
+  }
+
+  template <typename VarMap>
+  static bool HashVars(const VarMap& vars, size_t* hash) {
+    DispatchVarKey var_key;
+    for (const auto& pair : vars) {
+      *hash =
+          DispatchHashCombine(*hash, std::hash<std::string>()(pair.first));
+      for (const auto& var : pair.second) {
+        if (!MakeDispatchVarKey(var, &var_key)) return false;
+        *hash = DispatchHashCombine(*hash, var_key.Hash());
+      }
+    }
+    return true;
+  }
+
+  template <typename VarMap>
+  static bool Hash(const framework::OperatorBase& op,
+                   const platform::Place& place,
+                   const VarMap& ins,
+                   const VarMap& outs,
+                   const framework::AttributeMap& attrs,
+                   size_t* hash) {
+    *hash = std::hash<const void*>()(&op.Info());
+    *hash = DispatchHashCombine(*hash, place.HashValue());
+    if (!HashVars(ins, hash) || !HashVars(outs, hash)) return false;
+    *hash = DispatchHashCombine(*hash, HashDispatchAttrs(attrs));
+    return true;
+  }
+
+  std::unordered_map<size_t, std::vector<std::unique_ptr<Entry>>> entries_;
+  size_t size_{0};
+};
+
+}  // namespace imperative
+}  // namespace paddle
@@ -17,6 +17,7 @@
 #include "paddle/fluid/eager/eager_tensor.h"
 #include "paddle/fluid/framework/data_type_transform.h"
 #include "paddle/fluid/framework/details/nan_inf_utils.h"
+#include "paddle/fluid/imperative/dispatch_cache.h"
 #include "paddle/fluid/imperative/infer_shape_context.h"
 #include "paddle/fluid/imperative/tracer.h"
 #include "paddle/phi/common/int_array.h"
@@ -33,6 +34,7 @@
 DECLARE_bool(check_nan_inf);
 DECLARE_bool(benchmark);
 DECLARE_bool(run_kp_kernel);
+DECLARE_bool(dygraph_dispatch_cache);
 
 namespace paddle {
 namespace imperative {
@@ -176,6 +178,41 @@ PreparedOp PrepareImpl(
   // choose is:
   // phi npu kernel > fluid npu kernel > phi cpu kernel > fluid cpu kernel
 
+  // 0. reuse the kernel chosen for the same inputs and attributes before
+  bool use_dispatch_cache = FLAGS_dygraph_dispatch_cache;
+#ifdef PADDLE_WITH_MKLDNN
+  // The choice of the MKLDNN kernels also depends on the thread local state
+  // of MKLDNN.
+  use_dispatch_cache = use_dispatch_cache && !FLAGS_use_mkldnn;
+#endif
+#ifdef PADDLE_WITH_XPU_KP
+  use_dispatch_cache = use_dispatch_cache && !FLAGS_run_kp_kernel;
+#endif
+  auto& dispatch_cache = DygraphDispatchCache::Instance();
+  if (use_dispatch_cache) {
+    const auto* cached = dispatch_cache.Find(op, place, ins, outs, attrs);
+    if (cached != nullptr) {
+      auto* cached_dev_ctx = pool.Get(cached->kernel_type.place_);
+      if (cached->phi_kernel != nullptr) {
+        return PreparedOp(op,
+                          empty_ctx,
+                          cached->kernel_type,
+                          cached->arg_map_fn,
+                          cached->default_kernel_signature,
+                          phi::KernelSignature(cached->kernel_signature),
+                          *cached->phi_kernel,
+                          cached_dev_ctx);
+      }
+      return PreparedOp(op,
+                        empty_ctx,
+                        cached->kernel_type,
+                        *cached->func,
+                        cached->arg_map_fn,
+                        cached->default_kernel_signature,
+                        cached_dev_ctx);
+    }
+  }
+
   // 1. get expected kernel key
   auto dygraph_exe_ctx = DygraphExecutionContext<VarType>(
       op, empty_scope, *dev_ctx, empty_ctx, ins, outs, attrs, default_attrs);
@@ -211,6 +248,20 @@ PreparedOp PrepareImpl(
     }
   }
 
+  auto cache_dispatch =
+      [&](const framework::OpKernelType& kernel_type,
+          const phi::Kernel* phi_kernel,
+          const framework::OperatorWithKernel::OpKernelFunc* func) {
+        if (!use_dispatch_cache) return;
+        DispatchResult result(kernel_type);
+        result.arg_map_fn = arg_map_fn;
+        result.default_kernel_signature = default_kernel_signature;
+        result.kernel_signature = kernel_signature;
+        result.phi_kernel = phi_kernel;
+        result.func = func;
+        dispatch_cache.Insert(op, place, ins, outs, attrs, std::move(result));
+      };
+
   if (has_phi_kernel) {
     VLOG(6) << kernel_signature;
     pt_kernel_name = kernel_signature.name;
@@ -270,6 +321,7 @@ PreparedOp PrepareImpl(
         dev_ctx = pool.Get(expected_kernel_key.place_);
       }
 
+      cache_dispatch(expected_kernel_key, &phi_kernel, nullptr);
       return PreparedOp(op,
                         empty_ctx,
                         expected_kernel_key,
@@ -325,10 +377,13 @@ PreparedOp PrepareImpl(
                 << " | kernel key: " << pt_cpu_kernel_key
                 << " | kernel: " << pt_cpu_kernel;
         auto* cpu_ctx = pool.Get(paddle::platform::CPUPlace());
+        auto cpu_kernel_type =
+            framework::TransPhiKernelKeyToOpKernelType(pt_cpu_kernel_key);
+        cache_dispatch(cpu_kernel_type, &pt_cpu_kernel, nullptr);
         return PreparedOp(
             op,
             empty_ctx,
-            framework::TransPhiKernelKeyToOpKernelType(pt_cpu_kernel_key),
+            cpu_kernel_type,
             arg_map_fn,
             default_kernel_signature,
             std::move(kernel_signature),
@@ -437,6 +492,7 @@ PreparedOp PrepareImpl(
     dev_ctx = pool.Get(expected_kernel_key.place_);
   }
 
+  cache_dispatch(expected_kernel_key, nullptr, &kernel_iter->second);
   return PreparedOp(op,
                     empty_ctx,
                     expected_kernel_key,
@@ -24,6 +24,7 @@
 
 #include "gtest/gtest.h"
 #include "paddle/fluid/framework/op_info.h"
+#include "paddle/fluid/imperative/dispatch_cache.h"
 #include "paddle/fluid/imperative/prepared_operator.h"
 #include "paddle/fluid/imperative/type_defs.h"
 #include "paddle/phi/core/kernel_registry.h"
@@ -114,6 +115,78 @@ TEST(test_prepare_op, test_prepare_op) {
                               {}));
 }
 
+TEST(test_prepare_op, test_prepare_op_dispatch_cache) {
+  std::shared_ptr<imperative::VarBase> vin(
+      new imperative::VarBase(false, "vin"));
+  std::shared_ptr<imperative::VarBase> vout(
+      new imperative::VarBase(false, "vout"));
+  platform::CPUPlace place;
+  auto* vin_tensor = vin->MutableVar()->GetMutable<framework::LoDTensor>();
+  vin_tensor->Resize(phi::make_ddim({2, 5}));
+  vin_tensor->mutable_data<float>(place);
+  imperative::NameVarBaseMap ins = {var_pair("X", vb_vector(1, vin))};
+  imperative::NameVarBaseMap outs = {var_pair("Out", vb_vector(1, vout))};
+  const std::string op_type = "relu";
+  framework::AttributeMap attr_map;
+  const auto& info = framework::OpInfoMap::Instance().Get(op_type);
+  if (info.Checker()) info.Checker()->Check(&attr_map);
+  auto op = framework::OpRegistry::CreateOp(
+      op_type,
+      CreateVarNameMap(info, op_type, ins, true),
+      CreateVarNameMap(info, op_type, outs, false),
+      attr_map);
+  auto& op_with_kernel = dynamic_cast<framework::OperatorWithKernel&>(*op);
+
+  auto& cache = DygraphDispatchCache::Instance();
+  cache.Clear();
+  auto prepared_op =
+      PreparedOp::Prepare(ins, outs, op_with_kernel, place, attr_map, {});
+  ASSERT_EQ(cache.size(), 1UL);
+  ASSERT_NE(cache.Find(op_with_kernel, place, ins, outs, attr_map), nullptr);
+  // Prepared again from the cache
+  auto cached_op =
+      PreparedOp::Prepare(ins, outs, op_with_kernel, place, attr_map, {});
+  ASSERT_EQ(cache.size(), 1UL);
+  ASSERT_EQ(cached_op.kernel_type(), prepared_op.kernel_type());
+
+  // Another data type chooses another kernel
+  vin_tensor->mutable_data<double>(place);
+  ASSERT_EQ(cache.Find(op_with_kernel, place, ins, outs, attr_map), nullptr);
+  auto double_op =
+      PreparedOp::Prepare(ins, outs, op_with_kernel, place, attr_map, {});
+  ASSERT_EQ(cache.size(), 2UL);
+  ASSERT_EQ(double_op.kernel_type().data_type_,
+            framework::proto::VarType::FP64);
+
+  // So do other attributes
+  framework::AttributeMap other_attr_map = attr_map;
+  other_attr_map["use_cudnn"] = true;
+  ASSERT_EQ(cache.Find(op_with_kernel, place, ins, outs, other_attr_map),
+            nullptr);
+
+  // But not the floating point ones, which are not part of the key
+  framework::AttributeMap float_attr_map = attr_map;
+  float_attr_map["scale"] = 2.0f;
+  ASSERT_NE(cache.Find(op_with_kernel, place, ins, outs, float_attr_map),
+            nullptr);
+
+  // Of the floating point vectors only whether they are empty is compared
+  framework::AttributeMap values_attr_map = attr_map;
+  values_attr_map["fp32_values"] = std::vector<float>{1.0f};
+  cache.Insert(op_with_kernel,
+               place,
+               ins,
+               outs,
+               values_attr_map,
+               DispatchResult(double_op.kernel_type()));
+  values_attr_map["fp32_values"] = std::vector<float>{2.0f, 3.0f};
+  ASSERT_NE(cache.Find(op_with_kernel, place, ins, outs, values_attr_map),
+            nullptr);
+  values_attr_map["fp32_values"] = std::vector<float>();
+  ASSERT_EQ(cache.Find(op_with_kernel, place, ins, outs, values_attr_map),
+            nullptr);
+}
+
 const framework::Tensor* GetTensorFromVar(const framework::Variable& var);
 
 TEST(test_prepare_op, test_get_tensor_from_var) {
@@ -147,6 +147,9 @@ struct Argument {
   DECL_ARGUMENT_FIELD(model_program_path, ModelProgramPath, std::string);
   DECL_ARGUMENT_FIELD(model_params_path, ModelParamsPath, std::string);
   DECL_ARGUMENT_FIELD(model_from_memory, ModelFromMemory, bool);
+  // Memory map the combined parameters file instead of deserializing it.
+  DECL_ARGUMENT_FIELD(use_mmap_params, UseMmapParams, bool);
+  DECL_ARGUMENT_FIELD(mmap_params_lazy_load, MmapParamsLazyLoad, bool);
   DECL_ARGUMENT_FIELD(optim_cache_dir, OptimCacheDir, std::string);
   DECL_ARGUMENT_FIELD(enable_analysis_optim, EnableAnalysisOptim, bool);
 
@@ -36,10 +36,13 @@ limitations under the License. */
 #include <io.h>
 #define GCC_ATTRIBUTE(attr__)
 #define MKDIR(path) _mkdir(path)
+#define RMDIR(path) _rmdir(path)
 #else
+#include <dirent.h>
 #include <unistd.h>
 #define GCC_ATTRIBUTE(attr__) __attribute__((attr__));
 #define MKDIR(path) mkdir(path, S_IRWXU | S_IRWXG | S_IROTH | S_IXOTH)
+#define RMDIR(path) rmdir(path)
 #endif
 #define __SHOULD_USE_RESULT__ GCC_ATTRIBUTE(warn_unused_result)
 
@@ -189,6 +192,30 @@ static bool PathExists(const std::string &path) {
   return false;
 }
 
+// The names of the files and directories in path, without "." and "..".
+static std::vector<std::string> ListDir(const std::string &path) {
+  std::vector<std::string> names;
+#ifdef _WIN32
+  struct _finddata_t data;
+  intptr_t handle = _findfirst((path + "/*").c_str(), &data);
+  if (handle == -1) return names;
+  do {
+    std::string name = data.name;
+    if (name != "." && name != "..") names.push_back(name);
+  } while (_findnext(handle, &data) == 0);
+  _findclose(handle);
+#else
+  DIR *dir = opendir(path.c_str());
+  if (dir == nullptr) return names;
+  while (struct dirent *entry = readdir(dir)) {
+    std::string name = entry->d_name;
+    if (name != "." && name != "..") names.push_back(name);
+  }
+  closedir(dir);
+#endif
+  return names;
+}
+
 static std::string GetDirRoot(const std::string &path) {
   char sep_1 = '/', sep_2 = '\\';
 
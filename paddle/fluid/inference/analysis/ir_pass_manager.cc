@@ -14,8 +14,12 @@
 
 #include "paddle/fluid/inference/analysis/ir_pass_manager.h"
 
+#include <algorithm>
+#include <chrono>
+#include <functional>
 #include <map>
 #include <memory>
+#include <sstream>
 #include <string>
 #include <unordered_map>
 #include <unordered_set>
@@ -283,7 +287,9 @@ std::unique_ptr<Graph> IRPassManager::Apply(std::unique_ptr<Graph> graph) {
   PADDLE_ENFORCE_NOT_NULL(
       graph.get(),
       platform::errors::PreconditionNotMet("Graph cannot be NULL."));
-  // Apply all the passes
+  // Apply all the passes, timing each of them.
+  std::vector<std::pair<double, std::string>> pass_times;
+  double total_time = 0;
   for (const auto &pass : passes_) {
     if (pass->Type() != "graph_viz_pass" && !disable_logs_) {
       PrettyLogEndl(Style::H2(), "--- Running IR pass [%s]", pass->Type());
@@ -293,7 +299,28 @@ std::unique_ptr<Graph> IRPassManager::Apply(std::unique_ptr<Graph> graph) {
       bool use_dynamic = pass->Get<bool>("with_dynamic_shape");
       if (use_dynamic) continue;
     }
+    auto start = std::chrono::steady_clock::now();
     graph.reset(pass->Apply(graph.release()));
+    double time = std::chrono::duration<double, std::milli>(
+                      std::chrono::steady_clock::now() - start)
+                      .count();
+    VLOG(3) << "IR pass [" << pass->Type() << "] took " << time << " ms";
+    pass_times.emplace_back(time, pass->Type());
+    total_time += time;
+  }
+  if (!disable_logs_ && !pass_times.empty()) {
+    std::sort(pass_times.begin(),
+              pass_times.end(),
+              std::greater<std::pair<double, std::string>>());
+    pass_times.resize(std::min<size_t>(pass_times.size(), 5));
+    std::stringstream slowest;
+    for (const auto &pass_time : pass_times) {
+      slowest << " " << pass_time.second << ": " << pass_time.first << "ms";
+    }
+    PrettyLogEndl(Style::H2(),
+                  "--- IR passes took %.3fms, the slowest:%s",
+                  total_time,
+                  slowest.str());
   }
   return graph;
 }
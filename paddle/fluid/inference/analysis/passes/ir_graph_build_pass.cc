@@ -55,7 +55,10 @@ void IrGraphBuildPass::RunImpl(Argument *argument) {
         argument->model_params_path(),
         argument->scope_ptr(),
         place,
-        argument->model_from_memory_valid() && argument->model_from_memory());
+        argument->model_from_memory_valid() && argument->model_from_memory(),
+        argument->use_mmap_params_valid() && argument->use_mmap_params(),
+        argument->mmap_params_lazy_load_valid() &&
+            argument->mmap_params_lazy_load());
     argument->SetMainProgram(program.release());
   } else {
     PADDLE_THROW(platform::errors::PreconditionNotMet(
@@ -110,9 +113,14 @@ std::unique_ptr<framework::ProgramDesc> IrGraphBuildPass::LoadModel(
     const std::string &params_path,
     framework::Scope *scope,
     const platform::Place &place,
-    bool model_from_memory) {
+    bool model_from_memory,
+    bool use_mmap_params,
+    bool mmap_params_lazy_load) {
   framework::Executor exe(place);
-  if (!model_from_memory) {
+  if (!model_from_memory && use_mmap_params) {
+    return LoadWithMmapParams(
+        &exe, scope, program_path, params_path, mmap_params_lazy_load);
+  } else if (!model_from_memory) {
     return Load(&exe, scope, program_path, params_path);
   } else {
     return LoadFromMemory(&exe, scope, program_path, params_path);
@@ -43,7 +43,9 @@ class IrGraphBuildPass : public AnalysisPass {
       const std::string &params_path,
       framework::Scope *scope,
       const platform::Place &place,
-      bool model_from_memory);
+      bool model_from_memory,
+      bool use_mmap_params,
+      bool mmap_params_lazy_load);
 
   std::string model_binary_str_;
 };
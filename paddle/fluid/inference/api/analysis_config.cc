@@ -260,6 +260,9 @@ AnalysisConfig::AnalysisConfig(const AnalysisConfig &other) {
   CP_MEMBER(mixed_black_list_);
 
   CP_MEMBER(enable_memory_optim_);
+  CP_MEMBER(use_memory_mapped_params_);
+  CP_MEMBER(memory_mapped_params_lazy_load_);
+  CP_MEMBER(optimized_program_cache_dir_);
   // TensorRT related.
   CP_MEMBER(use_tensorrt_);
   CP_MEMBER(tensorrt_workspace_size_);
@@ -296,6 +299,10 @@ AnalysisConfig::AnalysisConfig(const AnalysisConfig &other) {
   CP_MEMBER(quantize_excluded_op_ids_);
   CP_MEMBER(use_mkldnn_quantizer_);
   CP_MEMBER(mkldnn_quantizer_config_);
+  CP_MEMBER(use_cpu_quantizer_);
+  CP_MEMBER(cpu_quantizer_warmup_data_);
+  CP_MEMBER(cpu_quantizer_scale_algo_);
+  CP_MEMBER(cpu_quantizer_percentile_);
   CP_MEMBER(min_input_shape_);
   CP_MEMBER(max_input_shape_);
   CP_MEMBER(optim_input_shape_);
@@ -335,6 +342,12 @@ AnalysisConfig::AnalysisConfig(const AnalysisConfig &other) {
   CP_MEMBER(specify_input_name_);
 
   CP_MEMBER(cpu_math_library_num_threads_);
+  CP_MEMBER(cpu_intra_op_num_threads_);
+  CP_MEMBER(cpu_packed_weight_cache_);
+  CP_MEMBER(cpu_autotune_);
+  CP_MEMBER(cpu_autotune_cache_file_);
+  CP_MEMBER(shared_cpu_runtime_model_);
+  CP_MEMBER(shared_cpu_runtime_max_concurrency_);
 
   CP_MEMBER(serialized_info_cache_);
 
@@ -456,6 +469,36 @@ void AnalysisConfig::EnableMkldnnQuantizer() {
   Update();
 }
 
+void AnalysisConfig::EnableCpuQuantizer(
+    std::shared_ptr<std::vector<std::vector<PaddleTensor>>> warmup_data,
+    ScaleAlgo scale_algo,
+    float percentile) {
+  PADDLE_ENFORCE_EQ(
+      warmup_data && !warmup_data->empty(),
+      true,
+      platform::errors::InvalidArgument(
+          "The CPU quantizer needs at least one warmup batch."));
+  PADDLE_ENFORCE_EQ(
+      scale_algo == ScaleAlgo::KL || scale_algo == ScaleAlgo::PERCENTILE ||
+          scale_algo == ScaleAlgo::MAX,
+      true,
+      platform::errors::InvalidArgument(
+          "The CPU quantizer only supports the KL, PERCENTILE and MAX scale "
+          "algorithms."));
+  PADDLE_ENFORCE_EQ(
+      percentile > 0.f && percentile <= 100.f,
+      true,
+      platform::errors::InvalidArgument(
+          "The percentile should be in (0, 100], but received %f.",
+          percentile));
+  use_cpu_quantizer_ = true;
+  cpu_quantizer_warmup_data_ = warmup_data;
+  cpu_quantizer_scale_algo_ = scale_algo;
+  cpu_quantizer_percentile_ = percentile;
+
+  Update();
+}
+
 void AnalysisConfig::EnableMkldnnBfloat16() {
 #ifdef PADDLE_WITH_MKLDNN
   if (platform::MayIUse(platform::cpu_isa_t::avx512_core)) {
@@ -705,6 +748,11 @@ void AnalysisConfig::Update() {
 #endif
   }
 
+  if (use_cpu_quantizer_ && !enable_ir_optim_) {
+    LOG(ERROR) << "EnableCpuQuantizer() only works when IR optimization "
+                  "is enabled.";
+  }
+
   if (use_mkldnn_bfloat16_) {
 #ifdef PADDLE_WITH_MKLDNN
     pass_builder()->EnableMkldnnBfloat16();
@@ -824,6 +872,8 @@ std::string AnalysisConfig::SerializeInfoCache() {
   ss << trt_dla_core_;
 
   ss << enable_memory_optim_;
+  ss << use_memory_mapped_params_;
+  ss << memory_mapped_params_lazy_load_;
 
   ss << use_mkldnn_;
   ss << mkldnn_cache_capacity_;
@@ -831,6 +881,9 @@ std::string AnalysisConfig::SerializeInfoCache() {
   ss << ";";
 
   ss << use_mkldnn_quantizer_;
+  ss << use_cpu_quantizer_;
+  ss << static_cast<int>(cpu_quantizer_scale_algo_);
+  ss << cpu_quantizer_percentile_;
   ss << use_mkldnn_bfloat16_;
   for (auto &item : bfloat16_enabled_op_types_) ss << item;
   ss << use_mkldnn_int8_;
@@ -849,6 +902,12 @@ std::string AnalysisConfig::SerializeInfoCache() {
 
   ss << specify_input_name_;
   ss << cpu_math_library_num_threads_;
+  ss << cpu_intra_op_num_threads_;
+  ss << cpu_packed_weight_cache_;
+  ss << cpu_autotune_;
+  ss << cpu_autotune_cache_file_;
+  ss << shared_cpu_runtime_model_;
+  ss << shared_cpu_runtime_max_concurrency_;
 
   ss << use_lite_;
   ss << use_xpu_;
@@ -885,6 +944,49 @@ void AnalysisConfig::SetCpuMathLibraryNumThreads(
   Update();
 }
 
+void AnalysisConfig::SetCpuIntraOpNumThreads(int cpu_intra_op_num_threads) {
+  PADDLE_ENFORCE_GE(cpu_intra_op_num_threads,
+                    1,
+                    platform::errors::InvalidArgument(
+                        "The number of intra op threads should be at least 1, "
+                        "but received %d.",
+                        cpu_intra_op_num_threads));
+  cpu_intra_op_num_threads_ = cpu_intra_op_num_threads;
+
+  Update();
+}
+
+void AnalysisConfig::EnableCpuPackedWeightCache(bool x) {
+  cpu_packed_weight_cache_ = x;
+
+  Update();
+}
+
+void AnalysisConfig::EnableCpuAutoTune(const std::string &cache_file) {
+  cpu_autotune_ = true;
+  cpu_autotune_cache_file_ = cache_file;
+
+  Update();
+}
+
+void AnalysisConfig::AttachSharedCPURuntime(const std::string &model_name,
+                                            int max_concurrency) {
+  PADDLE_ENFORCE_EQ(model_name.empty(),
+                    false,
+                    platform::errors::InvalidArgument(
+                        "The model name in the shared CPU runtime should not "
+                        "be empty."));
+  PADDLE_ENFORCE_GT(max_concurrency,
+                    0,
+                    platform::errors::InvalidArgument(
+                        "The max concurrency should be > 0, but got %d.",
+                        max_concurrency));
+  shared_cpu_runtime_model_ = model_name;
+  shared_cpu_runtime_max_concurrency_ = max_concurrency;
+
+  Update();
+}
+
 float AnalysisConfig::fraction_of_gpu_memory_for_pool() const {
 #if defined(PADDLE_WITH_CUDA) || defined(PADDLE_WITH_HIP)
   // Get the GPU memory details and calculate the fraction of memory for the
@@ -914,6 +1016,22 @@ bool AnalysisConfig::enable_memory_optim() const {
   return enable_memory_optim_;
 }
 
+void AnalysisConfig::EnableMemoryMappedParams(bool x, bool lazy_load) {
+  use_memory_mapped_params_ = x;
+  memory_mapped_params_lazy_load_ = lazy_load;
+  Update();
+}
+
+void AnalysisConfig::EnableOptimizedProgramCache(const std::string &cache_dir) {
+  PADDLE_ENFORCE_EQ(cache_dir.empty(),
+                    false,
+                    platform::errors::InvalidArgument(
+                        "The directory of the optimized program cache should "
+                        "not be empty."));
+  optimized_program_cache_dir_ = cache_dir;
+  Update();
+}
+
 void AnalysisConfig::SetModelBuffer(const char *prog_buffer,
                                     size_t prog_buffer_size,
                                     const char *param_buffer,
@@ -991,9 +1109,25 @@ std::string AnalysisConfig::Summary() {
   // cpu info
   os.InsertRow(
       {"cpu_math_thread", std::to_string(cpu_math_library_num_threads_)});
+  if (cpu_intra_op_num_threads_ > 1) {
+    os.InsertRow({"cpu_intra_op_thread",
+                  std::to_string(cpu_intra_op_num_threads_)});
+  }
+  os.InsertRow({"cpu_packed_weight_cache",
+                cpu_packed_weight_cache_ ? "true" : "false"});
+  os.InsertRow({"cpu_autotune", cpu_autotune_ ? "true" : "false"});
+  if (cpu_autotune_ && !cpu_autotune_cache_file_.empty()) {
+    os.InsertRow({"cpu_autotune_cache_file", cpu_autotune_cache_file_});
+  }
+  if (shared_cpu_runtime_attached()) {
+    os.InsertRow({"shared_cpu_runtime_model", shared_cpu_runtime_model_});
+    os.InsertRow({"shared_cpu_runtime_max_concurrency",
+                  std::to_string(shared_cpu_runtime_max_concurrency_)});
+  }
   os.InsertRow({"enable_mkldnn", use_mkldnn_ ? "true" : "false"});
   os.InsertRow(
       {"mkldnn_cache_capacity", std::to_string(mkldnn_cache_capacity_)});
+  os.InsertRow({"cpu_quantizer", use_cpu_quantizer_ ? "true" : "false"});
   os.InsetDivider();
 
   // gpu info
@@ -1089,6 +1223,13 @@ std::string AnalysisConfig::Summary() {
   os.InsertRow({"ir_optim", enable_ir_optim_ ? "true" : "false"});
   os.InsertRow({"ir_debug", ir_debug_ ? "true" : "false"});
   os.InsertRow({"memory_optim", enable_memory_optim_ ? "true" : "false"});
+  if (use_memory_mapped_params_) {
+    os.InsertRow({"memory_mapped_params",
+                  memory_mapped_params_lazy_load_ ? "lazy" : "eager"});
+  }
+  if (!optimized_program_cache_dir_.empty()) {
+    os.InsertRow({"optimized_program_cache", optimized_program_cache_dir_});
+  }
   os.InsertRow({"enable_profile", with_profile_ ? "true" : "false"});
   os.InsertRow({"enable_log", with_glog_info_ ? "true" : "false"});
   os.InsertRow({"collect_shape_range_info",
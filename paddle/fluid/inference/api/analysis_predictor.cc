@@ -15,12 +15,21 @@
 #include "paddle/fluid/inference/api/analysis_predictor.h"
 
 #include <glog/logging.h>
+#include <sys/stat.h>
+#include <xxhash.h>
 
 #include <algorithm>
+#include <cstdio>
 #include <fstream>
+#include <functional>
+#include <iterator>
+#include <limits>
 #include <memory>
+#include <random>
 #include <set>
+#include <sstream>
 #include <string>
+#include <unordered_set>
 #include <utility>
 #include <vector>
 
@@ -38,6 +47,7 @@
 #include "paddle/fluid/inference/analysis/helper.h"
 #include "paddle/fluid/inference/analysis/passes/convert_to_mixed_precision.h"
 #include "paddle/fluid/inference/analysis/passes/memory_optimize_pass.h"
+#include "paddle/fluid/inference/api/cpu_quantizer.h"
 #include "paddle/fluid/inference/api/helper.h"
 #include "paddle/fluid/inference/api/infer_context.h"
 #include "paddle/fluid/inference/api/paddle_analysis_config.h"
@@ -45,6 +55,7 @@
 #include "paddle/fluid/inference/api/paddle_inference_pass.h"
 #include "paddle/fluid/inference/api/resource_manager.h"
 #include "paddle/fluid/inference/utils/io_utils.h"
+#include "paddle/fluid/inference/utils/mmap_params_loader.h"
 #include "paddle/fluid/inference/utils/model_utils.h"
 #include "paddle/fluid/inference/utils/singleton.h"
 #include "paddle/fluid/memory/memcpy.h"
@@ -58,6 +69,9 @@
 #include "paddle/phi/common/data_type.h"
 #include "paddle/phi/common/place.h"
 #include "paddle/phi/core/enforce.h"
+#include "paddle/phi/kernels/autotune/cache.h"
+#include "paddle/phi/kernels/autotune/switch_autotune.h"
+#include "paddle/phi/kernels/funcs/blas/packed_weight_cache.h"
 #include "paddle/utils/string/split.h"
 
 #if defined(PADDLE_WITH_DISTRIBUTE) && defined(PADDLE_WITH_PSCORE)
@@ -146,6 +160,71 @@ phi::Backend ConvertBackend(AnalysisConfig::Backend backend) {
       return phi::Backend::CPU;
   }
 }
+
+// The most optimized programs a cache directory keeps. Past it, the ones
+// written first are removed.
+constexpr size_t kMaxOptimizedPrograms = 8;
+
+// The most input dims whose intermediate tensor bytes a predictor keeps.
+// Past it, they are all computed again.
+constexpr size_t kMaxIntermediateTensorBytes = 64;
+
+// Appends the 64 bit digest of the data to key.
+void AppendDigest(const char *data, size_t size, std::ostream *key) {
+  *key << " size " << size << " xxh64 " << XXH64(data, size, 0);
+}
+
+// Appends the name, the size and the 64 bit digest of the content of the
+// file in path to key, false if it can not be read. The path and the
+// modification time are left out, so that the copies of a model share the
+// key.
+bool AppendFileDigest(const std::string &name,
+                      const std::string &path,
+                      std::ostream *key) {
+  std::ifstream fin(path, std::ios::in | std::ios::binary);
+  if (!fin.is_open()) return false;
+  std::unique_ptr<XXH64_state_t, XXH_errorcode (*)(XXH64_state_t *)> state(
+      XXH64_createState(), XXH64_freeState);
+  XXH64_reset(state.get(), 0);
+  std::vector<char> chunk(1 << 20);
+  size_t size = 0;
+  while (fin) {
+    fin.read(chunk.data(), chunk.size());
+    size_t count = static_cast<size_t>(fin.gcount());
+    XXH64_update(state.get(), chunk.data(), count);
+    size += count;
+  }
+  *key << name << " size " << size << " xxh64 " << XXH64_digest(state.get())
+       << "\n";
+  return true;
+}
+
+// Removes the cache entry in path, the key first so that it is not found
+// while the other files go.
+void RemoveOptimizedProgram(const std::string &path) {
+  for (const char *file : {"/key", "/model", "/params"}) {
+    std::remove((path + file).c_str());
+  }
+  RMDIR(path.c_str());
+}
+
+// Removes the entries written first past kMaxOptimizedPrograms.
+void EvictOptimizedPrograms(const std::string &cache_dir) {
+  std::vector<std::pair<time_t, std::string>> entries;
+  for (auto &name : inference::analysis::ListDir(cache_dir)) {
+    struct stat info;
+    if (name.find(".tmp.") != std::string::npos ||
+        stat((cache_dir + "/" + name + "/key").c_str(), &info) != 0) {
+      continue;
+    }
+    entries.emplace_back(info.st_mtime, name);
+  }
+  if (entries.size() <= kMaxOptimizedPrograms) return;
+  std::sort(entries.begin(), entries.end());
+  for (size_t i = 0; i + kMaxOptimizedPrograms < entries.size(); ++i) {
+    RemoveOptimizedProgram(cache_dir + "/" + entries[i].second);
+  }
+}
 }  // namespace
 
 bool PaddleTensorToLoDTensor(const PaddleTensor &pt,
@@ -249,6 +328,14 @@ bool AnalysisPredictor::Init(
   // no matter with or without MKLDNN
   paddle::platform::SetNumThreads(config_.cpu_math_library_num_threads());
 
+  if (config_.shared_cpu_runtime_attached()) {
+    ResourceManager::Instance().GetSharedCPURuntime()->RegisterModel(
+        config_.shared_cpu_runtime_model(),
+        config_.shared_cpu_runtime_max_concurrency(),
+        config_.cpu_math_library_num_threads());
+    attached_to_shared_cpu_runtime_ = true;
+  }
+
   if (!PrepareScope(parent_scope)) {
     return false;
   }
@@ -292,9 +379,84 @@ bool AnalysisPredictor::Init(
     }
   }
 #endif
+  // The intra op threads belong to a CPU context private to the predictor,
+  // so that the clones and the other predictors do not share them.
+  if (platform::is_cpu_place(place_) &&
+      config_.cpu_intra_op_num_threads() > 1) {
+    private_context_ = true;
+    InitDeviceContexts();
+  }
+  if (platform::is_cpu_place(place_) &&
+      config_.cpu_packed_weight_cache_enabled()) {
+    RegisterPackedWeights();
+  }
+  if (platform::is_cpu_place(place_) && config_.cpu_autotune_enabled()) {
+    InitCpuAutoTune();
+  }
   return true;
 }
 
+void AnalysisPredictor::InitCpuAutoTune() {
+  const auto &cache_file = config_.cpu_autotune_cache_file();
+  if (!cache_file.empty() && inference::IsFileExists(cache_file)) {
+    auto count = phi::autotune::AutoTuneCache::Instance().Load(cache_file);
+    LOG(INFO) << "Loaded " << count << " tuned CPU kernel choices from "
+              << cache_file;
+    return;
+  }
+  // The autotune is only turned on in the runs of this predictor, so that
+  // the other ones in the process keep their kernels.
+  cpu_autotune_ = true;
+  save_autotune_cache_ = !cache_file.empty();
+}
+
+void AnalysisPredictor::RegisterPackedWeights() {
+  // Only the B matrices of the GEMM ops, which no op of the program writes,
+  // stay the same through the runs.
+  static const std::map<std::string, std::string> kWeightInputs = {
+      {"fc", "W"}, {"matmul", "Y"}, {"matmul_v2", "Y"}, {"mul", "Y"}};
+  std::set<std::string> weights;
+  std::set<std::string> outputs;
+  for (size_t i = 0; i < inference_program_->Size(); ++i) {
+    for (auto *op : inference_program_->Block(i).AllOps()) {
+      for (auto &name : op->OutputArgumentNames()) {
+        outputs.insert(name);
+      }
+      auto it = kWeightInputs.find(op->Type());
+      if (it == kWeightInputs.end() || !op->Inputs().count(it->second)) {
+        continue;
+      }
+      for (auto &name : op->Input(it->second)) {
+        weights.insert(name);
+      }
+    }
+  }
+
+  auto &cache = phi::funcs::PackedWeightCache::Instance();
+  auto &block = inference_program_->Block(0);
+  for (auto &name : weights) {
+    if (outputs.count(name)) continue;
+    auto *var = block.FindVar(name);
+    if (var == nullptr || !IsPersistable(var)) continue;
+    auto *scope_var = scope_->FindLocalVar(name);
+    if (scope_var == nullptr || !scope_var->IsType<framework::LoDTensor>()) {
+      continue;
+    }
+    const auto &tensor = scope_var->Get<framework::LoDTensor>();
+    if (!tensor.IsInitialized() ||
+        !platform::is_cpu_place(tensor.place()) ||
+        (tensor.dtype() != phi::DataType::FLOAT32 &&
+         tensor.dtype() != phi::DataType::FLOAT64)) {
+      continue;
+    }
+    cache.RegisterConstant(tensor.data(),
+                           tensor.numel() * phi::SizeOf(tensor.dtype()));
+    packed_weights_.push_back(tensor.data());
+  }
+  VLOG(3) << "Registered " << packed_weights_.size()
+          << " weights to the packed weight cache.";
+}
+
 void AnalysisPredictor::InitPlace() {
   if (config_.use_gpu()) {
     PADDLE_ENFORCE_EQ(config_.use_xpu(),
@@ -446,6 +608,17 @@ void AnalysisPredictor::InitDeviceContexts() {
         }));
   }
 #endif
+  if (place_.GetType() == phi::AllocationType::CPU) {
+    platform::EmplaceDeviceContexts(&device_contexts_,
+                                    {place_},
+                                    /*disable_setting_default_stream=*/false);
+    auto *cpu_context = dynamic_cast<phi::CPUContext *>(
+        device_contexts_.at(place_).get().get());
+    PADDLE_ENFORCE_NOT_NULL(
+        cpu_context,
+        platform::errors::Fatal("The private CPU context is not created."));
+    cpu_context->SetIntraOpNumThreads(config_.cpu_intra_op_num_threads());
+  }
   // TODO(Inference): Support other backends.
 }
 
@@ -888,7 +1061,7 @@ void AnalysisPredictor::MkldnnPostReset() {
 bool AnalysisPredictor::Run(const std::vector<PaddleTensor> &inputs,
                             std::vector<PaddleTensor> *output_data,
                             int batch_size) {
-  paddle::platform::SetNumThreads(config_.cpu_math_library_num_threads());
+  auto admission = AdmitRun();
 #ifdef PADDLE_WITH_MKLDNN
   if (config_.use_mkldnn_) MkldnnPreSet(inputs);
 #endif
@@ -907,7 +1080,19 @@ bool AnalysisPredictor::Run(const std::vector<PaddleTensor> &inputs,
 
   // Run the inference program
   // if share variables, we need not create variables
-  executor_->Run();
+  if (private_context_) {
+    paddle::platform::DeviceContextPool::SetDeviceContexts(&device_contexts_);
+  }
+  {
+    phi::autotune::ThreadAutoTuneGuard autotune_guard(cpu_autotune_);
+    executor_->Run();
+  }
+  if (private_context_) {
+    paddle::platform::DeviceContextPool::SetDeviceContexts(nullptr);
+  }
+  if (admission) {
+    admission->set_activation_bytes(GetIntermediateTensorBytes());
+  }
 
   // get fetch variable
   if (!GetFetch(output_data, scope)) {
@@ -1041,6 +1226,8 @@ void AnalysisPredictor::PrepareArgument() {
   argument_.SetEnableAnalysisOptim(config_.enable_ir_optim_);
   argument_.SetEnableMemoryOptim(config_.enable_memory_optim());
   argument_.SetModelFromMemory(config_.model_from_memory_);
+  argument_.SetUseMmapParams(config_.memory_mapped_params_enabled());
+  argument_.SetMmapParamsLazyLoad(config_.memory_mapped_params_lazy_load());
   // Analyze inference_program
   argument_.SetPredictorID(predictor_id_);
   argument_.SetOptimCacheDir(config_.opt_cache_dir_);
@@ -1223,6 +1410,20 @@ void AnalysisPredictor::PrepareArgument() {
 // NOTE All the members in AnalysisConfig should be copied to Argument.
 void AnalysisPredictor::OptimizeInferenceProgram() {
   PrepareArgument();
+  std::string cache_key = OptimizedProgramCacheKey();
+  std::string cache_path;
+  if (!cache_key.empty()) {
+    cache_path = config_.optimized_program_cache_dir() + "/" +
+                 std::to_string(std::hash<std::string>()(cache_key));
+    if (LoadOptimizedProgram(cache_path, cache_key)) {
+      program_from_cache_ = true;
+      argument_.PartiallyRelease();
+      config_.PartiallyRelease();
+      LOG(INFO) << "======= optimized program loaded from " << cache_path
+                << " =======";
+      return;
+    }
+  }
   Analyzer().Run(&argument_);
 
   PADDLE_ENFORCE_EQ(
@@ -1258,6 +1459,9 @@ void AnalysisPredictor::OptimizeInferenceProgram() {
 #endif
         delete prog;
       });
+  if (!cache_path.empty()) {
+    SaveOptimizedProgram(cache_path, cache_key);
+  }
   // The config and argument take a lot of storage,
   // when the predictor settings are complete, we release these stores.
   argument_.PartiallyRelease();
@@ -1265,6 +1469,162 @@ void AnalysisPredictor::OptimizeInferenceProgram() {
   LOG(INFO) << "======= optimize end =======";
 }
 
+std::string AnalysisPredictor::OptimizedProgramCacheKey() {
+  // The engines keep state out of the program, and the quantizers optimize
+  // the program again after the analysis.
+  if (!config_.optimized_program_cache_enabled() || !config_.ir_optim() ||
+      config_.tensorrt_engine_enabled() || config_.lite_engine_enabled() ||
+      config_.dlnne_enabled() || config_.use_ipu() ||
+      config_.mkldnn_quantizer_enabled() || config_.cpu_quantizer_enabled()) {
+    return "";
+  }
+  // The key holds what the passes depend on: the version, the config, the
+  // passes and the content of the model files. The stream of the config is
+  // only an address, and the model paths or buffers are left out of the
+  // config: the model files are digested below by content, so that the
+  // copies of a model in other paths share the entry.
+  void *exec_stream = config_.exec_stream_;
+  std::string model_dir, prog_file, params_file;
+  config_.exec_stream_ = nullptr;
+  model_dir.swap(config_.model_dir_);
+  prog_file.swap(config_.prog_file_);
+  params_file.swap(config_.params_file_);
+  std::string config_info = config_.SerializeInfoCache();
+  config_.exec_stream_ = exec_stream;
+  model_dir.swap(config_.model_dir_);
+  prog_file.swap(config_.prog_file_);
+  params_file.swap(config_.params_file_);
+
+  std::stringstream key;
+  key << "version: " << paddle::get_version() << "\n";
+  key << "config: " << config_info << "\n";
+  key << "ir passes:";
+  for (const auto &pass : argument_.ir_analysis_passes()) {
+    key << " " << pass;
+  }
+  key << "\nanalysis passes:";
+  for (const auto &pass : argument_.analysis_passes()) {
+    key << " " << pass;
+  }
+  key << "\nmodel:\n";
+  if (config_.model_from_memory()) {
+    key << "program";
+    AppendDigest(
+        config_.prog_file().data(), config_.prog_file().size(), &key);
+    key << "\nparams";
+    AppendDigest(
+        config_.params_file().data(), config_.params_file().size(), &key);
+    key << "\n";
+  } else if (!config_.model_dir().empty()) {
+    const std::string &dir = config_.model_dir();
+    if (!AppendFileDigest("__model__", dir + "/__model__", &key)) {
+      return "";
+    }
+    for (auto *var : inference_program_->Block(0).AllVars()) {
+      if (IsPersistable(var) &&
+          !AppendFileDigest(var->Name(), dir + "/" + var->Name(), &key)) {
+        return "";
+      }
+    }
+  } else if (!AppendFileDigest("program", config_.prog_file(), &key) ||
+             !AppendFileDigest("params", config_.params_file(), &key)) {
+    return "";
+  }
+  return key.str();
+}
+
+bool AnalysisPredictor::LoadOptimizedProgram(const std::string &path,
+                                             const std::string &key) {
+  std::ifstream key_file(path + "/key", std::ios::in | std::ios::binary);
+  if (!key_file.is_open()) return false;
+  std::string cached_key((std::istreambuf_iterator<char>(key_file)),
+                         std::istreambuf_iterator<char>());
+  if (cached_key != key) {
+    LOG(WARNING) << "The optimized program cached in " << path
+                 << " is of another model or config, ignore it";
+    return false;
+  }
+  try {
+    auto optimized_program = std::make_shared<framework::ProgramDesc>(
+        inference::analysis::LoadProgramDesc(path + "/model"));
+
+    // The parameters are loaded on the place of the predictor, as the
+    // params sync pass would have copied them.
+    if (config_.memory_mapped_params_enabled() &&
+        inference::MmapParamsSupported() && platform::is_cpu_place(place_) &&
+        inference::LoadPersistablesFromMmap(
+            *optimized_program,
+            path + "/params",
+            scope_.get(),
+            config_.memory_mapped_params_lazy_load())) {
+      inference_program_ = optimized_program;
+      return true;
+    }
+    framework::ProgramDesc load_program;
+    auto *load_block = load_program.MutableBlock(0);
+    std::vector<std::string> params;
+    for (auto *var : optimized_program->Block(0).AllVars()) {
+      if (!IsPersistable(var)) continue;
+      framework::VarDesc *new_var = load_block->Var(var->Name());
+      new_var->SetShape(var->GetShape());
+      new_var->SetDataType(var->GetDataType());
+      new_var->SetType(var->GetType());
+      new_var->SetLoDLevel(var->GetLoDLevel());
+      new_var->SetPersistable(true);
+      params.push_back(var->Name());
+    }
+    std::sort(params.begin(), params.end());
+    auto *op = load_block->AppendOp();
+    op->SetType("load_combine");
+    op->SetOutput("Out", params);
+    op->SetAttr("file_path", {path + "/params"});
+    op->CheckAttrs();
+    framework::NaiveExecutor e(place_);
+    e.Prepare(scope_.get(), load_program, 0, false);
+    e.Run();
+    inference_program_ = optimized_program;
+  } catch (const std::exception &e) {
+    LOG(WARNING) << "Failed to load the optimized program cached in " << path
+                 << ", run the analysis instead: " << e.what();
+    return false;
+  }
+  return true;
+}
+
+void AnalysisPredictor::SaveOptimizedProgram(const std::string &path,
+                                             const std::string &key) {
+  // The entry is written in a directory of its own and renamed to path, so
+  // that the predictors started together never load a partial one.
+  std::string tmp_path =
+      path + ".tmp." + std::to_string(std::random_device()());
+  const std::string &cache_dir = config_.optimized_program_cache_dir();
+  if (!inference::analysis::PathExists(cache_dir)) {
+    MKDIR(cache_dir.c_str());
+  }
+  if (inference::analysis::PathExists(path) ||
+      MKDIR(tmp_path.c_str()) != 0) {
+    return;
+  }
+  bool saved = false;
+  try {
+    SaveOptimModel(tmp_path);
+    std::ofstream fout(tmp_path + "/key", std::ios::out | std::ios::binary);
+    fout << key;
+    fout.close();
+    saved = static_cast<bool>(fout) &&
+            std::rename(tmp_path.c_str(), path.c_str()) == 0;
+  } catch (const std::exception &e) {
+    LOG(WARNING) << "Failed to cache the optimized program in " << path
+                 << ": " << e.what();
+  }
+  if (saved) {
+    LOG(INFO) << "Cached the optimized program in " << path;
+    EvictOptimizedPrograms(cache_dir);
+    return;
+  }
+  RemoveOptimizedProgram(tmp_path);
+}
+
 template <>
 std::unique_ptr<PaddlePredictor>
 CreatePaddlePredictor<AnalysisConfig, PaddleEngineKind::kAnalysis>(
@@ -1373,6 +1733,10 @@ CreatePaddlePredictor<AnalysisConfig, PaddleEngineKind::kAnalysis>(
     return nullptr;
   }
 
+  if (config.cpu_quantizer_enabled() && !predictor_p->CpuQuantize()) {
+    return nullptr;
+  }
+
   return predictor;
 }
 
@@ -1388,6 +1752,27 @@ bool AnalysisPredictor::MkldnnQuantize() {
 #endif
 }
 
+bool AnalysisPredictor::CpuQuantize() {
+  if (!platform::is_cpu_place(place_)) {
+    LOG(ERROR) << "CpuQuantizer only works on CPU.";
+    return false;
+  }
+  CpuQuantizer quantizer(*this);
+  return quantizer.Quantize();
+}
+
+void AnalysisPredictor::RegisterOpHooks(
+    const NaiveExecutor::HookFunc &input_hook,
+    const NaiveExecutor::HookFunc &output_hook) {
+  if (input_hook) executor_->RegisterInputHook(input_hook);
+  if (output_hook) executor_->RegisterOutputHook(output_hook);
+}
+
+void AnalysisPredictor::ClearOpHooks() {
+  executor_->ClearInputHooks();
+  executor_->ClearOutputHooks();
+}
+
 void AnalysisPredictor::PrepareFeedFetch() {
   PADDLE_ENFORCE_NOT_NULL(sub_scope_,
                           platform::errors::InvalidArgument(
@@ -1578,7 +1963,7 @@ bool AnalysisPredictor::ZeroCopyRun() {
   if (private_context_) {
     paddle::platform::DeviceContextPool::SetDeviceContexts(&device_contexts_);
   }
-  paddle::platform::SetNumThreads(config_.cpu_math_library_num_threads());
+  auto admission = AdmitRun();
 #ifdef PADDLE_WITH_MKLDNN
   if (config_.use_mkldnn_) {
     std::vector<std::vector<int>> shape_vector;
@@ -1590,7 +1975,13 @@ bool AnalysisPredictor::ZeroCopyRun() {
     MkldnnPreSet(shape_vector);
   }
 #endif
-  executor_->Run();
+  {
+    phi::autotune::ThreadAutoTuneGuard autotune_guard(cpu_autotune_);
+    executor_->Run();
+  }
+  if (admission) {
+    admission->set_activation_bytes(GetIntermediateTensorBytes());
+  }
 
   if (config_.shape_range_info_collected()) {
     CollectShapeRangeInfo();
@@ -1776,6 +2167,23 @@ bool AnalysisPredictor::LoadParameters() {
                           platform::errors::PreconditionNotMet(
                               "The inference program should be loaded first."));
 
+  // The mapped parameters live in host memory, so only CPU predictors can use
+  // them without a copy.
+  if (config_.memory_mapped_params_enabled() &&
+      inference::MmapParamsSupported() &&
+      !config_.params_file().empty() && !config_.model_from_memory() &&
+      platform::is_cpu_place(place_)) {
+    if (inference::LoadPersistablesFromMmap(
+            *inference_program_,
+            config_.params_file(),
+            scope_.get(),
+            config_.memory_mapped_params_lazy_load())) {
+      VLOG(3) << "get " << scope_->LocalVarNames().size()
+              << " vars after mmap";
+      return true;
+    }
+  }
+
   const auto &global_block = inference_program_->MutableBlock(0);
 
   // create a temporary program to load parameters.
@@ -1834,6 +2242,57 @@ uint64_t AnalysisPredictor::TryShrinkMemory() {
   return paddle::memory::Release(place_);
 }
 
+std::unique_ptr<SharedCPURuntime::Admission> AnalysisPredictor::AdmitRun() {
+  if (!attached_to_shared_cpu_runtime_) {
+    paddle::platform::SetNumThreads(config_.cpu_math_library_num_threads());
+    return nullptr;
+  }
+  std::unique_ptr<SharedCPURuntime::Admission> admission(
+      new SharedCPURuntime::Admission(
+          ResourceManager::Instance().GetSharedCPURuntime(),
+          config_.shared_cpu_runtime_model()));
+  paddle::platform::SetNumThreads(admission->num_threads());
+  return admission;
+}
+
+int64_t AnalysisPredictor::GetIntermediateTensorBytes() {
+  // The intermediate tensors take the same memory for the same input dims,
+  // the number of their dims leads the dims of each input.
+  framework::Scope *scope = executor_->scope();
+  std::vector<int64_t> input_dims;
+  for (const auto &pair : idx2feeds_) {
+    auto *variable = scope->FindVar(pair.second);
+    if (variable == nullptr || !variable->IsType<framework::LoDTensor>()) {
+      input_dims.push_back(-1);
+      continue;
+    }
+    auto dims = phi::vectorize(variable->Get<framework::LoDTensor>().dims());
+    input_dims.push_back(dims.size());
+    input_dims.insert(input_dims.end(), dims.begin(), dims.end());
+  }
+  auto it = intermediate_tensor_bytes_.find(input_dims);
+  if (it != intermediate_tensor_bytes_.end()) return it->second;
+
+  int64_t bytes = 0;
+  std::unordered_set<const phi::Allocation *> holders;
+  const auto &global_block = inference_program_->MutableBlock(0);
+  for (auto *var : global_block->AllVars()) {
+    if (IsPersistable(var)) continue;
+    auto *variable = scope->FindVar(var->Name());
+    if (variable != nullptr && variable->IsType<framework::LoDTensor>()) {
+      auto &t = variable->Get<framework::LoDTensor>();
+      if (t.IsInitialized() && holders.insert(t.Holder().get()).second) {
+        bytes += t.Holder()->size();
+      }
+    }
+  }
+  if (intermediate_tensor_bytes_.size() >= kMaxIntermediateTensorBytes) {
+    intermediate_tensor_bytes_.clear();
+  }
+  intermediate_tensor_bytes_.emplace(std::move(input_dims), bytes);
+  return bytes;
+}
+
 void AnalysisPredictor::ClearIntermediateTensor() {
   PADDLE_ENFORCE_NOT_NULL(inference_program_.get(),
                           platform::errors::PreconditionNotMet(
@@ -1923,6 +2382,18 @@ AnalysisPredictor::~AnalysisPredictor() {
   if (sub_scope_) {
     scope_->DeleteScope(sub_scope_);
   }
+  for (auto *weight : packed_weights_) {
+    phi::funcs::PackedWeightCache::Instance().UnregisterConstant(weight);
+  }
+  if (save_autotune_cache_) {
+    try {
+      phi::autotune::AutoTuneCache::Instance().Save(
+          config_.cpu_autotune_cache_file());
+    } catch (const std::exception &e) {
+      LOG(WARNING) << "Failed to save the tuned CPU kernel choices: "
+                   << e.what();
+    }
+  }
 
 #if PADDLE_WITH_MKLDNN
   if (mkldnn_quantizer_) {
@@ -1939,6 +2410,10 @@ AnalysisPredictor::~AnalysisPredictor() {
     ResourceManager::Instance().DestroyGPUResource(predictor_stream_);
   }
 #endif
+  if (attached_to_shared_cpu_runtime_) {
+    ResourceManager::Instance().GetSharedCPURuntime()->UnregisterModel(
+        config_.shared_cpu_runtime_model());
+  }
   if (place_.GetType() != phi::AllocationType::UNDEFINED) {
     memory::Release(place_);
   }
@@ -2281,6 +2756,92 @@ Predictor *PredictorPool::Retrive(size_t idx) {
   }
   return preds_[idx - 1].get();
 }
+
+AsyncPredictor::AsyncPredictor(const Config &config, size_t num_workers)
+    : pool_(config, num_workers) {
+  for (size_t i = 0; i < num_workers; ++i) {
+    workers_.emplace_back(&AsyncPredictor::WorkerLoop, this, pool_.Retrive(i));
+  }
+}
+
+AsyncPredictor::~AsyncPredictor() {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stop_ = true;
+  }
+  cv_.notify_all();
+  for (auto &worker : workers_) {
+    worker.join();
+  }
+}
+
+std::future<bool> AsyncPredictor::Run(PrepareCallback prepare,
+                                      DoneCallback done) {
+  Task task;
+  task.prepare = std::move(prepare);
+  task.done = std::move(done);
+  auto future = task.promise.get_future();
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    PADDLE_ENFORCE_EQ(stop_,
+                      false,
+                      paddle::platform::errors::PreconditionNotMet(
+                          "The AsyncPredictor has been stopped."));
+    tasks_.push_back(std::move(task));
+  }
+  cv_.notify_one();
+  return future;
+}
+
+size_t AsyncPredictor::GetPendingNum() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return tasks_.size();
+}
+
+void AsyncPredictor::WorkerLoop(Predictor *predictor) {
+  while (true) {
+    Task task;
+    {
+      std::unique_lock<std::mutex> lock(mutex_);
+      cv_.wait(lock, [this] { return stop_ || !tasks_.empty(); });
+      // Drain the queue before stopping.
+      if (tasks_.empty()) return;
+      task = std::move(tasks_.front());
+      tasks_.pop_front();
+    }
+    bool success = false;
+    try {
+      if (task.prepare) task.prepare(predictor);
+      success = predictor->Run();
+    } catch (const std::exception &e) {
+      LOG(ERROR) << "AsyncPredictor fails to run: " << e.what();
+    }
+    try {
+      if (task.done) task.done(predictor, success);
+    } catch (const std::exception &e) {
+      LOG(ERROR) << "AsyncPredictor fails in the done callback: " << e.what();
+    }
+    task.promise.set_value(success);
+  }
+}
+
+void InitSharedCPURuntime(int num_threads, int64_t memory_budget_mb) {
+  paddle::ResourceManager::Instance().InitSharedCPURuntime(
+      num_threads, memory_budget_mb << 20);
+}
+
+ModelRuntimeStats GetModelRuntimeStats(const std::string &model_name) {
+  auto stats = paddle::ResourceManager::Instance()
+                   .GetSharedCPURuntime()
+                   ->GetModelStats(model_name);
+  ModelRuntimeStats res;
+  res.num_runs = stats.num_runs;
+  res.num_running = stats.num_running;
+  res.total_wait_ms = stats.total_wait_ms;
+  res.total_run_ms = stats.total_run_ms;
+  res.peak_activation_bytes = stats.peak_activation_bytes;
+  return res;
+}
 }  // namespace services
 
 namespace experimental {
@@ -266,6 +266,14 @@ class AnalysisPredictor : public PaddlePredictor {
   ///
   std::string GetSerializedProgram() const override;
 
+  ///
+  /// \brief Whether the optimized program was loaded from the optimized
+  /// program cache instead of made by the analysis
+  ///
+  /// \return Whether the program was loaded from the cache
+  ///
+  bool program_from_cache() const { return program_from_cache_; }
+
   ///
   /// \brief Initialize mkldnn quantizer and execute mkldnn quantization pass
   ///
@@ -273,6 +281,29 @@ class AnalysisPredictor : public PaddlePredictor {
   ///
   bool MkldnnQuantize();
 
+  ///
+  /// \brief Calibrate on the warmup data and quantize the fc ops to the
+  /// plain CPU int8 kernel
+  ///
+  /// \return Whether the function executed successfully
+  ///
+  bool CpuQuantize();
+
+  ///
+  /// \brief Register functions called before and after each operator of the
+  /// optimized program runs, e.g. to profile the operators
+  ///
+  /// \param[in] input_hook called before each operator runs
+  /// \param[in] output_hook called after each operator runs
+  ///
+  void RegisterOpHooks(const NaiveExecutor::HookFunc &input_hook,
+                       const NaiveExecutor::HookFunc &output_hook);
+
+  ///
+  /// \brief Remove the functions registered by RegisterOpHooks
+  ///
+  void ClearOpHooks();
+
   ///
   /// \brief save program to model and save parameters to params
   ///
@@ -321,6 +352,29 @@ class AnalysisPredictor : public PaddlePredictor {
   /// \return Whether the function executed successfully
   ///
   bool LoadParameters();
+  ///
+  /// \brief Get the key of the optimized program of the model and the
+  /// argument in the cache.
+  ///
+  /// \return The key, empty if the program can not be cached
+  ///
+  std::string OptimizedProgramCacheKey();
+  ///
+  /// \brief Load the optimized program and its parameters cached in path.
+  ///
+  /// \param[in] path The directory of the cache entry
+  /// \param[in] key The key of the optimized program
+  /// \return Whether they were cached with this key and loaded
+  ///
+  bool LoadOptimizedProgram(const std::string &path, const std::string &key);
+  ///
+  /// \brief Cache the optimized program and its parameters in path, unless
+  /// another predictor already did.
+  ///
+  /// \param[in] path The directory of the cache entry
+  /// \param[in] key The key of the optimized program
+  ///
+  void SaveOptimizedProgram(const std::string &path, const std::string &key);
 
   ///
   /// \brief Prepare input data, only used in Run()
@@ -412,8 +466,33 @@ class AnalysisPredictor : public PaddlePredictor {
 
   void InitPlace();
   void InitDeviceContexts();
+  // Registers the persistable B matrices of the GEMM ops, which no op of the
+  // program writes, to the packed weight cache of the CPU GEMMs.
+  void RegisterPackedWeights();
+  // Loads the tuned choices of the CPU kernels from the cache file of the
+  // config, or turns on their autotune in the runs of this predictor.
+  void InitCpuAutoTune();
   void InitResourceManager(void *stream);
 
+  ///
+  /// \brief Wait for the shared CPU runtime to admit a run, and set the
+  /// number of math library threads for it.
+  ///
+  /// \return The admission to hold during the run, or nullptr if the
+  /// predictor is not attached to the shared CPU runtime.
+  ///
+  std::unique_ptr<SharedCPURuntime::Admission> AdmitRun();
+
+  ///
+  /// \brief Get the memory held by the intermediate tensors after a run.
+  /// The tensors sharing an allocation, like the ones memory_optim reuses,
+  /// count it once. The value is computed once for the dims of the inputs
+  /// of the run, and then looked up.
+  ///
+  /// \return int64_t Bytes held by the intermediate tensors.
+  ///
+  int64_t GetIntermediateTensorBytes();
+
 #if defined(PADDLE_WITH_DISTRIBUTE) && defined(PADDLE_WITH_PSCORE)
   // fleet exe related
 
@@ -485,6 +564,7 @@ class AnalysisPredictor : public PaddlePredictor {
   // Helper class to perform quantization
   class MkldnnQuantizer;
   MkldnnQuantizer *mkldnn_quantizer_{nullptr};
+  class CpuQuantizer;
 
 #if PADDLE_WITH_TESTING
   friend class MkldnnQuantizerTest;
@@ -513,6 +593,13 @@ class AnalysisPredictor : public PaddlePredictor {
 
   bool private_context_{false};
   void *predictor_stream_{nullptr};
+  bool attached_to_shared_cpu_runtime_{false};
+  // GetIntermediateTensorBytes by the dims of the inputs of the run.
+  std::map<std::vector<int64_t>, int64_t> intermediate_tensor_bytes_;
+  bool program_from_cache_{false};
+  std::vector<const void *> packed_weights_;
+  bool cpu_autotune_{false};
+  bool save_autotune_cache_{false};
   std::map<phi::Place, std::shared_future<std::unique_ptr<phi::DeviceContext>>>
       device_contexts_;
 
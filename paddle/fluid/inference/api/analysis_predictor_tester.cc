@@ -20,16 +20,25 @@
 #include <glog/logging.h>
 #include <gtest/gtest.h>
 
+#include <algorithm>
+#include <atomic>
+#include <chrono>  // NOLINT
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <random>
 #include <thread>  // NOLINT
 
 #include "paddle/fluid/framework/ir/pass.h"
 #include "paddle/fluid/framework/tensor.h"
+#include "paddle/fluid/inference/analysis/helper.h"
 #include "paddle/fluid/inference/api/helper.h"
 #include "paddle/fluid/inference/api/paddle_api.h"
 #include "paddle/fluid/inference/api/paddle_inference_api.h"
 #include "paddle/fluid/inference/tests/api/tester_helper.h"
 #include "paddle/fluid/inference/utils/io_utils.h"
 #include "paddle/fluid/platform/cpu_info.h"
+#include "paddle/phi/kernels/funcs/int8_gemm.h"
 
 DEFINE_string(dirname, "", "dirname to tests.");
 
@@ -125,6 +134,69 @@ TEST(AnalysisPredictor, analysis_on) {
   inference::CompareTensor(outputs.front(), naive_outputs.front());
 }
 
+TEST(AnalysisPredictor, OptimizedProgramCache) {
+  AnalysisConfig config;
+  config.SetModel(FLAGS_dirname);
+  config.SwitchIrOptim(true);
+  config.DisableGpu();
+  // A directory of its own, so that no entry of a former run is loaded.
+  std::string cache_dir =
+      "./optimized_program_cache." + std::to_string(std::random_device()());
+  ASSERT_FALSE(inference::analysis::PathExists(cache_dir));
+  config.EnableOptimizedProgramCache(cache_dir);
+
+  int64_t data[4] = {1, 2, 3, 4};
+  PaddleTensor tensor;
+  tensor.shape = std::vector<int>({4, 1});
+  tensor.data.Reset(data, sizeof(data));
+  tensor.dtype = PaddleDType::INT64;
+  std::vector<PaddleTensor> inputs(4, tensor);
+
+  // A copy of the model in another directory, like the one of a replica.
+  std::string model_copy = cache_dir + ".model";
+  ASSERT_EQ(MKDIR(model_copy.c_str()), 0);
+  auto model_files = inference::analysis::ListDir(FLAGS_dirname);
+  for (auto &file : model_files) {
+    std::ifstream fin(FLAGS_dirname + "/" + file,
+                      std::ios::in | std::ios::binary);
+    std::ofstream fout(model_copy + "/" + file,
+                       std::ios::out | std::ios::binary);
+    fout << fin.rdbuf();
+  }
+
+  // The first predictor runs the analysis and caches the program, the
+  // second one and the one of the copy load it.
+  std::vector<std::vector<PaddleTensor>> outputs(3);
+  std::vector<std::string> programs(3);
+  for (size_t i = 0; i < 3; ++i) {
+    AnalysisConfig predictor_config(config);
+    if (i == 2) predictor_config.SetModel(model_copy);
+    auto predictor = CreatePaddlePredictor<AnalysisConfig>(predictor_config);
+    ASSERT_TRUE(predictor->Run(inputs, &outputs[i]));
+    auto* analysis_predictor = static_cast<AnalysisPredictor*>(predictor.get());
+    ASSERT_EQ(analysis_predictor->program_from_cache(), i > 0);
+    programs[i] = analysis_predictor->GetSerializedProgram();
+  }
+  for (size_t i = 1; i < 3; ++i) {
+    ASSERT_EQ(programs[0], programs[i]);
+    inference::CompareResult(outputs[0], outputs[i]);
+  }
+
+  for (auto &file : model_files) {
+    ASSERT_EQ(std::remove((model_copy + "/" + file).c_str()), 0);
+  }
+  ASSERT_EQ(RMDIR(model_copy.c_str()), 0);
+  auto entries = inference::analysis::ListDir(cache_dir);
+  ASSERT_EQ(entries.size(), 1UL);
+  for (auto &entry : entries) {
+    for (const char *file : {"/key", "/model", "/params"}) {
+      ASSERT_EQ(std::remove((cache_dir + "/" + entry + file).c_str()), 0);
+    }
+    ASSERT_EQ(RMDIR((cache_dir + "/" + entry).c_str()), 0);
+  }
+  ASSERT_EQ(RMDIR(cache_dir.c_str()), 0);
+}
+
 TEST(AnalysisPredictor, ZeroCopy) {
   AnalysisConfig config;
   config.SetModel(FLAGS_dirname);
@@ -371,6 +443,96 @@ TEST(AnalysisPredictor, enable_onnxruntime) {
   ASSERT_TRUE(!config.use_onnxruntime());
 }
 
+TEST(AnalysisPredictor, cpu_quantizer) {
+  AnalysisConfig config;
+  config.SetModel(FLAGS_dirname);
+  config.SwitchIrOptim(true);
+  config.DisableGpu();
+
+  int64_t data[4] = {1, 2, 3, 4};
+  PaddleTensor tensor;
+  tensor.shape = std::vector<int>({4, 1});
+  tensor.data.Reset(data, sizeof(data));
+  tensor.dtype = PaddleDType::INT64;
+  std::vector<PaddleTensor> inputs(4, tensor);
+
+  AnalysisConfig qconfig(config);
+  auto warmup_data =
+      std::make_shared<std::vector<std::vector<PaddleTensor>>>(2, inputs);
+  qconfig.EnableCpuQuantizer(warmup_data, ScaleAlgo::PERCENTILE);
+  ASSERT_TRUE(qconfig.cpu_quantizer_enabled());
+
+  auto predictor = CreatePaddlePredictor<AnalysisConfig>(config);
+  auto qpredictor = CreatePaddlePredictor<AnalysisConfig>(qconfig);
+  ASSERT_TRUE(qpredictor);
+
+  int num_int8_fc = 0;
+  auto& program = static_cast<AnalysisPredictor*>(qpredictor.get())->program();
+  for (auto* op : program.Block(0).AllOps()) {
+    if (op->Type() == "fc" && op->GetAttrIfExists<bool>("cpu_int8")) {
+      ++num_int8_fc;
+    }
+  }
+  // Without an int8 SIMD kernel the fc ops stay in float.
+  if (phi::funcs::Int8GemmUseSimd()) {
+    ASSERT_GT(num_int8_fc, 0);
+  } else {
+    ASSERT_EQ(num_int8_fc, 0);
+  }
+
+  std::vector<PaddleTensor> outputs, qoutputs;
+  ASSERT_TRUE(predictor->Run(inputs, &outputs));
+  ASSERT_TRUE(qpredictor->Run(inputs, &qoutputs));
+  ASSERT_EQ(outputs.size(), qoutputs.size());
+  const float* out = static_cast<const float*>(outputs[0].data.data());
+  const float* qout = static_cast<const float*>(qoutputs[0].data.data());
+  size_t num = outputs[0].data.length() / sizeof(float);
+  ASSERT_EQ(num, qoutputs[0].data.length() / sizeof(float));
+  float max_diff = 0.f;
+  for (size_t i = 0; i < num; ++i) {
+    max_diff = std::max(max_diff, std::abs(out[i] - qout[i]));
+  }
+  LOG(INFO) << num_int8_fc << " int8 fc ops, max diff to fp32: " << max_diff;
+  ASSERT_LT(max_diff, 1e-2);
+}
+
+TEST(SharedCPURuntime, admission) {
+  SharedCPURuntime runtime(4, 0);
+  runtime.RegisterModel("model_a", 2, 1);
+  runtime.RegisterModel("model_b", 1, 3);
+
+  std::atomic<int> running_a{0};
+  std::atomic<int> max_running_a{0};
+  std::vector<std::thread> threads;
+  for (int i = 0; i < 8; ++i) {
+    threads.emplace_back([&] {
+      SharedCPURuntime::Admission admission(&runtime, "model_a");
+      int cur = ++running_a;
+      int prev = max_running_a.load();
+      while (prev < cur && !max_running_a.compare_exchange_weak(prev, cur)) {
+      }
+      std::this_thread::sleep_for(std::chrono::milliseconds(5));
+      admission.set_activation_bytes(1024);
+      --running_a;
+    });
+  }
+  {
+    SharedCPURuntime::Admission admission(&runtime, "model_b");
+    ASSERT_EQ(admission.num_threads(), 3);
+  }
+  for (auto& t : threads) {
+    t.join();
+  }
+  ASSERT_LE(max_running_a.load(), 2);
+
+  auto stats = runtime.GetModelStats("model_a");
+  ASSERT_EQ(stats.num_runs, 8);
+  ASSERT_EQ(stats.num_running, 0);
+  ASSERT_EQ(stats.peak_activation_bytes, 1024);
+  ASSERT_EQ(runtime.GetAllModelStats().size(), 2UL);
+  ASSERT_ANY_THROW(SharedCPURuntime::Admission(&runtime, "model_c"));
+}
+
 }  // namespace paddle
 
 namespace paddle_infer {
@@ -422,6 +584,34 @@ TEST(Predictor, Run) {
   predictor->TryShrinkMemory();
 }
 
+TEST(Predictor, SharedCPURuntime) {
+  Config config;
+  config.SetModel(FLAGS_dirname);
+  config.SetCpuMathLibraryNumThreads(2);
+  config.AttachSharedCPURuntime("word2vec", 2);
+  auto predictor = CreatePredictor(config);
+  auto predictor2 = predictor->Clone();
+
+  auto run = [](Predictor* p) {
+    for (auto& name : p->GetInputNames()) {
+      auto input = p->GetInputHandle(name);
+      input->Reshape({4, 1});
+      std::vector<int64_t> data{0, 1, 2, 3};
+      input->CopyFromCpu(data.data());
+    }
+    ASSERT_TRUE(p->Run());
+  };
+  std::thread t1(run, predictor.get());
+  std::thread t2(run, predictor2.get());
+  t1.join();
+  t2.join();
+
+  auto stats = services::GetModelRuntimeStats("word2vec");
+  ASSERT_EQ(stats.num_runs, 2);
+  ASSERT_EQ(stats.num_running, 0);
+  ASSERT_GT(stats.peak_activation_bytes, 0);
+}
+
 TEST(Predictor, EnableONNXRuntime) {
   Config config;
   config.SetModel(FLAGS_dirname);
@@ -0,0 +1,374 @@
+// Copyright (c) 2022 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "paddle/fluid/inference/api/cpu_quantizer.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <numeric>
+#include <unordered_set>
+
+#include "paddle/fluid/framework/naive_executor.h"
+#include "paddle/fluid/platform/enforce.h"
+#include "paddle/fluid/platform/place.h"
+#include "paddle/fluid/string/pretty_log.h"
+#include "paddle/phi/kernels/funcs/blas/packed_weight_cache.h"
+#include "paddle/phi/kernels/funcs/int8_gemm.h"
+
+namespace paddle {
+
+using framework::LoDTensor;
+using framework::OpDesc;
+using platform::CPUPlace;
+using string::PrettyLogH1;
+
+namespace {
+
+constexpr int kNumHistBins = 2048;
+constexpr int kNumQuantizedLevels = 128;
+constexpr float kMaxInt8 = 127.f;
+
+bool IsFloatTensor(const LoDTensor& tensor) {
+  return tensor.IsInitialized() && tensor.dtype() == phi::DataType::FLOAT32;
+}
+
+// The scale mapping [-threshold, threshold] to [-127, 127].
+float ThresholdToScale(float threshold) {
+  return threshold > 0.f ? kMaxInt8 / threshold : 1.f;
+}
+
+}  // namespace
+
+void AnalysisPredictor::CpuQuantizer::CollectTargets() {
+  auto* block = predictor_.inference_program_->MutableBlock(0);
+  // A weight read by any other op must stay in float.
+  std::unordered_map<std::string, int> num_readers;
+  for (auto* op : block->AllOps()) {
+    for (auto& name : op->InputArgumentNames()) {
+      ++num_readers[name];
+    }
+  }
+  std::unordered_map<std::string, int> num_fc_readers;
+  std::vector<OpDesc*> candidates;
+  for (auto* op : block->AllOps()) {
+    if (op->Type() != "fc") continue;
+    if (op->GetAttrIfExists<bool>("use_mkldnn") ||
+        op->GetAttrIfExists<bool>("padding_weights")) {
+      continue;
+    }
+    const auto& w_name = op->Input("W")[0];
+    auto* w_desc = block->FindVar(w_name);
+    auto* in_desc = block->FindVar(op->Input("Input")[0]);
+    if (w_desc == nullptr || !w_desc->Persistable() || in_desc == nullptr ||
+        in_desc->Persistable()) {
+      continue;
+    }
+    auto* w_var = predictor_.scope_->FindVar(w_name);
+    if (w_var == nullptr || !w_var->IsType<LoDTensor>() ||
+        !IsFloatTensor(w_var->Get<LoDTensor>()) ||
+        w_var->Get<LoDTensor>().dims().size() != 2) {
+      continue;
+    }
+    ++num_fc_readers[w_name];
+    candidates.push_back(op);
+  }
+  for (auto* op : candidates) {
+    const auto& w_name = op->Input("W")[0];
+    if (num_readers[w_name] != num_fc_readers[w_name]) {
+      VLOG(3) << "Weight " << w_name << " is shared with other ops, skip it.";
+      continue;
+    }
+    targets_.push_back(op);
+    stats_.emplace(op->Input("Input")[0], InputStats());
+  }
+}
+
+bool AnalysisPredictor::CpuQuantizer::RunWarmup(
+    const std::function<void(const LoDTensor&, InputStats*)>& observe) {
+  auto warmup_data = predictor_.config_.cpu_quantizer_warmup_data();
+  PADDLE_ENFORCE_NOT_NULL(warmup_data,
+                          platform::errors::PreconditionNotMet(
+                              "Warmup data cannot be NULL in the config."));
+  predictor_.executor_->RegisterOutputHook(
+      [&](framework::OperatorBase* op) {
+        if (op->Type() != "fc") return;
+        auto it = stats_.find(op->Input("Input"));
+        if (it == stats_.end() || !it->second.is_float) return;
+        auto* var = predictor_.sub_scope_->FindVar(it->first);
+        if (var == nullptr || !var->IsType<LoDTensor>() ||
+            !IsFloatTensor(var->Get<LoDTensor>())) {
+          it->second.is_float = false;
+          return;
+        }
+        observe(var->Get<LoDTensor>(), &it->second);
+      });
+  bool success = true;
+  std::vector<PaddleTensor> output_slots;
+  for (auto& batch : *warmup_data) {
+    if (!predictor_.Run(batch, &output_slots)) {
+      success = false;
+      break;
+    }
+  }
+  predictor_.executor_->ClearOutputHooks();
+  return success;
+}
+
+float AnalysisPredictor::CpuQuantizer::GetKLThreshold(
+    const std::vector<int64_t>& hist, float bin_width) {
+  int num_bins = hist.size();
+  if (num_bins <= kNumQuantizedLevels) {
+    return num_bins * bin_width;
+  }
+  int64_t total = std::accumulate(hist.begin(), hist.end(), int64_t{0});
+  if (total == 0) return num_bins * bin_width;
+
+  std::vector<double> p(num_bins);
+  std::vector<double> q(num_bins);
+  double min_kl = std::numeric_limits<double>::max();
+  int best = num_bins;
+  for (int i = kNumQuantizedLevels; i <= num_bins; ++i) {
+    // The reference distribution clips everything above bin i into its last
+    // bin.
+    int64_t outliers =
+        std::accumulate(hist.begin() + i, hist.end(), int64_t{0});
+    for (int j = 0; j < i; ++j) p[j] = hist[j];
+    p[i - 1] += outliers;
+
+    // The candidate merges the i bins into 128 levels and spreads each level
+    // back evenly over its non-empty bins.
+    for (int level = 0; level < kNumQuantizedLevels; ++level) {
+      int start = static_cast<int64_t>(level) * i / kNumQuantizedLevels;
+      int end = static_cast<int64_t>(level + 1) * i / kNumQuantizedLevels;
+      double sum = 0;
+      int non_empty = 0;
+      for (int j = start; j < end; ++j) {
+        sum += hist[j];
+        non_empty += hist[j] != 0;
+      }
+      for (int j = start; j < end; ++j) {
+        q[j] = (hist[j] != 0 && non_empty > 0) ? sum / non_empty : 0;
+      }
+    }
+
+    double p_sum = std::accumulate(p.begin(), p.begin() + i, 0.0);
+    double q_sum = std::accumulate(q.begin(), q.begin() + i, 0.0);
+    double kl = 0;
+    for (int j = 0; j < i; ++j) {
+      if (p[j] == 0) continue;
+      double pj = p[j] / p_sum;
+      // The clipped mass in the last bin may have no candidate counterpart.
+      double qj = q[j] > 0 ? q[j] / q_sum : 1e-12;
+      kl += pj * std::log(pj / qj);
+    }
+    if (kl < min_kl) {
+      min_kl = kl;
+      best = i;
+    }
+  }
+  return (best + 0.5f) * bin_width;
+}
+
+float AnalysisPredictor::CpuQuantizer::GetPercentileThreshold(
+    const std::vector<int64_t>& hist, float bin_width, float percentile) {
+  int64_t total = std::accumulate(hist.begin(), hist.end(), int64_t{0});
+  double target = total * static_cast<double>(percentile) / 100.0;
+  int64_t cumsum = 0;
+  for (size_t i = 0; i < hist.size(); ++i) {
+    cumsum += hist[i];
+    if (cumsum >= target) {
+      return (i + 1) * bin_width;
+    }
+  }
+  return hist.size() * bin_width;
+}
+
+float AnalysisPredictor::CpuQuantizer::CalculateScale(
+    const InputStats& stats) const {
+  if (stats.abs_max <= 0.f) return 1.f;
+  float bin_width = stats.abs_max / kNumHistBins;
+  const auto& config = predictor_.config_;
+  switch (config.cpu_quantizer_scale_algo()) {
+    case ScaleAlgo::KL:
+      return ThresholdToScale(GetKLThreshold(stats.hist, bin_width));
+    case ScaleAlgo::PERCENTILE:
+      return ThresholdToScale(GetPercentileThreshold(
+          stats.hist, bin_width, config.cpu_quantizer_percentile()));
+    default:
+      return ThresholdToScale(stats.abs_max);
+  }
+}
+
+const AnalysisPredictor::CpuQuantizer::QuantizedWeights&
+AnalysisPredictor::CpuQuantizer::QuantizeWeights(const std::string& w_name) {
+  auto it = weights_.find(w_name);
+  if (it != weights_.end()) return it->second;
+
+  auto* tensor = predictor_.scope_->FindVar(w_name)->GetMutable<LoDTensor>();
+  int K = tensor->dims()[0];
+  int N = tensor->dims()[1];
+  const float* w = tensor->data<float>();
+
+  QuantizedWeights& quantized = weights_[w_name];
+  quantized.scales.assign(N, 0.f);
+  quantized.col_sums.assign(N, 0);
+  for (int k = 0; k < K; ++k) {
+    for (int n = 0; n < N; ++n) {
+      quantized.scales[n] =
+          std::max(quantized.scales[n], std::abs(w[k * N + n]));
+    }
+  }
+  for (auto& scale : quantized.scales) {
+    scale = ThresholdToScale(scale);
+  }
+
+  LoDTensor int8_tensor;
+  auto* q = int8_tensor.mutable_data<int8_t>(tensor->dims(), CPUPlace());
+  for (int k = 0; k < K; ++k) {
+    for (int n = 0; n < N; ++n) {
+      float v = std::round(w[k * N + n] * quantized.scales[n]);
+      v = std::min(kMaxInt8, std::max(-kMaxInt8, v));
+      q[k * N + n] = static_cast<int8_t>(v);
+      quantized.col_sums[n] += q[k * N + n];
+    }
+  }
+  int8_tensor.set_lod(tensor->lod());
+
+  // The int8 weights are registered as constant, so that the kernel packs
+  // them once into its layout, and the float ones they replace are dropped.
+  auto& packed_cache = phi::funcs::PackedWeightCache::Instance();
+  auto& registered = predictor_.packed_weights_;
+  auto float_weight =
+      std::find(registered.begin(), registered.end(), tensor->data());
+  if (float_weight != registered.end()) {
+    packed_cache.UnregisterConstant(*float_weight);
+    registered.erase(float_weight);
+  }
+  *tensor = std::move(int8_tensor);
+  packed_cache.RegisterConstant(tensor->data(), tensor->numel());
+  registered.push_back(tensor->data());
+  predictor_.inference_program_->MutableBlock(0)->FindVar(w_name)->SetDataType(
+      framework::proto::VarType::INT8);
+  return quantized;
+}
+
+void AnalysisPredictor::CpuQuantizer::QuantizeOp(OpDesc* op, float scale_in) {
+  const auto& quantized = QuantizeWeights(op->Input("W")[0]);
+  int N = quantized.scales.size();
+
+  // The kernel shifts the int8 input by kInt8GemmShift into uint8, which adds
+  // kInt8GemmShift * col_sums[n] to every accumulator of the column n. That is
+  // subtracted from a copy of the bias, so the shared bias stays untouched.
+  std::vector<float> bias(N, 0.f);
+  if (op->Inputs().count("Bias") && !op->Input("Bias").empty()) {
+    auto* bias_var = predictor_.sub_scope_->FindVar(op->Input("Bias")[0]);
+    PADDLE_ENFORCE_NOT_NULL(
+        bias_var,
+        platform::errors::PreconditionNotMet(
+            "The bias of fc %s is not in the scope.", op->Output("Out")[0]));
+    auto& src = bias_var->Get<LoDTensor>();
+    PADDLE_ENFORCE_EQ(
+        src.numel(),
+        N,
+        platform::errors::InvalidArgument(
+            "The bias of fc %s should have %d elements, but received %d.",
+            op->Output("Out")[0],
+            N,
+            src.numel()));
+    std::copy(src.data<float>(), src.data<float>() + N, bias.begin());
+  }
+  for (int n = 0; n < N; ++n) {
+    bias[n] -= phi::funcs::kInt8GemmShift * quantized.col_sums[n] /
+               (scale_in * quantized.scales[n]);
+  }
+
+  auto* block = predictor_.inference_program_->MutableBlock(0);
+  std::string bias_name = op->Output("Out")[0] + "@cpu_int8_bias";
+  auto* bias_desc = block->Var(bias_name);
+  bias_desc->SetType(framework::proto::VarType::LOD_TENSOR);
+  bias_desc->SetDataType(framework::proto::VarType::FP32);
+  bias_desc->SetShape({N});
+  bias_desc->SetPersistable(true);
+  auto* bias_tensor =
+      predictor_.scope_->Var(bias_name)->GetMutable<LoDTensor>();
+  std::copy(bias.begin(),
+            bias.end(),
+            bias_tensor->mutable_data<float>({N}, CPUPlace()));
+
+  op->SetInput("Bias", {bias_name});
+  op->SetAttr("cpu_int8", true);
+  op->SetAttr("Scale_in", scale_in);
+  op->SetAttr("Scale_weights", quantized.scales);
+}
+
+bool AnalysisPredictor::CpuQuantizer::Quantize() {
+  // The generic loop of the int8 GEMM is slower than the float GEMMs.
+  if (!phi::funcs::Int8GemmUseSimd()) {
+    LOG(WARNING) << "CpuQuantizer: the CPU has neither AVX512-VNNI nor AVX2, "
+                    "the fc ops stay in float.";
+    return true;
+  }
+  CollectTargets();
+  if (targets_.empty()) {
+    LOG(WARNING) << "CpuQuantizer: there is no fc op to quantize.";
+    return true;
+  }
+
+  PrettyLogH1("--- Running warmup iterations for CPU quantization");
+  bool success = RunWarmup([](const LoDTensor& tensor, InputStats* stats) {
+    const float* data = tensor.data<float>();
+    for (int64_t i = 0; i < tensor.numel(); ++i) {
+      stats->abs_max = std::max(stats->abs_max, std::abs(data[i]));
+    }
+  });
+  if (!success) return false;
+  for (auto& item : stats_) {
+    item.second.hist.assign(kNumHistBins, 0);
+  }
+  success = RunWarmup([](const LoDTensor& tensor, InputStats* stats) {
+    if (stats->abs_max <= 0.f) return;
+    const float* data = tensor.data<float>();
+    float bins_per_unit = kNumHistBins / stats->abs_max;
+    for (int64_t i = 0; i < tensor.numel(); ++i) {
+      int bin = static_cast<int>(std::abs(data[i]) * bins_per_unit);
+      ++stats->hist[std::min(bin, kNumHistBins - 1)];
+    }
+  });
+  if (!success) return false;
+
+  PrettyLogH1("--- Quantizing the fc ops to int8");
+  // The weights shared with an fc that has a non-float input stay in float.
+  std::unordered_set<std::string> float_weights;
+  for (auto* op : targets_) {
+    if (!stats_.at(op->Input("Input")[0]).is_float) {
+      float_weights.insert(op->Input("W")[0]);
+    }
+  }
+  int num_quantized = 0;
+  for (auto* op : targets_) {
+    if (float_weights.count(op->Input("W")[0])) continue;
+    QuantizeOp(op, CalculateScale(stats_.at(op->Input("Input")[0])));
+    ++num_quantized;
+  }
+  LOG(INFO) << "CpuQuantizer: quantized " << num_quantized << " fc ops, "
+            << (phi::funcs::Int8GemmUseVnni() ? "with AVX512-VNNI."
+                                              : "with AVX2.");
+
+  // The operators hold a copy of their descs, so recreate them.
+  predictor_.CreateExecutor();
+  return predictor_.PrepareExecutor();
+}
+
+}  // namespace paddle
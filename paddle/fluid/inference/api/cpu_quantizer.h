@@ -0,0 +1,90 @@
+// Copyright (c) 2022 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+#include <functional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "paddle/fluid/framework/lod_tensor.h"
+#include "paddle/fluid/framework/op_desc.h"
+#include "paddle/fluid/inference/api/analysis_predictor.h"
+
+namespace paddle {
+
+/*
+ * Post-training int8 quantization of the plain CPU kernels, the counterpart of
+ * the MkldnnQuantizer for builds or models that do not run on MKLDNN.
+ *
+ * The warmup batches are run twice: first to find the range of the input of
+ * every fc op, then to collect the histogram of the absolute values over that
+ * range. The input scales are chosen from the histograms (KL divergence or a
+ * percentile), the weights are quantized per output channel and the fc ops are
+ * switched to the int8 kernel.
+ */
+class AnalysisPredictor::CpuQuantizer {
+ public:
+  explicit CpuQuantizer(AnalysisPredictor& predictor)  // NOLINT
+      : predictor_(predictor) {}
+
+  // Execute full quantization procedure.
+  bool Quantize();
+
+  // The threshold minimizing the KL divergence between the histogram of the
+  // absolute values and its 128 level quantization.
+  static float GetKLThreshold(const std::vector<int64_t>& hist,
+                              float bin_width);
+
+  // The threshold below which `percentile` percent of the values fall.
+  static float GetPercentileThreshold(const std::vector<int64_t>& hist,
+                                      float bin_width,
+                                      float percentile);
+
+ private:
+  struct InputStats {
+    float abs_max{0.f};
+    std::vector<int64_t> hist;
+    bool is_float{true};
+  };
+
+  struct QuantizedWeights {
+    // The per output channel scales.
+    std::vector<float> scales;
+    // The per output channel sums of the int8 weights, to fold the shift of
+    // the input into the bias.
+    std::vector<int64_t> col_sums;
+  };
+
+  // Collect the fc ops whose weights can be quantized.
+  void CollectTargets();
+  // Run all warmup batches, calling `observe` on the input of every target
+  // right after the fc consuming it has run.
+  bool RunWarmup(
+      const std::function<void(const framework::LoDTensor&, InputStats*)>&
+          observe);
+  float CalculateScale(const InputStats& stats) const;
+  // Quantize the weight variable in place, once for all the ops sharing it.
+  const QuantizedWeights& QuantizeWeights(const std::string& w_name);
+  void QuantizeOp(framework::OpDesc* op, float scale_in);
+
+  AnalysisPredictor& predictor_;
+  std::vector<framework::OpDesc*> targets_;
+  // A map: input variable name -> statistics of its values
+  std::unordered_map<std::string, InputStats> stats_;
+  // A map: weight variable name -> its quantization
+  std::unordered_map<std::string, QuantizedWeights> weights_;
+};
+
+}  // namespace paddle
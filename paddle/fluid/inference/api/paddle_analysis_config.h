@@ -734,6 +734,109 @@ struct PD_INFER_DECL AnalysisConfig {
     return cpu_math_library_num_threads_;
   }
 
+  ///
+  /// \brief Set the number of intra op threads of the CPU kernels, which split
+  /// the large elementwise, cast, transpose, reduce and broadcast computations
+  /// of one operator. They are owned by the predictor and are not shared with
+  /// the math library threads.
+  ///
+  /// \param cpu_intra_op_num_threads The number of intra op threads.
+  ///
+  void SetCpuIntraOpNumThreads(int cpu_intra_op_num_threads);
+  ///
+  /// \brief An int state telling how many intra op threads are used in the
+  /// CPU kernels.
+  ///
+  /// \return int The number of intra op threads of the CPU kernels.
+  ///
+  int cpu_intra_op_num_threads() const { return cpu_intra_op_num_threads_; }
+
+  ///
+  /// \brief Keep the persistable float weights of the model packed for the
+  /// CPU GEMMs of matmul, matmul_v2, mul and fc, so that they are packed once
+  /// instead of in every run. It takes the memory of another copy of the
+  /// weights, and helps most the small batches. The program must not write
+  /// its persistable variables.
+  ///
+  /// \param x Whether to cache the packed weights.
+  ///
+  void EnableCpuPackedWeightCache(bool x = true);
+  ///
+  /// \brief A boolean state telling whether the packed weights are cached.
+  ///
+  /// \return bool Whether the packed weights are cached.
+  ///
+  bool cpu_packed_weight_cache_enabled() const {
+    return cpu_packed_weight_cache_;
+  }
+
+  ///
+  /// \brief Let the CPU kernels with several implementations, like conv2d,
+  /// transpose and softmax, time them on the shapes of the model and keep
+  /// the fastest one. With a cache file that exists, the choices are loaded
+  /// from it at the predictor startup and nothing is timed, so that a table
+  /// tuned once on a type of machine can be deployed with the model.
+  /// Otherwise the kernels are tuned in the runs of the predictor, and the
+  /// choices are written to the cache file, if any, when it is destroyed.
+  ///
+  /// \param cache_file The file of the tuned choices.
+  ///
+  void EnableCpuAutoTune(const std::string& cache_file = "");
+  ///
+  /// \brief A boolean state telling whether the CPU kernels are autotuned.
+  ///
+  /// \return bool Whether the CPU kernels are autotuned.
+  ///
+  bool cpu_autotune_enabled() const { return cpu_autotune_; }
+  ///
+  /// \brief Get the file of the tuned choices of the CPU kernels.
+  ///
+  /// \return const std::string& The file of the tuned choices.
+  ///
+  const std::string& cpu_autotune_cache_file() const {
+    return cpu_autotune_cache_file_;
+  }
+
+  ///
+  /// \brief Attach the predictor to the process-wide CPU runtime shared by
+  /// co-served models. Runs are then admitted by the runtime, which bounds
+  /// the total number of math library threads and the activation memory of
+  /// all attached models, and collects per-model statistics. Each run uses
+  /// cpu_math_library_num_threads() threads of the shared budget.
+  ///
+  /// \param model_name The name the model is accounted under, shared by all
+  /// the predictors and clones of the model.
+  /// \param max_concurrency The max number of concurrent runs of the model.
+  ///
+  void AttachSharedCPURuntime(const std::string& model_name,
+                              int max_concurrency = 1);
+  ///
+  /// \brief A boolean state telling whether the predictor is attached to the
+  /// shared CPU runtime.
+  ///
+  /// \return bool Whether the predictor is attached to the shared CPU runtime.
+  ///
+  bool shared_cpu_runtime_attached() const {
+    return !shared_cpu_runtime_model_.empty();
+  }
+  ///
+  /// \brief Get the name of the model in the shared CPU runtime.
+  ///
+  /// \return const std::string& The model name.
+  ///
+  const std::string& shared_cpu_runtime_model() const {
+    return shared_cpu_runtime_model_;
+  }
+  ///
+  /// \brief Get the max number of concurrent runs of the model in the shared
+  /// CPU runtime.
+  ///
+  /// \return int The max number of concurrent runs.
+  ///
+  int shared_cpu_runtime_max_concurrency() const {
+    return shared_cpu_runtime_max_concurrency_;
+  }
+
   ///
   /// \brief Transform the AnalysisConfig to NativeConfig.
   ///
@@ -812,6 +915,58 @@ struct PD_INFER_DECL AnalysisConfig {
   ///
   MkldnnQuantizerConfig* mkldnn_quantizer_config() const;
 
+  ///
+  /// \brief Turn on the int8 post-training quantization of the plain CPU
+  /// kernels, which does not need MKLDNN. The predictor runs the warmup
+  /// batches to collect the histograms of the fc inputs, then runs those fc
+  /// ops with int8 weights. It does nothing on the CPUs with neither
+  /// AVX512-VNNI nor AVX2, on which the int8 fc is slower than the float one.
+  ///
+  /// \param warmup_data The batches of inputs to calibrate on.
+  /// \param scale_algo The algorithm choosing the input scales, one of
+  /// ScaleAlgo::KL, ScaleAlgo::PERCENTILE and ScaleAlgo::MAX.
+  /// \param percentile The percentile of the absolute input values that is
+  /// not clipped, only used by ScaleAlgo::PERCENTILE.
+  ///
+  void EnableCpuQuantizer(
+      std::shared_ptr<std::vector<std::vector<PaddleTensor>>> warmup_data,
+      ScaleAlgo scale_algo = ScaleAlgo::KL,
+      float percentile = 99.99f);
+
+  ///
+  /// \brief A boolean state telling whether the CPU quantization is enabled.
+  ///
+  /// \return bool Whether the CPU quantization is enabled.
+  ///
+  bool cpu_quantizer_enabled() const { return use_cpu_quantizer_; }
+
+  ///
+  /// \brief Get the warmup batches of the CPU quantization.
+  ///
+  /// \return The warmup batches.
+  ///
+  std::shared_ptr<std::vector<std::vector<PaddleTensor>>>
+  cpu_quantizer_warmup_data() const {
+    return cpu_quantizer_warmup_data_;
+  }
+
+  ///
+  /// \brief Get the algorithm choosing the input scales of the CPU
+  /// quantization.
+  ///
+  /// \return ScaleAlgo The scale algorithm.
+  ///
+  ScaleAlgo cpu_quantizer_scale_algo() const {
+    return cpu_quantizer_scale_algo_;
+  }
+
+  ///
+  /// \brief Get the percentile used by ScaleAlgo::PERCENTILE.
+  ///
+  /// \return float The percentile.
+  ///
+  float cpu_quantizer_percentile() const { return cpu_quantizer_percentile_; }
+
   ///
   /// \brief Specify the memory buffer of program and parameter.
   /// Used when model and params are loaded directly from memory.
@@ -848,6 +1003,66 @@ struct PD_INFER_DECL AnalysisConfig {
   ///
   bool enable_memory_optim() const;
 
+  ///
+  /// \brief Memory map the combined parameters file instead of reading it.
+  /// The parameters share the page cache with every process serving the same
+  /// model, which cuts down the startup time and the resident memory. Only
+  /// takes effect for a combined parameters file loaded from disk.
+  ///
+  /// \param x Whether to memory map the parameters.
+  /// \param lazy_load Whether to read the pages on first access instead of
+  /// faulting them all in at startup.
+  ///
+  void EnableMemoryMappedParams(bool x = true, bool lazy_load = true);
+  ///
+  /// \brief A boolean state telling whether the parameters are memory mapped.
+  ///
+  /// \return bool Whether the parameters are memory mapped.
+  ///
+  bool memory_mapped_params_enabled() const {
+    return use_memory_mapped_params_;
+  }
+  ///
+  /// \brief A boolean state telling whether the memory mapped parameters are
+  /// paged in lazily.
+  ///
+  /// \return bool Whether the memory mapped parameters are paged in lazily.
+  ///
+  bool memory_mapped_params_lazy_load() const {
+    return memory_mapped_params_lazy_load_;
+  }
+
+  ///
+  /// \brief Cache the optimized program and parameters of the model in a
+  /// directory. A predictor created again for the same model files, with the
+  /// same config and passes on the same version, loads them instead of
+  /// running the analysis passes. The model files are matched by their
+  /// names, sizes and content digests, not by their paths, so that the
+  /// copies of a model share the cached program. The directory keeps the 8
+  /// programs cached last. The models run with TensorRT, Lite, DLNNE or IPU,
+  /// or quantized after the analysis, are not cached.
+  ///
+  /// \param cache_dir The directory of the cached programs.
+  ///
+  void EnableOptimizedProgramCache(const std::string& cache_dir);
+  ///
+  /// \brief A boolean state telling whether the optimized programs are
+  /// cached.
+  ///
+  /// \return bool Whether the optimized programs are cached.
+  ///
+  bool optimized_program_cache_enabled() const {
+    return !optimized_program_cache_dir_.empty();
+  }
+  ///
+  /// \brief Get the directory of the cached optimized programs.
+  ///
+  /// \return const std::string& The directory of the cached programs.
+  ///
+  const std::string& optimized_program_cache_dir() const {
+    return optimized_program_cache_dir_;
+  }
+
   ///
   /// \brief Turn on profiling report.
   /// If not turned on, no profiling report will be generated.
@@ -1010,6 +1225,13 @@ struct PD_INFER_DECL AnalysisConfig {
   // memory reuse related.
   bool enable_memory_optim_{false};
 
+  // memory mapped parameters related.
+  bool use_memory_mapped_params_{false};
+  bool memory_mapped_params_lazy_load_{true};
+
+  // optimized program cache related.
+  std::string optimized_program_cache_dir_;
+
   bool use_mkldnn_{false};
   std::unordered_set<std::string> mkldnn_enabled_op_types_;
 
@@ -1022,6 +1244,14 @@ struct PD_INFER_DECL AnalysisConfig {
   bool specify_input_name_{false};
 
   int cpu_math_library_num_threads_{1};
+  int cpu_intra_op_num_threads_{1};
+  bool cpu_packed_weight_cache_{false};
+  bool cpu_autotune_{false};
+  std::string cpu_autotune_cache_file_;
+
+  // shared cpu runtime related.
+  std::string shared_cpu_runtime_model_;
+  int shared_cpu_runtime_max_concurrency_{1};
 
   bool with_profile_{false};
 
@@ -1055,6 +1285,12 @@ struct PD_INFER_DECL AnalysisConfig {
   int mkldnn_cache_capacity_{10};
   bool use_mkldnn_quantizer_{false};
   std::shared_ptr<MkldnnQuantizerConfig> mkldnn_quantizer_config_;
+  // plain CPU int8 related.
+  bool use_cpu_quantizer_{false};
+  std::shared_ptr<std::vector<std::vector<PaddleTensor>>>
+      cpu_quantizer_warmup_data_;
+  ScaleAlgo cpu_quantizer_scale_algo_{ScaleAlgo::KL};
+  float cpu_quantizer_percentile_{99.99f};
   bool use_mkldnn_bfloat16_{false};
   std::unordered_set<std::string> bfloat16_enabled_op_types_;
   bool use_mkldnn_int8_{false};
@@ -22,9 +22,15 @@ limitations under the License. */
 #pragma once
 
 #include <cassert>
+#include <condition_variable>  // NOLINT
+#include <deque>
+#include <functional>
+#include <future>  // NOLINT
 #include <map>
 #include <memory>
+#include <mutex>  // NOLINT
 #include <string>
+#include <thread>  // NOLINT
 #include <unordered_set>
 #include <utility>
 #include <vector>
@@ -220,6 +226,107 @@ class PD_INFER_DECL PredictorPool {
   std::shared_ptr<Predictor> main_pred_;
   std::vector<std::unique_ptr<Predictor>> preds_;
 };
+
+///
+/// \class AsyncPredictor
+///
+/// \brief AsyncPredictor runs predictions asynchronously on a queue served by
+/// a fixed number of predictor clones, so that a serving framework can keep
+/// many requests in flight without a thread per request.
+///
+/// A request is described by two callbacks, both called on the worker thread
+/// with the predictor the request is dispatched to: `prepare` sets the inputs
+/// before the run, and `done` fetches the outputs after it.
+///
+/// Usage:
+///
+/// \code{.cpp}
+/// AsyncPredictor async_predictor(config, 4);
+/// auto future = async_predictor.Run(
+///     [&](Predictor* p) { ... /* copy inputs in */ },
+///     [&](Predictor* p, bool success) { ... /* copy outputs out */ });
+/// \endcode
+///
+class PD_INFER_DECL AsyncPredictor {
+ public:
+  using PrepareCallback = std::function<void(Predictor*)>;
+  using DoneCallback = std::function<void(Predictor*, bool)>;
+
+  AsyncPredictor() = delete;
+  AsyncPredictor(const AsyncPredictor&) = delete;
+  AsyncPredictor& operator=(const AsyncPredictor&) = delete;
+
+  /// \brief Construct with \param num_workers predictor instances, each
+  /// served by its own thread.
+  explicit AsyncPredictor(const Config& config, size_t num_workers = 1);
+
+  /// \brief Finish all the queued requests and stop the workers.
+  ~AsyncPredictor();
+
+  ///
+  /// \brief Queue a prediction.
+  ///
+  /// \param[in] prepare Called to set the inputs of the predictor.
+  /// \param[in] done Called after the run with whether it succeeded, can be
+  /// empty.
+  /// \return A future telling whether the run succeeded, ready after `done`
+  /// returns.
+  ///
+  std::future<bool> Run(PrepareCallback prepare, DoneCallback done = nullptr);
+
+  /// \brief Get the number of requests waiting for a worker.
+  size_t GetPendingNum() const;
+
+ private:
+  struct Task {
+    PrepareCallback prepare;
+    DoneCallback done;
+    std::promise<bool> promise;
+  };
+
+  void WorkerLoop(Predictor* predictor);
+
+  PredictorPool pool_;
+  std::vector<std::thread> workers_;
+  std::deque<Task> tasks_;
+  mutable std::mutex mutex_;
+  std::condition_variable cv_;
+  bool stop_{false};
+};
+
+///
+/// \brief Statistics of a model attached to the shared CPU runtime, see
+/// Config::AttachSharedCPURuntime.
+///
+struct PD_INFER_DECL ModelRuntimeStats {
+  int64_t num_runs{0};
+  int64_t num_running{0};
+  double total_wait_ms{0.};
+  double total_run_ms{0.};
+  int64_t peak_activation_bytes{0};
+};
+
+///
+/// \brief Initialize the process-wide CPU runtime shared by co-served models.
+/// Must be called before creating predictors attached to it, otherwise the
+/// runtime uses all the hardware threads without a memory budget.
+///
+/// \param num_threads The total number of math library threads of all the
+/// concurrent runs, 0 means the number of hardware threads.
+/// \param memory_budget_mb The total activation memory of all the concurrent
+/// runs in MB, 0 means unlimited.
+///
+PD_INFER_DECL void InitSharedCPURuntime(int num_threads,
+                                        int64_t memory_budget_mb = 0);
+
+///
+/// \brief Get the statistics of a model attached to the shared CPU runtime.
+///
+/// \param model_name The model name passed to Config::AttachSharedCPURuntime.
+/// \return The statistics of the model.
+///
+PD_INFER_DECL ModelRuntimeStats
+GetModelRuntimeStats(const std::string& model_name);
 }  // namespace services
 
 }  // namespace paddle_infer
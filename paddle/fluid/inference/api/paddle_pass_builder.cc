@@ -265,6 +265,7 @@ CpuPassStrategy::CpuPassStrategy() : PassStrategy({}) {
                   "conv_eltwiseadd_bn_fuse_pass",            //
                   "conv_transpose_bn_fuse_pass",             //
                   "conv_transpose_eltwiseadd_bn_fuse_pass",  //
+                  "elementwise_chain_fuse_pass",             //
                   "is_test_pass",                            //
                   // following pass should be located in the last, since
                   // it will work on all fused ops.
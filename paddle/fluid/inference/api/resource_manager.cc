@@ -14,8 +14,10 @@
 
 #include "paddle/fluid/inference/api/resource_manager.h"
 
+#include <algorithm>
 #include <memory>
 #include <mutex>
+#include <thread>
 #include <unordered_map>
 #include <utility>
 
@@ -131,6 +133,123 @@ void CPUContextResource::InitCPUResource() {
 
 CPUContextResource::CPUContextResource() { InitCPUResource(); }
 
+SharedCPURuntime::SharedCPURuntime(int num_threads, int64_t memory_budget)
+    : num_threads_(num_threads > 0
+                       ? num_threads
+                       : std::max(1U, std::thread::hardware_concurrency())),
+      memory_budget_(memory_budget) {
+  PADDLE_ENFORCE_GE(memory_budget,
+                    0,
+                    platform::errors::InvalidArgument(
+                        "The memory budget of the shared CPU runtime should "
+                        "be >= 0, but got %d.",
+                        memory_budget));
+}
+
+void SharedCPURuntime::RegisterModel(const std::string& model_name,
+                                     int max_concurrency,
+                                     int num_threads) {
+  PADDLE_ENFORCE_GT(max_concurrency,
+                    0,
+                    platform::errors::InvalidArgument(
+                        "The max concurrency of model %s should be > 0, but "
+                        "got %d.",
+                        model_name,
+                        max_concurrency));
+  std::lock_guard<std::mutex> lock(mutex_);
+  auto& state = models_[model_name];
+  ++state.num_predictors;
+  state.max_concurrency = max_concurrency;
+  state.num_threads = std::max(1, std::min(num_threads, num_threads_));
+}
+
+void SharedCPURuntime::UnregisterModel(const std::string& model_name) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  auto it = models_.find(model_name);
+  PADDLE_ENFORCE_EQ(it != models_.end(),
+                    true,
+                    platform::errors::NotFound(
+                        "Model %s is not attached to the shared CPU runtime.",
+                        model_name));
+  // The statistics outlive the predictors of the model.
+  --it->second.num_predictors;
+}
+
+bool SharedCPURuntime::CanAdmit(const ModelState& state, int64_t bytes) const {
+  if (state.stats.num_running >= state.max_concurrency) return false;
+  // An idle runtime admits any run, so that a run larger than the budgets
+  // does not wait forever.
+  if (used_threads_ == 0) return true;
+  if (used_threads_ + state.num_threads > num_threads_) return false;
+  if (memory_budget_ > 0 && used_bytes_ + bytes > memory_budget_) return false;
+  return true;
+}
+
+SharedCPURuntime::ModelStats SharedCPURuntime::GetModelStats(
+    const std::string& model_name) const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  auto it = models_.find(model_name);
+  PADDLE_ENFORCE_EQ(it != models_.end(),
+                    true,
+                    platform::errors::NotFound(
+                        "Model %s is not attached to the shared CPU runtime.",
+                        model_name));
+  return it->second.stats;
+}
+
+std::map<std::string, SharedCPURuntime::ModelStats>
+SharedCPURuntime::GetAllModelStats() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  std::map<std::string, ModelStats> all_stats;
+  for (auto& item : models_) {
+    all_stats.emplace(item.first, item.second.stats);
+  }
+  return all_stats;
+}
+
+SharedCPURuntime::Admission::Admission(SharedCPURuntime* runtime,
+                                       const std::string& model_name)
+    : runtime_(runtime), model_name_(model_name) {
+  auto wait_start = std::chrono::steady_clock::now();
+  std::unique_lock<std::mutex> lock(runtime_->mutex_);
+  auto it = runtime_->models_.find(model_name_);
+  PADDLE_ENFORCE_EQ(it != runtime_->models_.end(),
+                    true,
+                    platform::errors::NotFound(
+                        "Model %s is not attached to the shared CPU runtime.",
+                        model_name_));
+  auto& state = it->second;
+  // Reserve what the largest run of this model took so far.
+  reserved_bytes_ = state.stats.peak_activation_bytes;
+  runtime_->cv_.wait(
+      lock, [&] { return runtime_->CanAdmit(state, reserved_bytes_); });
+  num_threads_ = state.num_threads;
+  runtime_->used_threads_ += num_threads_;
+  runtime_->used_bytes_ += reserved_bytes_;
+  ++state.stats.num_running;
+  start_ = std::chrono::steady_clock::now();
+  state.stats.total_wait_ms +=
+      std::chrono::duration<double, std::milli>(start_ - wait_start).count();
+}
+
+SharedCPURuntime::Admission::~Admission() {
+  double run_ms = std::chrono::duration<double, std::milli>(
+                      std::chrono::steady_clock::now() - start_)
+                      .count();
+  {
+    std::lock_guard<std::mutex> lock(runtime_->mutex_);
+    auto& stats = runtime_->models_[model_name_].stats;
+    runtime_->used_threads_ -= num_threads_;
+    runtime_->used_bytes_ -= reserved_bytes_;
+    --stats.num_running;
+    ++stats.num_runs;
+    stats.total_run_ms += run_ms;
+    stats.peak_activation_bytes =
+        std::max(stats.peak_activation_bytes, activation_bytes_);
+  }
+  runtime_->cv_.notify_all();
+}
+
 #if defined(PADDLE_WITH_CUDA) || defined(PADDLE_WITH_HIP)
 GPUContextResource::GPUContextResource(const phi::Place& place, void* stream)
     : place_(place) {
@@ -390,6 +509,26 @@ CPUContextResource* ResourceManager::GetCPUResource() const {
   return cpu_resource_.get();
 }
 
+void ResourceManager::InitSharedCPURuntime(int num_threads,
+                                           int64_t memory_budget) {
+  std::lock_guard<std::mutex> lock_gurad(shared_cpu_runtime_mutex_);
+  PADDLE_ENFORCE_EQ(shared_cpu_runtime_ == nullptr,
+                    true,
+                    platform::errors::PreconditionNotMet(
+                        "The shared CPU runtime has been initialized, it "
+                        "should be initialized before creating predictors "
+                        "attached to it."));
+  shared_cpu_runtime_.reset(new SharedCPURuntime(num_threads, memory_budget));
+}
+
+SharedCPURuntime* ResourceManager::GetSharedCPURuntime() {
+  std::lock_guard<std::mutex> lock_gurad(shared_cpu_runtime_mutex_);
+  if (shared_cpu_runtime_ == nullptr) {
+    shared_cpu_runtime_.reset(new SharedCPURuntime(0, 0));
+  }
+  return shared_cpu_runtime_.get();
+}
+
 #if defined(PADDLE_WITH_CUDA) || defined(PADDLE_WITH_HIP)
 void* ResourceManager::InitGPUResource(const phi::Place& place, void* stream) {
   std::lock_guard<std::mutex> lock_gurad(gpu_mutex_);
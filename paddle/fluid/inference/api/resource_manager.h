@@ -14,10 +14,13 @@
 #pragma once
 
 #include <atomic>
+#include <chrono>
+#include <condition_variable>
 #include <functional>
 #include <map>
 #include <memory>
 #include <mutex>
+#include <string>
 
 #include "paddle/fluid/platform/macros.h"
 #include "paddle/phi/api/include/tensor.h"
@@ -48,6 +51,81 @@ class CPUContextResource {
   std::unique_ptr<Eigen::DefaultDevice> cpu_eigen_device_;
 };
 
+// A process-wide runtime shared by the CPU predictors of many co-served
+// models. The math libraries spawn their own OpenMP/MKL threads per calling
+// thread, so instead of every predictor sizing them independently, the runtime
+// owns one intra-op thread budget and hands out slices of it to admitted runs.
+// It also enforces a global budget on the activation memory of concurrent
+// runs, and collects per-model statistics.
+class SharedCPURuntime {
+ public:
+  struct ModelStats {
+    int64_t num_runs{0};
+    int64_t num_running{0};
+    // Accumulated time spent in admission and in execution.
+    double total_wait_ms{0.};
+    double total_run_ms{0.};
+    // The largest activation memory of a single run observed so far.
+    int64_t peak_activation_bytes{0};
+  };
+
+  // Holds the resources of one run, released on destruction.
+  class Admission {
+   public:
+    Admission(SharedCPURuntime* runtime, const std::string& model_name);
+    ~Admission();
+    int num_threads() const { return num_threads_; }
+    void set_activation_bytes(int64_t bytes) { activation_bytes_ = bytes; }
+
+   private:
+    SharedCPURuntime* runtime_;
+    std::string model_name_;
+    int num_threads_{1};
+    int64_t reserved_bytes_{0};
+    int64_t activation_bytes_{0};
+    std::chrono::steady_clock::time_point start_;
+
+    DISABLE_COPY_AND_ASSIGN(Admission);
+  };
+
+  // `memory_budget` in bytes, 0 means unlimited.
+  SharedCPURuntime(int num_threads, int64_t memory_budget);
+
+  int num_threads() const { return num_threads_; }
+  int64_t memory_budget() const { return memory_budget_; }
+
+  // Attach a predictor (or a clone) of `model_name`. At most `max_concurrency`
+  // runs of the model execute at once, each on `num_threads` intra-op threads.
+  void RegisterModel(const std::string& model_name,
+                     int max_concurrency,
+                     int num_threads);
+  void UnregisterModel(const std::string& model_name);
+
+  ModelStats GetModelStats(const std::string& model_name) const;
+  std::map<std::string, ModelStats> GetAllModelStats() const;
+
+ private:
+  struct ModelState {
+    int num_predictors{0};
+    int max_concurrency{1};
+    int num_threads{1};
+    ModelStats stats;
+  };
+
+  bool CanAdmit(const ModelState& state, int64_t bytes) const;
+
+  const int num_threads_;
+  const int64_t memory_budget_;
+
+  mutable std::mutex mutex_;
+  std::condition_variable cv_;
+  int used_threads_{0};
+  int64_t used_bytes_{0};
+  std::map<std::string, ModelState> models_;
+
+  DISABLE_COPY_AND_ASSIGN(SharedCPURuntime);
+};
+
 #if defined(PADDLE_WITH_CUDA) || defined(PADDLE_WITH_HIP)
 class GPUContextResource {
  public:
@@ -142,6 +220,18 @@ class ResourceManager {
   std::mutex cpu_mutex_;
   std::unique_ptr<CPUContextResource> cpu_resource_{nullptr};
 
+  // Shared CPU runtime for co-served models
+ public:
+  // Must be called before any predictor attaches to the runtime.
+  void InitSharedCPURuntime(int num_threads, int64_t memory_budget);
+  // Created on first use with all the hardware threads and no memory budget
+  // unless initialized explicitly.
+  SharedCPURuntime* GetSharedCPURuntime();
+
+ private:
+  std::mutex shared_cpu_runtime_mutex_;
+  std::unique_ptr<SharedCPURuntime> shared_cpu_runtime_{nullptr};
+
 // GPU Resource
 #if defined(PADDLE_WITH_CUDA) || defined(PADDLE_WITH_HIP)
 
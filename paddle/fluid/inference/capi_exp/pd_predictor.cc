@@ -28,6 +28,13 @@
           "The pointer of paddle predictor shouldn't be nullptr")); \
   auto& predictor = pd_predictor->predictor
 
+#define CHECK_AND_CONVERT_PD_ASYNC_PREDICTOR                               \
+  PADDLE_ENFORCE_NOT_NULL(                                                 \
+      pd_async_predictor,                                                  \
+      paddle::platform::errors::InvalidArgument(                           \
+          "The pointer of paddle async predictor shouldn't be nullptr")); \
+  auto& async_predictor = pd_async_predictor->async_predictor
+
 extern "C" {
 __pd_give PD_Predictor* PD_PredictorCreate(__pd_take PD_Config* pd_config) {
   PADDLE_ENFORCE_NOT_NULL(
@@ -108,6 +115,55 @@ void PD_PredictorDestroy(__pd_take PD_Predictor* pd_predictor) {
   delete pd_predictor;
 }
 
+__pd_give PD_AsyncPredictor* PD_AsyncPredictorCreate(
+    __pd_take PD_Config* pd_config, size_t num_workers) {
+  PADDLE_ENFORCE_NOT_NULL(
+      pd_config,
+      paddle::platform::errors::InvalidArgument(
+          "The pointer of paddle config shouldn't be nullptr"));
+  PD_AsyncPredictor* pd_async_predictor = new PD_AsyncPredictor();
+  paddle_infer::Config* config =
+      reinterpret_cast<paddle_infer::Config*>(pd_config);
+  pd_async_predictor->async_predictor.reset(
+      new paddle_infer::services::AsyncPredictor(*config, num_workers));
+  delete config;
+  return pd_async_predictor;
+}
+
+void PD_AsyncPredictorRun(__pd_keep PD_AsyncPredictor* pd_async_predictor,
+                          PD_PredictorPrepareCallback prepare,
+                          PD_PredictorDoneCallback done,
+                          void* user_data) {
+  CHECK_AND_CONVERT_PD_ASYNC_PREDICTOR;
+  // Wrap the predictor of the worker without taking its ownership.
+  auto wrap = [](paddle_infer::Predictor* predictor) {
+    PD_Predictor pd_predictor;
+    pd_predictor.predictor.reset(predictor, [](paddle_infer::Predictor*) {});
+    return pd_predictor;
+  };
+  async_predictor->Run(
+      [=](paddle_infer::Predictor* predictor) {
+        if (prepare == nullptr) return;
+        PD_Predictor pd_predictor = wrap(predictor);
+        prepare(&pd_predictor, user_data);
+      },
+      [=](paddle_infer::Predictor* predictor, bool success) {
+        if (done == nullptr) return;
+        PD_Predictor pd_predictor = wrap(predictor);
+        done(&pd_predictor, success, user_data);
+      });
+}
+
+size_t PD_AsyncPredictorGetPendingNum(
+    __pd_keep PD_AsyncPredictor* pd_async_predictor) {
+  CHECK_AND_CONVERT_PD_ASYNC_PREDICTOR;
+  return async_predictor->GetPendingNum();
+}
+
+void PD_AsyncPredictorDestroy(__pd_take PD_AsyncPredictor* pd_async_predictor) {
+  delete pd_async_predictor;
+}
+
 const char* PD_GetVersion() {
   static std::string version = paddle_infer::GetVersion();
   return version.c_str();
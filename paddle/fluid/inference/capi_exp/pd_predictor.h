@@ -27,10 +27,25 @@
 #include "pd_common.h"  // NOLINT
 
 typedef struct PD_Predictor PD_Predictor;
+typedef struct PD_AsyncPredictor PD_AsyncPredictor;
 typedef struct PD_Config PD_Config;
 typedef struct PD_Tensor PD_Tensor;
 typedef struct PD_OneDimArrayCstr PD_OneDimArrayCstr;
 
+///
+/// \brief Callback of an asynchronous run to set the inputs of the predictor
+/// the run is dispatched to.
+///
+typedef void (*PD_PredictorPrepareCallback)(PD_Predictor* pd_predictor,
+                                            void* user_data);
+///
+/// \brief Callback of an asynchronous run to fetch the outputs of the
+/// predictor after the run.
+///
+typedef void (*PD_PredictorDoneCallback)(PD_Predictor* pd_predictor,
+                                         PD_Bool success,
+                                         void* user_data);
+
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -143,6 +158,51 @@ PADDLE_CAPI_EXPORT extern uint64_t PD_PredictorTryShrinkMemory(
 PADDLE_CAPI_EXPORT extern void PD_PredictorDestroy(
     __pd_take PD_Predictor* pd_predictor);
 
+///
+/// \brief Create an asynchronous predictor, which runs the queued predictions
+/// on `num_workers` predictor clones.
+///
+/// \param[in] pd_config config
+/// \param[in] num_workers the number of predictor clones
+/// \return new asynchronous predictor.
+///
+PADDLE_CAPI_EXPORT extern __pd_give PD_AsyncPredictor* PD_AsyncPredictorCreate(
+    __pd_take PD_Config* pd_config, size_t num_workers);
+
+///
+/// \brief Queue a prediction. The callbacks are called on a worker thread
+/// with the predictor the run is dispatched to, which is only valid inside
+/// the callbacks.
+///
+/// \param[in] pd_async_predictor asynchronous predictor
+/// \param[in] prepare called to set the inputs before the run, can be NULL
+/// \param[in] done called with whether the run succeeded, can be NULL
+/// \param[in] user_data passed to the callbacks
+///
+PADDLE_CAPI_EXPORT extern void PD_AsyncPredictorRun(
+    __pd_keep PD_AsyncPredictor* pd_async_predictor,
+    PD_PredictorPrepareCallback prepare,
+    PD_PredictorDoneCallback done,
+    void* user_data);
+
+///
+/// \brief Get the number of predictions waiting for a worker.
+///
+/// \param[in] pd_async_predictor asynchronous predictor
+/// \return the number of queued predictions
+///
+PADDLE_CAPI_EXPORT extern size_t PD_AsyncPredictorGetPendingNum(
+    __pd_keep PD_AsyncPredictor* pd_async_predictor);
+
+///
+/// \brief Finish the queued predictions and destroy the asynchronous
+/// predictor.
+///
+/// \param[in] pd_async_predictor asynchronous predictor
+///
+PADDLE_CAPI_EXPORT extern void PD_AsyncPredictorDestroy(
+    __pd_take PD_AsyncPredictor* pd_async_predictor);
+
 ///
 /// \brief Get version info.
 ///
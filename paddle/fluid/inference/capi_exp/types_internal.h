@@ -27,3 +27,7 @@ typedef struct PD_Tensor {
 typedef struct PD_Predictor {
   std::shared_ptr<paddle_infer::Predictor> predictor;
 } PD_Predictor;
+
+typedef struct PD_AsyncPredictor {
+  std::unique_ptr<paddle_infer::services::AsyncPredictor> async_predictor;
+} PD_AsyncPredictor;
@@ -0,0 +1,133 @@
+// Copyright (c) 2022 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+package paddle
+
+// #include "pd_predictor.h"
+// #include "pd_common.h"
+// #include <stdint.h>
+// #include <stdlib.h>
+// extern void goAsyncPrepare(PD_Predictor* pd_predictor, void* user_data);
+// extern void goAsyncDone(PD_Predictor* pd_predictor, PD_Bool success,
+//                         void* user_data);
+import "C"
+import (
+	"runtime"
+	"sync"
+	"unsafe"
+)
+
+type asyncRequest struct {
+	prepare func(*Predictor)
+	done    func(*Predictor, bool)
+}
+
+// The callbacks can not carry Go pointers through C, so the requests in
+// flight are kept here and identified by an id stored in C memory.
+var (
+	asyncRequestsMu sync.Mutex
+	asyncRequests   = make(map[uintptr]*asyncRequest)
+	asyncRequestID  uintptr
+)
+
+func lookupAsyncRequest(userData unsafe.Pointer, remove bool) *asyncRequest {
+	id := uintptr(*(*C.uintptr_t)(userData))
+	asyncRequestsMu.Lock()
+	defer asyncRequestsMu.Unlock()
+	req := asyncRequests[id]
+	if remove {
+		delete(asyncRequests, id)
+	}
+	return req
+}
+
+//export goAsyncPrepare
+func goAsyncPrepare(cPredictor *C.PD_Predictor, userData unsafe.Pointer) {
+	req := lookupAsyncRequest(userData, false)
+	if req.prepare != nil {
+		req.prepare(&Predictor{c: cPredictor})
+	}
+}
+
+//export goAsyncDone
+func goAsyncDone(cPredictor *C.PD_Predictor, success C.PD_Bool, userData unsafe.Pointer) {
+	req := lookupAsyncRequest(userData, true)
+	C.free(userData)
+	if req.done != nil {
+		req.done(&Predictor{c: cPredictor}, success != 0)
+	}
+}
+
+type AsyncPredictor struct {
+	c *C.PD_AsyncPredictor
+}
+
+///
+/// \brief Create an AsyncPredictor, which runs the queued predictions on
+/// numWorkers predictor clones
+///
+/// \param[in] Config config
+/// \param[in] numWorkers the number of predictor clones
+/// \return new async predictor.
+///
+func NewAsyncPredictor(config *Config, numWorkers uint) *AsyncPredictor {
+	cAsyncPredictor := C.PD_AsyncPredictorCreate(config.c, C.size_t(numWorkers))
+	asyncPredictor := &AsyncPredictor{c: cAsyncPredictor}
+	runtime.SetFinalizer(asyncPredictor, func(asyncPredictor *AsyncPredictor) {
+		asyncPredictor.Destroy()
+	})
+	return asyncPredictor
+}
+
+///
+/// \brief Queue a prediction. prepare sets the inputs and done fetches the
+/// outputs, both are called on a worker thread with the predictor the run is
+/// dispatched to, which is only valid inside the callbacks.
+///
+/// \param[in] prepare called to set the inputs, can be nil
+/// \param[in] done called with whether the run succeeded, can be nil
+///
+func (p *AsyncPredictor) Run(prepare func(*Predictor), done func(*Predictor, bool)) {
+	asyncRequestsMu.Lock()
+	asyncRequestID++
+	id := asyncRequestID
+	asyncRequests[id] = &asyncRequest{prepare: prepare, done: done}
+	asyncRequestsMu.Unlock()
+
+	userData := C.malloc(C.size_t(unsafe.Sizeof(C.uintptr_t(0))))
+	*(*C.uintptr_t)(userData) = C.uintptr_t(id)
+	C.PD_AsyncPredictorRun(p.c,
+		C.PD_PredictorPrepareCallback(C.goAsyncPrepare),
+		C.PD_PredictorDoneCallback(C.goAsyncDone),
+		userData)
+}
+
+///
+/// \brief Get the number of predictions waiting for a worker
+///
+/// \return the number of queued predictions
+///
+func (p *AsyncPredictor) GetPendingNum() uint {
+	return uint(C.PD_AsyncPredictorGetPendingNum(p.c))
+}
+
+///
+/// \brief Finish the queued predictions and release the predictor clones
+///
+func (p *AsyncPredictor) Destroy() {
+	if p.c != nil {
+		C.PD_AsyncPredictorDestroy(p.c)
+		p.c = nil
+	}
+}
@@ -18,6 +18,7 @@ import (
 	"io/ioutil"
 	"os"
 	"runtime"
+	"sync"
 	"testing"
 	"time"
 )
@@ -190,6 +191,37 @@ func TestCollectShapeInfo(t *testing.T) {
 
 }
 
+func TestAsyncPredictor(t *testing.T) {
+	config := NewConfig()
+	config.SetModel("./mobilenetv1/inference.pdmodel", "./mobilenetv1/inference.pdiparams")
+	asyncPredictor := NewAsyncPredictor(config, 2)
+
+	data := make([]float32, numElements([]int32{1, 3, 224, 224}))
+	for i := 0; i < int(numElements([]int32{1, 3, 224, 224})); i++ {
+		data[i] = float32(i%255) * 0.1
+	}
+	var wg sync.WaitGroup
+	for i := 0; i < 8; i++ {
+		wg.Add(1)
+		asyncPredictor.Run(func(p *Predictor) {
+			inHandle := p.GetInputHandle(p.GetInputNames()[0])
+			inHandle.Reshape([]int32{1, 3, 224, 224})
+			inHandle.CopyFromCpu(data)
+		}, func(p *Predictor, success bool) {
+			defer wg.Done()
+			if !success {
+				t.Error("async run failed")
+				return
+			}
+			outHandle := p.GetOutputHandle(p.GetOutputNames()[0])
+			outData := make([]float32, numElements(outHandle.Shape()))
+			outHandle.CopyToCpu(outData)
+		})
+	}
+	wg.Wait()
+	asyncPredictor.Destroy()
+}
+
 func numElements(shape []int32) int32 {
 	n := int32(1)
 	for _, v := range shape {
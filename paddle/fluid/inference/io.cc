@@ -22,6 +22,7 @@ limitations under the License. */
 #include "paddle/fluid/framework/feed_fetch_type.h"
 #include "paddle/fluid/framework/op_registry.h"
 #include "paddle/fluid/framework/version.h"
+#include "paddle/fluid/inference/utils/mmap_params_loader.h"
 #include "paddle/fluid/platform/cpu_helper.h"
 #include "paddle/fluid/platform/enforce.h"
 #include "paddle/fluid/pybind/pybind.h"
@@ -185,6 +186,38 @@ std::unique_ptr<framework::ProgramDesc> Load(
   return main_program;
 }
 
+std::unique_ptr<framework::ProgramDesc> LoadWithMmapParams(
+    framework::Executor* executor,
+    framework::Scope* scope,
+    const std::string& prog_filename,
+    const std::string& param_filename,
+    bool lazy_load) {
+  if (!MmapParamsSupported() || param_filename.empty()) {
+    return Load(executor, scope, prog_filename, param_filename);
+  }
+  std::string program_desc_str;
+  ReadBinaryFile(prog_filename, &program_desc_str);
+
+  std::unique_ptr<framework::ProgramDesc> main_program(
+      new framework::ProgramDesc(program_desc_str));
+  PADDLE_ENFORCE_EQ(
+      framework::IsProgramVersionSupported(main_program->Version()),
+      true,
+      platform::errors::Unavailable("Model version %ld is not supported.",
+                                    main_program->Version()));
+
+  if (!LoadPersistablesFromMmap(
+          *main_program, param_filename, scope, lazy_load)) {
+    LoadPersistables(executor,
+                     scope,
+                     *main_program,
+                     "",
+                     param_filename,
+                     false /* model_from_memory */);
+  }
+  return main_program;
+}
+
 std::unique_ptr<framework::ProgramDesc> LoadFromMemory(
     framework::Executor* executor,
     framework::Scope* scope,
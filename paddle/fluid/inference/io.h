@@ -44,6 +44,16 @@ std::unique_ptr<framework::ProgramDesc> Load(framework::Executor* executor,
                                              const std::string& prog_filename,
                                              const std::string& param_filename);
 
+// Load the program and memory map its combined parameters file instead of
+// running load_combine. Falls back to Load() when the parameters can not be
+// mapped.
+std::unique_ptr<framework::ProgramDesc> LoadWithMmapParams(
+    framework::Executor* executor,
+    framework::Scope* scope,
+    const std::string& prog_filename,
+    const std::string& param_filename,
+    bool lazy_load);
+
 std::unique_ptr<framework::ProgramDesc> LoadFromMemory(
     framework::Executor* executor,
     framework::Scope* scope,
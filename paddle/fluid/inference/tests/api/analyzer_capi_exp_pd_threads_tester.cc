@@ -117,6 +117,83 @@ void threads_run(int thread_num) {
 
 TEST(PD_Predictor, PD_multi_threads_run) { threads_run(10); }
 
+void prepare_async_run(PD_Predictor* predictor, void* user_data) {
+  struct RunParameter* param = (struct RunParameter*)user_data;
+  PD_OneDimArrayCstr* input_names = PD_PredictorGetInputNames(predictor);
+  PD_Tensor* tensor =
+      PD_PredictorGetInputHandle(predictor, input_names->data[0]);
+  PD_TensorReshape(tensor, param->shape_size, param->shapes);
+  PD_TensorCopyFromCpuFloat(tensor, param->input_data);
+  PD_TensorDestroy(tensor);
+  PD_OneDimArrayCstrDestroy(input_names);
+}
+
+void finish_async_run(PD_Predictor* predictor,
+                      PD_Bool success,
+                      void* user_data) {
+  struct RunParameter* param = (struct RunParameter*)user_data;
+  ASSERT_TRUE(success);
+  PD_OneDimArrayCstr* output_names = PD_PredictorGetOutputNames(predictor);
+  PD_Tensor* output_tensor =
+      PD_PredictorGetOutputHandle(predictor, output_names->data[0]);
+  PD_OneDimArrayInt32* output_shape = PD_TensorGetShape(output_tensor);
+  param->out_size = 1;
+  for (size_t index = 0; index < output_shape->size; ++index) {
+    param->out_size = param->out_size * output_shape->data[index];
+  }
+  PD_OneDimArrayInt32Destroy(output_shape);
+  param->out_data =
+      reinterpret_cast<float*>(malloc(param->out_size * sizeof(float)));
+  PD_TensorCopyToCpuFloat(output_tensor, param->out_data);
+  PD_TensorDestroy(output_tensor);
+  PD_OneDimArrayCstrDestroy(output_names);
+}
+
+void async_run(int worker_num, int request_num) {
+  auto model_dir = FLAGS_infer_model;
+  PD_Config* config = PD_ConfigCreate();
+  PD_ConfigSetModel(config,
+                    (model_dir + "/__model__").c_str(),
+                    (model_dir + "/__params__").c_str());
+  PD_AsyncPredictor* async_predictor =
+      PD_AsyncPredictorCreate(config, worker_num);
+
+  RunParameter* params = reinterpret_cast<RunParameter*>(
+      malloc(request_num * sizeof(RunParameter)));
+  int32_t shapes[4] = {1, 3, 300, 300};
+  float* input =
+      reinterpret_cast<float*>(malloc(1 * 3 * 300 * 300 * sizeof(float)));
+  memset(input, 0, 1 * 3 * 300 * 300 * sizeof(float));
+  for (int i = 0; i < request_num; ++i) {
+    params[i].predictor = NULL;
+    params[i].shapes = shapes;
+    params[i].shape_size = 4;
+    params[i].input_data = input;
+    params[i].out_size = 0;
+    params[i].out_data = NULL;
+    params[i].thread_index = i;
+    PD_AsyncPredictorRun(
+        async_predictor, prepare_async_run, finish_async_run, params + i);
+  }
+  // Destroying the async predictor waits for all the queued runs.
+  PD_AsyncPredictorDestroy(async_predictor);
+  ASSERT_GT(params[0].out_size, 0);
+
+  for (int i = 1; i < request_num; ++i) {
+    ASSERT_EQ(params[i].out_size, params[0].out_size);
+    for (int j = 0; j < params[i].out_size; ++j) {
+      ASSERT_EQ(params[i].out_data[j], params[0].out_data[j]);
+    }
+  }
+  for (int i = 0; i < request_num; ++i) {
+    free(params[i].out_data);
+  }
+  free(input);
+  free(params);
+}
+
+TEST(PD_AsyncPredictor, PD_async_run) { async_run(4, 32); }
+
 }  // namespace analysis
 }  // namespace inference
 }  // namespace paddle
@@ -105,6 +105,15 @@ TEST(Analyzer_resnet50, compare) { compare(); }
 TEST(Analyzer_resnet50, compare_mkldnn) { compare(true /* use_mkldnn */); }
 #endif
 
+// Compare the latency and the outputs of the plain CPU int8 quantization
+TEST(Analyzer_resnet50, compare_cpu_quantizer) {
+  AnalysisConfig cfg;
+  SetConfig(&cfg);
+  std::vector<std::vector<PaddleTensor>> input_slots_all;
+  SetInput(&input_slots_all);
+  CompareCpuQuantizedAndAnalysis(&cfg, input_slots_all);
+}
+
 // Compare Deterministic result
 TEST(Analyzer_resnet50, compare_determine) {
   AnalysisConfig cfg;
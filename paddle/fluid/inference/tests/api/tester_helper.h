@@ -887,6 +887,86 @@ void CompareQuantizedAndAnalysis(
     CompareAccuracy(quantized_outputs, analysis_outputs, compared_idx);
 }
 
+// Compare the latency and the outputs of the FP32 predictor with the one
+// quantized by the plain CPU quantizer, calibrated on the first
+// FLAGS_warmup_iters batches of inputs.
+void CompareCpuQuantizedAndAnalysis(
+    const AnalysisConfig *config,
+    const std::vector<std::vector<PaddleTensor>> &inputs,
+    ScaleAlgo scale_algo = ScaleAlgo::KL) {
+  PADDLE_ENFORCE_GT(
+      inputs.size(),
+      0,
+      platform::errors::PreconditionNotMet("There is no input data provided."));
+  AnalysisConfig qconfig(*config);
+  int num_warmup = (std::min)((std::max)(FLAGS_warmup_iters, 1),
+                              static_cast<int>(inputs.size()));
+  qconfig.EnableCpuQuantizer(
+      std::make_shared<std::vector<std::vector<PaddleTensor>>>(
+          inputs.begin(), inputs.begin() + num_warmup),
+      scale_algo);
+
+  LOG(INFO) << "--- FP32 prediction start ---";
+  auto *cfg = reinterpret_cast<const PaddlePredictor::Config *>(config);
+  PrintConfig(cfg, true);
+  std::vector<std::vector<PaddleTensor>> analysis_outputs;
+  float sample_latency_fp32{-1};
+  TestOneThreadPrediction(cfg,
+                          inputs,
+                          &analysis_outputs,
+                          true,
+                          VarType::FP32,
+                          &sample_latency_fp32);
+
+  LOG(INFO) << "--- CPU INT8 prediction start ---";
+  auto *qcfg = reinterpret_cast<const PaddlePredictor::Config *>(&qconfig);
+  PrintConfig(qcfg, true);
+  std::vector<std::vector<PaddleTensor>> quantized_outputs;
+  float sample_latency_int8{-1};
+  TestOneThreadPrediction(qcfg,
+                          inputs,
+                          &quantized_outputs,
+                          true,
+                          VarType::INT8,
+                          &sample_latency_int8);
+
+  SummarizePerformance("FP32", sample_latency_fp32);
+  SummarizePerformance("CPU INT8", sample_latency_int8);
+  LOG(INFO) << "CPU INT8 speedup: "
+            << sample_latency_fp32 / sample_latency_int8;
+
+  // The drift of the first output, and how often its top-1 class is kept.
+  float max_diff = 0.f;
+  int num_rows = 0;
+  int num_top1_kept = 0;
+  for (size_t i = 0; i < analysis_outputs.size(); ++i) {
+    auto &out = analysis_outputs[i][0];
+    auto &qout = quantized_outputs[i][0];
+    if (out.dtype != PaddleDType::FLOAT32 || out.shape.empty()) continue;
+    int rows = out.shape[0];
+    size_t size = VecReduceToInt(out.shape);
+    if (rows <= 0 || size != VecReduceToInt(qout.shape)) continue;
+    size_t cols = size / rows;
+    auto *data = static_cast<float *>(out.data.data());
+    auto *qdata = static_cast<float *>(qout.data.data());
+    for (size_t j = 0; j < size; ++j) {
+      max_diff = (std::max)(max_diff, std::abs(data[j] - qdata[j]));
+    }
+    for (int r = 0; r < rows; ++r) {
+      auto *row = data + r * cols;
+      auto *qrow = qdata + r * cols;
+      num_top1_kept += std::max_element(row, row + cols) - row ==
+                       std::max_element(qrow, qrow + cols) - qrow;
+    }
+    num_rows += rows;
+  }
+  LOG(INFO) << "--- CPU INT8 accuracy summary --- ";
+  LOG(INFO) << "max abs diff to FP32: " << max_diff;
+  if (num_rows > 0) {
+    LOG(INFO) << "top1 kept: " << num_top1_kept << "/" << num_rows;
+  }
+}
+
 void CompareBFloat16AndAnalysis(
     const AnalysisConfig *config,
     const AnalysisConfig *qconfig,
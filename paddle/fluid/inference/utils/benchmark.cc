@@ -14,13 +14,68 @@
 
 #include "paddle/fluid/inference/utils/benchmark.h"
 
+#include <algorithm>
+#include <cmath>
 #include <fstream>
+#include <iomanip>
+#include <numeric>
+#include <sstream>
+#include <unordered_map>
 
 #include "paddle/fluid/platform/enforce.h"
 
 namespace paddle {
 namespace inference {
 
+namespace {
+
+std::string EscapeJson(const std::string &str) {
+  std::string res;
+  for (char c : str) {
+    if (c == '"' || c == '\\') {
+      res += '\\';
+      res += c;
+    } else if (static_cast<unsigned char>(c) < 0x20) {
+      res += ' ';
+    } else {
+      res += c;
+    }
+  }
+  return res;
+}
+
+void StatsToJson(const OpProfile::LatencyStats &stats, std::ostream &os) {
+  os << "\"mean\": " << stats.mean << ", \"p50\": " << stats.p50
+     << ", \"p90\": " << stats.p90 << ", \"p99\": " << stats.p99;
+}
+
+void StatsToCsv(const OpProfile::LatencyStats &stats, std::ostream &os) {
+  os << stats.mean << ',' << stats.p50 << ',' << stats.p90 << ','
+     << stats.p99;
+}
+
+struct OpTypeTotals {
+  int count{0};
+  int64_t alloc_bytes{0};
+  int64_t allocs{0};
+};
+
+// The number of operators of each type and their memory per run.
+std::unordered_map<std::string, OpTypeTotals> SumOpTypes(
+    const std::vector<OpProfile::OpRecord> &ops) {
+  std::unordered_map<std::string, OpTypeTotals> totals;
+  for (auto &op : ops) {
+    int64_t runs = std::max<int64_t>(op.latency.size(), 1);
+    auto &total = totals[op.type];
+    ++total.count;
+    total.alloc_bytes += op.alloc_bytes / runs;
+    total.allocs += op.allocs / runs;
+  }
+  return totals;
+}
+
+}  // namespace
+
 std::string Benchmark::SerializeToString() const {
   std::stringstream ss;
   ss << "-----------------------------------------------------\n";
@@ -50,5 +105,238 @@ void Benchmark::PersistToFile(const std::string &path) const {
   file.close();
 }
 
+void OpProfile::RecordOp(size_t idx,
+                         const std::string &type,
+                         float latency,
+                         int64_t alloc_bytes,
+                         int64_t allocs) {
+  if (ops_.size() <= idx) {
+    ops_.resize(idx + 1);
+  }
+  auto &op = ops_[idx];
+  if (op.type.empty()) {
+    op.type = type;
+  }
+  PADDLE_ENFORCE_EQ(
+      op.type,
+      type,
+      platform::errors::InvalidArgument(
+          "The operator %d is recorded as %s, but it was %s in the former "
+          "runs.",
+          idx,
+          type,
+          op.type));
+  op.latency.push_back(latency);
+  op.alloc_bytes += alloc_bytes;
+  op.allocs += allocs;
+}
+
+void OpProfile::RecordRun(float latency) { runs_.push_back(latency); }
+
+void OpProfile::RecordPassEffect(const std::string &pass,
+                                 const std::vector<float> &latency) {
+  passes_.emplace_back(pass, latency);
+}
+
+OpProfile::LatencyStats OpProfile::OpStats(size_t idx) const {
+  PADDLE_ENFORCE_LT(idx,
+                    ops_.size(),
+                    platform::errors::OutOfRange(
+                        "The operator %d is out of the %d recorded ones.",
+                        idx,
+                        ops_.size()));
+  return ComputeStats(ops_[idx].latency);
+}
+
+std::vector<std::pair<std::string, OpProfile::LatencyStats>>
+OpProfile::OpTypeStats() const {
+  std::vector<std::string> types;
+  std::unordered_map<std::string, std::vector<float>> per_run;
+  for (auto &op : ops_) {
+    if (op.type.empty()) continue;
+    auto it = per_run.find(op.type);
+    if (it == per_run.end()) {
+      types.push_back(op.type);
+      it = per_run.emplace(op.type, std::vector<float>()).first;
+    }
+    auto &sums = it->second;
+    if (sums.size() < op.latency.size()) {
+      sums.resize(op.latency.size(), 0.f);
+    }
+    for (size_t i = 0; i < op.latency.size(); ++i) {
+      sums[i] += op.latency[i];
+    }
+  }
+  std::vector<std::pair<std::string, LatencyStats>> res;
+  for (auto &type : types) {
+    res.emplace_back(type, ComputeStats(per_run[type]));
+  }
+  return res;
+}
+
+std::string OpProfile::SerializeToJson() const {
+  auto totals = SumOpTypes(ops_);
+  std::stringstream ss;
+  ss << "{\n";
+  ss << "  \"name\": \"" << EscapeJson(name_) << "\",\n";
+  ss << "  \"batch_size\": " << batch_size_ << ",\n";
+  ss << "  \"num_threads\": " << num_threads_ << ",\n";
+  ss << "  \"runs\": " << runs_.size() << ",\n";
+  ss << "  \"latency\": {";
+  StatsToJson(RunStats(), ss);
+  ss << "},\n";
+
+  ss << "  \"ops\": [";
+  for (size_t i = 0; i < ops_.size(); ++i) {
+    auto &op = ops_[i];
+    int64_t runs = std::max<int64_t>(op.latency.size(), 1);
+    ss << (i ? ",\n" : "\n") << "    {\"index\": " << i << ", \"type\": \""
+       << EscapeJson(op.type) << "\", ";
+    StatsToJson(ComputeStats(op.latency), ss);
+    ss << ", \"alloc_bytes\": " << op.alloc_bytes / runs
+       << ", \"allocs\": " << op.allocs / runs << "}";
+  }
+  ss << "\n  ],\n";
+
+  ss << "  \"op_types\": [";
+  auto type_stats = OpTypeStats();
+  for (size_t i = 0; i < type_stats.size(); ++i) {
+    auto &total = totals[type_stats[i].first];
+    ss << (i ? ",\n" : "\n") << "    {\"type\": \""
+       << EscapeJson(type_stats[i].first) << "\", \"count\": " << total.count
+       << ", ";
+    StatsToJson(type_stats[i].second, ss);
+    ss << ", \"alloc_bytes\": " << total.alloc_bytes
+       << ", \"allocs\": " << total.allocs << "}";
+  }
+  ss << "\n  ],\n";
+
+  float base = RunStats().p50;
+  ss << "  \"passes\": [";
+  for (size_t i = 0; i < passes_.size(); ++i) {
+    auto stats = ComputeStats(passes_[i].second);
+    ss << (i ? ",\n" : "\n") << "    {\"pass\": \""
+       << EscapeJson(passes_[i].first) << "\", ";
+    StatsToJson(stats, ss);
+    // The latency saved by the pass, negative if the pass slows it down.
+    ss << ", \"saved\": " << stats.p50 - base << "}";
+  }
+  ss << "\n  ]\n";
+  ss << "}\n";
+  return ss.str();
+}
+
+std::string OpProfile::SerializeToCsv() const {
+  std::stringstream ss;
+  ss << "kind,index,name,count,mean,p50,p90,p99,alloc_bytes,allocs\n";
+  ss << "run,," << name_ << ',' << runs_.size() << ',';
+  StatsToCsv(RunStats(), ss);
+  ss << ",,\n";
+  for (size_t i = 0; i < ops_.size(); ++i) {
+    auto &op = ops_[i];
+    int64_t runs = std::max<int64_t>(op.latency.size(), 1);
+    ss << "op," << i << ',' << op.type << ',' << op.latency.size() << ',';
+    StatsToCsv(ComputeStats(op.latency), ss);
+    ss << ',' << op.alloc_bytes / runs << ',' << op.allocs / runs << '\n';
+  }
+  auto totals = SumOpTypes(ops_);
+  for (auto &type : OpTypeStats()) {
+    auto &total = totals[type.first];
+    ss << "op_type,," << type.first << ',' << total.count << ',';
+    StatsToCsv(type.second, ss);
+    ss << ',' << total.alloc_bytes << ',' << total.allocs << '\n';
+  }
+  for (auto &pass : passes_) {
+    ss << "pass,," << pass.first << ',' << pass.second.size() << ',';
+    StatsToCsv(ComputeStats(pass.second), ss);
+    ss << ",,\n";
+  }
+  return ss.str();
+}
+
+void OpProfile::PersistToFile(const std::string &path) const {
+  std::ofstream file(path);
+  PADDLE_ENFORCE_EQ(
+      file.is_open(),
+      true,
+      platform::errors::Unavailable("Can not open %s to write profile.", path));
+  const std::string suffix = ".json";
+  bool json = path.size() >= suffix.size() &&
+              path.compare(path.size() - suffix.size(), suffix.size(),
+                           suffix) == 0;
+  file << (json ? SerializeToJson() : SerializeToCsv());
+  file.close();
+}
+
+bool OpProfile::Compare(const OpProfile &base,
+                        const OpProfile &other,
+                        float tolerance,
+                        std::string *report) {
+  auto base_run = base.RunStats();
+  auto other_run = other.RunStats();
+  bool pass = other_run.p50 <= base_run.p50 * (1.f + tolerance);
+  if (report == nullptr) {
+    return pass;
+  }
+
+  std::stringstream ss;
+  ss << std::fixed << std::setprecision(4);
+  ss << "-----------------------------------------------------\n";
+  ss << "compare " << other.name() << " against " << base.name() << '\n';
+  ss << "name\tbase_p50\tother_p50\tratio\n";
+  auto ratio = [](float b, float o) { return b > 0.f ? o / b : 0.f; };
+  ss << "run\t" << base_run.p50 << '\t' << other_run.p50 << '\t'
+     << ratio(base_run.p50, other_run.p50) << '\n';
+
+  auto base_types = base.OpTypeStats();
+  auto other_types = other.OpTypeStats();
+  std::unordered_map<std::string, float> other_p50;
+  for (auto &type : other_types) {
+    other_p50[type.first] = type.second.p50;
+  }
+  for (auto &type : base_types) {
+    auto it = other_p50.find(type.first);
+    float o = it == other_p50.end() ? 0.f : it->second;
+    ss << type.first << '\t' << type.second.p50 << '\t' << o << '\t'
+       << ratio(type.second.p50, o) << '\n';
+    if (it != other_p50.end()) other_p50.erase(it);
+  }
+  // The operator types only in other, e.g. created by a fusion pass.
+  for (auto &type : other_types) {
+    if (other_p50.count(type.first)) {
+      ss << type.first << '\t' << 0.f << '\t' << type.second.p50 << "\t-\n";
+    }
+  }
+  ss << (pass ? "PASS" : "REGRESSION") << ": tolerance " << tolerance << '\n';
+  *report = ss.str();
+  return pass;
+}
+
+float OpProfile::Percentile(std::vector<float> samples, float p) {
+  if (samples.empty()) {
+    return 0.f;
+  }
+  std::sort(samples.begin(), samples.end());
+  float rank = std::min(100.f, std::max(0.f, p)) / 100.f * (samples.size() - 1);
+  size_t lo = static_cast<size_t>(std::floor(rank));
+  size_t hi = std::min(lo + 1, samples.size() - 1);
+  float frac = rank - lo;
+  return samples[lo] + (samples[hi] - samples[lo]) * frac;
+}
+
+OpProfile::LatencyStats OpProfile::ComputeStats(
+    const std::vector<float> &samples) {
+  LatencyStats stats;
+  if (samples.empty()) {
+    return stats;
+  }
+  stats.mean = std::accumulate(samples.begin(), samples.end(), 0.f) /
+               samples.size();
+  stats.p50 = Percentile(samples, 50.f);
+  stats.p90 = Percentile(samples, 90.f);
+  stats.p99 = Percentile(samples, 99.f);
+  return stats;
+}
+
 }  // namespace inference
 }  // namespace paddle
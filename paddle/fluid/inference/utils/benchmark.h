@@ -16,6 +16,8 @@
 #include <fstream>
 #include <iostream>
 #include <string>
+#include <utility>
+#include <vector>
 
 namespace paddle {
 namespace inference {
@@ -50,5 +52,92 @@ struct Benchmark {
   std::string name_;
 };
 
+/*
+ * Per operator latency and memory profile of a program, collected over many
+ * runs, with the effect of the IR passes on the latency of a whole run.
+ *
+ * The latencies are in milliseconds. The memory of an operator is the change
+ * of the allocated bytes in memory/stats.h across its run, which is negative
+ * for the operators freeing more than they allocate, and the number of
+ * allocations made in its run, averaged over the runs.
+ */
+class OpProfile {
+ public:
+  struct LatencyStats {
+    float mean{0.f};
+    float p50{0.f};
+    float p90{0.f};
+    float p99{0.f};
+  };
+
+  struct OpRecord {
+    std::string type;
+    std::vector<float> latency;
+    int64_t alloc_bytes{0};
+    int64_t allocs{0};
+  };
+
+  const std::string& name() const { return name_; }
+  void SetName(const std::string& name) { name_ = name; }
+
+  int batch_size() const { return batch_size_; }
+  void SetBatchSize(int x) { batch_size_ = x; }
+
+  int num_threads() const { return num_threads_; }
+  void SetNumThreads(int x) { num_threads_ = x; }
+
+  // Record a run of the idx-th operator of the program. The operators are
+  // expected to be recorded once per run, as RecordRun is.
+  void RecordOp(size_t idx,
+                const std::string& type,
+                float latency,
+                int64_t alloc_bytes,
+                int64_t allocs);
+  // Record the latency of a whole run.
+  void RecordRun(float latency);
+  // Record the latencies of the whole runs with the pass disabled.
+  void RecordPassEffect(const std::string& pass,
+                        const std::vector<float>& latency);
+
+  const std::vector<OpRecord>& ops() const { return ops_; }
+  const std::vector<float>& runs() const { return runs_; }
+
+  LatencyStats RunStats() const { return ComputeStats(runs_); }
+  LatencyStats OpStats(size_t idx) const;
+  // The latency of all the operators of a type in a run, in the order the
+  // types first appear in the program.
+  std::vector<std::pair<std::string, LatencyStats>> OpTypeStats() const;
+
+  std::string SerializeToJson() const;
+  // One row per run, operator, operator type and pass, tagged by the kind
+  // column.
+  std::string SerializeToCsv() const;
+  // Write the profile to path, in JSON if the path ends with ".json" and in
+  // CSV otherwise.
+  void PersistToFile(const std::string& path) const;
+
+  // Compare the latency of other against base, in total and per operator
+  // type. Return whether the median latency of a run of other is within
+  // (1 + tolerance) times that of base, and write a readable report to
+  // report if it is not null.
+  static bool Compare(const OpProfile& base,
+                      const OpProfile& other,
+                      float tolerance,
+                      std::string* report);
+
+  // The p-th percentile, p in [0, 100], of the samples with linear
+  // interpolation between the closest ranks.
+  static float Percentile(std::vector<float> samples, float p);
+  static LatencyStats ComputeStats(const std::vector<float>& samples);
+
+ private:
+  std::string name_;
+  int batch_size_{0};
+  int num_threads_{1};
+  std::vector<OpRecord> ops_;
+  std::vector<float> runs_;
+  std::vector<std::pair<std::string, std::vector<float>>> passes_;
+};
+
 }  // namespace inference
 }  // namespace paddle
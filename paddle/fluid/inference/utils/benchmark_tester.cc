@@ -38,3 +38,54 @@ TEST(Benchmark, PersistToFile) {
   benchmark.PersistToFile("2.log");
   benchmark.PersistToFile("3.log");
 }
+
+TEST(OpProfile, percentile) {
+  std::vector<float> samples = {4.f, 1.f, 3.f, 2.f};
+  EXPECT_FLOAT_EQ(OpProfile::Percentile(samples, 0.f), 1.f);
+  EXPECT_FLOAT_EQ(OpProfile::Percentile(samples, 50.f), 2.5f);
+  EXPECT_FLOAT_EQ(OpProfile::Percentile(samples, 100.f), 4.f);
+  EXPECT_FLOAT_EQ(OpProfile::Percentile({}, 50.f), 0.f);
+}
+
+TEST(OpProfile, op_types) {
+  OpProfile profile;
+  profile.SetName("model");
+  for (int i = 0; i < 10; ++i) {
+    profile.RecordOp(0, "fc", 1.f, 1024, 2);
+    profile.RecordOp(1, "relu", 0.5f, 0, 0);
+    profile.RecordOp(2, "fc", 2.f, 512, 1);
+    profile.RecordRun(3.5f);
+  }
+  auto types = profile.OpTypeStats();
+  ASSERT_EQ(types.size(), 2UL);
+  EXPECT_EQ(types[0].first, "fc");
+  EXPECT_FLOAT_EQ(types[0].second.p50, 3.f);
+  EXPECT_EQ(types[1].first, "relu");
+  EXPECT_FLOAT_EQ(profile.RunStats().p99, 3.5f);
+
+  std::string json = profile.SerializeToJson();
+  EXPECT_NE(json.find("\"alloc_bytes\": 1536"), std::string::npos);
+  std::string csv = profile.SerializeToCsv();
+  EXPECT_NE(csv.find("op,0,fc,10,"), std::string::npos);
+  LOG(INFO) << "profile:\n" << json << csv;
+
+  profile.PersistToFile("op_profile.json");
+  profile.PersistToFile("op_profile.csv");
+}
+
+TEST(OpProfile, compare) {
+  OpProfile base, other;
+  base.SetName("base");
+  other.SetName("other");
+  for (int i = 0; i < 10; ++i) {
+    base.RecordOp(0, "conv2d", 10.f, 0, 0);
+    base.RecordRun(10.f);
+    other.RecordOp(0, "conv2d", 12.f, 0, 0);
+    other.RecordRun(12.f);
+  }
+  std::string report;
+  EXPECT_FALSE(OpProfile::Compare(base, other, 0.1f, &report));
+  LOG(INFO) << report;
+  EXPECT_TRUE(OpProfile::Compare(base, other, 0.3f, nullptr));
+  EXPECT_TRUE(OpProfile::Compare(other, base, 0.f, nullptr));
+}
@@ -0,0 +1,300 @@
+// Copyright (c) 2022 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "paddle/fluid/inference/utils/mmap_params_loader.h"
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <functional>
+#include <numeric>
+
+#include "paddle/fluid/framework/convert_utils.h"
+#include "paddle/fluid/framework/data_type.h"
+#include "paddle/fluid/framework/framework.pb.h"
+#include "paddle/fluid/framework/lod_tensor.h"
+#include "paddle/fluid/framework/version.h"
+#include "paddle/fluid/platform/enforce.h"
+#include "paddle/phi/core/allocator.h"
+
+namespace paddle {
+namespace inference {
+
+namespace {
+
+// An allocation that points into a mapped parameters file and keeps the
+// mapping alive for as long as any tensor references it.
+class MappedParamAllocation : public phi::Allocation {
+ public:
+  MappedParamAllocation(std::shared_ptr<MappedParamsFile> file,
+                        size_t offset,
+                        size_t size)
+      : phi::Allocation(const_cast<char*>(file->data()) + offset,
+                        size,
+                        platform::CPUPlace()),
+        file_(std::move(file)) {}
+
+ private:
+  std::shared_ptr<MappedParamsFile> file_;
+};
+
+// Sequential reader over the mapped bytes, with bounds checking.
+class MappedReader {
+ public:
+  explicit MappedReader(const MappedParamsFile& file)
+      : data_(file.data()), size_(file.size()), path_(file.path()) {}
+
+  template <typename T>
+  T Read() {
+    T value;
+    std::memcpy(&value, Skip(sizeof(T)), sizeof(T));
+    return value;
+  }
+
+  const char* Skip(size_t n) {
+    PADDLE_ENFORCE_LE(
+        offset_ + n,
+        size_,
+        platform::errors::InvalidArgument(
+            "Unexpected end of the parameters file %s, please check whether "
+            "the model file is complete or damaged.",
+            path_));
+    const char* p = data_ + offset_;
+    offset_ += n;
+    return p;
+  }
+
+  size_t offset() const { return offset_; }
+  bool eof() const { return offset_ == size_; }
+
+ private:
+  const char* data_;
+  size_t size_;
+  const std::string& path_;
+  size_t offset_{0};
+};
+
+bool IsPersistable(const framework::VarDesc* var) {
+  return var->Persistable() &&
+         var->GetType() != framework::proto::VarType::FEED_MINIBATCH &&
+         var->GetType() != framework::proto::VarType::FETCH_LIST &&
+         var->GetType() != framework::proto::VarType::RAW;
+}
+
+// Parse one LoDTensor in the layout written by `SerializeToStream`. Returns
+// true if the tensor aliases the mapped file.
+bool ReadLoDTensor(const std::shared_ptr<MappedParamsFile>& file,
+                   MappedReader* reader,
+                   framework::LoDTensor* tensor) {
+  uint32_t version = reader->Read<uint32_t>();
+  PADDLE_ENFORCE_EQ(framework::IsTensorVersionSupported(version),
+                    true,
+                    platform::errors::InvalidArgument(
+                        "Tensor version %u is not supported.", version));
+  PADDLE_ENFORCE_EQ(
+      version,
+      0U,
+      platform::errors::InvalidArgument(
+          "Deserialize to tensor failed, maybe the loaded file is "
+          "not a paddle model(expected file format: 0, but %u found).",
+          version));
+
+  uint64_t lod_level = reader->Read<uint64_t>();
+  framework::LoD lod(lod_level);
+  for (uint64_t i = 0; i < lod_level; ++i) {
+    uint64_t size = reader->Read<uint64_t>();
+    lod[i].resize(size / sizeof(size_t));
+    std::memcpy(lod[i].data(), reader->Skip(size), size);
+  }
+
+  version = reader->Read<uint32_t>();
+  PADDLE_ENFORCE_EQ(
+      version,
+      0U,
+      platform::errors::InvalidArgument(
+          "tensor version %u is not supported, Only version 0 is supported",
+          version));
+
+  framework::proto::VarType::TensorDesc desc;
+  int32_t desc_size = reader->Read<int32_t>();
+  PADDLE_ENFORCE_GE(
+      desc_size,
+      0,
+      platform::errors::InvalidArgument("Tensor desc size should >= 0"));
+  PADDLE_ENFORCE_EQ(
+      desc.ParseFromArray(reader->Skip(desc_size), desc_size),
+      true,
+      platform::errors::InvalidArgument("Cannot parse tensor desc"));
+
+  std::vector<int64_t> dims(desc.dims().begin(), desc.dims().end());
+  auto dtype = framework::TransToPhiDataType(desc.data_type());
+  size_t type_size = framework::SizeOfType(desc.data_type());
+  size_t offset = reader->offset();
+  size_t numel = std::accumulate(
+      dims.begin(), dims.end(), size_t(1), std::multiplies<size_t>());
+  size_t bytes = numel * type_size;
+  const char* src = reader->Skip(bytes);
+
+  // Aliasing a misaligned buffer would break the alignment assumptions of
+  // the kernels, so only suitably aligned tensors share the mapped pages.
+  bool aliased =
+      bytes > 0 && reinterpret_cast<uintptr_t>(src) % type_size == 0;
+  if (aliased) {
+    phi::DenseTensorMeta meta(dtype, phi::make_ddim(dims));
+    *tensor = framework::LoDTensor(
+        std::make_shared<MappedParamAllocation>(file, offset, bytes), meta);
+  } else {
+    tensor->Resize(phi::make_ddim(dims));
+    void* dst = tensor->mutable_data(platform::CPUPlace(), dtype);
+    if (bytes > 0) std::memcpy(dst, src, bytes);
+  }
+  tensor->set_lod(lod);
+  return aliased;
+}
+
+}  // namespace
+
+#ifndef _WIN32
+
+MappedParamsFile::MappedParamsFile(const std::string& path, bool lazy_load)
+    : path_(path) {
+  int fd = open(path.c_str(), O_RDONLY);
+  PADDLE_ENFORCE_NE(fd,
+                    -1,
+                    platform::errors::Unavailable(
+                        "Fail to open the parameters file %s, please check "
+                        "whether the model file is complete or damaged.",
+                        path));
+  struct stat file_stat;
+  if (fstat(fd, &file_stat) == -1) {
+    close(fd);
+    PADDLE_THROW(platform::errors::Unavailable(
+        "Fail to stat the parameters file %s.", path));
+  }
+  size_ = static_cast<size_t>(file_stat.st_size);
+  if (size_ == 0) {
+    close(fd);
+    return;
+  }
+
+  int flags = MAP_PRIVATE;
+#ifdef MAP_POPULATE
+  if (!lazy_load) flags |= MAP_POPULATE;
+#endif
+  void* ptr = mmap(nullptr, size_, PROT_READ | PROT_WRITE, flags, fd, 0);
+  // The mapping keeps its own reference to the file.
+  close(fd);
+  PADDLE_ENFORCE_NE(ptr,
+                    MAP_FAILED,
+                    platform::errors::Unavailable(
+                        "Fail to memory map the parameters file %s, errno is "
+                        "%d.",
+                        path,
+                        errno));
+  data_ = static_cast<char*>(ptr);
+  if (lazy_load) {
+    // Weights are usually read in program order, let the kernel read ahead.
+    madvise(data_, size_, MADV_SEQUENTIAL);
+  }
+}
+
+MappedParamsFile::~MappedParamsFile() {
+  if (data_ != nullptr) {
+    munmap(data_, size_);
+  }
+}
+
+bool MmapParamsSupported() { return true; }
+
+#else
+
+MappedParamsFile::MappedParamsFile(const std::string& path, bool lazy_load)
+    : path_(path) {
+  PADDLE_THROW(platform::errors::Unimplemented(
+      "Can not memory map the parameters file %s (lazy_load = %d), memory "
+      "mapped parameters are not supported on Windows.",
+      path,
+      lazy_load));
+}
+
+MappedParamsFile::~MappedParamsFile() {}
+
+bool MmapParamsSupported() { return false; }
+
+#endif
+
+std::shared_ptr<MappedParamsFile> MappedParamsFile::Open(
+    const std::string& path, bool lazy_load) {
+  return std::shared_ptr<MappedParamsFile>(
+      new MappedParamsFile(path, lazy_load));
+}
+
+size_t LoadCombinedParamsFromMmap(const std::string& param_filename,
+                                  const std::vector<std::string>& var_names,
+                                  framework::Scope* scope,
+                                  bool lazy_load) {
+  PADDLE_ENFORCE_NOT_NULL(
+      scope,
+      platform::errors::InvalidArgument("The scope should not be nullptr."));
+  auto file = MappedParamsFile::Open(param_filename, lazy_load);
+  MappedReader reader(*file);
+  size_t num_aliased = 0;
+  for (auto& name : var_names) {
+    auto* tensor = scope->Var(name)->GetMutable<framework::LoDTensor>();
+    if (ReadLoDTensor(file, &reader, tensor)) {
+      ++num_aliased;
+    }
+  }
+  PADDLE_ENFORCE_EQ(
+      reader.eof(),
+      true,
+      platform::errors::InvalidArgument(
+          "You are not allowed to load partial data via memory mapped "
+          "parameters, please load all the variables of %s.",
+          param_filename));
+  VLOG(3) << "Mapped " << var_names.size() << " parameters from "
+          << param_filename << ", " << num_aliased
+          << " of them share the mapped pages.";
+  return num_aliased;
+}
+
+bool LoadPersistablesFromMmap(const framework::ProgramDesc& main_program,
+                              const std::string& param_filename,
+                              framework::Scope* scope,
+                              bool lazy_load) {
+  std::vector<std::string> params;
+  for (auto* var : main_program.Block(0).AllVars()) {
+    if (!IsPersistable(var)) continue;
+    if (var->GetType() != framework::proto::VarType::LOD_TENSOR) {
+      VLOG(3) << "Persistable variable " << var->Name()
+              << " is not a LoDTensor, can not memory map the parameters.";
+      return false;
+    }
+    params.push_back(var->Name());
+  }
+  // Same ordering as the load_combine op.
+  std::sort(params.begin(), params.end());
+  LoadCombinedParamsFromMmap(param_filename, params, scope, lazy_load);
+  return true;
+}
+
+}  // namespace inference
+}  // namespace paddle
@@ -0,0 +1,98 @@
+// Copyright (c) 2022 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "paddle/fluid/framework/program_desc.h"
+#include "paddle/fluid/framework/scope.h"
+
+namespace paddle {
+namespace inference {
+
+///
+/// \brief A combined parameters file (e.g. `.pdiparams`) mapped into the
+/// address space of the process.
+///
+/// The file is mapped with MAP_PRIVATE, so the pages are backed by the page
+/// cache and shared by every process serving the same model, while a pass
+/// that rewrites a weight in place (e.g. conv-bn folding) only gets a private
+/// copy of the pages it touches. Every predictor maps the file on its own, so
+/// such a rewrite never leaks into another predictor of the same model.
+///
+class MappedParamsFile {
+ public:
+  ///
+  /// \brief Map the file at `path`.
+  ///
+  /// \param path The combined parameters file.
+  /// \param lazy_load If false, all pages are faulted in while mapping;
+  /// otherwise pages are read on first access.
+  ///
+  static std::shared_ptr<MappedParamsFile> Open(const std::string& path,
+                                                bool lazy_load);
+
+  ~MappedParamsFile();
+
+  const char* data() const { return data_; }
+  size_t size() const { return size_; }
+  const std::string& path() const { return path_; }
+
+ private:
+  MappedParamsFile(const std::string& path, bool lazy_load);
+
+  std::string path_;
+  char* data_{nullptr};
+  size_t size_{0};
+};
+
+///
+/// \brief Whether the parameters of this platform can be memory mapped.
+///
+bool MmapParamsSupported();
+
+///
+/// \brief Load the persistable variables of `main_program` from the combined
+/// parameters file `param_filename` into `scope` without deserializing them.
+///
+/// The variables are read in the same (sorted) order as the `load_combine`
+/// op. A tensor whose data is suitably aligned inside the file aliases the
+/// mapped pages directly; otherwise it is copied out of the mapping.
+///
+/// \return false if the program holds persistable variables that are not
+/// LoDTensors, in which case nothing is loaded and the caller should fall back
+/// to `load_combine`.
+///
+bool LoadPersistablesFromMmap(const framework::ProgramDesc& main_program,
+                              const std::string& param_filename,
+                              framework::Scope* scope,
+                              bool lazy_load);
+
+///
+/// \brief Load the variables `var_names` from the combined parameters file
+/// `param_filename` into `scope`, in the order given.
+///
+/// \return The number of tensors that alias the mapped file.
+///
+size_t LoadCombinedParamsFromMmap(const std::string& param_filename,
+                                  const std::vector<std::string>& var_names,
+                                  framework::Scope* scope,
+                                  bool lazy_load);
+
+}  // namespace inference
+}  // namespace paddle
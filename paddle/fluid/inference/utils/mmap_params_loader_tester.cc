@@ -0,0 +1,134 @@
+// Copyright (c) 2022 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "paddle/fluid/inference/utils/mmap_params_loader.h"
+
+#include <glog/logging.h>
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include "paddle/fluid/framework/lod_tensor.h"
+
+namespace paddle {
+namespace inference {
+namespace {
+
+const char kParamsFile[] = "mmap_params_loader_tester.pdiparams";
+
+// Write `num` float parameters named param_0 ... param_{num-1} in the
+// layout of the save_combine op.
+std::vector<std::string> WriteCombinedParams(int num, int64_t numel) {
+  std::vector<std::string> names;
+  std::ofstream fout(kParamsFile, std::ios::binary);
+  for (int i = 0; i < num; ++i) {
+    names.push_back("param_" + std::to_string(i));
+  }
+  std::sort(names.begin(), names.end());
+  for (size_t i = 0; i < names.size(); ++i) {
+    framework::LoDTensor tensor;
+    float* data =
+        tensor.mutable_data<float>(phi::make_ddim({numel}), phi::CPUPlace());
+    for (int64_t j = 0; j < numel; ++j) {
+      data[j] = static_cast<float>(i) + static_cast<float>(j) * 0.5f;
+    }
+    framework::SerializeToStream(fout, tensor);
+  }
+  return names;
+}
+
+void LoadByStream(const std::vector<std::string>& names,
+                  framework::Scope* scope) {
+  std::ifstream fin(kParamsFile, std::ios::binary);
+  for (auto& name : names) {
+    framework::DeserializeFromStream(
+        fin, scope->Var(name)->GetMutable<framework::LoDTensor>());
+  }
+}
+
+double ElapsedMs(std::chrono::high_resolution_clock::time_point start) {
+  return std::chrono::duration<double, std::milli>(
+             std::chrono::high_resolution_clock::now() - start)
+      .count();
+}
+
+}  // namespace
+
+TEST(MmapParamsLoader, same_as_stream_loader) {
+  if (!MmapParamsSupported()) return;
+  auto names = WriteCombinedParams(16, 1000);
+
+  framework::Scope stream_scope;
+  LoadByStream(names, &stream_scope);
+  framework::Scope mmap_scope;
+  LoadCombinedParamsFromMmap(kParamsFile, names, &mmap_scope, true);
+
+  for (auto& name : names) {
+    auto& expected = stream_scope.FindVar(name)->Get<framework::LoDTensor>();
+    auto& actual = mmap_scope.FindVar(name)->Get<framework::LoDTensor>();
+    ASSERT_EQ(expected.dims(), actual.dims());
+    ASSERT_EQ(expected.dtype(), actual.dtype());
+    ASSERT_EQ(0,
+              std::memcmp(expected.data<float>(),
+                          actual.data<float>(),
+                          expected.numel() * sizeof(float)));
+  }
+  std::remove(kParamsFile);
+}
+
+TEST(MmapParamsLoader, partial_load) {
+  if (!MmapParamsSupported()) return;
+  auto names = WriteCombinedParams(4, 10);
+  names.pop_back();
+  framework::Scope scope;
+  ASSERT_ANY_THROW(
+      LoadCombinedParamsFromMmap(kParamsFile, names, &scope, false));
+  std::remove(kParamsFile);
+}
+
+// Compare the startup cost of both loaders on a synthetic 4MB model, small
+// enough for the unit tests. Raise numel to measure a real model.
+TEST(MmapParamsLoader, benchmark) {
+  if (!MmapParamsSupported()) return;
+  auto names = WriteCombinedParams(64, 1 << 14);
+
+  auto start = std::chrono::high_resolution_clock::now();
+  {
+    framework::Scope scope;
+    LoadByStream(names, &scope);
+  }
+  double stream_ms = ElapsedMs(start);
+
+  start = std::chrono::high_resolution_clock::now();
+  size_t num_aliased = 0;
+  {
+    framework::Scope scope;
+    num_aliased = LoadCombinedParamsFromMmap(kParamsFile, names, &scope, true);
+  }
+  double mmap_ms = ElapsedMs(start);
+
+  LOG(INFO) << "load " << names.size() << " params, stream: " << stream_ms
+            << "ms, mmap: " << mmap_ms << "ms, " << num_aliased
+            << " params share the mapped pages.";
+  std::remove(kParamsFile);
+}
+
+}  // namespace inference
+}  // namespace paddle
@@ -0,0 +1,225 @@
+// Copyright (c) 2022 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "paddle/fluid/inference/utils/model_profiler.h"
+
+#include <memory>
+#include <random>
+#include <sstream>
+#include <unordered_map>
+
+#include "paddle/fluid/framework/data_type.h"
+#include "paddle/fluid/inference/api/analysis_predictor.h"
+#include "paddle/fluid/inference/api/helper.h"
+#include "paddle/fluid/memory/stats.h"
+#include "paddle/fluid/platform/enforce.h"
+
+namespace paddle {
+namespace inference {
+
+namespace {
+
+class MemoryStatReader {
+ public:
+  explicit MemoryStatReader(const AnalysisConfig &config)
+      : use_gpu_(config.use_gpu()), dev_id_(config.gpu_device_id()) {}
+
+  int64_t Read(const std::string &stat_type) const {
+    return use_gpu_ ? memory::DeviceMemoryStatCurrentValue(stat_type, dev_id_)
+                    : memory::HostMemoryStatCurrentValue(stat_type, 0);
+  }
+
+ private:
+  bool use_gpu_;
+  int dev_id_;
+};
+
+template <typename T, typename Dist>
+void FillInput(ZeroCopyTensor *tensor,
+               int64_t numel,
+               Dist dist,
+               std::mt19937 *rng) {
+  std::vector<T> data(numel);
+  for (auto &v : data) {
+    v = static_cast<T>(dist(*rng));
+  }
+  tensor->copy_from_cpu(data.data());
+}
+
+void FeedRandomInputs(AnalysisPredictor *predictor,
+                      const ModelProfileOptions &options,
+                      std::mt19937 *rng) {
+  auto saved_shapes = predictor->GetInputTensorShape();
+  for (auto &name : predictor->GetInputNames()) {
+    std::vector<int> shape;
+    auto it = options.input_shapes.find(name);
+    if (it != options.input_shapes.end()) {
+      shape = it->second;
+    } else {
+      auto &saved = saved_shapes[name];
+      for (size_t i = 0; i < saved.size(); ++i) {
+        int dim = static_cast<int>(saved[i]);
+        shape.push_back(dim > 0 ? dim : (i == 0 ? options.batch_size : 1));
+      }
+    }
+    int64_t numel = 1;
+    for (int dim : shape) {
+      numel *= dim;
+    }
+
+    auto *var = predictor->program().Block(0).FindVar(name);
+    PADDLE_ENFORCE_NOT_NULL(
+        var,
+        platform::errors::NotFound("The input %s is not in the program.",
+                                   name));
+    auto tensor = predictor->GetInputTensor(name);
+    tensor->Reshape(shape);
+    auto dtype = var->GetDataType();
+    switch (dtype) {
+      case framework::proto::VarType::FP32:
+        FillInput<float>(tensor.get(),
+                         numel,
+                         std::uniform_real_distribution<float>(0.f, 1.f),
+                         rng);
+        break;
+      case framework::proto::VarType::INT64:
+        FillInput<int64_t>(tensor.get(),
+                           numel,
+                           std::uniform_int_distribution<int64_t>(
+                               0, options.int_input_max - 1),
+                           rng);
+        break;
+      case framework::proto::VarType::INT32:
+        FillInput<int32_t>(tensor.get(),
+                           numel,
+                           std::uniform_int_distribution<int64_t>(
+                               0, options.int_input_max - 1),
+                           rng);
+        break;
+      default:
+        PADDLE_THROW(platform::errors::Unimplemented(
+            "The input %s of type %s can not be generated, only float32, "
+            "int64 and int32 inputs are supported.",
+            name,
+            framework::DataTypeToString(dtype)));
+    }
+  }
+}
+
+std::unique_ptr<PaddlePredictor> CreateProfiledPredictor(
+    AnalysisConfig config,
+    const ModelProfileOptions &options,
+    std::mt19937 *rng) {
+  config.SwitchUseFeedFetchOps(false);
+  auto predictor = CreatePaddlePredictor<AnalysisConfig>(config);
+  auto *analysis_predictor = static_cast<AnalysisPredictor *>(predictor.get());
+  FeedRandomInputs(analysis_predictor, options, rng);
+  for (int i = 0; i < options.warmup; ++i) {
+    analysis_predictor->ZeroCopyRun();
+  }
+  return predictor;
+}
+
+std::vector<float> TimeRuns(PaddlePredictor *predictor, int repeat) {
+  std::vector<float> latency;
+  Timer timer;
+  for (int i = 0; i < repeat; ++i) {
+    timer.tic();
+    predictor->ZeroCopyRun();
+    latency.push_back(timer.toc());
+  }
+  return latency;
+}
+
+}  // namespace
+
+OpProfile ProfileModel(const AnalysisConfig &config,
+                       const ModelProfileOptions &options) {
+  std::mt19937 rng(options.seed);
+  OpProfile profile;
+  profile.SetName(config.model_dir().empty() ? config.prog_file()
+                                             : config.model_dir());
+  profile.SetBatchSize(options.batch_size);
+  profile.SetNumThreads(config.cpu_math_library_num_threads());
+
+  auto predictor = CreateProfiledPredictor(config, options, &rng);
+  auto *analysis_predictor = static_cast<AnalysisPredictor *>(predictor.get());
+  // The runs are first timed as a whole without the hooks, whose reading of
+  // the memory stats would add to the latency.
+  for (float latency : TimeRuns(predictor.get(), options.repeat)) {
+    profile.RecordRun(latency);
+  }
+
+  MemoryStatReader stats(config);
+  std::unordered_map<const framework::OperatorBase *, size_t> op_index;
+  Timer timer;
+  int64_t bytes = 0;
+  int64_t allocs = 0;
+  analysis_predictor->RegisterOpHooks(
+      [&](framework::OperatorBase *) {
+        bytes = stats.Read("Allocated");
+        allocs = stats.Read("Allocations");
+        timer.tic();
+      },
+      [&](framework::OperatorBase *op) {
+        float latency = timer.toc();
+        size_t idx = op_index.emplace(op, op_index.size()).first->second;
+        profile.RecordOp(idx,
+                         op->Type(),
+                         latency,
+                         stats.Read("Allocated") - bytes,
+                         stats.Read("Allocations") - allocs);
+      });
+  TimeRuns(predictor.get(), options.repeat);
+  analysis_predictor->ClearOpHooks();
+
+  if (options.profile_passes && config.ir_optim()) {
+    for (auto &pass : config.pass_builder()->AllPasses()) {
+      AnalysisConfig pass_config(config);
+      pass_config.pass_builder()->DeletePass(pass);
+      auto pass_predictor = CreateProfiledPredictor(pass_config, options, &rng);
+      profile.RecordPassEffect(pass,
+                               TimeRuns(pass_predictor.get(), options.repeat));
+      VLOG(3) << "Profiled the model without " << pass;
+    }
+  }
+  return profile;
+}
+
+std::map<std::string, std::vector<int>> ParseInputShapes(
+    const std::string &str) {
+  std::map<std::string, std::vector<int>> shapes;
+  std::stringstream ss(str);
+  std::string item;
+  while (std::getline(ss, item, ';')) {
+    if (item.empty()) continue;
+    auto pos = item.rfind(':');
+    PADDLE_ENFORCE_NE(
+        pos,
+        std::string::npos,
+        platform::errors::InvalidArgument(
+            "The input shape %s should be like name:1,3,224,224.", item));
+    std::vector<int> shape;
+    std::stringstream dims(item.substr(pos + 1));
+    std::string dim;
+    while (std::getline(dims, dim, ',')) {
+      shape.push_back(std::stoi(dim));
+    }
+    shapes[item.substr(0, pos)] = shape;
+  }
+  return shapes;
+}
+
+}  // namespace inference
+}  // namespace paddle
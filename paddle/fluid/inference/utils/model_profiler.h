@@ -0,0 +1,55 @@
+// Copyright (c) 2022 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <map>
+#include <string>
+#include <vector>
+
+#include "paddle/fluid/inference/api/paddle_analysis_config.h"
+#include "paddle/fluid/inference/utils/benchmark.h"
+
+namespace paddle {
+namespace inference {
+
+struct ModelProfileOptions {
+  int batch_size{1};
+  int warmup{10};
+  int repeat{100};
+  // The shapes of the inputs, overriding those saved in the model. The
+  // unknown dimensions left are set to batch_size for the first one and to 1
+  // for the others.
+  std::map<std::string, std::vector<int>> input_shapes;
+  // The integer inputs are drawn from [0, int_input_max).
+  int64_t int_input_max{1};
+  unsigned int seed{0};
+  // Whether to run the model once more with each IR pass disabled.
+  bool profile_passes{false};
+};
+
+// Run the model of config on random inputs and collect the latency of every
+// run and of every operator, with the memory it allocates.
+//
+// The operators are timed on the host, so the latencies of the operators
+// running asynchronously on a device only cover their launches.
+OpProfile ProfileModel(const AnalysisConfig& config,
+                       const ModelProfileOptions& options);
+
+// Parse shapes like "x:1,3,224,224;y:1,128".
+std::map<std::string, std::vector<int>> ParseInputShapes(
+    const std::string& str);
+
+}  // namespace inference
+}  // namespace paddle
@@ -0,0 +1,155 @@
+// Copyright (c) 2022 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Profile a saved inference model on random inputs, e.g.
+//
+//   model_profiler_main --model_dir=./mobilenet --batch_size=1 --repeat=200 \
+//       --output=mobilenet.json --compare_ir_optim --tolerance=0.05
+//
+// The latency of the runs and of every operator is written to --output, in
+// JSON or CSV by its suffix. With a compare flag, the model is profiled once
+// more with the other config, and the tool exits with 1 if the latency of the
+// first config regresses against the second one by more than --tolerance.
+
+#include <iostream>
+#include <sstream>
+
+#include "gflags/gflags.h"
+#include "glog/logging.h"
+#include "paddle/fluid/inference/utils/model_profiler.h"
+
+DEFINE_string(model_dir, "", "Directory of the inference model.");
+DEFINE_string(prog_file, "", "Path of the program, used with params_file.");
+DEFINE_string(params_file, "", "Path of the combined parameters.");
+DEFINE_int32(batch_size, 1, "The batch size of the generated inputs.");
+DEFINE_string(input_shapes,
+              "",
+              "The shapes of the inputs, like x:1,3,224,224;y:1,128. The "
+              "shapes saved in the model are used by default.");
+DEFINE_int64(int_input_max, 1, "The integer inputs are in [0, max).");
+DEFINE_int32(warmup, 10, "The number of runs before profiling.");
+DEFINE_int32(repeat, 100, "The number of profiled runs.");
+DEFINE_int32(num_threads, 1, "The number of CPU math library threads.");
+DEFINE_bool(use_gpu, false, "Whether to run the model on GPU.");
+DEFINE_bool(ir_optim, true, "Whether to optimize the program.");
+DEFINE_bool(use_mkldnn, false, "Whether to use MKLDNN.");
+DEFINE_bool(profile_passes,
+            false,
+            "Whether to profile the model with each IR pass disabled.");
+DEFINE_string(output,
+              "",
+              "The file to write the profile to, JSON if it ends with .json "
+              "and CSV otherwise. Print the JSON if it is empty.");
+DEFINE_bool(compare_ir_optim,
+            false,
+            "Compare against the model run without the IR optimization.");
+DEFINE_string(compare_delete_passes,
+              "",
+              "Compare against the model optimized without these passes, "
+              "separated by commas.");
+DEFINE_int32(compare_num_threads,
+             0,
+             "Compare against the model run with this number of threads.");
+DEFINE_string(compare_output, "", "The file to write the other profile to.");
+DEFINE_double(tolerance,
+              0.05,
+              "The relative increase of the median latency allowed against "
+              "the compared config.");
+
+namespace paddle {
+namespace inference {
+
+AnalysisConfig MakeConfig() {
+  AnalysisConfig config;
+  if (!FLAGS_model_dir.empty()) {
+    config.SetModel(FLAGS_model_dir);
+  } else {
+    config.SetModel(FLAGS_prog_file, FLAGS_params_file);
+  }
+  if (FLAGS_use_gpu) {
+    config.EnableUseGpu(100, 0);
+  } else {
+    config.DisableGpu();
+  }
+  config.SwitchIrOptim(FLAGS_ir_optim);
+  config.SetCpuMathLibraryNumThreads(FLAGS_num_threads);
+  if (FLAGS_use_mkldnn) {
+    config.EnableMKLDNN();
+  }
+  return config;
+}
+
+// Turn the copy of the profiled config into the compared one.
+bool MakeCompareConfig(AnalysisConfig* config) {
+  bool compare = false;
+  if (FLAGS_compare_ir_optim) {
+    config->SwitchIrOptim(false);
+    compare = true;
+  }
+  if (!FLAGS_compare_delete_passes.empty()) {
+    std::stringstream ss(FLAGS_compare_delete_passes);
+    std::string pass;
+    while (std::getline(ss, pass, ',')) {
+      config->pass_builder()->DeletePass(pass);
+    }
+    compare = true;
+  }
+  if (FLAGS_compare_num_threads > 0) {
+    config->SetCpuMathLibraryNumThreads(FLAGS_compare_num_threads);
+    compare = true;
+  }
+  return compare;
+}
+
+int Main() {
+  ModelProfileOptions options;
+  options.batch_size = FLAGS_batch_size;
+  options.warmup = FLAGS_warmup;
+  options.repeat = FLAGS_repeat;
+  options.input_shapes = ParseInputShapes(FLAGS_input_shapes);
+  options.int_input_max = FLAGS_int_input_max;
+  options.profile_passes = FLAGS_profile_passes;
+
+  auto config = MakeConfig();
+  auto profile = ProfileModel(config, options);
+  if (FLAGS_output.empty()) {
+    std::cout << profile.SerializeToJson();
+  } else {
+    profile.PersistToFile(FLAGS_output);
+  }
+
+  AnalysisConfig other_config(config);
+  if (!MakeCompareConfig(&other_config)) {
+    return 0;
+  }
+  options.profile_passes = false;
+  auto other = ProfileModel(other_config, options);
+  other.SetName(other.name() + " (compared)");
+  if (!FLAGS_compare_output.empty()) {
+    other.PersistToFile(FLAGS_compare_output);
+  }
+  std::string report;
+  bool pass = OpProfile::Compare(other, profile, FLAGS_tolerance, &report);
+  std::cout << report;
+  return pass ? 0 : 1;
+}
+
+}  // namespace inference
+}  // namespace paddle
+
+int main(int argc, char** argv) {
+  ::GFLAGS_NAMESPACE::ParseCommandLineFlags(&argc, &argv, true);
+  google::InitGoogleLogging(argv[0]);
+  return paddle::inference::Main();
+}
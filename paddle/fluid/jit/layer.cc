@@ -14,13 +14,22 @@
 
 #include "paddle/fluid/jit/layer.h"
 
+#include "paddle/fluid/framework/tensor_util.h"
+
+#include "paddle/fluid/jit/executor_function.h"
+#include "paddle/fluid/jit/pe_function.h"
+
+DECLARE_string(jit_engine_type);
+
 namespace paddle {
 namespace jit {
 Layer::Layer(const std::vector<std::shared_ptr<FunctionInfo>>& infos,
-             const Name2VariableMap& params_dict,
+             const std::shared_ptr<const Name2VariableMap>& params_dict,
              const phi::Place& place)
-    : params_dict_(params_dict) {
+    : infos_(infos), params_dict_(params_dict), place_(place) {
   VLOG(3) << "infos size: " << infos.size();
+  MaterializeParams();
+  BuildFunctions();
 }
 
 std::shared_ptr<BaseFunction> Layer::Function(const std::string& name) const {
@@ -38,7 +47,58 @@ std::vector<DenseTensor> Layer::forward(
   return (*func)(inputs);
 }
 
-void Layer::to(const phi::Place& place) {}
+void Layer::to(const phi::Place& place) {
+  if (place == place_) return;
+  VLOG(3) << "Move Layer from " << place_ << " to " << place;
+  place_ = place;
+  MaterializeParams();
+  BuildFunctions();
+}
+
+void Layer::MaterializeParams() {
+  bool on_place = true;
+  for (auto& it : *params_dict_) {
+    auto& tensor = it.second.Get<DenseTensor>();
+    if (tensor.initialized() && tensor.place() != place_) {
+      on_place = false;
+      break;
+    }
+  }
+  if (on_place) return;
+
+  // The params may be shared with other Layers, so they are copied into a
+  // new dict rather than moved.
+  auto params_dict = std::make_shared<Name2VariableMap>();
+  for (auto& it : *params_dict_) {
+    auto& src_tensor = it.second.Get<DenseTensor>();
+    Variable& var = (*params_dict)[it.first];
+    auto* dst_tensor = var.GetMutable<DenseTensor>();
+    if (src_tensor.initialized()) {
+      VLOG(3) << "Copy param " << it.first << " to " << place_;
+      framework::TensorCopySync(src_tensor, place_, dst_tensor);
+    } else {
+      *dst_tensor = src_tensor;
+    }
+  }
+  params_dict_ = params_dict;
+}
+
+void Layer::BuildFunctions() {
+  for (auto& info : infos_) {
+    if (FLAGS_jit_engine_type == "Executor") {
+      VLOG(3) << "Add function type: ExecutorFunction.";
+      SetFunction(
+          info->FunctionName(),
+          utils::MakeFunction<ExecutorFunction>(info, *params_dict_, place_));
+    } else if (FLAGS_jit_engine_type == "PE") {
+      VLOG(3) << "Add function type: PEFunction.";
+      SetFunction(info->FunctionName(),
+                  utils::MakeFunction<PEFunction>(info, *params_dict_, place_));
+    } else {
+      PD_THROW("Invalid JitLayer funciton type.");
+    }
+  }
+}
 
 void Layer::SetFunction(const std::string& name,
                         const std::shared_ptr<BaseFunction>& function) {
@@ -53,5 +113,7 @@ const Name2FunctionMap& Layer::FunctionMap() const {
   return unit_.FunctionMap();
 }
 
+const Name2VariableMap& Layer::Params() const { return *params_dict_; }
+
 }  // namespace jit
 }  // namespace paddle
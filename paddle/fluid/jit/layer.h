@@ -14,6 +14,7 @@
 
 #pragma once
 
+#include <memory>
 #include <string>
 #include <unordered_map>
 #include <vector>
@@ -32,8 +33,10 @@ using Name2VariableMap = std::unordered_map<std::string, Variable>;
 
 class Layer {
  public:
+  // The params may be shared with other Layers, like the memory mapped
+  // params of the same file, and are copied when they are not on place.
   Layer(const std::vector<std::shared_ptr<FunctionInfo>>& infos,
-        const Name2VariableMap& params_dict,
+        const std::shared_ptr<const Name2VariableMap>& params_dict,
         const phi::Place& place);
 
   std::shared_ptr<BaseFunction> Function(const std::string& name) const;
@@ -44,6 +47,8 @@ class Layer {
 
   std::vector<DenseTensor> forward(const std::vector<DenseTensor>& inputs);
 
+  // Copies the params to place and builds the functions of the infos on it
+  // again.
   void to(const phi::Place& place);
 
   void SetFunction(const std::string& name,
@@ -53,8 +58,16 @@ class Layer {
 
   const Name2FunctionMap& FunctionMap() const;
 
+  const Name2VariableMap& Params() const;
+
  private:
-  Name2VariableMap params_dict_;
+  void MaterializeParams();
+
+  void BuildFunctions();
+
+  std::vector<std::shared_ptr<FunctionInfo>> infos_;
+  std::shared_ptr<const Name2VariableMap> params_dict_;
+  phi::Place place_;
   Name2VariableMap attrs_dict_;
   CompilationUnit unit_;
 };
@@ -27,6 +27,7 @@
 
 #include "paddle/fluid/jit/function_utils.h"
 #include "paddle/fluid/jit/layer.h"
+#include "paddle/fluid/jit/mapped_params.h"
 #include "paddle/fluid/jit/serializer.h"
 
 USE_OP_ITSELF(elementwise_add);
@@ -87,7 +88,44 @@ TEST(CpuLayerTest, Construct) {
   EXPECT_NEAR(out_data[0], pow(1.41562390, 2.0), 1e-6);
 }
 
+TEST(CpuLayerTest, LoadTwice) {
+  auto place = phi::CPUPlace();
+  std::string path = "./multi_program_load/export";
+  // The second Layer shares the params of the first one.
+  auto layer = jit::Load(path, place);
+  auto other_layer = jit::Load(path, place);
+  auto inputs = PrepareInputs(place);
+
+  auto outs = layer.forward(inputs);
+  auto other_outs = other_layer.forward(inputs);
+  EXPECT_NEAR(outs[0].data<float>()[0], 0.02194316, 1e-6);
+  EXPECT_NEAR(other_outs[0].data<float>()[0], 0.02194316, 1e-6);
+
+  // Without the memory mapped params each Layer reads its own copy.
+  if (!MappedParamsEnabled()) return;
+  ASSERT_EQ(layer.Params().size(), other_layer.Params().size());
+  for (auto& param : layer.Params()) {
+    auto& tensor = param.second.Get<DenseTensor>();
+    auto& other_tensor =
+        other_layer.Params().at(param.first).Get<DenseTensor>();
+    EXPECT_EQ(tensor.data(), other_tensor.data()) << param.first;
+  }
+}
+
 #if defined(PADDLE_WITH_CUDA)
+TEST(GpuLayerTest, To) {
+  std::string path = "./multi_program_load/export";
+  auto layer = jit::Load(path, phi::CPUPlace());
+  auto place = phi::GPUPlace();
+  layer.to(place);
+  auto inputs = PrepareInputs(place);
+
+  auto outs = layer.forward(inputs);
+  auto cpu_tensor =
+      paddle::experimental::copy_to(outs[0], phi::CPUPlace(), true);
+  EXPECT_NEAR(cpu_tensor.data<float>()[0], 0.02194316, 1e-6);
+}
+
 TEST(GpuLayerTest, Construct) {
   auto place = phi::GPUPlace();
 
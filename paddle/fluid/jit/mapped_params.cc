@@ -0,0 +1,119 @@
+// Copyright (c) 2022 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "paddle/fluid/jit/mapped_params.h"
+
+#include <sys/stat.h>
+
+#include <map>
+#include <mutex>
+#include <tuple>
+#include <vector>
+
+#include "gflags/gflags.h"
+#include "paddle/fluid/framework/scope.h"
+#include "paddle/fluid/inference/utils/mmap_params_loader.h"
+#include "paddle/phi/core/enforce.h"
+
+DECLARE_bool(jit_mmap_params);
+
+namespace paddle {
+namespace jit {
+
+namespace {
+
+// A rewritten file must be mapped again, so a file is identified by its
+// path, size and modification time.
+struct MappedFileKey {
+  std::string path;
+  int64_t size;
+  int64_t mtime;
+
+  bool operator<(const MappedFileKey& other) const {
+    return std::tie(path, size, mtime) <
+           std::tie(other.path, other.size, other.mtime);
+  }
+};
+
+struct CachedParams {
+  std::set<std::string> var_names;
+  std::weak_ptr<const Name2VariableMap> params;
+};
+
+MappedFileKey GetMappedFileKey(const std::string& file_name) {
+  struct stat file_stat;
+  PADDLE_ENFORCE_EQ(stat(file_name.c_str(), &file_stat),
+                    0,
+                    phi::errors::Unavailable(
+                        "Fail to stat the parameters file %s, please check "
+                        "whether the model file exists.",
+                        file_name));
+  return MappedFileKey{file_name,
+                       static_cast<int64_t>(file_stat.st_size),
+                       static_cast<int64_t>(file_stat.st_mtime)};
+}
+
+std::shared_ptr<const Name2VariableMap> MapParams(
+    const std::string& file_name, const std::set<std::string>& var_names) {
+  std::vector<std::string> names(var_names.begin(), var_names.end());
+  framework::Scope scope;
+  size_t num_aliased = inference::LoadCombinedParamsFromMmap(
+      file_name, names, &scope, /*lazy_load=*/true);
+  VLOG(3) << num_aliased << " of the " << names.size()
+          << " parameters alias the mapped file " << file_name;
+  // The variables share their tensors, which keep the mapping alive, with
+  // the variables of the scope.
+  auto params = std::make_shared<Name2VariableMap>();
+  for (auto& name : names) {
+    (*params)[name] = *scope.FindVar(name);
+  }
+  return params;
+}
+
+}  // namespace
+
+bool MappedParamsEnabled() {
+  return FLAGS_jit_mmap_params && inference::MmapParamsSupported();
+}
+
+std::shared_ptr<const Name2VariableMap> LoadMappedParams(
+    const std::string& file_name, const std::set<std::string>& var_names) {
+  static std::mutex mutex;
+  static std::map<MappedFileKey, CachedParams> cache;
+
+  MappedFileKey key = GetMappedFileKey(file_name);
+  std::lock_guard<std::mutex> guard(mutex);
+  auto it = cache.find(key);
+  if (it != cache.end() && it->second.var_names == var_names) {
+    auto params = it->second.params.lock();
+    if (params) {
+      VLOG(3) << "Share the cached parameters of " << file_name;
+      return params;
+    }
+  }
+  // Drop the files no Layer holds anymore.
+  for (auto iter = cache.begin(); iter != cache.end();) {
+    if (iter->second.params.expired()) {
+      iter = cache.erase(iter);
+    } else {
+      ++iter;
+    }
+  }
+  auto params = MapParams(file_name, var_names);
+  cache[key] = CachedParams{var_names, params};
+  return params;
+}
+
+}  // namespace jit
+}  // namespace paddle
@@ -0,0 +1,46 @@
+// Copyright (c) 2022 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <memory>
+#include <set>
+#include <string>
+
+#include "paddle/fluid/jit/function_utils.h"
+
+namespace paddle {
+namespace jit {
+
+// Whether the parameters of a jit-saved model are memory mapped: requires
+// FLAGS_jit_mmap_params and a platform that supports it.
+bool MappedParamsEnabled();
+
+/*
+ * Loads the parameters var_names, in the order of the set, from the combined
+ * parameters file file_name without deserializing them.
+ *
+ * The file is mapped lazily, so loading costs little more than opening it,
+ * and the CPU tensors alias the mapped pages, which are only read from disk
+ * when a kernel first touches them. The parameters are cached while any
+ * Layer holds them: loading the same unchanged file again returns the same
+ * tensors instead of mapping it again. They are shared with the other
+ * Layers of the file and must not be written to; Layer::to copies them to
+ * another place.
+ * **/
+std::shared_ptr<const Name2VariableMap> LoadMappedParams(
+    const std::string& file_name, const std::set<std::string>& var_names);
+
+}  // namespace jit
+}  // namespace paddle
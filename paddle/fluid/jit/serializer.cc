@@ -18,12 +18,9 @@
 
 #include "paddle/fluid/platform/device_context.h"
 
-#include "paddle/fluid/jit/executor_function.h"
-#include "paddle/fluid/jit/pe_function.h"
+#include "paddle/fluid/jit/mapped_params.h"
 #include "paddle/fluid/jit/serializer_utils.h"
 
-DECLARE_string(jit_engine_type);
-
 namespace paddle {
 namespace jit {
 
@@ -33,7 +30,6 @@ Layer Deserializer::operator()(const std::string& path,
   // set is ordered
   std::set<std::string> param_names_set;
   std::vector<std::shared_ptr<FunctionInfo>> infos;
-  Name2VariableMap params_dict;
   for (auto& it : pdmodel_paths) {
     auto& func_name = it.first;
     auto program_desc = LoadProgram(it.second);
@@ -52,27 +48,20 @@ Layer Deserializer::operator()(const std::string& path,
         func_name, persist_var_names, program_desc));
   }
 
-  ReadTensorData(path + PDPARAMS_SUFFIX, param_names_set, place, &params_dict);
+  std::shared_ptr<const Name2VariableMap> params_dict;
+  if (MappedParamsEnabled()) {
+    // Mapped on the CPU, the Layer copies them when place is another one.
+    params_dict = LoadMappedParams(path + PDPARAMS_SUFFIX, param_names_set);
+  } else {
+    auto read_params_dict = std::make_shared<Name2VariableMap>();
+    ReadTensorData(
+        path + PDPARAMS_SUFFIX, param_names_set, place, read_params_dict.get());
+    params_dict = read_params_dict;
+  }
   // ReadAttributeData();
 
   Layer layer = Layer(infos, params_dict, place);
 
-  for (auto& info : infos) {
-    if (FLAGS_jit_engine_type == "Executor") {
-      VLOG(3) << "Add function type: ExecutorFunction.";
-      layer.SetFunction(
-          info->FunctionName(),
-          utils::MakeFunction<ExecutorFunction>(info, params_dict, place));
-    } else if (FLAGS_jit_engine_type == "PE") {
-      VLOG(3) << "Add function type: PEFunction.";
-      layer.SetFunction(
-          info->FunctionName(),
-          utils::MakeFunction<PEFunction>(info, params_dict, place));
-    } else {
-      PD_THROW("Invalid JitLayer funciton type.");
-    }
-  }
-
   return layer;
 }
 
@@ -55,9 +55,11 @@ class StatAllocator : public Allocator {
         platform::is_cuda_pinned_place(place)) {
       HOST_MEMORY_STAT_UPDATE(
           Allocated, place.GetDeviceId(), allocation->size());
+      HOST_MEMORY_STAT_UPDATE(Allocations, place.GetDeviceId(), 1);
     } else {
       DEVICE_MEMORY_STAT_UPDATE(
           Allocated, place.GetDeviceId(), allocation->size());
+      DEVICE_MEMORY_STAT_UPDATE(Allocations, place.GetDeviceId(), 1);
     }
     platform::RecordMemEvent(allocation->ptr(),
                              allocation->place(),
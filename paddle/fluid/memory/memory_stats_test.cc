@@ -40,6 +40,18 @@ TEST(stat_allocator_test, host_memory_stat_test) {
   EXPECT_EQ(HostMemoryStatPeakValue("Allocated", 0), max_alloc_size);
 }
 
+TEST(stat_allocator_test, host_memory_allocations_test) {
+  int64_t base = HostMemoryStatCurrentValue("Allocations", 0);
+  std::vector<AllocationPtr> allocations;
+  for (int i = 1; i <= 8; ++i) {
+    allocations.emplace_back(Alloc(platform::CPUPlace(), 256 * i));
+    EXPECT_EQ(HostMemoryStatCurrentValue("Allocations", 0), base + i);
+  }
+  // The frees do not take back the allocations made.
+  allocations.clear();
+  EXPECT_EQ(HostMemoryStatCurrentValue("Allocations", 0), base + 8);
+}
+
 #if defined(PADDLE_WITH_CUDA) || defined(PADDLE_WITH_HIP)
 TEST(stat_allocator_test, device_memory_stat_test) {
   std::vector<int64_t> alloc_sizes{
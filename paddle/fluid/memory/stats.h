@@ -198,11 +198,15 @@ void HostMemoryStatUpdate(const std::string& stat_type,
   struct HostMemoryStat##item##0 : public ThreadLocalStatBase{};
 
 // To add a new STAT type, declare here and register in stats.cc
+// Allocated and Reserved are in bytes, Allocations is the number of
+// allocations made so far, which the frees do not take back.
 DEVICE_MEMORY_STAT_DECLARE(Allocated);
 DEVICE_MEMORY_STAT_DECLARE(Reserved);
+DEVICE_MEMORY_STAT_DECLARE(Allocations);
 
 HOST_MEMORY_STAT_DECLARE(Allocated);
 HOST_MEMORY_STAT_DECLARE(Reserved);
+HOST_MEMORY_STAT_DECLARE(Allocations);
 
 }  // namespace memory
 }  // namespace paddle
@@ -203,6 +203,12 @@ class FCOpMaker : public framework::OpProtoAndCheckerMaker {
                   "(bool, default false) Force INT8 kernel output FP32, only "
                   "used in MKL-DNN INT8")
         .SetDefault(false);
+    AddAttr<bool>("cpu_int8",
+                  "(bool, default false) Run the plain CPU kernel on int8 "
+                  "weights quantized with Scale_weights. The input is "
+                  "quantized with Scale_in and shifted into uint8, the "
+                  "quantizer folds the shift into Bias.")
+        .SetDefault(false);
     AddComment(R"DOC(
 Fully Connected Operator.
 
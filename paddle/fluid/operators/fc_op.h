@@ -15,10 +15,12 @@ limitations under the License. */
 #pragma once
 
 #include <string>
+#include <type_traits>
 #include <vector>
 
 #include "paddle/fluid/framework/op_registry.h"
 #include "paddle/phi/kernels/funcs/fc_functor.h"
+#include "paddle/phi/kernels/funcs/int8_gemm.h"
 
 namespace paddle {
 namespace operators {
@@ -54,6 +56,71 @@ inline void FCOutputSize(const framework::DDim& in_dims,
   out_dims.push_back(w_dims1);
 }
 
+// The plain CPU int8 fc, used when the cpu_int8 attribute is set by the CPU
+// quantizer: W holds int8 weights and Bias has the input shift folded in.
+inline void FCInt8Compute(const framework::ExecutionContext& ctx,
+                          int M,
+                          int N,
+                          int K,
+                          bool with_relu,
+                          const float* input_data,
+                          float* output_data) {
+  PADDLE_ENFORCE_EQ(
+      platform::is_cpu_place(ctx.GetPlace()),
+      true,
+      platform::errors::Unimplemented("The int8 fc only runs on CPU."));
+  auto* w = ctx.Input<Tensor>("W");
+  auto* bias = ctx.Input<Tensor>("Bias");
+  PADDLE_ENFORCE_EQ(w->dtype(),
+                    phi::DataType::INT8,
+                    platform::errors::InvalidArgument(
+                        "The weight of the int8 fc should be int8, but "
+                        "received %s.",
+                        w->dtype()));
+  float scale_in = ctx.Attr<float>("Scale_in");
+  auto scale_weights = ctx.Attr<std::vector<float>>("Scale_weights");
+  PADDLE_ENFORCE_EQ(
+      scale_weights.size() == 1 || static_cast<int>(scale_weights.size()) == N,
+      true,
+      platform::errors::InvalidArgument(
+          "The size of Scale_weights should be 1 or the output size %d, but "
+          "received %d.",
+          N,
+          scale_weights.size()));
+
+  Tensor quant_input;
+  auto* quant_data =
+      quant_input.mutable_data<uint8_t>({M, K}, ctx.GetPlace());
+  phi::funcs::QuantizeShiftedUint8(
+      static_cast<int64_t>(M) * K, input_data, scale_in, quant_data);
+  Tensor acc;
+  auto* acc_data = acc.mutable_data<int32_t>({M, N}, ctx.GetPlace());
+  phi::funcs::Int8Gemm(ctx.device_context<phi::CPUContext>(),
+                       M,
+                       N,
+                       K,
+                       quant_data,
+                       w->data<int8_t>(),
+                       acc_data);
+
+  std::vector<float> dequant_scales(N);
+  for (int j = 0; j < N; ++j) {
+    float scale_w = scale_weights.size() == 1 ? scale_weights[0]
+                                              : scale_weights[j];
+    dequant_scales[j] = 1.0f / (scale_in * scale_w);
+  }
+  const float* bias_data = bias ? bias->data<float>() : nullptr;
+  for (int i = 0; i < M; ++i) {
+    const int32_t* acc_row = acc_data + static_cast<int64_t>(i) * N;
+    float* out_row = output_data + static_cast<int64_t>(i) * N;
+    for (int j = 0; j < N; ++j) {
+      float v = acc_row[j] * dequant_scales[j];
+      if (bias_data) v += bias_data[j];
+      out_row[j] = (with_relu && v < 0.0f) ? 0.0f : v;
+    }
+  }
+}
+
 template <typename DeviceContext, typename T>
 class FCOpKernel : public framework::OpKernel<T> {
  public:
@@ -80,6 +147,18 @@ class FCOpKernel : public framework::OpKernel<T> {
     auto w_dims1 = padding_weights ? w_dims[1] - 4 : w_dims[1];
     int M = phi::product(out_dims) / w_dims1;
 
+    if (std::is_same<T, float>::value && ctx.Attr<bool>("cpu_int8")) {
+      FCInt8Compute(ctx,
+                    M,
+                    w_dims1,
+                    w_dims0,
+                    with_relu,
+                    reinterpret_cast<const float*>(input->data<T>()),
+                    reinterpret_cast<float*>(
+                        output->mutable_data<T>(ctx.GetPlace())));
+      return;
+    }
+
     const T* input_data = input->data<T>();
     const T* w_data = w->data<T>();
     T* output_data = output->mutable_data<T>(ctx.GetPlace());
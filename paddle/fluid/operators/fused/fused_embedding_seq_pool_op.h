@@ -24,6 +24,7 @@ limitations under the License. */
 #include "paddle/fluid/framework/selected_rows_utils.h"
 #include "paddle/fluid/operators/jit/kernels.h"
 #include "paddle/phi/kernels/funcs/blas/blas.h"
+#include "paddle/phi/kernels/funcs/cpu_embedding.h"
 
 namespace paddle {
 namespace operators {
@@ -128,6 +129,58 @@ struct EmbeddingVSumFunctor {
 };
 #endif
 
+// Pools the float tables with CpuEmbeddingSeqPool, which skips the padding
+// ids as the CSRMM path does and as padding_idx is documented, where the jit
+// path of the builds without MKL summed their rows. The other types return
+// false.
+template <typename T>
+bool CpuEmbeddingSeqPoolSum(const framework::ExecutionContext &context,
+                            const LoDTensor *table_t,
+                            const LoDTensor *ids_t,
+                            LoDTensor *output_t) {
+  return false;
+}
+
+template <>
+inline bool CpuEmbeddingSeqPoolSum<float>(
+    const framework::ExecutionContext &context,
+    const LoDTensor *table_t,
+    const LoDTensor *ids_t,
+    LoDTensor *output_t) {
+  const auto &offsets = ids_t->lod()[0];
+  PADDLE_ENFORCE_GT(offsets.size(),
+                    1UL,
+                    platform::errors::InvalidArgument(
+                        "The tensor ids's LoD[0] should be greater than 1. "
+                        "But received the ids's LoD[0] = %d.",
+                        offsets.size()));
+  int64_t table_width = table_t->dims()[1];
+  int64_t out_width = output_t->dims()[1];
+  int64_t idx_width = ids_t->numel() / offsets.back();
+  PADDLE_ENFORCE_LE(table_width * idx_width,
+                    out_width,
+                    platform::errors::InvalidArgument(
+                        "table_width * idx_width should be less than or "
+                        "equal to out_width. But received "
+                        "table_width * idx_width = %s, out_width = %d.",
+                        table_width * idx_width,
+                        out_width));
+  phi::funcs::CpuEmbeddingTable table(phi::funcs::EmbeddingRowType::kFloat32,
+                                      table_t->data<float>(),
+                                      table_t->dims()[0],
+                                      table_width);
+  phi::funcs::CpuEmbeddingSeqPool<int64_t>(
+      context.template device_context<phi::CPUContext>(),
+      table,
+      ids_t->data<int64_t>(),
+      offsets,
+      idx_width,
+      context.Attr<int64_t>("padding_idx"),
+      phi::funcs::EmbeddingPoolType::kSum,
+      output_t->mutable_data<float>(context.GetPlace()));
+  return true;
+}
+
 inline int FusedEmbeddingSeqPoolLastDim(const framework::DDim &table_dims,
                                         const framework::DDim &ids_dims) {
   int64_t last_dim = table_dims[1];
@@ -162,6 +215,9 @@ class FusedEmbeddingSeqPoolKernel : public framework::OpKernel<T> {
     output_t->Resize({batch_size, last_dim});
 
     if (combiner_type == "sum") {
+      if (CpuEmbeddingSeqPoolSum<T>(context, table_var, ids_t, output_t)) {
+        return;
+      }
 #if defined(PADDLE_WITH_MKLML) && !defined(_WIN32) && !defined(__APPLE__) && \
     !defined(__OSX__)
       int64_t padding_idx = context.Attr<int64_t>("padding_idx");
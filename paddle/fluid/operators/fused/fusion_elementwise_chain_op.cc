@@ -0,0 +1,410 @@
+/* Copyright (c) 2022 PaddlePaddle Authors. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License. */
+
+#include "paddle/fluid/operators/fused/fusion_elementwise_chain_op.h"
+
+#include <algorithm>
+#include <cmath>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "paddle/fluid/operators/jit/kernels.h"
+
+namespace paddle {
+namespace operators {
+
+namespace {
+
+// Whether the input of in_dims is broadcast to out_dims along its trailing
+// dimensions: leaving out its leading 1s, it is a suffix of out_dims.
+bool IsTrailingBroadcast(const framework::DDim& out_dims,
+                         const framework::DDim& in_dims) {
+  int begin = 0;
+  while (begin < in_dims.size() && in_dims[begin] == 1) ++begin;
+  int pre = out_dims.size() - (in_dims.size() - begin);
+  if (pre < 0) return false;
+  for (int i = begin; i < in_dims.size(); ++i) {
+    if (in_dims[i] != out_dims[pre + i - begin]) return false;
+  }
+  return true;
+}
+
+}  // namespace
+
+void FusionElementwiseChainOp::InferShape(
+    framework::InferShapeContext* ctx) const {
+  OP_INOUT_CHECK(
+      ctx->HasInputs("Inputs"), "Input", "Inputs", "FusionElementwiseChain");
+  OP_INOUT_CHECK(
+      ctx->HasOutputs("Outs"), "Output", "Outs", "FusionElementwiseChain");
+  auto ins_dims = ctx->GetInputsDim("Inputs");
+  int shape_input = ctx->Attrs().Get<int>("shape_input");
+  PADDLE_ENFORCE_EQ(
+      shape_input >= 0 && shape_input < static_cast<int>(ins_dims.size()),
+      true,
+      platform::errors::InvalidArgument(
+          "The attribute shape_input should be in [0, %d), but received %d.",
+          ins_dims.size(),
+          shape_input));
+
+  size_t num_ops =
+      ctx->Attrs().Get<std::vector<std::string>>("op_types").size();
+  PADDLE_ENFORCE_EQ(
+      ctx->Attrs().Get<std::vector<int>>("op_operands").size(),
+      2 * num_ops,
+      platform::errors::InvalidArgument(
+          "The attribute op_operands should hold 2 operands for each of the "
+          "%d ops.",
+          num_ops));
+  PADDLE_ENFORCE_EQ(
+      ctx->Attrs().Get<std::vector<float>>("op_scales").size() == num_ops &&
+          ctx->Attrs().Get<std::vector<float>>("op_biases").size() == num_ops,
+      true,
+      platform::errors::InvalidArgument(
+          "The attributes op_scales and op_biases should hold one value for "
+          "each of the %d ops.",
+          num_ops));
+  size_t num_outs = ctx->Outputs("Outs").size();
+  PADDLE_ENFORCE_EQ(ctx->Attrs().Get<std::vector<int>>("out_ids").size(),
+                    num_outs,
+                    platform::errors::InvalidArgument(
+                        "The attribute out_ids should hold one id for each of "
+                        "the %d outputs.",
+                        num_outs));
+  const auto& out_dims = ins_dims[shape_input];
+  for (size_t i = 0; i < ins_dims.size(); ++i) {
+    if (ctx->IsRuntime() || (!phi::contain_unknown_dim(out_dims) &&
+                             !phi::contain_unknown_dim(ins_dims[i]))) {
+      PADDLE_ENFORCE_EQ(
+          IsTrailingBroadcast(out_dims, ins_dims[i]),
+          true,
+          platform::errors::InvalidArgument(
+              "Inputs[%d] of shape [%s] can not be broadcast to the shape "
+              "[%s] of the outputs along its trailing dimensions.",
+              i,
+              ins_dims[i],
+              out_dims));
+    }
+  }
+  ctx->SetOutputsDim("Outs",
+                     std::vector<framework::DDim>(num_outs, out_dims));
+  for (size_t j = 0; j < num_outs; ++j) {
+    ctx->ShareLoD("Inputs", "Outs", shape_input, j);
+  }
+}
+
+framework::OpKernelType FusionElementwiseChainOp::GetExpectedKernelType(
+    const framework::ExecutionContext& ctx) const {
+  return framework::OpKernelType(
+      OperatorWithKernel::IndicateVarDataType(ctx, "Inputs"), ctx.GetPlace());
+}
+
+void FusionElementwiseChainOpMaker::Make() {
+  AddInput("Inputs", "(Tensor) The inputs of the fused ops.").AsDuplicable();
+  AddOutput("Outs", "(Tensor) The results of the fused ops used outside.")
+      .AsDuplicable();
+  AddAttr<std::vector<std::string>>(
+      "op_types", "The types of the fused ops, in the order they run.");
+  AddAttr<std::vector<int>>(
+      "op_operands",
+      "The ids of the X and Y operands of each op, -1 for no Y. The ids "
+      "0 to len(Inputs) - 1 are the inputs, len(Inputs) + k is the result "
+      "of the k-th op.");
+  AddAttr<std::vector<float>>(
+      "op_scales", "The scale of each op, only used by scale.");
+  AddAttr<std::vector<float>>(
+      "op_biases",
+      "The bias of each op added after the scale, only used by scale.");
+  AddAttr<std::vector<int>>("out_ids", "The id of the value of each output.");
+  AddAttr<int>("shape_input",
+               "The index of the input whose shape all outputs have, the "
+               "other inputs are of the same size or broadcast to it.")
+      .SetDefault(0);
+  AddComment(R"DOC(
+    Fusion Elementwise Chain Operator.
+
+    Computes a graph of elementwise_add/sub/mul/div/max/min, relu, sigmoid,
+    tanh, sqrt, square, exp and scale ops, found by elementwise_chain_fuse_pass,
+    in a single pass over the data: the ops run one after the other on tiles
+    of the inputs small enough that the intermediate results stay in the
+    cache. An input smaller than the outputs is broadcast along their
+    trailing dimensions.
+)DOC");
+}
+
+namespace {
+
+// The number of elements every op computes at once.
+constexpr int kTileSize = 1024;
+
+enum class ChainOpType {
+  kAdd,
+  kSub,
+  kMul,
+  kDiv,
+  kMax,
+  kMin,
+  kRelu,
+  kSigmoid,
+  kTanh,
+  kSqrt,
+  kSquare,
+  kExp,
+  kScale
+};
+
+ChainOpType GetChainOpType(const std::string& type) {
+  static const std::unordered_map<std::string, ChainOpType> types = {
+      {"elementwise_add", ChainOpType::kAdd},
+      {"elementwise_sub", ChainOpType::kSub},
+      {"elementwise_mul", ChainOpType::kMul},
+      {"elementwise_div", ChainOpType::kDiv},
+      {"elementwise_max", ChainOpType::kMax},
+      {"elementwise_min", ChainOpType::kMin},
+      {"relu", ChainOpType::kRelu},
+      {"sigmoid", ChainOpType::kSigmoid},
+      {"tanh", ChainOpType::kTanh},
+      {"sqrt", ChainOpType::kSqrt},
+      {"square", ChainOpType::kSquare},
+      {"exp", ChainOpType::kExp},
+      {"scale", ChainOpType::kScale}};
+  auto it = types.find(type);
+  PADDLE_ENFORCE_NE(it,
+                    types.end(),
+                    platform::errors::Unimplemented(
+                        "Op %s can not be fused into fusion_elementwise_chain.",
+                        type));
+  return it->second;
+}
+
+// The jit kernels of the ops on n elements.
+template <typename T>
+struct ChainKernels {
+  explicit ChainKernels(int n) : n(n) {
+    using CPU = platform::CPUPlace;
+    add = jit::KernelFuncs<jit::VAddTuple<T>, CPU>::Cache().At(n);
+    sub = jit::KernelFuncs<jit::VSubTuple<T>, CPU>::Cache().At(n);
+    mul = jit::KernelFuncs<jit::VMulTuple<T>, CPU>::Cache().At(n);
+    scal = jit::KernelFuncs<jit::VScalTuple<T>, CPU>::Cache().At(n);
+    add_bias = jit::KernelFuncs<jit::VAddBiasTuple<T>, CPU>::Cache().At(n);
+    relu = jit::KernelFuncs<jit::VReluTuple<T>, CPU>::Cache().At(n);
+    sigmoid = jit::KernelFuncs<jit::VSigmoidTuple<T>, CPU>::Cache().At(n);
+    tanh = jit::KernelFuncs<jit::VTanhTuple<T>, CPU>::Cache().At(n);
+    square = jit::KernelFuncs<jit::VSquareTuple<T>, CPU>::Cache().At(n);
+    exp = jit::KernelFuncs<jit::VExpTuple<T>, CPU>::Cache().At(n);
+  }
+
+  int n;
+  typename jit::VAddTuple<T>::func_type add;
+  typename jit::VSubTuple<T>::func_type sub;
+  typename jit::VMulTuple<T>::func_type mul;
+  typename jit::VScalTuple<T>::func_type scal;
+  typename jit::VAddBiasTuple<T>::func_type add_bias;
+  typename jit::VReluTuple<T>::func_type relu;
+  typename jit::VSigmoidTuple<T>::func_type sigmoid;
+  typename jit::VTanhTuple<T>::func_type tanh;
+  typename jit::VSquareTuple<T>::func_type square;
+  typename jit::VExpTuple<T>::func_type exp;
+};
+
+template <typename T>
+void RunChainOp(const ChainKernels<T>& kernels,
+                ChainOpType type,
+                const T* x,
+                const T* y,
+                T scale,
+                T bias,
+                T* out) {
+  int n = kernels.n;
+  switch (type) {
+    case ChainOpType::kAdd:
+      kernels.add(x, y, out, n);
+      break;
+    case ChainOpType::kSub:
+      kernels.sub(x, y, out, n);
+      break;
+    case ChainOpType::kMul:
+      kernels.mul(x, y, out, n);
+      break;
+    case ChainOpType::kDiv:
+      for (int i = 0; i < n; ++i) out[i] = x[i] / y[i];
+      break;
+    case ChainOpType::kMax:
+      for (int i = 0; i < n; ++i) out[i] = x[i] > y[i] ? x[i] : y[i];
+      break;
+    case ChainOpType::kMin:
+      for (int i = 0; i < n; ++i) out[i] = x[i] < y[i] ? x[i] : y[i];
+      break;
+    case ChainOpType::kRelu:
+      kernels.relu(x, out, n);
+      break;
+    case ChainOpType::kSigmoid:
+      kernels.sigmoid(x, out, n);
+      break;
+    case ChainOpType::kTanh:
+      kernels.tanh(x, out, n);
+      break;
+    case ChainOpType::kSqrt:
+      for (int i = 0; i < n; ++i) out[i] = std::sqrt(x[i]);
+      break;
+    case ChainOpType::kSquare:
+      kernels.square(x, out, n);
+      break;
+    case ChainOpType::kExp:
+      kernels.exp(x, out, n);
+      break;
+    case ChainOpType::kScale:
+      kernels.scal(&scale, x, out, n);
+      if (bias != static_cast<T>(0)) kernels.add_bias(&bias, out, out, n);
+      break;
+  }
+}
+
+}  // namespace
+
+template <typename T>
+class FusionElementwiseChainKernel : public framework::OpKernel<T> {
+ public:
+  void Compute(const framework::ExecutionContext& ctx) const override {
+    auto ins = ctx.MultiInput<LoDTensor>("Inputs");
+    auto outs = ctx.MultiOutput<LoDTensor>("Outs");
+    const auto& op_types = ctx.Attr<std::vector<std::string>>("op_types");
+    const auto& operands = ctx.Attr<std::vector<int>>("op_operands");
+    const auto& scales = ctx.Attr<std::vector<float>>("op_scales");
+    const auto& biases = ctx.Attr<std::vector<float>>("op_biases");
+    const auto& out_ids = ctx.Attr<std::vector<int>>("out_ids");
+    int shape_input = ctx.Attr<int>("shape_input");
+
+    int num_ins = static_cast<int>(ins.size());
+    int num_ops = static_cast<int>(op_types.size());
+    int64_t numel = ins[shape_input]->numel();
+
+    std::vector<ChainOpType> types(num_ops);
+    for (int k = 0; k < num_ops; ++k) {
+      types[k] = GetChainOpType(op_types[k]);
+      int x = operands[2 * k];
+      int y = operands[2 * k + 1];
+      PADDLE_ENFORCE_EQ(
+          x >= 0 && x < num_ins + k && y >= -1 && y < num_ins + k,
+          true,
+          platform::errors::InvalidArgument(
+              "The operands of op %d (%s) should be the inputs or the "
+              "results of the ops before it, but received %d and %d.",
+              k,
+              op_types[k],
+              x,
+              y));
+    }
+
+    // The results of the ops written to an output skip the tile buffers,
+    // the others and the broadcast inputs get one buffer each.
+    std::vector<T*> result_data(num_ops, nullptr);
+    for (size_t j = 0; j < outs.size(); ++j) {
+      int k = out_ids[j] - num_ins;
+      PADDLE_ENFORCE_EQ(
+          k >= 0 && k < num_ops,
+          true,
+          platform::errors::InvalidArgument(
+              "The id of Outs[%d] should be the result of an op, but "
+              "received %d.",
+              j,
+              out_ids[j]));
+      result_data[k] = outs[j]->mutable_data<T>(ctx.GetPlace());
+    }
+    if (numel == 0) return;
+
+    std::vector<const T*> in_data(num_ins);
+    std::vector<int64_t> in_numel(num_ins);
+    std::vector<int> buffer_ids(num_ins + num_ops, -1);
+    int num_buffers = 0;
+    for (int i = 0; i < num_ins; ++i) {
+      in_data[i] = ins[i]->data<T>();
+      in_numel[i] = ins[i]->numel();
+      PADDLE_ENFORCE_EQ(
+          IsTrailingBroadcast(ins[shape_input]->dims(), ins[i]->dims()),
+          true,
+          platform::errors::InvalidArgument(
+              "Inputs[%d] of shape [%s] can not be broadcast to the shape "
+              "[%s] of the outputs along its trailing dimensions.",
+              i,
+              ins[i]->dims(),
+              ins[shape_input]->dims()));
+      if (in_numel[i] < numel) buffer_ids[i] = num_buffers++;
+    }
+    for (int k = 0; k < num_ops; ++k) {
+      if (result_data[k] == nullptr) buffer_ids[num_ins + k] = num_buffers++;
+    }
+    std::vector<T> buffers(static_cast<size_t>(num_buffers) * kTileSize);
+    auto buffer = [&buffers, &buffer_ids](int id) {
+      return buffers.data() + static_cast<size_t>(buffer_ids[id]) * kTileSize;
+    };
+
+    std::unique_ptr<ChainKernels<T>> tile_kernels;
+    std::unique_ptr<ChainKernels<T>> tail_kernels;
+    if (numel >= kTileSize) {
+      tile_kernels.reset(new ChainKernels<T>(kTileSize));
+    }
+    if (numel % kTileSize != 0) {
+      tail_kernels.reset(new ChainKernels<T>(numel % kTileSize));
+    }
+
+    // The values are the inputs followed by the results of the ops.
+    std::vector<const T*> values(num_ins + num_ops);
+    for (int64_t start = 0; start < numel; start += kTileSize) {
+      int n = static_cast<int>(std::min<int64_t>(kTileSize, numel - start));
+      const ChainKernels<T>& kernels =
+          n == kTileSize ? *tile_kernels : *tail_kernels;
+      for (int i = 0; i < num_ins; ++i) {
+        if (buffer_ids[i] < 0) {
+          values[i] = in_data[i] + start;
+          continue;
+        }
+        T* dst = buffer(i);
+        int64_t m = in_numel[i];
+        for (int64_t j = start % m, k = 0; k < n; ++k) {
+          dst[k] = in_data[i][j];
+          if (++j == m) j = 0;
+        }
+        values[i] = dst;
+      }
+      for (int k = 0; k < num_ops; ++k) {
+        T* out = result_data[k] != nullptr ? result_data[k] + start
+                                           : buffer(num_ins + k);
+        int y = operands[2 * k + 1];
+        RunChainOp(kernels,
+                   types[k],
+                   values[operands[2 * k]],
+                   y >= 0 ? values[y] : nullptr,
+                   static_cast<T>(scales[k]),
+                   static_cast<T>(biases[k]),
+                   out);
+        values[num_ins + k] = out;
+      }
+    }
+  }
+};
+
+}  // namespace operators
+}  // namespace paddle
+
+namespace ops = paddle::operators;
+REGISTER_OPERATOR(fusion_elementwise_chain,
+                  ops::FusionElementwiseChainOp,
+                  ops::FusionElementwiseChainOpMaker);
+
+REGISTER_OP_CPU_KERNEL(fusion_elementwise_chain,
+                       ops::FusionElementwiseChainKernel<float>,
+                       ops::FusionElementwiseChainKernel<double>);
@@ -23,6 +23,7 @@ limitations under the License. */
 #include "paddle/fluid/framework/selected_rows_utils.h"
 #include "paddle/fluid/framework/var_type_traits.h"
 #include "paddle/phi/kernels/funcs/blas/blas.h"
+#include "paddle/phi/kernels/funcs/cpu_embedding.h"
 
 namespace paddle {
 namespace operators {
@@ -32,20 +33,6 @@ using LoDTensor = framework::LoDTensor;
 using SelectedRows = phi::SelectedRows;
 using DDim = framework::DDim;
 
-template <typename T>
-void dequant(const unsigned char *in,
-             T *out,
-             float min,
-             float max,
-             int emb_size,
-             int pow_2_bits) {
-  float scale = (max - min) / pow_2_bits;
-  for (int i = 0; i < emb_size; ++i) {
-    T x = scale * static_cast<int>(in[i]) + min;
-    out[i] = x;
-  }
-}
-
 constexpr int64_t kNoPadding = -1;
 
 template <typename T>
@@ -73,44 +60,20 @@ class LookupTableDequantKernel : public framework::OpKernel<T> {
     int64_t quant_number = table_t->dims()[1];
     int64_t row_width = (quant_number - 2) * 4;
 
-    auto *table = table_t->data<float>();
     auto *output = output_t->mutable_data<T>(context.GetPlace());
-    int pow_2_bits = static_cast<int>(pow(2, 8));
-    for (int64_t i = 0; i < ids_numel; ++i) {
-      if (padding_idx != kNoPadding && ids[i] == padding_idx) {
-        memset(output + i * row_width, 0, row_width * sizeof(T));
-      } else {
-        PADDLE_ENFORCE_LT(
-            ids[i],
-            row_number,
-            platform::errors::InvalidArgument(
-                "Variable value (input) of OP(fluid.layers.embedding) "
-                "expected >= 0 and < %ld, but got %ld. Please check input "
-                "value.",
-                row_number,
-                ids[i]));
-        PADDLE_ENFORCE_GE(
-            ids[i],
-            0,
-            platform::errors::InvalidArgument(
-                "Variable value (input) of OP(fluid.layers.embedding) "
-                "expected >= 0 and < %ld, but got %ld. Please check input "
-                "value.",
-                row_number,
-                ids[i]));
-        float min = *(table + ids[i] * quant_number);
-        float max = *(table + ids[i] * quant_number + 1);
-        int offset = ids[i] * quant_number + 2;
-        const unsigned char *tensor_buf =
-            reinterpret_cast<const unsigned char *>(table + offset);
-        dequant(tensor_buf,
-                output + i * row_width,
-                min,
-                max,
-                row_width,
-                pow_2_bits);
-      }
-    }
+    // Each row holds its min and max, then the row_width uint8 values.
+    phi::funcs::CpuEmbeddingTable table(
+        phi::funcs::EmbeddingRowType::kUInt8MinMax,
+        table_t->data<float>(),
+        row_number,
+        row_width);
+    phi::funcs::CpuEmbeddingLookup<int64_t>(
+        context.template device_context<phi::CPUContext>(),
+        table,
+        ids,
+        ids_numel,
+        padding_idx,
+        output);
   }
 };
 
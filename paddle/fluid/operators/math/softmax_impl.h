@@ -20,6 +20,7 @@ limitations under the License. */
 #include "paddle/fluid/operators/jit/kernels.h"
 #include "paddle/fluid/operators/math/cpu_vec.h"
 #include "paddle/fluid/platform/cpu_info.h"
+#include "paddle/phi/kernels/autotune/auto_tune_base.h"
 
 namespace paddle {
 namespace operators {
@@ -228,6 +229,99 @@ template <class DeviceContext>
 using enable_if_CPU = typename std::enable_if<
     std::is_same<DeviceContext, phi::CPUContext>::value>::type;
 
+// The CPU softmax of the vectorized loops of cpu_vec.h when the axis is the
+// last one, and of Eigen otherwise.
+template <typename T, bool is_test>
+void SoftmaxCPUDefault(const phi::CPUContext& context,
+                       const int axis_dim,
+                       const framework::Tensor* X,
+                       framework::Tensor* Y) {
+  const auto& in_dims = X->dims();
+  constexpr int kBatchDim = 0;
+  constexpr int kClassDim = 1;
+
+  const int num_classes = in_dims[kClassDim];
+  const int batch_size = in_dims[kBatchDim];
+  const int num_remain = num_classes / axis_dim;
+
+  if (num_remain == 1 && platform::MayIUse(platform::avx)) {
+    const T* in_data = X->data<T>();
+    T* out_data = Y->data<T>();
+    for (int bs = 0; bs < batch_size; ++bs) {
+      T max_val = *std::max_element(in_data, in_data + num_classes);
+      max_val *= static_cast<T>(-1);
+      vec_add_bias<T, platform::avx>(num_classes, max_val, in_data, out_data);
+      vec_clip<T, platform::avx>(
+          num_classes, static_cast<T>(-64), out_data, out_data);
+      vec_exp<T>(num_classes, out_data, out_data);
+
+      T sum = 0;
+      vec_sum<T, platform::avx>(num_classes, out_data, &sum);
+      sum = static_cast<T>(1) / sum;
+      vec_scal<T, platform::avx>(num_classes, sum, out_data, out_data);
+
+      in_data += num_classes;
+      out_data += num_classes;
+    }
+  } else {
+    SoftmaxEigen<phi::CPUContext, T, is_test>()(context, axis_dim, X, Y);
+  }
+}
+
+template <typename T, bool is_test>
+void SoftmaxCPUEigen(const phi::CPUContext& context,
+                     const int axis_dim,
+                     const framework::Tensor* X,
+                     framework::Tensor* Y) {
+  SoftmaxEigen<phi::CPUContext, T, is_test>()(context, axis_dim, X, Y);
+}
+
+inline void SoftmaxCPUJit(const phi::CPUContext& context,
+                          const int axis_dim,
+                          const framework::Tensor* X,
+                          framework::Tensor* Y) {
+  const auto& in_dims = X->dims();
+  auto compute_softmax =
+      jit::KernelFuncs<jit::SoftmaxTuple<float>, platform::CPUPlace>::Cache()
+          .At(in_dims[1]);
+  compute_softmax(X->data<float>(),
+                  Y->data<float>(),
+                  in_dims[1],
+                  in_dims[0],
+                  in_dims[1] / axis_dim);
+}
+
+template <typename T>
+using SoftmaxCPUKernel = phi::autotune::KernelCallback<T,
+                                                       void,
+                                                       const phi::CPUContext&,
+                                                       int,
+                                                       const framework::Tensor*,
+                                                       framework::Tensor*>;
+
+template <typename T>
+using SoftmaxCPUTunerType =
+    phi::autotune::AutoTuneBase<T, SoftmaxCPUKernel<T>>;
+
+// The tuner picking among the CPU softmax implementations of T, of which
+// SoftmaxCPUDefault is the default. It is built here rather than by
+// MakeCpuTuner, whose instances can not tell the two is_test apart.
+template <typename T, bool is_test>
+struct SoftmaxCPUTuner {
+  static SoftmaxCPUTunerType<T>* Instance() {
+    static SoftmaxCPUTunerType<T>* tuner = [] {
+      auto* tuner = new SoftmaxCPUTunerType<T>(
+          SoftmaxCPUKernel<T>(SoftmaxCPUDefault<T, is_test>));
+      tuner->AddCallBack(SoftmaxCPUKernel<T>(SoftmaxCPUEigen<T, is_test>));
+      if (std::is_same<T, float>::value) {
+        tuner->AddCallBack(SoftmaxCPUKernel<T>(SoftmaxCPUJit));
+      }
+      return tuner;
+    }();
+    return tuner;
+  }
+};
+
 template <typename DeviceContext, typename T, bool is_test>
 class SoftmaxFunctor<DeviceContext, T, is_test, enable_if_CPU<DeviceContext>> {
  public:
@@ -235,36 +329,24 @@ class SoftmaxFunctor<DeviceContext, T, is_test, enable_if_CPU<DeviceContext>> {
                   const int axis_dim,
                   const framework::Tensor* X,
                   framework::Tensor* Y) {
-    const auto& in_dims = X->dims();
-    constexpr int kBatchDim = 0;
-    constexpr int kClassDim = 1;
-
-    const int num_classes = in_dims[kClassDim];
-    const int batch_size = in_dims[kBatchDim];
-    const int num_remain = num_classes / axis_dim;
-
-    if (num_remain == 1 && platform::MayIUse(platform::avx)) {
-      const T* in_data = X->data<T>();
-      T* out_data = Y->data<T>();
-      for (int bs = 0; bs < batch_size; ++bs) {
-        T max_val = *std::max_element(in_data, in_data + num_classes);
-        max_val *= static_cast<T>(-1);
-        vec_add_bias<T, platform::avx>(num_classes, max_val, in_data, out_data);
-        vec_clip<T, platform::avx>(
-            num_classes, static_cast<T>(-64), out_data, out_data);
-        vec_exp<T>(num_classes, out_data, out_data);
-
-        T sum = 0;
-        vec_sum<T, platform::avx>(num_classes, out_data, &sum);
-        sum = static_cast<T>(1) / sum;
-        vec_scal<T, platform::avx>(num_classes, sum, out_data, out_data);
-
-        in_data += num_classes;
-        out_data += num_classes;
-      }
-    } else {
-      SoftmaxEigen<DeviceContext, T, is_test>()(context, axis_dim, X, Y);
+    constexpr auto kAlgo = phi::autotune::AlgorithmType::kCpuSoftmax;
+    size_t key = phi::autotune::GetKey(phi::vectorize(X->dims()),
+                                       axis_dim,
+                                       static_cast<int64_t>(X->dtype()),
+                                       is_test,
+                                       context.GetIntraOpNumThreads());
+    auto* tuner = SoftmaxCPUTuner<T, is_test>::Instance();
+    if (phi::autotune::AutoTuneStatus::Instance().UseAutoTune() &&
+        !phi::autotune::AutoTuneCache::Instance().Get(kAlgo).Find(key)) {
+      // The candidates run several times while tuning, and Y may be X for
+      // the inplace softmax, so they write to a scratch output instead.
+      framework::Tensor scratch;
+      scratch.Resize(Y->dims());
+      context.template Alloc<T>(&scratch);
+      tuner->Run(context, kAlgo, key, context, axis_dim, X, &scratch);
     }
+    // Runs the tuned kernel once, or the default one when not tuning.
+    tuner->Run(context, kAlgo, key, context, axis_dim, X, Y);
   }
 };
 
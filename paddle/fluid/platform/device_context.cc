@@ -23,6 +23,7 @@ limitations under the License. */
 #include "paddle/fluid/framework/generator.h"
 #include "paddle/fluid/memory/allocation/allocator_facade.h"
 #include "paddle/fluid/platform/device/device_wrapper.h"
+#include "paddle/fluid/platform/flags.h"
 #include "paddle/fluid/platform/place.h"
 #include "paddle/fluid/platform/profiler.h"
 #include "paddle/fluid/platform/profiler/event_tracing.h"
@@ -40,6 +41,8 @@ limitations under the License. */
 #include "paddle/fluid/platform/device/mlu/device_context_allocator.h"
 #endif
 
+DECLARE_int32(cpu_intra_op_num_threads);
+
 namespace paddle {
 namespace memory {
 
@@ -214,6 +217,12 @@ std::unique_ptr<DeviceContext> CreateDeviceContext(
     dev_ctx->SetAllocator(
         memory::allocation::AllocatorFacade::Instance().GetAllocator(p).get());
     dev_ctx->SetGenerator(framework::DefaultCPUGenerator().get());
+    if (is_cpu_place(p)) {
+      auto* cpu_ctx = dynamic_cast<phi::CPUContext*>(dev_ctx);
+      if (cpu_ctx != nullptr) {
+        cpu_ctx->SetIntraOpNumThreads(FLAGS_cpu_intra_op_num_threads);
+      }
+    }
   }
   dev_ctx->SetHostGenerator(framework::DefaultCPUGenerator().get());
   dev_ctx->SetHostAllocator(memory::allocation::AllocatorFacade::Instance()
@@ -54,6 +54,88 @@ PADDLE_DEFINE_EXPORTED_int32(paddle_num_threads,
                              1,
                              "Number of threads for each paddle instance.");
 
+/**
+ * Operator related FLAG
+ * Name: FLAGS_cpu_intra_op_num_threads
+ * Since Version: 2.4.0
+ * Value Range: int32, default=1
+ * Example: FLAGS_cpu_intra_op_num_threads=4, the elementwise, cast,
+ * transpose, reduce and broadcast CPU kernels split their large tensors over
+ * 4 threads
+ * Note: The threads are owned by each CPU device context and are not shared
+ * with the math library threads set by FLAGS_paddle_num_threads.
+ */
+PADDLE_DEFINE_EXPORTED_int32(cpu_intra_op_num_threads,
+                             1,
+                             "Number of intra op threads of the CPU kernels.");
+
+/**
+ * Dygraph related FLAG
+ * Name: FLAGS_eager_backward_num_threads
+ * Since Version: 2.4.0
+ * Value Range: int32, default=1
+ * Example: FLAGS_eager_backward_num_threads=4, the independent grad nodes of
+ * a CPU backward run concurrently on 4 threads
+ * Note: Only takes effect on paddle.autograd.backward and Tensor.backward of
+ * CPU tensors without create_graph. The gradient hooks must be thread safe.
+ */
+PADDLE_DEFINE_EXPORTED_int32(eager_backward_num_threads,
+                             1,
+                             "Number of threads running the grad nodes of "
+                             "an eager backward.");
+
+/**
+ * Dygraph related FLAG
+ * Name: FLAGS_dygraph_dispatch_cache
+ * Since Version: 2.4.0
+ * Value Range: bool, default=true
+ * Example: FLAGS_dygraph_dispatch_cache=false, every op traced in dygraph
+ * chooses its kernel again
+ * Note: If set, an op traced again with inputs and outputs of the same types,
+ * data types, layouts, places and ranks and with the same attributes, other
+ * than the float ones, runs the kernel chosen the first time. Of the float
+ * and double vector attributes only whether they are empty is compared. Not
+ * used with MKLDNN. The C++ APIs run by the eager forward functions also
+ * keep the kernels they selected for each kernel key.
+ */
+PADDLE_DEFINE_EXPORTED_bool(dygraph_dispatch_cache,
+                            true,
+                            "Reuse the kernel chosen for an op of dygraph "
+                            "traced again with the same kind of inputs and "
+                            "the same attributes.");
+
+/**
+ * Operator related FLAG
+ * Name: FLAGS_use_builtin_cpu_gemm
+ * Since Version: 2.4.0
+ * Value Range: bool, default=true
+ * Example: FLAGS_use_builtin_cpu_gemm=false, the float GEMMs of the CPU
+ * kernels run on the CBLAS library the build links, like OpenBLAS
+ * Note: Only takes effect without MKL, whose GEMMs are always used, and for
+ * the float GEMMs on a CPU with AVX2, AVX512 or NEON. The others always run
+ * on the CBLAS library.
+ */
+PADDLE_DEFINE_EXPORTED_bool(use_builtin_cpu_gemm,
+                            true,
+                            "Whether the float CPU GEMMs of the builds without "
+                            "MKL run on the GEMM built in Paddle.");
+
+/**
+ * Operator related FLAG
+ * Name: FLAGS_sparse_conv_rulebook_cache
+ * Since Version: 2.4.0
+ * Value Range: bool, default=true
+ * Example: FLAGS_sparse_conv_rulebook_cache=false, every CPU sparse conv3d
+ * and pooling builds its rulebook
+ * Note: If set, the CPU sparse conv3d and pooling reuse the rulebooks of the
+ * last 8 calls on indices of the same values with the same window, which
+ * costs a hash and a compare of the indices in every call.
+ */
+PADDLE_DEFINE_EXPORTED_bool(sparse_conv_rulebook_cache,
+                            true,
+                            "Whether the CPU sparse conv3d and pooling reuse "
+                            "the rulebooks of the recent calls.");
+
 /**
  * Operator related FLAG
  * Name: FLAGS_check_nan_inf
@@ -391,6 +473,24 @@ PADDLE_DEFINE_EXPORTED_bool(
     "Fast eager deletion mode. If enabled, memory would release "
     "immediately without waiting GPU kernel ends.");
 
+/**
+ * Memory related FLAG
+ * Name: FLAGS_async_cpu_garbage_collection
+ * Since Version: 2.4
+ * Value Range: bool, default=false
+ * Example:
+ * Note: Whether the CPU garbage collectors of Executor and ParallelExecutor
+ *       release the memory on a background thread. If set, the compute
+ *       threads hand their garbage over without taking a lock, and the
+ *       background thread releases it in batches.
+ *       Only works when garbage collection strategy is enabled.
+ */
+PADDLE_DEFINE_EXPORTED_bool(
+    async_cpu_garbage_collection,
+    false,
+    "Release the memory of the CPU garbage collectors on a background "
+    "thread.");
+
 /**
  * Memory related FLAG
  * Name: FLAGS_memory_fraction_of_eager_deletion
@@ -931,3 +1031,19 @@ PADDLE_DEFINE_EXPORTED_bool(
 PADDLE_DEFINE_EXPORTED_string(jit_engine_type,
                               "PE",
                               "Choose default funciton type in JitLayer.");
+
+/**
+ * JitLayer related FLAG
+ * Name: FLAGS_jit_mmap_params
+ * Since Version: 2.4.0
+ * Value Range: bool, default=true
+ * Example:
+ * Note: If True, jit::Load memory maps the parameters file of the model
+ * instead of reading it. The parameters alias the mapped pages on the CPU,
+ * are shared by the Layers loaded from the same file, and are copied to
+ * another place by the Layer.
+ */
+PADDLE_DEFINE_EXPORTED_bool(
+    jit_mmap_params,
+    true,
+    "Whether to memory map the parameters of the models loaded by jit.");
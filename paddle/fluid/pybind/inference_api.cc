@@ -672,6 +672,19 @@ void BindAnalysisConfig(py::module *m) {
       .def("enable_memory_optim",
            &AnalysisConfig::EnableMemoryOptim,
            py::arg("x") = true)
+      .def("enable_memory_mapped_params",
+           &AnalysisConfig::EnableMemoryMappedParams,
+           py::arg("x") = true,
+           py::arg("lazy_load") = true)
+      .def("memory_mapped_params_enabled",
+           &AnalysisConfig::memory_mapped_params_enabled)
+      .def("enable_optimized_program_cache",
+           &AnalysisConfig::EnableOptimizedProgramCache,
+           py::arg("cache_dir"))
+      .def("optimized_program_cache_enabled",
+           &AnalysisConfig::optimized_program_cache_enabled)
+      .def("optimized_program_cache_dir",
+           &AnalysisConfig::optimized_program_cache_dir)
       .def("enable_profile", &AnalysisConfig::EnableProfile)
       .def("disable_glog_info", &AnalysisConfig::DisableGlogInfo)
       .def("glog_info_disabled", &AnalysisConfig::glog_info_disabled)
@@ -14,6 +14,10 @@
 
 #include "paddle/phi/backends/cpu/cpu_context.h"
 
+#include <algorithm>
+#include <exception>
+#include <mutex>
+
 #include "paddle/phi/common/place.h"
 #include "paddle/phi/core/enforce.h"
 
@@ -21,6 +25,7 @@
 // without eigen.
 #include "paddle/phi/core/device_context.h"
 #include "unsupported/Eigen/CXX11/Tensor"
+#include "unsupported/Eigen/CXX11/ThreadPool"
 
 namespace phi {
 
@@ -48,11 +53,68 @@ struct CPUContext::Impl {
     return eigen_device_;
   }
 
+  void SetIntraOpNumThreads(int num_threads) {
+    PADDLE_ENFORCE_GE(
+        num_threads,
+        1,
+        phi::errors::InvalidArgument(
+            "The number of intra op threads should be at least 1, but "
+            "received %d.",
+            num_threads));
+    if (num_threads == intra_op_num_threads_) return;
+    intra_op_num_threads_ = num_threads;
+    // The calling thread runs a block too.
+    intra_op_pool_.reset(
+        num_threads > 1 ? new Eigen::ThreadPool(num_threads - 1) : nullptr);
+  }
+
+  void ParallelFor(int64_t n,
+                   int64_t grain_size,
+                   const std::function<void(int64_t, int64_t)>& func) const {
+    if (n <= 0) return;
+    grain_size = std::max<int64_t>(grain_size, 1);
+    auto* pool = intra_op_pool_.get();
+    if (pool == nullptr || n <= grain_size || pool->CurrentThreadId() != -1) {
+      func(0, n);
+      return;
+    }
+    int64_t num_blocks = std::min<int64_t>(intra_op_num_threads_,
+                                           (n + grain_size - 1) / grain_size);
+    int64_t block_size = (n + num_blocks - 1) / num_blocks;
+    num_blocks = (n + block_size - 1) / block_size;
+
+    // The exceptions are rethrown on the calling thread, the first one wins.
+    std::exception_ptr error;
+    std::mutex error_mutex;
+    auto run_block = [&](int64_t i) {
+      try {
+        func(i * block_size, std::min(n, (i + 1) * block_size));
+      } catch (...) {
+        std::lock_guard<std::mutex> guard(error_mutex);
+        if (!error) error = std::current_exception();
+      }
+    };
+    Eigen::Barrier barrier(static_cast<unsigned int>(num_blocks - 1));
+    for (int64_t i = 1; i < num_blocks; ++i) {
+      pool->Schedule([&, i] {
+        run_block(i);
+        barrier.Notify();
+      });
+    }
+    run_block(0);
+    barrier.Wait();
+    if (error) std::rethrow_exception(error);
+  }
+
   bool owned_{false};
   Eigen::DefaultDevice* eigen_device_{nullptr};
   Place place_;
+  int intra_op_num_threads_{1};
+  std::unique_ptr<Eigen::ThreadPool> intra_op_pool_;
 };
 
+constexpr int64_t CPUContext::kDefaultGrainSize;
+
 CPUContext::CPUContext()
     : DeviceContext(), impl_(std::make_unique<CPUContext::Impl>()) {
   impl_->Init();
@@ -75,6 +137,21 @@ Eigen::DefaultDevice* CPUContext::eigen_device() const {
 
 const Place& CPUContext::GetPlace() const { return impl_->place_; }
 
+int CPUContext::GetIntraOpNumThreads() const {
+  return impl_->intra_op_num_threads_;
+}
+
+void CPUContext::SetIntraOpNumThreads(int num_threads) {
+  impl_->SetIntraOpNumThreads(num_threads);
+}
+
+void CPUContext::ParallelFor(
+    int64_t n,
+    int64_t grain_size,
+    const std::function<void(int64_t, int64_t)>& func) const {
+  impl_->ParallelFor(n, grain_size, func);
+}
+
 void CPUContext::SetEigenDevice(Eigen::DefaultDevice* device) {
   impl_->eigen_device_ = device;
 }
@@ -14,6 +14,7 @@ limitations under the License. */
 
 #pragma once
 
+#include <functional>
 #include <memory>
 
 #include "paddle/phi/backends/cpu/forwards.h"
@@ -34,6 +35,24 @@ class PADDLE_API CPUContext : public DeviceContext {
   Eigen::DefaultDevice* eigen_device() const;
   const Place& GetPlace() const override;
 
+  // The number of elements below which splitting a simple loop over the
+  // intra op threads costs more than it saves.
+  static constexpr int64_t kDefaultGrainSize = 32768;
+
+  // The number of threads a kernel may split a single operator across,
+  // including the calling thread. It is 1 by default, for which no thread is
+  // created and ParallelFor runs inline.
+  int GetIntraOpNumThreads() const;
+  void SetIntraOpNumThreads(int num_threads);
+
+  // Call func(begin, end) on blocks covering [0, n), each of at least
+  // grain_size elements, on the intra op threads, and wait for all of them.
+  // It runs inline when n is at most grain_size, or when called from an
+  // intra op thread.
+  void ParallelFor(int64_t n,
+                   int64_t grain_size,
+                   const std::function<void(int64_t, int64_t)>& func) const;
+
  protected:
   // NOTE: External users manage resources. Used in inference scenarios.
   // The Set interface is for inference only, DeviceContext will mark the
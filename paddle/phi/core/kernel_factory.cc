@@ -14,9 +14,12 @@
 
 #include "paddle/phi/core/kernel_factory.h"
 
+#include "gflags/gflags.h"
 #include "glog/logging.h"
 #include "paddle/phi/core/enforce.h"
 
+DECLARE_bool(dygraph_dispatch_cache);
+
 namespace phi {
 
 const static Kernel empty_kernel;  // NOLINT
@@ -138,6 +141,23 @@ const Kernel& KernelFactory::SelectKernelOrThrowError(
                                   KernelKey(backend, layout, dtype));
 }
 
+const Kernel& KernelSelectCache::Select(const KernelKey& kernel_key,
+                                        bool use_gpudnn) {
+  if (!FLAGS_dygraph_dispatch_cache) {
+    return KernelFactory::Instance().SelectKernelOrThrowError(
+        kernel_name_, kernel_key, use_gpudnn);
+  }
+  for (const auto& entry : entries_) {
+    if (entry.kernel_key == kernel_key && entry.use_gpudnn == use_gpudnn) {
+      return entry.kernel;
+    }
+  }
+  const Kernel& kernel = KernelFactory::Instance().SelectKernelOrThrowError(
+      kernel_name_, kernel_key, use_gpudnn);
+  entries_.push_back(Entry{kernel_key, use_gpudnn, kernel});
+  return entries_.back().kernel;
+}
+
 const KernelArgsDef& KernelFactory::GetFirstKernelArgsDef(
     const std::string& kernel_name) const {
   auto iter = kernels_.find(kernel_name);
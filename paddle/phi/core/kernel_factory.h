@@ -14,6 +14,7 @@
 
 #pragma once
 
+#include <deque>
 #include <ostream>
 #include <string>
 #include <unordered_map>
@@ -294,6 +295,36 @@ class KernelFactory {
   KernelNameMap kernels_;
 };
 
+/**
+ * The kernels of one name selected by a call site, by key.
+ *
+ * The generated C++ APIs, which the eager forward functions call, select
+ * a kernel of a fixed name on every call. Each call site keeps a
+ * thread_local cache, so that with FLAGS_dygraph_dispatch_cache a key seen
+ * before skips finding the name in the factory and the fallbacks of
+ * SelectKernelOrThrowError. The kernels are kept by value, since the maps
+ * of the factory may move them when kernels are registered later. There
+ * are as many entries as the keys the call site saw, a few at most.
+ */
+class KernelSelectCache {
+ public:
+  explicit KernelSelectCache(const char* kernel_name)
+      : kernel_name_(kernel_name) {}
+
+  const Kernel& Select(const KernelKey& kernel_key, bool use_gpudnn = false);
+
+ private:
+  struct Entry {
+    KernelKey kernel_key;
+    bool use_gpudnn;
+    Kernel kernel;
+  };
+
+  std::string kernel_name_;
+  // A deque, whose elements stay in place while it grows.
+  std::deque<Entry> entries_;
+};
+
 inline std::ostream& operator<<(std::ostream& os, const KernelKey& kernel_key) {
   os << "(" << kernel_key.backend() << ", " << kernel_key.layout() << ", "
      << kernel_key.dtype() << ")";
@@ -16,8 +16,12 @@
 
 #include <type_traits>
 #include "glog/logging.h"
-#include "paddle/phi/kernels/autotune/gpu_timer.h"
+#include "paddle/phi/backends/cpu/cpu_context.h"
+#include "paddle/phi/kernels/autotune/cpu_timer.h"
 #include "paddle/phi/kernels/autotune/switch_autotune.h"
+#if defined(PADDLE_WITH_CUDA) || defined(PADDLE_WITH_HIP)
+#include "paddle/phi/kernels/autotune/gpu_timer.h"
+#endif
 
 namespace phi {
 namespace autotune {
@@ -74,8 +78,15 @@ class AutoTuneBase {
     is_init_ = true;
 
     auto& cache = AutoTuneCache::Instance().Get(algo);
-    if (cache.Find(key)) {
-      auto best_idx = cache.Get(key);
+    // An index loaded by AutoTuneCache::Load may come from a build with
+    // another list of kernels, and is dropped when out of range.
+    int64_t best_idx = cache.Find(key) ? cache.Get(key) : -1;
+    if (best_idx >= static_cast<int64_t>(kernels_.size())) {
+      VLOG(3) << "Drop the cached kernel idx " << best_idx << " out of the "
+              << kernels_.size() << " kernels.";
+      best_idx = -1;
+    }
+    if (best_idx >= 0) {
       kernels_[best_idx].Run(args...);
     } else {
       bool use_autotune = AutoTuneStatus::Instance().UseAutoTune();
@@ -108,7 +119,7 @@ class AutoTuneBase {
 
     // Time cost test estabulished in default stream.
     for (int i = 0; i < kernels_.size(); ++i) {
-      auto time = RunAndMeasureKernel<Context>(ctx, i, args...);
+      auto time = RunAndMeasureKernel(ctx, i, args...);
       if (time < min_time) {
         min_time = time;
         best_idx = i;
@@ -118,6 +129,7 @@ class AutoTuneBase {
     return best_idx;
   }
 
+#if defined(PADDLE_WITH_CUDA) || defined(PADDLE_WITH_HIP)
   template <typename Context, typename... Args>
   float RunAndMeasureKernel(const Context& ctx, const int idx, Args&&... args) {
     // Regard 1st run as warmup. Judge the result by the time cost of rest run
@@ -140,6 +152,28 @@ class AutoTuneBase {
     }
     return time_cost;
   }
+#endif
+
+  template <typename... Args>
+  float RunAndMeasureKernel(const phi::CPUContext& ctx,
+                            const int idx,
+                            Args&&... args) {
+    // The same warmup as above, timed by the wall clock.
+    constexpr int repeats = 3;
+    phi::CpuTimer timer;
+    float time_cost = 0;
+    for (int i = 0; i < repeats; ++i) {
+      timer.Start();
+      kernels_[idx].Run(args...);
+      timer.Stop();
+      auto time = timer.ElapsedTime();
+      if (i > 0) {
+        time_cost += time;
+      }
+      VLOG(3) << "kernel[" << idx << "][" << i << "th time cost is " << time;
+    }
+    return time_cost;
+  }
 };
 
 template <typename T, typename RetureType, typename... Args>
@@ -174,5 +208,44 @@ MakeTransposeTuner(RetureType (*func)(Args...)) {
   return TransposeAutoTuner<T, decltype(obj)>::Instance(obj);
 }
 
+// The tuner of the CPU kernels of algo, one for each T and signature. The
+// first kernel is the default one, run when autotune is off and the key is
+// not in the cache. The keys of the CPU kernels should include the number of
+// intra op threads of the context, on which the fastest kernel depends.
+template <AlgorithmType algo, typename T, typename KernelType>
+class CpuAutoTuner : public AutoTuneBase<T, KernelType> {
+ public:
+  template <typename... Kernels>
+  static AutoTuneBase<T, KernelType>* Instance(KernelType kernel,
+                                               Kernels... others) {
+    static std::unique_ptr<AutoTuneBase<T, KernelType>> instance_;
+    std::call_once(init_flag_, [&] {
+      instance_.reset(new AutoTuneBase<T, KernelType>(kernel));
+      // Expands the calls in order in the initializer list.
+      int unused[] = {0, (instance_->AddCallBack(KernelType(others)), 0)...};
+      (void)unused;
+    });
+    return instance_.get();
+  }
+
+ private:
+  static std::once_flag init_flag_;
+};
+
+template <AlgorithmType algo, typename T, typename KernelType>
+std::once_flag CpuAutoTuner<algo, T, KernelType>::init_flag_;
+
+template <AlgorithmType algo,
+          typename T,
+          typename RetureType,
+          typename... Args,
+          typename... Funcs>
+static AutoTuneBase<T, KernelCallback<T, RetureType, Args...>>* MakeCpuTuner(
+    RetureType (*func)(Args...), Funcs... others) {
+  using KernelType = KernelCallback<T, RetureType, Args...>;
+  return CpuAutoTuner<algo, T, KernelType>::Instance(KernelType(func),
+                                                     others...);
+}
+
 }  // namespace autotune
 }  // namespace phi
@@ -14,13 +14,19 @@
 
 #include "paddle/phi/kernels/autotune/cache.h"
 
+#include <cstdio>
+#include <fstream>
 #include <iomanip>
+#include <random>
+#include <sstream>
 
 #include "glog/logging.h"
 
 namespace phi {
 namespace autotune {
 
+static const char kCacheFileHeader[] = "# paddle autotune cache v1";
+
 // Define the cache key of operator
 size_t ConvKey(const std::vector<int64_t>& x_dims,
                const std::vector<int64_t>& w_dims,
@@ -52,10 +58,91 @@ std::string AlgorithmTypeString(int64_t algo_type) {
   } else if (algo_type ==
              static_cast<int64_t>(AlgorithmType::kConvBackwardFilter)) {
     return "conv_backward_filter";
+  } else if (algo_type ==
+             static_cast<int64_t>(AlgorithmType::kCpuConvForward)) {
+    return "cpu_conv_forward";
+  } else if (algo_type == static_cast<int64_t>(AlgorithmType::kCpuTranspose)) {
+    return "cpu_transpose";
+  } else if (algo_type == static_cast<int64_t>(AlgorithmType::kCpuSoftmax)) {
+    return "cpu_softmax";
   }
   return std::to_string(algo_type);
 }
 
+void AutoTuneCache::Save(const std::string& path) {
+  // Written aside and renamed, so that the readers never see half a file.
+  // The name is unique, as the predictors of a model may save at once.
+  std::string tmp_path =
+      path + ".tmp." + std::to_string(std::random_device()());
+  std::ofstream fout(tmp_path);
+  PADDLE_ENFORCE_EQ(fout.is_open(),
+                    true,
+                    phi::errors::Unavailable(
+                        "Cannot open %s to save the autotune cache.", path));
+  fout << kCacheFileHeader << "\n";
+  int64_t count = 0;
+  for (auto& v : auto_tune_map_) {
+    for (const auto& item : v.second.Items()) {
+      fout << v.first << " " << item.first << " " << item.second << "\n";
+      ++count;
+    }
+  }
+  fout.close();
+  bool saved =
+      !fout.fail() && std::rename(tmp_path.c_str(), path.c_str()) == 0;
+  if (!saved) std::remove(tmp_path.c_str());
+  PADDLE_ENFORCE_EQ(
+      saved,
+      true,
+      phi::errors::Unavailable("Failed to save the autotune cache to %s.",
+                               path));
+  VLOG(3) << "Saved " << count << " autotuned algorithms to " << path;
+}
+
+int64_t AutoTuneCache::Load(const std::string& path) {
+  std::ifstream fin(path);
+  PADDLE_ENFORCE_EQ(
+      fin.is_open(),
+      true,
+      phi::errors::NotFound("Cannot open the autotune cache %s.", path));
+  std::string line;
+  PADDLE_ENFORCE_EQ(
+      std::getline(fin, line) && line == kCacheFileHeader,
+      true,
+      phi::errors::InvalidArgument("%s is not an autotune cache.", path));
+  int64_t count = 0;
+  while (std::getline(fin, line)) {
+    if (line.empty()) continue;
+    std::istringstream is(line);
+    int64_t algo_type;
+    size_t key;
+    int64_t algo;
+    PADDLE_ENFORCE_EQ(
+        static_cast<bool>(is >> algo_type >> key >> algo),
+        true,
+        phi::errors::InvalidArgument(
+            "Malformed line '%s' in the autotune cache %s.", line, path));
+    PADDLE_ENFORCE_EQ(
+        algo_type > 0 &&
+            algo_type < static_cast<int64_t>(AlgorithmType::kAlgorithmCount),
+        true,
+        phi::errors::InvalidArgument(
+            "Unknown algorithm type %d in the autotune cache %s.",
+            algo_type,
+            path));
+    if (algo < 0) {
+      LOG(WARNING) << "Drop the invalid algorithm " << algo << " of type "
+                   << AlgorithmTypeString(algo_type)
+                   << " in the autotune cache " << path;
+      continue;
+    }
+    Get(static_cast<AlgorithmType>(algo_type)).Set(key, algo);
+    ++count;
+  }
+  VLOG(3) << "Loaded " << count << " autotuned algorithms from " << path;
+  return count;
+}
+
 void AutoTuneCache::UpdateStatus() {
   int64_t size = 0;
   int64_t cache_hits = 0;
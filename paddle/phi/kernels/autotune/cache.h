@@ -17,6 +17,7 @@
 #include <algorithm>
 #include <mutex>
 #include <numeric>
+#include <string>
 #include <unordered_map>
 #include <vector>
 
@@ -126,6 +127,12 @@ class AlgorithmsCache {
 
   int64_t Size() const { return hash_.size(); }
 
+  // A copy of the cached algorithms, for the serialization of the cache.
+  std::unordered_map<size_t, AlgorithmT> Items() {
+    std::lock_guard<std::mutex> lock(*cache_mutex_);
+    return hash_;
+  }
+
  private:
   std::unordered_map<size_t, AlgorithmT> hash_;
   std::shared_ptr<std::mutex> cache_mutex_;
@@ -139,7 +146,10 @@ enum class AlgorithmType {
   kConvBackwardData = 2,
   kConvBackwardFilter = 3,
   kTranspose = 4,
-  kAlgorithmCount = 5
+  kCpuConvForward = 5,
+  kCpuTranspose = 6,
+  kCpuSoftmax = 7,
+  kAlgorithmCount = 8
 };
 
 // AlgorithmsConfigKey -> AlgorithmsID
@@ -172,6 +182,18 @@ class AutoTuneCache {
 
   AlgorithmsCacheMap& GetTranspose() { return Get(AlgorithmType::kTranspose); }
 
+  AlgorithmsCacheMap& GetCpuConvForward() {
+    return Get(AlgorithmType::kCpuConvForward);
+  }
+
+  AlgorithmsCacheMap& GetCpuTranspose() {
+    return Get(AlgorithmType::kCpuTranspose);
+  }
+
+  AlgorithmsCacheMap& GetCpuSoftmax() {
+    return Get(AlgorithmType::kCpuSoftmax);
+  }
+
   void Clean() {
     for (auto& v : auto_tune_map_) {
       v.second.Clean();
@@ -180,6 +202,18 @@ class AutoTuneCache {
 
   void UpdateStatus();
 
+  // Writes the algorithms of all the caches to a text file, so that a tuned
+  // table can be deployed with a model and restored by Load, skipping the
+  // tuning. The keys are hashes of the shapes, which only match between the
+  // processes of the same Paddle build, and the timings only hold on the
+  // same type of machine.
+  void Save(const std::string& path);
+
+  // Adds the algorithms saved in the file to the caches, and returns their
+  // number. The tuners drop an algorithm they do not have, e.g. one saved
+  // by a build with another list of kernels, and tune or use the default.
+  int64_t Load(const std::string& path);
+
   // The number of total config cached
   int64_t Size() const { return total_size_; }
 
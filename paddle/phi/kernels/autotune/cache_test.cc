@@ -17,7 +17,10 @@
 #include <gtest/gtest.h>
 
 #include <cmath>
+#include <cstdio>
+#include <fstream>
 #include <functional>
+#include <string>
 
 #include "glog/logging.h"
 
@@ -61,3 +64,43 @@ TEST(AlgosCache, AlgosCache) {
   EXPECT_EQ(autotune_cache.CacheMisses(), 2);
   EXPECT_LT(std::abs(cache_hit_rate - autotune_cache.CacheHitRate()), 1e-5);
 }
+
+TEST(AlgosCache, SaveAndLoad) {
+  auto& autotune_cache = phi::autotune::AutoTuneCache::Instance();
+  autotune_cache.Clean();
+  autotune_cache.GetCpuConvForward().Set(1, 3);
+  autotune_cache.GetCpuConvForward().Set(2, 4);
+  autotune_cache.GetCpuTranspose().Set(static_cast<size_t>(-1), 2);
+
+  std::string path = "autotune_cache_test.txt";
+  autotune_cache.Save(path);
+  autotune_cache.Clean();
+  EXPECT_EQ(autotune_cache.GetCpuConvForward().Size(), 0);
+
+  EXPECT_EQ(autotune_cache.Load(path), 3);
+  EXPECT_EQ(autotune_cache.GetCpuConvForward().Size(), 2);
+  EXPECT_EQ(autotune_cache.GetCpuConvForward().Get(1), 3);
+  EXPECT_EQ(autotune_cache.GetCpuConvForward().Get(2), 4);
+  EXPECT_EQ(autotune_cache.GetCpuTranspose().Get(static_cast<size_t>(-1)), 2);
+  autotune_cache.Clean();
+  std::remove(path.c_str());
+}
+
+TEST(AlgosCache, LoadDropsInvalidAlgos) {
+  auto& autotune_cache = phi::autotune::AutoTuneCache::Instance();
+  autotune_cache.Clean();
+  std::string path = "autotune_cache_invalid_test.txt";
+  {
+    std::ofstream fout(path);
+    fout << "# paddle autotune cache v1\n"
+         << static_cast<int>(phi::autotune::AlgorithmType::kCpuTranspose)
+         << " 1 -1\n"
+         << static_cast<int>(phi::autotune::AlgorithmType::kCpuTranspose)
+         << " 2 1\n";
+  }
+  EXPECT_EQ(autotune_cache.Load(path), 1);
+  EXPECT_EQ(autotune_cache.GetCpuTranspose().Size(), 1);
+  EXPECT_EQ(autotune_cache.GetCpuTranspose().Get(2), 1);
+  autotune_cache.Clean();
+  std::remove(path.c_str());
+}
@@ -28,7 +28,12 @@ class AutoTuneStatus {
     return switch_autotune;
   }
 
-  bool UseAutoTune() { return use_autotune_; }
+  bool UseAutoTune() { return use_autotune_ || ThreadAutoTune(); }
+
+  // Turns the autotune on or off for the kernels run by the calling thread
+  // only, e.g. by a predictor asking for it, leaving the rest of the
+  // process alone.
+  static void SetThreadAutoTune(bool on) { ThreadAutoTune() = on; }
 
   // EnableAutoTune and DisableAutoTune should be used for debug only.
   void EnableAutoTune();
@@ -87,6 +92,11 @@ class AutoTuneStatus {
     AutoTuneCache::Instance().Clean();
   }
 
+  static bool& ThreadAutoTune() {
+    static thread_local bool thread_autotune = false;
+    return thread_autotune;
+  }
+
   bool use_autotune_{false};
   int64_t start_step_id_{1};
   int64_t stop_step_id_{10};
@@ -97,5 +107,20 @@ class AutoTuneStatus {
   std::vector<float> step_hit_rates_;
 };
 
+// Turns the autotune of the calling thread on in its scope if on is true.
+class ThreadAutoTuneGuard {
+ public:
+  explicit ThreadAutoTuneGuard(bool on) : on_(on) {
+    if (on_) AutoTuneStatus::SetThreadAutoTune(true);
+  }
+
+  ~ThreadAutoTuneGuard() {
+    if (on_) AutoTuneStatus::SetThreadAutoTune(false);
+  }
+
+ private:
+  bool on_;
+};
+
 }  // namespace autotune
 }  // namespace phi
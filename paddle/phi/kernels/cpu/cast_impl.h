@@ -14,10 +14,10 @@
 
 #pragma once
 
-#include "paddle/phi/backends/cpu/cpu_context.h"
+#include <algorithm>
 
-// See Note [ Why still include the fluid headers? ]
-#include "paddle/fluid/platform/transform.h"
+#include "paddle/phi/backends/cpu/cpu_context.h"
+#include "paddle/phi/core/hostdevice.h"
 
 namespace phi {
 
@@ -32,16 +32,17 @@ void CastKernelImpl(const CPUContext& dev_ctx,
                     DenseTensor* out) {
   auto* in_begin = x.data<InT>();
   auto numel = x.numel();
-  auto* in_end = in_begin + numel;
 
   auto* out_begin = dev_ctx.Alloc<OutT>(out);
 
-  paddle::platform::Transform<CPUContext> trans;
-  trans(dev_ctx,
-        in_begin,
-        in_end,
-        out_begin,
-        CastOpTransformFunctor<InT, OutT>());
+  dev_ctx.ParallelFor(numel,
+                      CPUContext::kDefaultGrainSize,
+                      [&](int64_t begin, int64_t end) {
+                        std::transform(in_begin + begin,
+                                       in_begin + end,
+                                       out_begin + begin,
+                                       CastOpTransformFunctor<InT, OutT>());
+                      });
 }
 
 }  // namespace phi
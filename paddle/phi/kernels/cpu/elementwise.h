@@ -14,6 +14,8 @@ limitations under the License. */
 
 #pragma once
 
+#include <functional>
+
 #include "paddle/phi/backends/cpu/cpu_context.h"
 #include "paddle/phi/core/dense_tensor.h"
 #include "paddle/phi/kernels/funcs/blas/blas.h"
@@ -25,6 +27,47 @@ namespace phi {
 
 // FORWARD CODE
 
+// z = func(x, y) on the elements of x and y of the same shape, split over the
+// intra op threads.
+template <typename T, typename Functor>
+void SameDimsElementwiseLoop(const CPUContext& dev_ctx,
+                             const DenseTensor& x,
+                             const DenseTensor& y,
+                             DenseTensor* z,
+                             Functor func) {
+  const T* x_data = x.data<T>();
+  const T* y_data = y.data<T>();
+  T* z_data = dev_ctx.template Alloc<T>(z);
+  dev_ctx.ParallelFor(x.numel(),
+                      CPUContext::kDefaultGrainSize,
+                      [&](int64_t begin, int64_t end) {
+                        for (int64_t i = begin; i < end; ++i) {
+                          z_data[i] = func(x_data[i], y_data[i]);
+                        }
+                      });
+}
+
+// Call the blas vector function vfunc(n, x, y, z) on the blocks of the
+// intra op threads.
+template <typename T, typename VFunc>
+void SameDimsBlasLoop(const CPUContext& dev_ctx,
+                      const DenseTensor& x,
+                      const DenseTensor& y,
+                      DenseTensor* z,
+                      VFunc vfunc) {
+  const T* x_data = x.data<T>();
+  const T* y_data = y.data<T>();
+  T* z_data = dev_ctx.template Alloc<T>(z);
+  dev_ctx.ParallelFor(x.numel(),
+                      CPUContext::kDefaultGrainSize,
+                      [&](int64_t begin, int64_t end) {
+                        vfunc(static_cast<int>(end - begin),
+                              x_data + begin,
+                              y_data + begin,
+                              z_data + begin);
+                      });
+}
+
 // Add
 template <typename DevCtx, typename T, class Enable = void>
 struct SameDimsAddFunctor {
@@ -44,8 +87,10 @@ struct SameDimsAddFunctor<
                   const DenseTensor& y,
                   DenseTensor* z) {
     auto blas = phi::funcs::GetBlas<DevCtx, T>(dev_ctx);
-    blas.VADD(
-        x.numel(), x.data<T>(), y.data<T>(), dev_ctx.template Alloc<T>(z));
+    SameDimsBlasLoop<T>(
+        dev_ctx, x, y, z, [&](int n, const T* a, const T* b, T* c) {
+          blas.VADD(n, a, b, c);
+        });
   }
 };
 
@@ -58,12 +103,7 @@ struct SameDimsAddFunctor<
                   const DenseTensor& x,
                   const DenseTensor& y,
                   DenseTensor* z) {
-    dev_ctx.template Alloc<T>(z);
-    auto eigen_x = phi::EigenVector<T>::Flatten(x);
-    auto eigen_y = phi::EigenVector<T>::Flatten(y);
-    auto eigen_z = phi::EigenVector<T>::Flatten(*z);
-    auto& place = *dev_ctx.eigen_device();
-    eigen_z.device(place) = eigen_x + eigen_y;
+    SameDimsElementwiseLoop<T>(dev_ctx, x, y, z, std::plus<T>());
   }
 };
 
@@ -86,8 +126,10 @@ struct SameDimsSubtractFunctor<
                   const DenseTensor& y,
                   DenseTensor* z) {
     auto blas = phi::funcs::GetBlas<DevCtx, T>(dev_ctx);
-    blas.VSUB(
-        x.numel(), x.data<T>(), y.data<T>(), dev_ctx.template Alloc<T>(z));
+    SameDimsBlasLoop<T>(
+        dev_ctx, x, y, z, [&](int n, const T* a, const T* b, T* c) {
+          blas.VSUB(n, a, b, c);
+        });
   }
 };
 
@@ -100,11 +142,7 @@ struct SameDimsSubtractFunctor<
                   const DenseTensor& x,
                   const DenseTensor& y,
                   DenseTensor* z) {
-    auto eigen_x = phi::EigenVector<T>::Flatten(x);
-    auto eigen_y = phi::EigenVector<T>::Flatten(y);
-    auto eigen_z = phi::EigenVector<T>::Flatten(*z);
-    auto& place = *dev_ctx.eigen_device();
-    eigen_z.device(place) = eigen_x - eigen_y;
+    SameDimsElementwiseLoop<T>(dev_ctx, x, y, z, std::minus<T>());
   }
 };
 
@@ -142,8 +180,10 @@ struct SameDimsDivideFunctor<
                   const DenseTensor& y,
                   DenseTensor* z) {
     auto blas = phi::funcs::GetBlas<DevCtx, T>(dev_ctx);
-    blas.VDIV(
-        x.numel(), x.data<T>(), y.data<T>(), dev_ctx.template Alloc<T>(z));
+    SameDimsBlasLoop<T>(
+        dev_ctx, x, y, z, [&](int n, const T* a, const T* b, T* c) {
+          blas.VDIV(n, a, b, c);
+        });
   }
 };
 
@@ -166,8 +206,10 @@ struct SameDimsMultiplyFunctor<
                   const DenseTensor& y,
                   DenseTensor* z) {
     auto blas = phi::funcs::GetBlas<DevCtx, T>(dev_ctx);
-    blas.VMUL(
-        x.numel(), x.data<T>(), y.data<T>(), dev_ctx.template Alloc<T>(z));
+    SameDimsBlasLoop<T>(
+        dev_ctx, x, y, z, [&](int n, const T* a, const T* b, T* c) {
+          blas.VMUL(n, a, b, c);
+        });
   }
 };
 
@@ -180,11 +222,7 @@ struct SameDimsMultiplyFunctor<
                   const DenseTensor& x,
                   const DenseTensor& y,
                   DenseTensor* z) {
-    auto eigen_x = phi::EigenVector<T>::Flatten(x);
-    auto eigen_y = phi::EigenVector<T>::Flatten(y);
-    auto eigen_z = phi::EigenVector<T>::Flatten(*z);
-    auto& place = *dev_ctx.eigen_device();
-    eigen_z.device(place) = eigen_x * eigen_y;
+    SameDimsElementwiseLoop<T>(dev_ctx, x, y, z, std::multiplies<T>());
   }
 };
 
@@ -17,6 +17,7 @@
 #include "paddle/phi/backends/cpu/cpu_context.h"
 #include "paddle/phi/core/kernel_registry.h"
 #include "paddle/phi/kernels/funcs/mode.h"
+#include "paddle/phi/kernels/funcs/sort_function.h"
 
 namespace phi {
 
@@ -40,12 +41,12 @@ void ModeKernel(const Context& dev_ctx,
     const int64_t& input_height =
         phi::product(phi::slice_ddim(in_dims, 0, in_dims.size() - 1));
     const int64_t& input_width = in_dims[in_dims.size() - 1];
-    funcs::GetMode<T, int64_t>(input_height,
-                               input_width,
-                               in_dims.size(),
-                               &x,
-                               output_data,
-                               indices_data);
+    funcs::ModeRows<T>(dev_ctx,
+                       x.data<T>(),
+                       input_height,
+                       input_width,
+                       output_data,
+                       indices_data);
   } else {
     std::vector<int> trans_axis;
     for (int i = 0; i < axis; i++) {
@@ -101,8 +102,12 @@ void ModeKernel(const Context& dev_ctx,
     tmp_indices.Resize(trans_out_shape);
     int64_t* t_ind = dev_ctx.template Alloc<int64_t>(&tmp_indices);
 
-    funcs::GetMode<T, int64_t>(
-        input_height, input_width, in_dims.size(), &trans_input, t_out, t_ind);
+    funcs::ModeRows<T>(dev_ctx,
+                       trans_input.data<T>(),
+                       input_height,
+                       input_width,
+                       t_out,
+                       t_ind);
     // transpose back
     funcs::TransCompute<CPUContext, int64_t>(
         ndims, dev_ctx, tmp_indices, indices, trans_axis);
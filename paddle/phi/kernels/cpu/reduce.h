@@ -14,7 +14,9 @@
 
 #pragma once
 
+#include <algorithm>
 #include <set>
+#include <type_traits>
 
 #include "paddle/phi/backends/cpu/cpu_context.h"
 #include "paddle/phi/core/dense_tensor.h"
@@ -68,10 +70,123 @@ void ReduceFunctor(const DeviceContext& context,
   }
 }
 
-#define HANDLE_REDUCE_DIM(NDIM, RDIM)                        \
-  if (ndim == NDIM && rdim == RDIM) {                        \
-    ReduceFunctor<DeviceContext, OutT, NDIM, RDIM, Functor>( \
-        dev_ctx, input, output, dims, keep_dim);             \
+// Split the input along the dimension split, which is not reduced, into
+// blocks reduced on the intra op threads. Each block of the input reduces to
+// the matching block of the output, so any reduce functor works unchanged.
+template <typename DeviceContext,
+          typename T,
+          size_t D,
+          size_t R_D,
+          typename Functor>
+void ReduceFunctorOnBlocks(const DeviceContext& context,
+                           const phi::DenseTensor& input,
+                           phi::DenseTensor* output,
+                           const std::vector<int64_t>& dims,
+                           bool keep_dim,
+                           int split,
+                           std::true_type) {
+  auto x = EigenTensor<T, D>::From(input);
+  auto reduce_dim = Eigen::array<int, R_D>();
+  std::vector<bool> reduced(D, false);
+  for (size_t i = 0; i < dims.size(); ++i) {
+    int dim = dims[i] < 0 ? D + dims[i] : dims[i];
+    reduce_dim[i] = dim;
+    reduced[dim] = true;
+  }
+  std::vector<int64_t> out_dims;
+  int out_split = 0;
+  for (int i = 0; i < static_cast<int>(D); ++i) {
+    if (reduced[i]) continue;
+    if (i == split) out_split = out_dims.size();
+    out_dims.push_back(input.dims()[i]);
+  }
+  auto out = EigenTensor<T, D - R_D>::From(*output, phi::make_ddim(out_dims));
+
+  const int64_t extent = input.dims()[split];
+  const int64_t grain_size = std::max<int64_t>(
+      1, CPUContext::kDefaultGrainSize / (input.numel() / extent));
+  auto& place = *context.eigen_device();
+  context.ParallelFor(extent, grain_size, [&](int64_t begin, int64_t end) {
+    Eigen::DSizes<Eigen::DenseIndex, D> x_offsets;
+    Eigen::DSizes<Eigen::DenseIndex, D> x_extents = x.dimensions();
+    x_offsets[split] = begin;
+    x_extents[split] = end - begin;
+    Eigen::DSizes<Eigen::DenseIndex, D - R_D> out_offsets;
+    Eigen::DSizes<Eigen::DenseIndex, D - R_D> out_extents = out.dimensions();
+    out_offsets[out_split] = begin;
+    out_extents[out_split] = end - begin;
+    auto x_block = x.slice(x_offsets, x_extents);
+    auto out_block = out.slice(out_offsets, out_extents);
+    Functor functor;
+    functor(place, &x_block, &out_block, reduce_dim);
+  });
+}
+
+template <typename DeviceContext,
+          typename T,
+          size_t D,
+          size_t R_D,
+          typename Functor>
+void ReduceFunctorOnBlocks(const DeviceContext& context,
+                           const phi::DenseTensor& input,
+                           phi::DenseTensor* output,
+                           const std::vector<int64_t>& dims,
+                           bool keep_dim,
+                           int split,
+                           std::false_type) {
+  ReduceFunctor<DeviceContext, T, D, R_D, Functor>(
+      context, input, output, dims, keep_dim);
+}
+
+// ReduceFunctor on the intra op threads of the CPU context, for the large
+// inputs which keep a dimension to split.
+template <typename DeviceContext,
+          typename T,
+          size_t D,
+          size_t R_D,
+          typename Functor>
+void ParallelReduceFunctor(const DeviceContext& context,
+                           const phi::DenseTensor& input,
+                           phi::DenseTensor* output,
+                           const std::vector<int64_t>& dims,
+                           bool keep_dim) {
+  int num_threads = context.GetIntraOpNumThreads();
+  int split = -1;
+  if (num_threads > 1 && input.numel() > CPUContext::kDefaultGrainSize) {
+    std::vector<bool> reduced(D, false);
+    for (auto dim : dims) {
+      reduced[dim < 0 ? D + dim : dim] = true;
+    }
+    // The outermost dimension kept with enough rows for all the threads,
+    // or else the largest one kept.
+    for (int i = 0; i < static_cast<int>(D); ++i) {
+      if (reduced[i]) continue;
+      if (input.dims()[i] >= num_threads) {
+        split = i;
+        break;
+      }
+      if (split < 0 || input.dims()[i] > input.dims()[split]) split = i;
+    }
+  }
+  if (split < 0 || input.dims()[split] < 2) {
+    ReduceFunctor<DeviceContext, T, D, R_D, Functor>(
+        context, input, output, dims, keep_dim);
+    return;
+  }
+  ReduceFunctorOnBlocks<DeviceContext, T, D, R_D, Functor>(
+      context,
+      input,
+      output,
+      dims,
+      keep_dim,
+      split,
+      std::integral_constant<bool, (D > R_D)>());
+}
+
+#define HANDLE_REDUCE_DIM(NDIM, RDIM)                                \
+  if (ndim == NDIM && rdim == RDIM) {                                \
+    ParallelReduceFunctor<DeviceContext, OutT, NDIM, RDIM, Functor>( \
+        dev_ctx, input, output, dims, keep_dim);                     \
   }
 //////////////// HandleLargeDim
 
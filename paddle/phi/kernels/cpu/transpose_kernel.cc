@@ -19,11 +19,30 @@
 #include "paddle/phi/backends/cpu/cpu_context.h"
 #include "paddle/phi/common/bfloat16.h"
 #include "paddle/phi/core/kernel_registry.h"
+#include "paddle/phi/kernels/autotune/auto_tune_base.h"
+#include "paddle/phi/kernels/funcs/cpu_transpose.h"
 #include "paddle/phi/kernels/funcs/math_function.h"
 #include "paddle/phi/kernels/impl/transpose_grad_kernel_impl.h"
 
 namespace phi {
 
+template <typename T>
+void TransposeBlocked(const CPUContext& ctx,
+                      const DenseTensor& x,
+                      const std::vector<int>& axis,
+                      DenseTensor* out) {
+  funcs::CpuTranspose(ctx, x, axis, out);
+}
+
+template <typename T>
+void TransposeByIndex(const CPUContext& ctx,
+                      const DenseTensor& x,
+                      const std::vector<int>& axis,
+                      DenseTensor* out) {
+  funcs::TransposeNormal<CPUContext, T> trans_normal;
+  trans_normal(ctx, x, out, axis);
+}
+
 template <typename T, typename Context>
 void TransposeKernel(const Context& ctx,
                      const DenseTensor& x,
@@ -33,37 +52,19 @@ void TransposeKernel(const Context& ctx,
   if (out->numel() == 0) {
     return;
   }
-  int rank = axis.size();
-  switch (rank) {
-    case 1:
-      funcs::Transpose<Context, T, 1> trans1;
-      trans1(ctx, x, out, axis);
-      break;
-    case 2:
-      funcs::Transpose<Context, T, 2> trans2;
-      trans2(ctx, x, out, axis);
-      break;
-    case 3:
-      funcs::Transpose<Context, T, 3> trans3;
-      trans3(ctx, x, out, axis);
-      break;
-    case 4:
-      funcs::Transpose<Context, T, 4> trans4;
-      trans4(ctx, x, out, axis);
-      break;
-    case 5:
-      funcs::Transpose<Context, T, 5> trans5;
-      trans5(ctx, x, out, axis);
-      break;
-    case 6:
-      funcs::Transpose<Context, T, 6> trans6;
-      trans6(ctx, x, out, axis);
-      break;
-    default:
-      // for rank >= 7 situation
-      funcs::TransposeNormal<Context, T> trans_normal;
-      trans_normal(ctx, x, out, axis);
-  }
+  auto* tuner =
+      autotune::MakeCpuTuner<autotune::AlgorithmType::kCpuTranspose, T>(
+          TransposeBlocked<T>, TransposeByIndex<T>);
+  size_t key = autotune::GetKey(
+      autotune::TransposeKey(vectorize(x.dims()), axis, x.dtype()),
+      ctx.GetIntraOpNumThreads());
+  tuner->Run(ctx,
+             autotune::AlgorithmType::kCpuTranspose,
+             key,
+             ctx,
+             x,
+             axis,
+             out);
 }
 }  // namespace phi
 
@@ -20,10 +20,14 @@
 #include <algorithm>
 #include <cmath>
 #include <limits>
+#include <memory>
+#include <type_traits>
 #include <vector>
 
 #include "paddle/phi/common/bfloat16.h"
 #include "paddle/phi/common/complex.h"
+#include "paddle/phi/kernels/funcs/blas/cpu_gemm.h"
+#include "paddle/phi/kernels/funcs/blas/packed_weight_cache.h"
 #include "paddle/phi/kernels/funcs/math_function.h"
 
 namespace phi {
@@ -1049,6 +1053,306 @@ void Blas<phi::CPUContext>::GEMM_FREE(T *data) const {
 }
 #endif
 
+namespace detail {
+template <typename T>
+struct IsRealGemmType : std::false_type {};
+template <>
+struct IsRealGemmType<float> : std::true_type {};
+template <>
+struct IsRealGemmType<double> : std::true_type {};
+
+template <typename T>
+typename std::enable_if<!IsRealGemmType<T>::value, bool>::type
+TryPackedGemm(const phi::CPUContext &context,
+              bool transA,
+              bool transB,
+              int M,
+              int N,
+              int K,
+              T alpha,
+              const T *A,
+              int lda,
+              const T *B,
+              int ldb,
+              T beta,
+              T *C,
+              int ldc) {
+  return false;
+}
+
+// Runs the GEMM with the cached pack of B if B is a registered constant, see
+// PackedWeightCache. Returns false if B is not packed.
+template <typename T>
+typename std::enable_if<IsRealGemmType<T>::value, bool>::type
+TryPackedGemm(const phi::CPUContext &context,
+              bool transA,
+              bool transB,
+              int M,
+              int N,
+              int K,
+              T alpha,
+              const T *A,
+              int lda,
+              const T *B,
+              int ldb,
+              T beta,
+              T *C,
+              int ldc) {
+  auto &cache = PackedWeightCache::Instance();
+  if (!cache.HasConstants() || M <= 0 || N <= 0 || K <= 0) {
+    return false;
+  }
+#ifndef PADDLE_WITH_MKLML
+  // Without MKL, B is packed for CpuGemm, and the GEMMs CpuGemm does not run
+  // are left to the CBLAS library.
+  if (!UseCpuGemm<T>()) {
+    return false;
+  }
+#endif
+  PackedWeightKey key{
+      B, N, K, ldb, transB, static_cast<double>(alpha), sizeof(T)};
+  auto packed = cache.Get(key, [&]() -> std::shared_ptr<void> {
+#ifdef PADDLE_WITH_MKLML
+    // The pack of B does not depend on the number of rows of A.
+    T *dst = CBlas<T>::GEMM_ALLOC(CblasBMatrix, 1, N, K);
+    PADDLE_ENFORCE_NOT_NULL(
+        dst,
+        phi::errors::ResourceExhausted(
+            "Failed to allocate the packed B of a %d x %d GEMM.", K, N));
+    CBlas<T>::GEMM_PACK(CblasRowMajor,
+                        CblasBMatrix,
+                        transB ? CblasTrans : CblasNoTrans,
+                        1,
+                        N,
+                        K,
+                        alpha,
+                        B,
+                        ldb,
+                        dst);
+    return std::shared_ptr<void>(
+        dst, [](void *data) { CBlas<T>::GEMM_FREE(static_cast<T *>(data)); });
+#else
+    std::shared_ptr<T> packed(new T[CpuGemmPackedBSize<T>(N, K)],
+                              std::default_delete<T[]>());
+    CpuGemmPackB<T>(context, transB, N, K, B, ldb, packed.get());
+    return packed;
+#endif
+  });
+  if (packed == nullptr) {
+    return false;
+  }
+  auto *packed_b = static_cast<const T *>(packed.get());
+#ifdef PADDLE_WITH_MKLML
+  CBlas<T>::GEMM_COMPUTE(CblasRowMajor,
+                         transA ? CblasTrans : CblasNoTrans,
+                         CblasPacked,
+                         M,
+                         N,
+                         K,
+                         A,
+                         lda,
+                         packed_b,
+                         ldb,
+                         beta,
+                         C,
+                         ldc);
+#else
+  CpuGemmPackedB<T>(
+      context, transA, M, N, K, alpha, A, lda, packed_b, beta, C, ldc);
+#endif
+  return true;
+}
+
+template <typename T>
+typename std::enable_if<!IsRealGemmType<T>::value, bool>::type
+TryCpuGemm(const phi::CPUContext &context,
+           bool transA,
+           bool transB,
+           int M,
+           int N,
+           int K,
+           T alpha,
+           const T *A,
+           int lda,
+           const T *B,
+           int ldb,
+           T beta,
+           T *C,
+           int ldc) {
+  return false;
+}
+
+// Runs the GEMM on the GEMM built in Paddle, see UseCpuGemm. Returns false if
+// the CBLAS library is used instead.
+template <typename T>
+typename std::enable_if<IsRealGemmType<T>::value, bool>::type
+TryCpuGemm(const phi::CPUContext &context,
+           bool transA,
+           bool transB,
+           int M,
+           int N,
+           int K,
+           T alpha,
+           const T *A,
+           int lda,
+           const T *B,
+           int ldb,
+           T beta,
+           T *C,
+           int ldc) {
+  if (!UseCpuGemm<T>()) {
+    return false;
+  }
+  CpuGemm<T>(
+      context, transA, transB, M, N, K, alpha, A, lda, B, ldb, beta, C, ldc);
+  return true;
+}
+
+template <typename T>
+typename std::enable_if<!IsRealGemmType<T>::value, bool>::type
+TryCpuGemmBatched(const phi::CPUContext &context,
+                  bool transA,
+                  bool transB,
+                  int M,
+                  int N,
+                  int K,
+                  T alpha,
+                  const T **A,
+                  const T **B,
+                  T beta,
+                  T **C,
+                  int batchCount) {
+  return false;
+}
+
+template <typename T>
+typename std::enable_if<IsRealGemmType<T>::value, bool>::type
+TryCpuGemmBatched(const phi::CPUContext &context,
+                  bool transA,
+                  bool transB,
+                  int M,
+                  int N,
+                  int K,
+                  T alpha,
+                  const T **A,
+                  const T **B,
+                  T beta,
+                  T **C,
+                  int batchCount) {
+  if (!UseCpuGemm<T>()) {
+    return false;
+  }
+  CpuGemmBatched<T>(
+      context, transA, transB, M, N, K, alpha, A, B, beta, C, batchCount);
+  return true;
+}
+
+template <typename T>
+typename std::enable_if<!IsRealGemmType<T>::value, bool>::type
+TryCpuGemmStridedBatched(const phi::CPUContext &context,
+                         bool transA,
+                         bool transB,
+                         int M,
+                         int N,
+                         int K,
+                         T alpha,
+                         const T *A,
+                         int64_t strideA,
+                         const T *B,
+                         int64_t strideB,
+                         T beta,
+                         T *C,
+                         int64_t strideC,
+                         int batchCount) {
+  return false;
+}
+
+template <typename T>
+typename std::enable_if<IsRealGemmType<T>::value, bool>::type
+TryCpuGemmStridedBatched(const phi::CPUContext &context,
+                         bool transA,
+                         bool transB,
+                         int M,
+                         int N,
+                         int K,
+                         T alpha,
+                         const T *A,
+                         int64_t strideA,
+                         const T *B,
+                         int64_t strideB,
+                         T beta,
+                         T *C,
+                         int64_t strideC,
+                         int batchCount) {
+  if (!UseCpuGemm<T>()) {
+    return false;
+  }
+  CpuGemmStridedBatched<T>(context,
+                           transA,
+                           transB,
+                           M,
+                           N,
+                           K,
+                           alpha,
+                           A,
+                           strideA,
+                           B,
+                           strideB,
+                           beta,
+                           C,
+                           strideC,
+                           batchCount);
+  return true;
+}
+
+// The GEMMs of Blas<CPUContext> try the packed weights first, then the
+// built-in GEMM.
+template <typename T>
+bool TryBuiltinGemm(const phi::CPUContext &context,
+                    bool transA,
+                    bool transB,
+                    int M,
+                    int N,
+                    int K,
+                    T alpha,
+                    const T *A,
+                    int lda,
+                    const T *B,
+                    int ldb,
+                    T beta,
+                    T *C,
+                    int ldc) {
+  return TryPackedGemm(context,
+                       transA,
+                       transB,
+                       M,
+                       N,
+                       K,
+                       alpha,
+                       A,
+                       lda,
+                       B,
+                       ldb,
+                       beta,
+                       C,
+                       ldc) ||
+         TryCpuGemm(context,
+                    transA,
+                    transB,
+                    M,
+                    N,
+                    K,
+                    alpha,
+                    A,
+                    lda,
+                    B,
+                    ldb,
+                    beta,
+                    C,
+                    ldc);
+}
+}  // namespace detail
+
 template <>
 template <typename T>
 void Blas<phi::CPUContext>::GEMM(CBLAS_TRANSPOSE transA,
@@ -1064,6 +1368,22 @@ void Blas<phi::CPUContext>::GEMM(CBLAS_TRANSPOSE transA,
   int lda = (transA == CblasNoTrans) ? K : M;
   int ldb = (transB == CblasNoTrans) ? N : K;
   int ldc = N;
+  if (detail::TryBuiltinGemm(context_,
+                             transA != CblasNoTrans,
+                             transB != CblasNoTrans,
+                             M,
+                             N,
+                             K,
+                             alpha,
+                             A,
+                             lda,
+                             B,
+                             ldb,
+                             beta,
+                             C,
+                             ldc)) {
+    return;
+  }
   CBlas<T>::GEMM(CblasRowMajor,
                  transA,
                  transB,
@@ -1095,6 +1415,22 @@ void Blas<phi::CPUContext>::GEMM(bool transA,
                                  T beta,
                                  T *C,
                                  int ldc) const {
+  if (detail::TryBuiltinGemm(context_,
+                             transA,
+                             transB,
+                             M,
+                             N,
+                             K,
+                             alpha,
+                             A,
+                             lda,
+                             B,
+                             ldb,
+                             beta,
+                             C,
+                             ldc)) {
+    return;
+  }
   CBlas<T>::GEMM(CblasRowMajor,
                  transA == false ? CblasNoTrans : CblasTrans,
                  transB == false ? CblasNoTrans : CblasTrans,
@@ -1126,6 +1462,22 @@ void Blas<phi::CPUContext>::GEMM(CBLAS_TRANSPOSE transA,
                                  T beta,
                                  T *C,
                                  int ldc) const {
+  if (detail::TryBuiltinGemm(context_,
+                             transA != CblasNoTrans,
+                             transB != CblasNoTrans,
+                             M,
+                             N,
+                             K,
+                             alpha,
+                             A,
+                             lda,
+                             B,
+                             ldb,
+                             beta,
+                             C,
+                             ldc)) {
+    return;
+  }
   CBlas<T>::GEMM(CblasRowMajor,
                  transA,
                  transB,
@@ -1401,6 +1753,23 @@ void Blas<phi::CPUContext>::BatchedGEMM(CBLAS_TRANSPOSE transA,
                        1 /* group_count */,
                        &batchCount);
 #else
+  if (detail::TryCpuGemmStridedBatched(context_,
+                                       transA != CblasNoTrans,
+                                       transB != CblasNoTrans,
+                                       M,
+                                       N,
+                                       K,
+                                       alpha,
+                                       A,
+                                       strideA,
+                                       B,
+                                       strideB,
+                                       beta,
+                                       C,
+                                       static_cast<int64_t>(M) * N,
+                                       batchCount)) {
+    return;
+  }
   for (int k = 0; k < batchCount; ++k) {
     auto *Ak = &A[k * strideA];
     auto *Bk = &B[k * strideB];
@@ -1444,6 +1813,20 @@ void Blas<phi::CPUContext>::BatchedGEMM(CBLAS_TRANSPOSE transA,
                        1 /* group_count */,
                        &batchCount);
 #else
+  if (detail::TryCpuGemmBatched(context_,
+                                transA != CblasNoTrans,
+                                transB != CblasNoTrans,
+                                M,
+                                N,
+                                K,
+                                alpha,
+                                A,
+                                B,
+                                beta,
+                                C,
+                                batchCount)) {
+    return;
+  }
   for (int k = 0; k < batchCount; ++k) {
     this->template GEMM<T>(
         transA, transB, M, N, K, alpha, A[k], B[k], beta, C[k]);
@@ -1585,6 +1968,22 @@ template <>
 template <typename T>
 void Blas<phi::CPUContext>::MatMul(
     const int M, const int N, const int K, const T *A, const T *B, T *C) const {
+  if (detail::TryPackedGemm(context_,
+                            false,
+                            false,
+                            M,
+                            N,
+                            K,
+                            static_cast<T>(1),
+                            A,
+                            K,
+                            B,
+                            N,
+                            static_cast<T>(0),
+                            C,
+                            N)) {
+    return;
+  }
 #ifdef PADDLE_WITH_LIBXSMM
   // Refer to https://github.com/hfp/libxsmm/blob/master/README.md
   // But the threshold is custom constexpr int LIBXSMM_THRESHOLD = 20 * 20 * 20;
@@ -1603,6 +2002,22 @@ void Blas<phi::CPUContext>::MatMul(
   return;
 #endif
 
+  if (detail::TryCpuGemm(context_,
+                         false,
+                         false,
+                         M,
+                         N,
+                         K,
+                         static_cast<T>(1),
+                         A,
+                         K,
+                         B,
+                         N,
+                         static_cast<T>(0),
+                         C,
+                         N)) {
+    return;
+  }
   CBlas<T>::GEMM(CblasRowMajor,
                  CblasNoTrans,
                  CblasNoTrans,
@@ -0,0 +1,820 @@
+// Copyright (c) 2022 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "paddle/phi/kernels/funcs/blas/cpu_gemm.h"
+
+#include <algorithm>
+#include <cstring>
+#include <vector>
+
+#include "gflags/gflags.h"
+#include "paddle/fluid/platform/cpu_info.h"
+
+// The SIMD microkernels are compiled with function level targets, so that
+// the library runs on any CPU and picks the widest kernel the CPU supports.
+#if defined(__x86_64__) && !defined(_WIN32) && \
+    (defined(__clang__) || defined(__GNUC__))
+#define PADDLE_CPU_GEMM_WITH_AVX
+#include <immintrin.h>
+#endif
+
+#if defined(__aarch64__) && defined(__ARM_NEON)
+#define PADDLE_CPU_GEMM_WITH_NEON
+#include <arm_neon.h>
+#endif
+
+DECLARE_bool(use_builtin_cpu_gemm);
+
+namespace phi {
+namespace funcs {
+
+namespace {
+
+// The blocks of the packed matrices: a kGemmKC x nr panel of B stays in L1
+// while it is multiplied with a kGemmMC x kGemmKC block of A in L2. kGemmMC
+// and kGemmNC are multiples of the shapes of all the microkernels.
+constexpr int kGemmKC = 256;
+constexpr int kGemmMC = 96;
+constexpr int kGemmNC = 4096;
+// The largest mr and nr of the microkernels.
+constexpr int kGemmMaxMR = 8;
+constexpr int kGemmMaxNR = 32;
+// The multiply-adds below which a task is not worth a thread.
+constexpr int64_t kGemmGrainSize = 1 << 17;
+
+// c = alpha * a * b + beta * c, where a is a packed mr x kc panel of A, b a
+// packed kc x nr panel of B and c an mr x nr block. c is not read when beta
+// is 0.
+template <typename T>
+using MicroKernel = void (*)(
+    int kc, const T* a, const T* b, T* c, int ldc, T alpha, T beta);
+
+template <typename T>
+struct GemmKernel {
+  const char* name;
+  int mr;
+  int nr;
+  MicroKernel<T> run;
+};
+
+template <typename T, int MR, int NR>
+void MicroKernelRef(
+    int kc, const T* a, const T* b, T* c, int ldc, T alpha, T beta) {
+  T acc[MR][NR] = {};
+  for (int k = 0; k < kc; ++k) {
+    for (int i = 0; i < MR; ++i) {
+      T av = a[i];
+      for (int j = 0; j < NR; ++j) {
+        acc[i][j] += av * b[j];
+      }
+    }
+    a += MR;
+    b += NR;
+  }
+  for (int i = 0; i < MR; ++i) {
+    T* ci = c + static_cast<int64_t>(i) * ldc;
+    for (int j = 0; j < NR; ++j) {
+      ci[j] = beta == static_cast<T>(0) ? alpha * acc[i][j]
+                                        : alpha * acc[i][j] + beta * ci[j];
+    }
+  }
+}
+
+#ifdef PADDLE_CPU_GEMM_WITH_AVX
+
+#define PADDLE_GEMM_AVX2_FMA(r)                         \
+  {                                                     \
+    __m256 av = _mm256_broadcast_ss(a + r);             \
+    c##r##0 = _mm256_fmadd_ps(av, b0, c##r##0);         \
+    c##r##1 = _mm256_fmadd_ps(av, b1, c##r##1);         \
+  }
+
+#define PADDLE_GEMM_AVX2_STORE(r)                                  \
+  {                                                                \
+    float* cr = c + static_cast<int64_t>(r) * ldc;                 \
+    __m256 v0 = _mm256_mul_ps(valpha, c##r##0);                    \
+    __m256 v1 = _mm256_mul_ps(valpha, c##r##1);                    \
+    if (beta != 0.f) {                                             \
+      v0 = _mm256_fmadd_ps(vbeta, _mm256_loadu_ps(cr), v0);        \
+      v1 = _mm256_fmadd_ps(vbeta, _mm256_loadu_ps(cr + 8), v1);    \
+    }                                                              \
+    _mm256_storeu_ps(cr, v0);                                      \
+    _mm256_storeu_ps(cr + 8, v1);                                  \
+  }
+
+// 6 x 16, in 12 of the 16 ymm registers.
+__attribute__((target("avx2,fma"))) void MicroKernelAvx2(int kc,
+                                                         const float* a,
+                                                         const float* b,
+                                                         float* c,
+                                                         int ldc,
+                                                         float alpha,
+                                                         float beta) {
+  __m256 c00 = _mm256_setzero_ps(), c01 = _mm256_setzero_ps();
+  __m256 c10 = _mm256_setzero_ps(), c11 = _mm256_setzero_ps();
+  __m256 c20 = _mm256_setzero_ps(), c21 = _mm256_setzero_ps();
+  __m256 c30 = _mm256_setzero_ps(), c31 = _mm256_setzero_ps();
+  __m256 c40 = _mm256_setzero_ps(), c41 = _mm256_setzero_ps();
+  __m256 c50 = _mm256_setzero_ps(), c51 = _mm256_setzero_ps();
+  for (int k = 0; k < kc; ++k) {
+    __m256 b0 = _mm256_loadu_ps(b);
+    __m256 b1 = _mm256_loadu_ps(b + 8);
+    PADDLE_GEMM_AVX2_FMA(0);
+    PADDLE_GEMM_AVX2_FMA(1);
+    PADDLE_GEMM_AVX2_FMA(2);
+    PADDLE_GEMM_AVX2_FMA(3);
+    PADDLE_GEMM_AVX2_FMA(4);
+    PADDLE_GEMM_AVX2_FMA(5);
+    a += 6;
+    b += 16;
+  }
+  __m256 valpha = _mm256_set1_ps(alpha);
+  __m256 vbeta = _mm256_set1_ps(beta);
+  PADDLE_GEMM_AVX2_STORE(0);
+  PADDLE_GEMM_AVX2_STORE(1);
+  PADDLE_GEMM_AVX2_STORE(2);
+  PADDLE_GEMM_AVX2_STORE(3);
+  PADDLE_GEMM_AVX2_STORE(4);
+  PADDLE_GEMM_AVX2_STORE(5);
+}
+
+#undef PADDLE_GEMM_AVX2_FMA
+#undef PADDLE_GEMM_AVX2_STORE
+
+#define PADDLE_GEMM_AVX512_FMA(r)                       \
+  {                                                     \
+    __m512 av = _mm512_set1_ps(a[r]);                   \
+    c##r##0 = _mm512_fmadd_ps(av, b0, c##r##0);         \
+    c##r##1 = _mm512_fmadd_ps(av, b1, c##r##1);         \
+  }
+
+#define PADDLE_GEMM_AVX512_STORE(r)                                 \
+  {                                                                 \
+    float* cr = c + static_cast<int64_t>(r) * ldc;                  \
+    __m512 v0 = _mm512_mul_ps(valpha, c##r##0);                     \
+    __m512 v1 = _mm512_mul_ps(valpha, c##r##1);                     \
+    if (beta != 0.f) {                                              \
+      v0 = _mm512_fmadd_ps(vbeta, _mm512_loadu_ps(cr), v0);         \
+      v1 = _mm512_fmadd_ps(vbeta, _mm512_loadu_ps(cr + 16), v1);    \
+    }                                                               \
+    _mm512_storeu_ps(cr, v0);                                       \
+    _mm512_storeu_ps(cr + 16, v1);                                  \
+  }
+
+// 8 x 32, in 16 of the 32 zmm registers.
+__attribute__((target("avx512f"))) void MicroKernelAvx512(int kc,
+                                                          const float* a,
+                                                          const float* b,
+                                                          float* c,
+                                                          int ldc,
+                                                          float alpha,
+                                                          float beta) {
+  __m512 c00 = _mm512_setzero_ps(), c01 = _mm512_setzero_ps();
+  __m512 c10 = _mm512_setzero_ps(), c11 = _mm512_setzero_ps();
+  __m512 c20 = _mm512_setzero_ps(), c21 = _mm512_setzero_ps();
+  __m512 c30 = _mm512_setzero_ps(), c31 = _mm512_setzero_ps();
+  __m512 c40 = _mm512_setzero_ps(), c41 = _mm512_setzero_ps();
+  __m512 c50 = _mm512_setzero_ps(), c51 = _mm512_setzero_ps();
+  __m512 c60 = _mm512_setzero_ps(), c61 = _mm512_setzero_ps();
+  __m512 c70 = _mm512_setzero_ps(), c71 = _mm512_setzero_ps();
+  for (int k = 0; k < kc; ++k) {
+    __m512 b0 = _mm512_loadu_ps(b);
+    __m512 b1 = _mm512_loadu_ps(b + 16);
+    PADDLE_GEMM_AVX512_FMA(0);
+    PADDLE_GEMM_AVX512_FMA(1);
+    PADDLE_GEMM_AVX512_FMA(2);
+    PADDLE_GEMM_AVX512_FMA(3);
+    PADDLE_GEMM_AVX512_FMA(4);
+    PADDLE_GEMM_AVX512_FMA(5);
+    PADDLE_GEMM_AVX512_FMA(6);
+    PADDLE_GEMM_AVX512_FMA(7);
+    a += 8;
+    b += 32;
+  }
+  __m512 valpha = _mm512_set1_ps(alpha);
+  __m512 vbeta = _mm512_set1_ps(beta);
+  PADDLE_GEMM_AVX512_STORE(0);
+  PADDLE_GEMM_AVX512_STORE(1);
+  PADDLE_GEMM_AVX512_STORE(2);
+  PADDLE_GEMM_AVX512_STORE(3);
+  PADDLE_GEMM_AVX512_STORE(4);
+  PADDLE_GEMM_AVX512_STORE(5);
+  PADDLE_GEMM_AVX512_STORE(6);
+  PADDLE_GEMM_AVX512_STORE(7);
+}
+
+#undef PADDLE_GEMM_AVX512_FMA
+#undef PADDLE_GEMM_AVX512_STORE
+
+#endif  // PADDLE_CPU_GEMM_WITH_AVX
+
+#ifdef PADDLE_CPU_GEMM_WITH_NEON
+
+#define PADDLE_GEMM_NEON_FMA(r, av, lane)               \
+  {                                                     \
+    c##r##0 = vfmaq_laneq_f32(c##r##0, b0, av, lane);   \
+    c##r##1 = vfmaq_laneq_f32(c##r##1, b1, av, lane);   \
+  }
+
+#define PADDLE_GEMM_NEON_STORE(r)                                \
+  {                                                              \
+    float* cr = c + static_cast<int64_t>(r) * ldc;               \
+    float32x4_t v0 = vmulq_n_f32(c##r##0, alpha);                \
+    float32x4_t v1 = vmulq_n_f32(c##r##1, alpha);                \
+    if (beta != 0.f) {                                           \
+      v0 = vfmaq_n_f32(v0, vld1q_f32(cr), beta);                 \
+      v1 = vfmaq_n_f32(v1, vld1q_f32(cr + 4), beta);             \
+    }                                                            \
+    vst1q_f32(cr, v0);                                           \
+    vst1q_f32(cr + 4, v1);                                       \
+  }
+
+// 8 x 8, in 16 of the 32 q registers.
+void MicroKernelNeon(int kc,
+                     const float* a,
+                     const float* b,
+                     float* c,
+                     int ldc,
+                     float alpha,
+                     float beta) {
+  float32x4_t c00 = vdupq_n_f32(0.f), c01 = vdupq_n_f32(0.f);
+  float32x4_t c10 = vdupq_n_f32(0.f), c11 = vdupq_n_f32(0.f);
+  float32x4_t c20 = vdupq_n_f32(0.f), c21 = vdupq_n_f32(0.f);
+  float32x4_t c30 = vdupq_n_f32(0.f), c31 = vdupq_n_f32(0.f);
+  float32x4_t c40 = vdupq_n_f32(0.f), c41 = vdupq_n_f32(0.f);
+  float32x4_t c50 = vdupq_n_f32(0.f), c51 = vdupq_n_f32(0.f);
+  float32x4_t c60 = vdupq_n_f32(0.f), c61 = vdupq_n_f32(0.f);
+  float32x4_t c70 = vdupq_n_f32(0.f), c71 = vdupq_n_f32(0.f);
+  for (int k = 0; k < kc; ++k) {
+    float32x4_t b0 = vld1q_f32(b);
+    float32x4_t b1 = vld1q_f32(b + 4);
+    float32x4_t a0 = vld1q_f32(a);
+    float32x4_t a1 = vld1q_f32(a + 4);
+    PADDLE_GEMM_NEON_FMA(0, a0, 0);
+    PADDLE_GEMM_NEON_FMA(1, a0, 1);
+    PADDLE_GEMM_NEON_FMA(2, a0, 2);
+    PADDLE_GEMM_NEON_FMA(3, a0, 3);
+    PADDLE_GEMM_NEON_FMA(4, a1, 0);
+    PADDLE_GEMM_NEON_FMA(5, a1, 1);
+    PADDLE_GEMM_NEON_FMA(6, a1, 2);
+    PADDLE_GEMM_NEON_FMA(7, a1, 3);
+    a += 8;
+    b += 8;
+  }
+  PADDLE_GEMM_NEON_STORE(0);
+  PADDLE_GEMM_NEON_STORE(1);
+  PADDLE_GEMM_NEON_STORE(2);
+  PADDLE_GEMM_NEON_STORE(3);
+  PADDLE_GEMM_NEON_STORE(4);
+  PADDLE_GEMM_NEON_STORE(5);
+  PADDLE_GEMM_NEON_STORE(6);
+  PADDLE_GEMM_NEON_STORE(7);
+}
+
+#undef PADDLE_GEMM_NEON_FMA
+#undef PADDLE_GEMM_NEON_STORE
+
+#endif  // PADDLE_CPU_GEMM_WITH_NEON
+
+template <typename T>
+const GemmKernel<T>& GetGemmKernel();
+
+template <>
+const GemmKernel<float>& GetGemmKernel<float>() {
+  static const GemmKernel<float> kernel = []() -> GemmKernel<float> {
+#ifdef PADDLE_CPU_GEMM_WITH_AVX
+    if (paddle::platform::MayIUse(paddle::platform::avx512f)) {
+      return {"avx512", 8, 32, MicroKernelAvx512};
+    }
+    if (paddle::platform::MayIUse(paddle::platform::avx2)) {
+      return {"avx2", 6, 16, MicroKernelAvx2};
+    }
+#endif
+#ifdef PADDLE_CPU_GEMM_WITH_NEON
+    return {"neon", 8, 8, MicroKernelNeon};
+#endif
+    return {"generic", 4, 16, MicroKernelRef<float, 4, 16>};
+  }();
+  return kernel;
+}
+
+// The double GEMMs are rare in inference, they have only the generic kernel
+// and run on the CBLAS library, see UseCpuGemm.
+template <>
+const GemmKernel<double>& GetGemmKernel<double>() {
+  static const GemmKernel<double> kernel = {
+      "generic", 4, 8, MicroKernelRef<double, 4, 8>};
+  return kernel;
+}
+
+// Packs the panels [begin, end) of nr columns of the kc x nc block of op(B)
+// at (pc, jc), each stored row by row and padded with zeros.
+template <typename T>
+void PackB(bool trans,
+           const T* B,
+           int ldb,
+           int pc,
+           int jc,
+           int kc,
+           int nc,
+           int nr,
+           int64_t begin,
+           int64_t end,
+           T* packed) {
+  for (int64_t p = begin; p < end; ++p) {
+    T* dst = packed + p * kc * nr;
+    int col = jc + static_cast<int>(p) * nr;
+    int width = std::min(nr, nc - static_cast<int>(p) * nr);
+    for (int k = 0; k < kc; ++k) {
+      int64_t row = pc + k;
+      for (int j = 0; j < width; ++j) {
+        dst[j] = trans ? B[(col + j) * static_cast<int64_t>(ldb) + row]
+                       : B[row * ldb + col + j];
+      }
+      std::fill(dst + width, dst + nr, static_cast<T>(0));
+      dst += nr;
+    }
+  }
+}
+
+// Packs the panels [begin, end) of mr rows of the M x kc block of op(A) at
+// column pc, each stored column by column and padded with zeros.
+template <typename T>
+void PackA(bool trans,
+           const T* A,
+           int lda,
+           int pc,
+           int M,
+           int kc,
+           int mr,
+           int64_t begin,
+           int64_t end,
+           T* packed) {
+  for (int64_t p = begin; p < end; ++p) {
+    T* dst = packed + p * kc * mr;
+    int row = static_cast<int>(p) * mr;
+    int height = std::min(mr, M - row);
+    for (int k = 0; k < kc; ++k) {
+      int64_t col = pc + k;
+      for (int i = 0; i < height; ++i) {
+        dst[i] = trans ? A[col * lda + row + i]
+                       : A[(row + i) * static_cast<int64_t>(lda) + col];
+      }
+      std::fill(dst + height, dst + mr, static_cast<T>(0));
+      dst += mr;
+    }
+  }
+}
+
+template <typename T>
+void ScaleC(int M, int N, T beta, T* C, int ldc) {
+  for (int i = 0; i < M; ++i) {
+    T* c = C + static_cast<int64_t>(i) * ldc;
+    for (int j = 0; j < N; ++j) {
+      c[j] = beta == static_cast<T>(0) ? static_cast<T>(0) : beta * c[j];
+    }
+  }
+}
+
+// C[0:M, jc:jc + nc] = alpha * packed_a * packed_b + beta * C[0:M, jc:jc + nc],
+// where packed_a is the pack of an M x kc block of op(A) and packed_b the one
+// of a kc x nc block of op(B), with the tasks split over the intra op
+// threads.
+template <typename T>
+void ComputeBlock(const CPUContext& context,
+                  const GemmKernel<T>& kernel,
+                  int M,
+                  int N,
+                  int jc,
+                  int nc,
+                  int kc,
+                  T alpha,
+                  const T* packed_a,
+                  const T* packed_b,
+                  T beta,
+                  T* C,
+                  int ldc) {
+  const int mr = kernel.mr;
+  const int nr = kernel.nr;
+  const int n_panels = (nc + nr - 1) / nr;
+  const int m_blocks = (M + kGemmMC - 1) / kGemmMC;
+  const int num_threads = context.GetIntraOpNumThreads();
+
+  // The tasks are the blocks of kGemmMC rows times the groups of panels
+  // of B, with a few tasks for each thread to balance them. The
+  // consecutive tasks share the group of B.
+  int n_groups =
+      std::min(n_panels,
+               std::max(1, (4 * num_threads + m_blocks - 1) / m_blocks));
+  const int group_size = (n_panels + n_groups - 1) / n_groups;
+  n_groups = (n_panels + group_size - 1) / group_size;
+  const int64_t task_work = static_cast<int64_t>(std::min(M, kGemmMC)) *
+                            kc * group_size * nr;
+  const int64_t grain_size = std::max<int64_t>(1, kGemmGrainSize / task_work);
+  context.ParallelFor(
+      static_cast<int64_t>(m_blocks) * n_groups,
+      grain_size,
+      [&](int64_t begin, int64_t end) {
+        T tile[kGemmMaxMR * kGemmMaxNR];
+        for (int64_t task = begin; task < end; ++task) {
+          int group = static_cast<int>(task / m_blocks);
+          int block = static_cast<int>(task % m_blocks);
+          int panel_end = std::min(n_panels, (group + 1) * group_size);
+          int row_end = std::min(M, (block + 1) * kGemmMC);
+          for (int jr = group * group_size; jr < panel_end; ++jr) {
+            const T* b = packed_b + static_cast<int64_t>(jr) * kc * nr;
+            const int col = jc + jr * nr;
+            const int width = std::min(nr, N - col);
+            for (int row = block * kGemmMC; row < row_end; row += mr) {
+              const T* a = packed_a + static_cast<int64_t>(row) * kc;
+              const int height = std::min(mr, M - row);
+              T* c = C + static_cast<int64_t>(row) * ldc + col;
+              if (height == mr && width == nr) {
+                kernel.run(kc, a, b, c, ldc, alpha, beta);
+                continue;
+              }
+              // The edges are computed on a full tile.
+              kernel.run(kc, a, b, tile, nr, alpha, static_cast<T>(0));
+              for (int i = 0; i < height; ++i) {
+                T* ci = c + static_cast<int64_t>(i) * ldc;
+                const T* ti = tile + i * nr;
+                for (int j = 0; j < width; ++j) {
+                  ci[j] = beta == static_cast<T>(0) ? ti[j]
+                                                    : ti[j] + beta * ci[j];
+                }
+              }
+            }
+          }
+        }
+      });
+}
+
+// Packs the M x kc block of op(A) at column pc into a buffer of the calling
+// thread, which the intra op threads only read.
+template <typename T>
+const T* PackABlock(const CPUContext& context,
+                    const GemmKernel<T>& kernel,
+                    bool trans_a,
+                    const T* A,
+                    int lda,
+                    int pc,
+                    int M,
+                    int kc) {
+  const int mr = kernel.mr;
+  const int m_panels = (M + mr - 1) / mr;
+  thread_local std::vector<T> a_buffer;
+  size_t a_size = static_cast<size_t>(m_panels) * mr * kGemmKC;
+  if (a_buffer.size() < a_size) a_buffer.resize(a_size);
+  T* packed_a = a_buffer.data();
+  context.ParallelFor(
+      m_panels,
+      std::max<int64_t>(1, CPUContext::kDefaultGrainSize / (kc * mr)),
+      [&](int64_t begin, int64_t end) {
+        PackA(trans_a, A, lda, pc, M, kc, mr, begin, end, packed_a);
+      });
+  return packed_a;
+}
+
+}  // namespace
+
+template <typename T>
+bool UseCpuGemm() {
+#ifdef PADDLE_WITH_MKLML
+  return false;
+#else
+  // The generic kernel is slower than the CBLAS library.
+  static const bool has_simd_kernel =
+      std::strcmp(GetGemmKernel<T>().name, "generic") != 0;
+  return has_simd_kernel && FLAGS_use_builtin_cpu_gemm;
+#endif
+}
+
+template <typename T>
+const char* CpuGemmKernelName() {
+  return GetGemmKernel<T>().name;
+}
+
+template <typename T>
+void CpuGemm(const CPUContext& context,
+             bool trans_a,
+             bool trans_b,
+             int M,
+             int N,
+             int K,
+             T alpha,
+             const T* A,
+             int lda,
+             const T* B,
+             int ldb,
+             T beta,
+             T* C,
+             int ldc) {
+  if (M <= 0 || N <= 0) return;
+  if (K <= 0 || alpha == static_cast<T>(0)) {
+    ScaleC(M, N, beta, C, ldc);
+    return;
+  }
+  const auto& kernel = GetGemmKernel<T>();
+  const int nr = kernel.nr;
+
+  // The packs are kept by the calling thread, the intra op threads only read
+  // them.
+  thread_local std::vector<T> b_buffer;
+  size_t b_size =
+      static_cast<size_t>((std::min(N, kGemmNC) + nr - 1) / nr) * nr * kGemmKC;
+  if (b_buffer.size() < b_size) b_buffer.resize(b_size);
+  T* packed_b = b_buffer.data();
+
+  for (int jc = 0; jc < N; jc += kGemmNC) {
+    const int nc = std::min(kGemmNC, N - jc);
+    const int n_panels = (nc + nr - 1) / nr;
+    for (int pc = 0; pc < K; pc += kGemmKC) {
+      const int kc = std::min(kGemmKC, K - pc);
+      // The later blocks of K accumulate on the former ones.
+      const T block_beta = pc == 0 ? beta : static_cast<T>(1);
+
+      int64_t pack_grain_size =
+          std::max<int64_t>(1, CPUContext::kDefaultGrainSize / (kc * nr));
+      context.ParallelFor(
+          n_panels, pack_grain_size, [&](int64_t begin, int64_t end) {
+            PackB(trans_b, B, ldb, pc, jc, kc, nc, nr, begin, end, packed_b);
+          });
+      const T* packed_a =
+          PackABlock(context, kernel, trans_a, A, lda, pc, M, kc);
+      ComputeBlock(context,
+                   kernel,
+                   M,
+                   N,
+                   jc,
+                   nc,
+                   kc,
+                   alpha,
+                   packed_a,
+                   packed_b,
+                   block_beta,
+                   C,
+                   ldc);
+    }
+  }
+}
+
+template <typename T>
+size_t CpuGemmPackedBSize(int N, int K) {
+  const int nr = GetGemmKernel<T>().nr;
+  return static_cast<size_t>((N + nr - 1) / nr) * nr * std::max(K, 0);
+}
+
+// The pack of op(B) holds the packs of CpuGemm for all the blocks of K one
+// after the other, each with the panels of all the N columns. As kGemmNC is a
+// multiple of nr, the panels of a block of columns are the ones of CpuGemm.
+template <typename T>
+void CpuGemmPackB(const CPUContext& context,
+                  bool trans_b,
+                  int N,
+                  int K,
+                  const T* B,
+                  int ldb,
+                  T* packed_b) {
+  const int nr = GetGemmKernel<T>().nr;
+  const int n_panels = (N + nr - 1) / nr;
+  for (int pc = 0; pc < K; pc += kGemmKC) {
+    const int kc = std::min(kGemmKC, K - pc);
+    T* dst = packed_b + static_cast<int64_t>(pc) * n_panels * nr;
+    context.ParallelFor(
+        n_panels,
+        std::max<int64_t>(1, CPUContext::kDefaultGrainSize / (kc * nr)),
+        [&](int64_t begin, int64_t end) {
+          PackB(trans_b, B, ldb, pc, 0, kc, N, nr, begin, end, dst);
+        });
+  }
+}
+
+template <typename T>
+void CpuGemmPackedB(const CPUContext& context,
+                    bool trans_a,
+                    int M,
+                    int N,
+                    int K,
+                    T alpha,
+                    const T* A,
+                    int lda,
+                    const T* packed_b,
+                    T beta,
+                    T* C,
+                    int ldc) {
+  if (M <= 0 || N <= 0) return;
+  if (K <= 0 || alpha == static_cast<T>(0)) {
+    ScaleC(M, N, beta, C, ldc);
+    return;
+  }
+  const auto& kernel = GetGemmKernel<T>();
+  const int nr = kernel.nr;
+  const int n_panels = (N + nr - 1) / nr;
+  for (int jc = 0; jc < N; jc += kGemmNC) {
+    const int nc = std::min(kGemmNC, N - jc);
+    for (int pc = 0; pc < K; pc += kGemmKC) {
+      const int kc = std::min(kGemmKC, K - pc);
+      const T block_beta = pc == 0 ? beta : static_cast<T>(1);
+      const T* b = packed_b + static_cast<int64_t>(pc) * n_panels * nr +
+                   static_cast<int64_t>(jc) * kc;
+      const T* packed_a =
+          PackABlock(context, kernel, trans_a, A, lda, pc, M, kc);
+      ComputeBlock(context,
+                   kernel,
+                   M,
+                   N,
+                   jc,
+                   nc,
+                   kc,
+                   alpha,
+                   packed_a,
+                   b,
+                   block_beta,
+                   C,
+                   ldc);
+    }
+  }
+}
+
+template <typename T>
+void CpuGemmBatched(const CPUContext& context,
+                    bool trans_a,
+                    bool trans_b,
+                    int M,
+                    int N,
+                    int K,
+                    T alpha,
+                    const T* const* A,
+                    const T* const* B,
+                    T beta,
+                    T* const* C,
+                    int batch_count) {
+  const int lda = std::max(trans_a ? M : K, 1);
+  const int ldb = std::max(trans_b ? K : N, 1);
+  const int ldc = std::max(N, 1);
+  // With enough matrices for all the threads, each thread runs whole GEMMs,
+  // whose ParallelFor then run inline. Otherwise each GEMM is split.
+  if (batch_count < context.GetIntraOpNumThreads()) {
+    for (int i = 0; i < batch_count; ++i) {
+      CpuGemm<T>(context,
+                 trans_a,
+                 trans_b,
+                 M,
+                 N,
+                 K,
+                 alpha,
+                 A[i],
+                 lda,
+                 B[i],
+                 ldb,
+                 beta,
+                 C[i],
+                 ldc);
+    }
+    return;
+  }
+  const int64_t work = std::max<int64_t>(
+      1, static_cast<int64_t>(M) * N * std::max(K, 1));
+  context.ParallelFor(batch_count,
+                      std::max<int64_t>(1, kGemmGrainSize / work),
+                      [&](int64_t begin, int64_t end) {
+                        for (int64_t i = begin; i < end; ++i) {
+                          CpuGemm<T>(context,
+                                     trans_a,
+                                     trans_b,
+                                     M,
+                                     N,
+                                     K,
+                                     alpha,
+                                     A[i],
+                                     lda,
+                                     B[i],
+                                     ldb,
+                                     beta,
+                                     C[i],
+                                     ldc);
+                        }
+                      });
+}
+
+template <typename T>
+void CpuGemmStridedBatched(const CPUContext& context,
+                           bool trans_a,
+                           bool trans_b,
+                           int M,
+                           int N,
+                           int K,
+                           T alpha,
+                           const T* A,
+                           int64_t stride_a,
+                           const T* B,
+                           int64_t stride_b,
+                           T beta,
+                           T* C,
+                           int64_t stride_c,
+                           int batch_count) {
+  std::vector<const T*> a_array(batch_count);
+  std::vector<const T*> b_array(batch_count);
+  std::vector<T*> c_array(batch_count);
+  for (int i = 0; i < batch_count; ++i) {
+    a_array[i] = A + i * stride_a;
+    b_array[i] = B + i * stride_b;
+    c_array[i] = C + i * stride_c;
+  }
+  CpuGemmBatched<T>(context,
+                    trans_a,
+                    trans_b,
+                    M,
+                    N,
+                    K,
+                    alpha,
+                    a_array.data(),
+                    b_array.data(),
+                    beta,
+                    c_array.data(),
+                    batch_count);
+}
+
+#define INSTANTIATE_CPU_GEMM(T)                                        \
+  template bool UseCpuGemm<T>();                                       \
+  template const char* CpuGemmKernelName<T>();                         \
+  template void CpuGemm<T>(const CPUContext&,                          \
+                           bool,                                       \
+                           bool,                                       \
+                           int,                                        \
+                           int,                                        \
+                           int,                                        \
+                           T,                                          \
+                           const T*,                                   \
+                           int,                                        \
+                           const T*,                                   \
+                           int,                                        \
+                           T,                                          \
+                           T*,                                         \
+                           int);                                       \
+  template size_t CpuGemmPackedBSize<T>(int, int);                     \
+  template void CpuGemmPackB<T>(const CPUContext&,                     \
+                                bool,                                  \
+                                int,                                   \
+                                int,                                   \
+                                const T*,                              \
+                                int,                                   \
+                                T*);                                   \
+  template void CpuGemmPackedB<T>(const CPUContext&,                   \
+                                  bool,                                \
+                                  int,                                 \
+                                  int,                                 \
+                                  int,                                 \
+                                  T,                                   \
+                                  const T*,                            \
+                                  int,                                 \
+                                  const T*,                            \
+                                  T,                                   \
+                                  T*,                                  \
+                                  int);                                \
+  template void CpuGemmBatched<T>(const CPUContext&,                   \
+                                  bool,                                \
+                                  bool,                                \
+                                  int,                                 \
+                                  int,                                 \
+                                  int,                                 \
+                                  T,                                   \
+                                  const T* const*,                     \
+                                  const T* const*,                     \
+                                  T,                                   \
+                                  T* const*,                           \
+                                  int);                                \
+  template void CpuGemmStridedBatched<T>(const CPUContext&,            \
+                                         bool,                         \
+                                         bool,                         \
+                                         int,                          \
+                                         int,                          \
+                                         int,                          \
+                                         T,                            \
+                                         const T*,                     \
+                                         int64_t,                      \
+                                         const T*,                     \
+                                         int64_t,                      \
+                                         T,                            \
+                                         T*,                           \
+                                         int64_t,                      \
+                                         int)
+
+INSTANTIATE_CPU_GEMM(float);
+INSTANTIATE_CPU_GEMM(double);
+
+#undef INSTANTIATE_CPU_GEMM
+
+}  // namespace funcs
+}  // namespace phi
@@ -0,0 +1,125 @@
+// Copyright (c) 2022 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include "paddle/phi/backends/cpu/cpu_context.h"
+
+namespace phi {
+namespace funcs {
+
+// A GEMM owned by Paddle for the builds without MKL. The matrices are packed
+// into the panels of a register blocked microkernel picked at runtime for
+// the CPU, AVX512, AVX2 or NEON, and the blocks of C are split over the intra
+// op threads of the context. All the matrices are row-major, and only float
+// and double are instantiated.
+
+// Whether Blas<CPUContext> runs its GEMMs of T on CpuGemm, which is the case
+// without MKL when the CPU has a SIMD microkernel for T, unless
+// FLAGS_use_builtin_cpu_gemm is false. Only float has SIMD microkernels.
+template <typename T>
+bool UseCpuGemm();
+
+// The name of the microkernel CpuGemm<T> runs on, like "avx2".
+template <typename T>
+const char* CpuGemmKernelName();
+
+// C = alpha * op(A) * op(B) + beta * C, where op(A) is M x K and op(B) is
+// K x N. C is not read when beta is 0.
+template <typename T>
+void CpuGemm(const CPUContext& context,
+             bool trans_a,
+             bool trans_b,
+             int M,
+             int N,
+             int K,
+             T alpha,
+             const T* A,
+             int lda,
+             const T* B,
+             int ldb,
+             T beta,
+             T* C,
+             int ldc);
+
+// The number of elements of the pack of a K x N op(B) by CpuGemmPackB.
+template <typename T>
+size_t CpuGemmPackedBSize(int N, int K);
+
+// Packs op(B) once into packed_b, in the panels of the microkernel of
+// CpuGemm, for the weights multiplied by many A.
+template <typename T>
+void CpuGemmPackB(const CPUContext& context,
+                  bool trans_b,
+                  int N,
+                  int K,
+                  const T* B,
+                  int ldb,
+                  T* packed_b);
+
+// CpuGemm with op(B) packed by CpuGemmPackB, which only packs A.
+template <typename T>
+void CpuGemmPackedB(const CPUContext& context,
+                    bool trans_a,
+                    int M,
+                    int N,
+                    int K,
+                    T alpha,
+                    const T* A,
+                    int lda,
+                    const T* packed_b,
+                    T beta,
+                    T* C,
+                    int ldc);
+
+// CpuGemm on each of batch_count packed matrices, the i-th ones at A[i], B[i]
+// and C[i].
+template <typename T>
+void CpuGemmBatched(const CPUContext& context,
+                    bool trans_a,
+                    bool trans_b,
+                    int M,
+                    int N,
+                    int K,
+                    T alpha,
+                    const T* const* A,
+                    const T* const* B,
+                    T beta,
+                    T* const* C,
+                    int batch_count);
+
+// CpuGemm on each of batch_count packed matrices, the i-th ones at
+// A + i * stride_a, B + i * stride_b and C + i * stride_c.
+template <typename T>
+void CpuGemmStridedBatched(const CPUContext& context,
+                           bool trans_a,
+                           bool trans_b,
+                           int M,
+                           int N,
+                           int K,
+                           T alpha,
+                           const T* A,
+                           int64_t stride_a,
+                           const T* B,
+                           int64_t stride_b,
+                           T beta,
+                           T* C,
+                           int64_t stride_c,
+                           int batch_count);
+
+}  // namespace funcs
+}  // namespace phi
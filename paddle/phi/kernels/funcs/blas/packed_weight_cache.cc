@@ -0,0 +1,99 @@
+// Copyright (c) 2022 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "paddle/phi/kernels/funcs/blas/packed_weight_cache.h"
+
+#include "paddle/phi/core/enforce.h"
+
+namespace phi {
+namespace funcs {
+
+PackedWeightCache& PackedWeightCache::Instance() {
+  static PackedWeightCache cache;
+  return cache;
+}
+
+void PackedWeightCache::RegisterConstant(const void* data, size_t size) {
+  if (data == nullptr || size == 0) return;
+  auto* begin = static_cast<const char*>(data);
+  AutoWRLock guard(&lock_);
+  auto it = constants_.find(begin);
+  if (it != constants_.end()) {
+    PADDLE_ENFORCE_EQ(it->second.end,
+                      begin + size,
+                      phi::errors::InvalidArgument(
+                          "The constant at %p is registered with %d bytes, "
+                          "which differs from the former registration.",
+                          data,
+                          size));
+    ++it->second.ref_count;
+    return;
+  }
+  constants_[begin] = Range{begin + size, 1};
+  ++num_constants_;
+}
+
+void PackedWeightCache::UnregisterConstant(const void* data) {
+  auto* begin = static_cast<const char*>(data);
+  AutoWRLock guard(&lock_);
+  auto it = constants_.find(begin);
+  if (it == constants_.end() || --it->second.ref_count > 0) return;
+  const char* end = it->second.end;
+  constants_.erase(it);
+  --num_constants_;
+  for (auto pack = packs_.begin(); pack != packs_.end();) {
+    auto* packed_data = static_cast<const char*>(pack->first.data);
+    if (packed_data >= begin && packed_data < end) {
+      pack = packs_.erase(pack);
+    } else {
+      ++pack;
+    }
+  }
+}
+
+bool PackedWeightCache::IsConstant(const char* begin, const char* end) const {
+  auto it = constants_.upper_bound(begin);
+  if (it == constants_.begin()) return false;
+  --it;
+  return end <= it->second.end;
+}
+
+std::shared_ptr<void> PackedWeightCache::Get(const PackedWeightKey& key,
+                                             const PackFunc& pack) {
+  // The last element of B is at (rows - 1) * ldb + cols - 1.
+  int64_t rows = key.trans ? key.n : key.k;
+  int64_t cols = key.trans ? key.k : key.n;
+  auto* begin = static_cast<const char*>(key.data);
+  auto* end = begin + ((rows - 1) * key.ldb + cols) * key.elem_size;
+  {
+    AutoRDLock guard(&lock_);
+    auto it = packs_.find(key);
+    if (it != packs_.end()) return it->second;
+    if (!IsConstant(begin, end)) return nullptr;
+  }
+  // Pack out of the lock, the first of the concurrent packs is kept.
+  auto packed = pack();
+  AutoWRLock guard(&lock_);
+  // The constant may be unregistered during the pack.
+  if (!IsConstant(begin, end)) return packed;
+  return packs_.emplace(key, std::move(packed)).first->second;
+}
+
+size_t PackedWeightCache::Size() {
+  AutoRDLock guard(&lock_);
+  return packs_.size();
+}
+
+}  // namespace funcs
+}  // namespace phi
@@ -0,0 +1,104 @@
+// Copyright (c) 2022 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <memory>
+#include <unordered_map>
+
+#include "paddle/phi/core/utils/rw_lock.h"
+
+namespace phi {
+namespace funcs {
+
+// The B matrix of a CPU GEMM, with the layout and the scale it is packed with.
+struct PackedWeightKey {
+  const void* data;
+  int n;
+  int k;
+  int ldb;
+  bool trans;
+  double alpha;
+  size_t elem_size;
+
+  bool operator==(const PackedWeightKey& other) const {
+    return data == other.data && n == other.n && k == other.k &&
+           ldb == other.ldb && trans == other.trans && alpha == other.alpha &&
+           elem_size == other.elem_size;
+  }
+};
+
+struct PackedWeightKeyHash {
+  size_t operator()(const PackedWeightKey& key) const {
+    size_t seed = std::hash<const void*>()(key.data);
+    auto combine = [&seed](size_t value) {
+      seed ^= value + 0x9e3779b9 + (seed << 6) + (seed >> 2);
+    };
+    combine(std::hash<int>()(key.n));
+    combine(std::hash<int>()(key.k));
+    combine(std::hash<int>()(key.ldb));
+    combine(std::hash<bool>()(key.trans));
+    combine(std::hash<double>()(key.alpha));
+    return seed;
+  }
+};
+
+// Keeps the packed copies of the constant B matrices of the CPU GEMMs, so that
+// the weights of the inference programs are packed once instead of in every
+// call. Only the memory registered as constant, like the persistable
+// parameters of a predictor, is packed, and its packs are dropped when it is
+// unregistered. The ranges are counted, so that the predictors sharing their
+// parameters register them each.
+class PackedWeightCache {
+ public:
+  using PackFunc = std::function<std::shared_ptr<void>()>;
+
+  static PackedWeightCache& Instance();
+
+  void RegisterConstant(const void* data, size_t size);
+  void UnregisterConstant(const void* data);
+
+  bool HasConstants() const { return num_constants_.load() > 0; }
+
+  // Returns the pack of the key, made by pack on the first call, or nullptr if
+  // the B matrix of the key is not in a constant range.
+  std::shared_ptr<void> Get(const PackedWeightKey& key, const PackFunc& pack);
+
+  size_t Size();
+
+ private:
+  PackedWeightCache() = default;
+
+  struct Range {
+    const char* end;
+    int ref_count;
+  };
+
+  bool IsConstant(const char* begin, const char* end) const;
+
+  RWLock lock_;
+  std::atomic<int> num_constants_{0};
+  std::map<const char*, Range> constants_;
+  std::unordered_map<PackedWeightKey,
+                     std::shared_ptr<void>,
+                     PackedWeightKeyHash>
+      packs_;
+};
+
+}  // namespace funcs
+}  // namespace phi
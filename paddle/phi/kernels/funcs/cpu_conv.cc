@@ -0,0 +1,553 @@
+/* Copyright (c) 2022 PaddlePaddle Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License. */
+
+#include "paddle/phi/kernels/funcs/cpu_conv.h"
+
+#include <algorithm>
+#include <vector>
+
+#include "paddle/phi/core/enforce.h"
+#include "paddle/phi/kernels/funcs/blas/blas.h"
+
+namespace phi {
+namespace funcs {
+
+namespace {
+
+// The offsets of the dimensions of an NCHW or NHWC tensor.
+struct Layout {
+  int64_t n;
+  int64_t c;
+  int64_t h;
+  int64_t w;
+};
+
+Layout MakeLayout(int channels, int height, int width, bool channel_last) {
+  int64_t image = static_cast<int64_t>(channels) * height * width;
+  if (channel_last) {
+    return {image, 1, static_cast<int64_t>(width) * channels, channels};
+  }
+  return {image, static_cast<int64_t>(height) * width, width, 1};
+}
+
+int64_t GrainSize(int64_t cost) {
+  return std::max<int64_t>(1, CPUContext::kDefaultGrainSize / cost);
+}
+
+template <typename T>
+void Conv1x1(const CPUContext& dev_ctx,
+             const CpuConv2dShape& shape,
+             const T* input,
+             const T* filter,
+             T* output) {
+  auto blas = GetBlas<CPUContext, T>(dev_ctx);
+  const int in_step = shape.in_channels / shape.groups;
+  const int out_step = shape.out_channels / shape.groups;
+  const int64_t hw = static_cast<int64_t>(shape.out_h) * shape.out_w;
+  if (shape.channel_last) {
+    // output[NHW, O] = input[NHW, C] * filter[O, C]^T, one GEMM per group.
+    const int rows = static_cast<int>(shape.batch_size * hw);
+    for (int g = 0; g < shape.groups; ++g) {
+      blas.GEMM(false,
+                true,
+                rows,
+                out_step,
+                in_step,
+                static_cast<T>(1),
+                input + g * in_step,
+                shape.in_channels,
+                filter + static_cast<int64_t>(g) * out_step * in_step,
+                in_step,
+                static_cast<T>(0),
+                output + g * out_step,
+                shape.out_channels);
+    }
+    return;
+  }
+  // output[n][O, HW] = filter[O, C] * input[n][C, HW].
+  if (shape.groups == 1) {
+    blas.BatchedGEMM(CblasNoTrans,
+                     CblasNoTrans,
+                     shape.out_channels,
+                     static_cast<int>(hw),
+                     shape.in_channels,
+                     static_cast<T>(1),
+                     filter,
+                     input,
+                     static_cast<T>(0),
+                     output,
+                     shape.batch_size,
+                     0,
+                     shape.in_channels * hw);
+    return;
+  }
+  for (int n = 0; n < shape.batch_size; ++n) {
+    for (int g = 0; g < shape.groups; ++g) {
+      blas.GEMM(false,
+                false,
+                out_step,
+                static_cast<int>(hw),
+                in_step,
+                static_cast<T>(1),
+                filter + static_cast<int64_t>(g) * out_step * in_step,
+                in_step,
+                input + (n * shape.in_channels + g * in_step) * hw,
+                static_cast<int>(hw),
+                static_cast<T>(0),
+                output + (n * shape.out_channels + g * out_step) * hw,
+                static_cast<int>(hw));
+    }
+  }
+}
+
+// The range [begin, end) of the outputs whose input index o * stride + offset
+// is in [0, size).
+inline void ValidRange(
+    int size, int out_size, int stride, int offset, int* begin, int* end) {
+  *begin = offset >= 0 ? 0 : (-offset + stride - 1) / stride;
+  *end = size - offset <= 0 ? 0 : (size - offset - 1) / stride + 1;
+  *end = std::min(*end, out_size);
+  *begin = std::min(*begin, *end);
+}
+
+template <typename T>
+void DepthwiseConvNHWC(const CPUContext& dev_ctx,
+                       const CpuConv2dShape& shape,
+                       const T* input,
+                       const T* filter,
+                       T* output) {
+  const int channels = shape.in_channels;
+  const int kernel_size = shape.kernel_h * shape.kernel_w;
+  // [C, 1, KH, KW] to [KH, KW, C], so that the loops run along the channels.
+  std::vector<T> filter_hwc(static_cast<size_t>(kernel_size) * channels);
+  for (int c = 0; c < channels; ++c) {
+    for (int k = 0; k < kernel_size; ++k) {
+      filter_hwc[k * channels + c] = filter[c * kernel_size + k];
+    }
+  }
+  const int64_t rows = static_cast<int64_t>(shape.batch_size) * shape.out_h;
+  const int64_t grain_size =
+      GrainSize(static_cast<int64_t>(shape.out_w) * channels * kernel_size);
+  dev_ctx.ParallelFor(rows, grain_size, [&](int64_t begin, int64_t end) {
+    for (int64_t row = begin; row < end; ++row) {
+      const int n = static_cast<int>(row / shape.out_h);
+      const int oh = static_cast<int>(row % shape.out_h);
+      const T* x = input + n * static_cast<int64_t>(shape.in_h) *
+                               shape.in_w * channels;
+      T* y = output + row * shape.out_w * channels;
+      std::fill(y, y + static_cast<int64_t>(shape.out_w) * channels, T(0));
+      for (int kh = 0; kh < shape.kernel_h; ++kh) {
+        const int ih = oh * shape.stride_h - shape.pad_top +
+                       kh * shape.dilation_h;
+        if (ih < 0 || ih >= shape.in_h) continue;
+        for (int kw = 0; kw < shape.kernel_w; ++kw) {
+          const int offset = kw * shape.dilation_w - shape.pad_left;
+          int ow_begin, ow_end;
+          ValidRange(shape.in_w,
+                     shape.out_w,
+                     shape.stride_w,
+                     offset,
+                     &ow_begin,
+                     &ow_end);
+          const T* w = filter_hwc.data() +
+                       (kh * shape.kernel_w + kw) * channels;
+          for (int ow = ow_begin; ow < ow_end; ++ow) {
+            const int iw = ow * shape.stride_w + offset;
+            const T* xp =
+                x + (static_cast<int64_t>(ih) * shape.in_w + iw) * channels;
+            T* yp = y + static_cast<int64_t>(ow) * channels;
+            for (int c = 0; c < channels; ++c) {
+              yp[c] += xp[c] * w[c];
+            }
+          }
+        }
+      }
+    }
+  });
+}
+
+template <typename T>
+void DepthwiseConvNCHW(const CPUContext& dev_ctx,
+                       const CpuConv2dShape& shape,
+                       const T* input,
+                       const T* filter,
+                       T* output) {
+  const int channels = shape.in_channels;
+  const int kernel_size = shape.kernel_h * shape.kernel_w;
+  const int64_t planes = static_cast<int64_t>(shape.batch_size) * channels;
+  const int64_t plane_cost =
+      static_cast<int64_t>(shape.out_h) * shape.out_w * kernel_size;
+  dev_ctx.ParallelFor(
+      planes, GrainSize(plane_cost), [&](int64_t begin, int64_t end) {
+        for (int64_t plane = begin; plane < end; ++plane) {
+          const int c = static_cast<int>(plane % channels);
+          const T* x = input + plane * shape.in_h * shape.in_w;
+          const T* w = filter + c * kernel_size;
+          T* y = output + plane * shape.out_h * shape.out_w;
+          std::fill(
+              y, y + static_cast<int64_t>(shape.out_h) * shape.out_w, T(0));
+          for (int oh = 0; oh < shape.out_h; ++oh) {
+            T* y_row = y + static_cast<int64_t>(oh) * shape.out_w;
+            for (int kh = 0; kh < shape.kernel_h; ++kh) {
+              const int ih = oh * shape.stride_h - shape.pad_top +
+                             kh * shape.dilation_h;
+              if (ih < 0 || ih >= shape.in_h) continue;
+              const T* x_row = x + static_cast<int64_t>(ih) * shape.in_w;
+              for (int kw = 0; kw < shape.kernel_w; ++kw) {
+                const int offset = kw * shape.dilation_w - shape.pad_left;
+                int ow_begin, ow_end;
+                ValidRange(shape.in_w,
+                           shape.out_w,
+                           shape.stride_w,
+                           offset,
+                           &ow_begin,
+                           &ow_end);
+                const T wv = w[kh * shape.kernel_w + kw];
+                for (int ow = ow_begin; ow < ow_end; ++ow) {
+                  y_row[ow] += x_row[ow * shape.stride_w + offset] * wv;
+                }
+              }
+            }
+          }
+        }
+      });
+}
+
+// The matrices of Winograd F(m x m, 3 x 3) on tiles of t = m + 2: a tile d
+// of the input and a filter g give the m x m outputs
+// A^T [(G g G^T) .* (B^T d B)] A.
+struct WinogradMatrices {
+  int m;
+  int t;
+  const double* bt;  // t x t
+  const double* g;   // t x 3
+  const double* at;  // m x t
+};
+
+const WinogradMatrices& GetWinogradMatrices(CpuConvAlgo algo) {
+  // clang-format off
+  static const double kBtF2[] = {
+      1,  0, -1,  0,
+      0,  1,  1,  0,
+      0, -1,  1,  0,
+      0,  1,  0, -1};
+  static const double kGF2[] = {
+      1,    0,    0,
+      0.5,  0.5,  0.5,
+      0.5, -0.5,  0.5,
+      0,    0,    1};
+  static const double kAtF2[] = {
+      1,  1,  1,  0,
+      0,  1, -1, -1};
+  static const double kBtF4[] = {
+      4,  0, -5,  0,  1,  0,
+      0, -4, -4,  1,  1,  0,
+      0,  4, -4, -1,  1,  0,
+      0, -2, -1,  2,  1,  0,
+      0,  2, -1, -2,  1,  0,
+      0,  4,  0, -5,  0,  1};
+  static const double kGF4[] = {
+       1. / 4,   0,        0,
+      -1. / 6,  -1. / 6,  -1. / 6,
+      -1. / 6,   1. / 6,  -1. / 6,
+       1. / 24,  1. / 12,  1. / 6,
+       1. / 24, -1. / 12,  1. / 6,
+       0,        0,        1};
+  static const double kAtF4[] = {
+      1,  1,  1,  1,  1,  0,
+      0,  1, -1,  2, -2,  0,
+      0,  1,  1,  4,  4,  0,
+      0,  1, -1,  8, -8,  1};
+  // clang-format on
+  static const WinogradMatrices kF2 = {2, 4, kBtF2, kGF2, kAtF2};
+  static const WinogradMatrices kF4 = {4, 6, kBtF4, kGF4, kAtF4};
+  return algo == CpuConvAlgo::kWinogradF4 ? kF4 : kF2;
+}
+
+// out[rows x t] = left[rows x inner] * right[inner x t]^T, where the right
+// matrix is given transposed, as t x inner.
+template <typename T>
+inline void MulTransposed(const double* left,
+                          const T* right,
+                          int rows,
+                          int inner,
+                          int t,
+                          T* out) {
+  for (int i = 0; i < rows; ++i) {
+    for (int j = 0; j < t; ++j) {
+      T sum = 0;
+      for (int k = 0; k < inner; ++k) {
+        sum += static_cast<T>(left[i * inner + k]) * right[j * inner + k];
+      }
+      out[i * t + j] = sum;
+    }
+  }
+}
+
+// out = x * right^T for x of rows x inner and right of t x inner.
+template <typename T>
+inline void MulRightTransposed(
+    const T* x, const double* right, int rows, int inner, int t, T* out) {
+  for (int i = 0; i < rows; ++i) {
+    for (int j = 0; j < t; ++j) {
+      T sum = 0;
+      for (int k = 0; k < inner; ++k) {
+        sum += x[i * inner + k] * static_cast<T>(right[j * inner + k]);
+      }
+      out[i * t + j] = sum;
+    }
+  }
+}
+
+// The tiles of the input transformed by a block are at most this many
+// elements, with the products of the block.
+constexpr int64_t kWinogradWorkspaceSize = 1 << 20;
+
+template <typename T>
+void WinogradConv(const CPUContext& dev_ctx,
+                  CpuConvAlgo algo,
+                  const CpuConv2dShape& shape,
+                  const T* input,
+                  const T* filter,
+                  T* output) {
+  const auto& mat = GetWinogradMatrices(algo);
+  const int m = mat.m;
+  const int t = mat.t;
+  const int tt = t * t;
+  const int in_c = shape.in_channels;
+  const int out_c = shape.out_channels;
+  const Layout in_layout =
+      MakeLayout(in_c, shape.in_h, shape.in_w, shape.channel_last);
+  const Layout out_layout =
+      MakeLayout(out_c, shape.out_h, shape.out_w, shape.channel_last);
+
+  // U[e][o][c], the element e of G g G^T of the filter (o, c).
+  std::vector<T> u(static_cast<size_t>(tt) * out_c * in_c);
+  dev_ctx.ParallelFor(
+      out_c, GrainSize(in_c * tt * 12), [&](int64_t begin, int64_t end) {
+        T g_left[6 * 3];
+        T g_tile[6 * 6];
+        T g[3 * 3];
+        for (int64_t o = begin; o < end; ++o) {
+          for (int c = 0; c < in_c; ++c) {
+            const T* w = filter + (o * in_c + c) * 9;
+            // G g, then (G g) G^T. g is passed transposed to the first one.
+            for (int i = 0; i < 3; ++i) {
+              for (int j = 0; j < 3; ++j) g[j * 3 + i] = w[i * 3 + j];
+            }
+            MulTransposed(mat.g, g, t, 3, 3, g_left);
+            MulRightTransposed(g_left, mat.g, t, 3, t, g_tile);
+            for (int e = 0; e < tt; ++e) {
+              u[(static_cast<int64_t>(e) * out_c + o) * in_c + c] = g_tile[e];
+            }
+          }
+        }
+      });
+
+  const int tiles_h = (shape.out_h + m - 1) / m;
+  const int tiles_w = (shape.out_w + m - 1) / m;
+  const int64_t tiles_per_image = static_cast<int64_t>(tiles_h) * tiles_w;
+  const int64_t num_tiles = shape.batch_size * tiles_per_image;
+  const int64_t block_size = std::max<int64_t>(
+      8,
+      std::min<int64_t>(
+          256, kWinogradWorkspaceSize / (static_cast<int64_t>(tt) *
+                                         (in_c + out_c))));
+  const int64_t num_blocks = (num_tiles + block_size - 1) / block_size;
+
+  dev_ctx.ParallelFor(num_blocks, 1, [&](int64_t block_begin,
+                                         int64_t block_end) {
+    auto blas = GetBlas<CPUContext, T>(dev_ctx);
+    std::vector<T> v(static_cast<size_t>(tt) * in_c * block_size);
+    std::vector<T> prod(static_cast<size_t>(tt) * out_c * block_size);
+    T d[6 * 6];
+    T tmp[6 * 6];
+    T tile[6 * 6];
+    for (int64_t block = block_begin; block < block_end; ++block) {
+      const int64_t first = block * block_size;
+      const int pb =
+          static_cast<int>(std::min(block_size, num_tiles - first));
+      // V[e][c][p], the element e of B^T d B of the input tile p.
+      for (int p = 0; p < pb; ++p) {
+        const int64_t tile_id = first + p;
+        const int64_t n = tile_id / tiles_per_image;
+        const int th = static_cast<int>(tile_id / tiles_w % tiles_h);
+        const int tw = static_cast<int>(tile_id % tiles_w);
+        const int h0 = th * m - shape.pad_top;
+        const int w0 = tw * m - shape.pad_left;
+        for (int c = 0; c < in_c; ++c) {
+          const T* x = input + n * in_layout.n + c * in_layout.c;
+          for (int i = 0; i < t; ++i) {
+            const int ih = h0 + i;
+            for (int j = 0; j < t; ++j) {
+              const int iw = w0 + j;
+              // d is stored transposed for the first product.
+              d[j * t + i] =
+                  (ih >= 0 && ih < shape.in_h && iw >= 0 && iw < shape.in_w)
+                      ? x[ih * in_layout.h + iw * in_layout.w]
+                      : static_cast<T>(0);
+            }
+          }
+          MulTransposed(mat.bt, d, t, t, t, tmp);
+          MulRightTransposed(tmp, mat.bt, t, t, t, tile);
+          for (int e = 0; e < tt; ++e) {
+            v[(static_cast<int64_t>(e) * in_c + c) * pb + p] = tile[e];
+          }
+        }
+      }
+      // prod[e] = U[e] * V[e], of out_c x pb.
+      blas.BatchedGEMM(CblasNoTrans,
+                       CblasNoTrans,
+                       out_c,
+                       pb,
+                       in_c,
+                       static_cast<T>(1),
+                       u.data(),
+                       v.data(),
+                       static_cast<T>(0),
+                       prod.data(),
+                       tt,
+                       static_cast<int64_t>(out_c) * in_c,
+                       static_cast<int64_t>(in_c) * pb);
+      // A^T prod A into the outputs of the tiles.
+      for (int p = 0; p < pb; ++p) {
+        const int64_t tile_id = first + p;
+        const int64_t n = tile_id / tiles_per_image;
+        const int th = static_cast<int>(tile_id / tiles_w % tiles_h);
+        const int tw = static_cast<int>(tile_id % tiles_w);
+        const int rows = std::min(m, shape.out_h - th * m);
+        const int cols = std::min(m, shape.out_w - tw * m);
+        for (int o = 0; o < out_c; ++o) {
+          for (int e = 0; e < tt; ++e) {
+            // Transposed for the first product.
+            d[(e % t) * t + e / t] =
+                prod[(static_cast<int64_t>(e) * out_c + o) * pb + p];
+          }
+          MulTransposed(mat.at, d, m, t, t, tmp);
+          MulRightTransposed(tmp, mat.at, m, t, m, tile);
+          T* y = output + n * out_layout.n + o * out_layout.c;
+          for (int i = 0; i < rows; ++i) {
+            for (int j = 0; j < cols; ++j) {
+              y[(th * m + i) * out_layout.h + (tw * m + j) * out_layout.w] =
+                  tile[i * m + j];
+            }
+          }
+        }
+      }
+    }
+  });
+}
+
+}  // namespace
+
+const char* CpuConvAlgoName(CpuConvAlgo algo) {
+  switch (algo) {
+    case CpuConvAlgo::kIm2ColGemm:
+      return "im2col_gemm";
+    case CpuConvAlgo::kGemm1x1:
+      return "gemm_1x1";
+    case CpuConvAlgo::kWinogradF2:
+      return "winograd_f2x2_3x3";
+    case CpuConvAlgo::kWinogradF4:
+      return "winograd_f4x4_3x3";
+    case CpuConvAlgo::kDepthwise:
+      return "depthwise";
+    default:
+      return "unknown";
+  }
+}
+
+bool CpuConvSupports(CpuConvAlgo algo, const CpuConv2dShape& shape) {
+  switch (algo) {
+    case CpuConvAlgo::kIm2ColGemm:
+      return true;
+    case CpuConvAlgo::kGemm1x1:
+      return shape.kernel_h == 1 && shape.kernel_w == 1 &&
+             shape.stride_h == 1 && shape.stride_w == 1 &&
+             shape.pad_top == 0 && shape.pad_left == 0 &&
+             shape.out_h == shape.in_h && shape.out_w == shape.in_w;
+    case CpuConvAlgo::kWinogradF2:
+    case CpuConvAlgo::kWinogradF4:
+      return shape.kernel_h == 3 && shape.kernel_w == 3 &&
+             shape.stride_h == 1 && shape.stride_w == 1 &&
+             shape.dilation_h == 1 && shape.dilation_w == 1 &&
+             shape.groups == 1;
+    case CpuConvAlgo::kDepthwise:
+      return shape.groups > 1 && shape.groups == shape.in_channels &&
+             shape.out_channels == shape.in_channels;
+    default:
+      return false;
+  }
+}
+
+CpuConvAlgo SelectCpuConvAlgo(const CpuConv2dShape& shape) {
+  if (CpuConvSupports(CpuConvAlgo::kDepthwise, shape)) {
+    return CpuConvAlgo::kDepthwise;
+  }
+  if (CpuConvSupports(CpuConvAlgo::kGemm1x1, shape)) {
+    return CpuConvAlgo::kGemm1x1;
+  }
+  // Winograd rounds differently from a direct conv, so it is left to the
+  // autotune, which only times it for float.
+  return CpuConvAlgo::kIm2ColGemm;
+}
+
+template <typename T>
+void CpuConv2d(const CPUContext& dev_ctx,
+               CpuConvAlgo algo,
+               const CpuConv2dShape& shape,
+               const T* input,
+               const T* filter,
+               T* output) {
+  PADDLE_ENFORCE_EQ(
+      algo != CpuConvAlgo::kIm2ColGemm && CpuConvSupports(algo, shape),
+      true,
+      phi::errors::InvalidArgument(
+          "The CPU conv algorithm %s does not support the conv.",
+          CpuConvAlgoName(algo)));
+  switch (algo) {
+    case CpuConvAlgo::kGemm1x1:
+      Conv1x1(dev_ctx, shape, input, filter, output);
+      break;
+    case CpuConvAlgo::kWinogradF2:
+    case CpuConvAlgo::kWinogradF4:
+      WinogradConv(dev_ctx, algo, shape, input, filter, output);
+      break;
+    case CpuConvAlgo::kDepthwise:
+      if (shape.channel_last) {
+        DepthwiseConvNHWC(dev_ctx, shape, input, filter, output);
+      } else {
+        DepthwiseConvNCHW(dev_ctx, shape, input, filter, output);
+      }
+      break;
+    default:
+      break;
+  }
+}
+
+template void CpuConv2d<float>(const CPUContext&,
+                               CpuConvAlgo,
+                               const CpuConv2dShape&,
+                               const float*,
+                               const float*,
+                               float*);
+template void CpuConv2d<double>(const CPUContext&,
+                                CpuConvAlgo,
+                                const CpuConv2dShape&,
+                                const double*,
+                                const double*,
+                                double*);
+
+}  // namespace funcs
+}  // namespace phi
@@ -0,0 +1,82 @@
+/* Copyright (c) 2022 PaddlePaddle Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License. */
+
+#pragma once
+
+#include <string>
+
+#include "paddle/phi/backends/cpu/cpu_context.h"
+
+namespace phi {
+namespace funcs {
+
+// The algorithms of the CPU conv2d. Except for the generic im2col + GEMM of
+// ConvKernel, they need neither the col buffer nor the transposes of the
+// NHWC tensors, which they read and write in place.
+enum class CpuConvAlgo {
+  // im2col + GEMM, for any conv.
+  kIm2ColGemm = 0,
+  // A GEMM on the input, for the 1x1 convs of stride 1 without padding.
+  kGemm1x1 = 1,
+  // Winograd F(2x2, 3x3) and F(4x4, 3x3), for the 3x3 convs of stride 1
+  // without dilation or groups.
+  kWinogradF2 = 2,
+  kWinogradF4 = 3,
+  // A direct loop, for the depthwise convs with one filter per channel.
+  kDepthwise = 4,
+  kCount = 5,
+};
+
+const char* CpuConvAlgoName(CpuConvAlgo algo);
+
+struct CpuConv2dShape {
+  int batch_size;
+  int in_channels;
+  int in_h;
+  int in_w;
+  int out_channels;
+  int out_h;
+  int out_w;
+  int kernel_h;
+  int kernel_w;
+  int stride_h;
+  int stride_w;
+  // The bottom and right paddings follow from the output size.
+  int pad_top;
+  int pad_left;
+  int dilation_h;
+  int dilation_w;
+  int groups;
+  bool channel_last;
+};
+
+bool CpuConvSupports(CpuConvAlgo algo, const CpuConv2dShape& shape);
+
+// The algorithm expected to be the fastest for the shape among the ones
+// that match the numerics of im2col; Winograd is never chosen.
+CpuConvAlgo SelectCpuConvAlgo(const CpuConv2dShape& shape);
+
+// output = conv2d(input, filter) with any algorithm but kIm2ColGemm, which
+// ConvKernel runs itself. The input and the output are NCHW or NHWC as the
+// shape tells, and the filter is OIHW.
+template <typename T>
+void CpuConv2d(const CPUContext& dev_ctx,
+               CpuConvAlgo algo,
+               const CpuConv2dShape& shape,
+               const T* input,
+               const T* filter,
+               T* output);
+
+}  // namespace funcs
+}  // namespace phi
@@ -0,0 +1,390 @@
+/* Copyright (c) 2022 PaddlePaddle Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License. */
+
+#include "paddle/phi/kernels/funcs/cpu_embedding.h"
+
+#include <algorithm>
+#include <cstring>
+
+#include "paddle/fluid/platform/cpu_info.h"
+#include "paddle/phi/common/bfloat16.h"
+#include "paddle/phi/common/float16.h"
+#include "paddle/phi/core/enforce.h"
+
+// The row kernels are compiled with function level targets, as the
+// microkernels of CpuGemm.
+#if defined(__x86_64__) && !defined(_WIN32) && \
+    (defined(__clang__) || defined(__GNUC__))
+#define PADDLE_CPU_EMBEDDING_WITH_AVX
+#include <immintrin.h>
+#endif
+
+namespace phi {
+namespace funcs {
+
+namespace {
+
+// How many ids ahead the rows are prefetched, and how much of a row.
+constexpr int64_t kPrefetchDistance = 8;
+constexpr int64_t kPrefetchBytes = 1024;
+
+inline void PrefetchRow(const void* row, int64_t bytes) {
+#if defined(__clang__) || defined(__GNUC__)
+  const char* p = static_cast<const char*>(row);
+  bytes = std::min(bytes, kPrefetchBytes);
+  for (int64_t i = 0; i < bytes; i += 64) {
+    __builtin_prefetch(p + i, 0, 1);
+  }
+#endif
+}
+
+template <typename IdT>
+inline void CheckId(IdT id, int64_t height) {
+  PADDLE_ENFORCE_LT(
+      id,
+      height,
+      phi::errors::InvalidArgument(
+          "Variable value (input) of OP(fluid.layers.embedding) "
+          "expected >= 0 and < %ld, but got %ld. Please check input "
+          "value.",
+          height,
+          id));
+  PADDLE_ENFORCE_GE(
+      id,
+      0,
+      phi::errors::InvalidArgument(
+          "Variable value (input) of OP(fluid.layers.embedding) "
+          "expected >= 0 and < %ld, but got %ld. Please check input "
+          "value.",
+          height,
+          id));
+}
+
+// out = row, or out += row, for the rows of each type.
+using RowFunc = void (*)(const char* row, int64_t width, float* out);
+
+void CopyFloat32(const char* row, int64_t width, float* out) {
+  std::memcpy(out, row, width * sizeof(float));
+}
+
+void AddFloat32(const char* row, int64_t width, float* out) {
+  const float* in = reinterpret_cast<const float*>(row);
+  for (int64_t i = 0; i < width; ++i) out[i] += in[i];
+}
+
+template <bool kAccumulate>
+void Float16Row(const char* row, int64_t width, float* out) {
+  const dtype::float16* in = reinterpret_cast<const dtype::float16*>(row);
+  for (int64_t i = 0; i < width; ++i) {
+    float x = static_cast<float>(in[i]);
+    out[i] = kAccumulate ? out[i] + x : x;
+  }
+}
+
+template <bool kAccumulate>
+void UInt8MinMaxRow(const char* row, int64_t width, float* out) {
+  const float* min_max = reinterpret_cast<const float*>(row);
+  const float min = min_max[0];
+  const float scale = (min_max[1] - min) / 256;
+  const uint8_t* in = reinterpret_cast<const uint8_t*>(row + 2 * sizeof(float));
+  for (int64_t i = 0; i < width; ++i) {
+    float x = scale * in[i] + min;
+    out[i] = kAccumulate ? out[i] + x : x;
+  }
+}
+
+#ifdef PADDLE_CPU_EMBEDDING_WITH_AVX
+__attribute__((target("avx"))) void AddFloat32Avx(const char* row,
+                                                  int64_t width,
+                                                  float* out) {
+  const float* in = reinterpret_cast<const float*>(row);
+  int64_t i = 0;
+  for (; i + 8 <= width; i += 8) {
+    _mm256_storeu_ps(
+        out + i,
+        _mm256_add_ps(_mm256_loadu_ps(out + i), _mm256_loadu_ps(in + i)));
+  }
+  for (; i < width; ++i) out[i] += in[i];
+}
+
+// F16C came with AVX2 on every x86 CPU.
+template <bool kAccumulate>
+__attribute__((target("avx2,f16c"))) void Float16RowAvx2(const char* row,
+                                                         int64_t width,
+                                                         float* out) {
+  const uint16_t* in = reinterpret_cast<const uint16_t*>(row);
+  int64_t i = 0;
+  for (; i + 8 <= width; i += 8) {
+    __m256 x = _mm256_cvtph_ps(
+        _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + i)));
+    if (kAccumulate) x = _mm256_add_ps(x, _mm256_loadu_ps(out + i));
+    _mm256_storeu_ps(out + i, x);
+  }
+  if (i < width) {
+    Float16Row<kAccumulate>(
+        row + i * sizeof(uint16_t), width - i, out + i);
+  }
+}
+
+template <bool kAccumulate>
+__attribute__((target("avx2"))) void UInt8MinMaxRowAvx2(const char* row,
+                                                        int64_t width,
+                                                        float* out) {
+  const float* min_max = reinterpret_cast<const float*>(row);
+  const float min = min_max[0];
+  const float scale = (min_max[1] - min) / 256;
+  const __m256 min8 = _mm256_set1_ps(min);
+  const __m256 scale8 = _mm256_set1_ps(scale);
+  const uint8_t* in = reinterpret_cast<const uint8_t*>(row + 2 * sizeof(float));
+  int64_t i = 0;
+  for (; i + 8 <= width; i += 8) {
+    __m128i q = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(in + i));
+    __m256 x = _mm256_cvtepi32_ps(_mm256_cvtepu8_epi32(q));
+    x = _mm256_add_ps(_mm256_mul_ps(x, scale8), min8);
+    if (kAccumulate) x = _mm256_add_ps(x, _mm256_loadu_ps(out + i));
+    _mm256_storeu_ps(out + i, x);
+  }
+  for (; i < width; ++i) {
+    float x = scale * in[i] + min;
+    out[i] = kAccumulate ? out[i] + x : x;
+  }
+}
+#endif
+
+// The kernels copying a row of the type to out, or adding it to out.
+void GetRowFuncs(EmbeddingRowType row_type, RowFunc* copy, RowFunc* add) {
+  switch (row_type) {
+    case EmbeddingRowType::kFloat32:
+      *copy = CopyFloat32;
+      *add = AddFloat32;
+      break;
+    case EmbeddingRowType::kFloat16:
+      *copy = Float16Row<false>;
+      *add = Float16Row<true>;
+      break;
+    case EmbeddingRowType::kUInt8MinMax:
+      *copy = UInt8MinMaxRow<false>;
+      *add = UInt8MinMaxRow<true>;
+      break;
+    default:
+      PADDLE_THROW(phi::errors::Unimplemented(
+          "Unsupported row type %d of the embedding table.",
+          static_cast<int>(row_type)));
+  }
+#ifdef PADDLE_CPU_EMBEDDING_WITH_AVX
+  if (row_type == EmbeddingRowType::kFloat32 &&
+      paddle::platform::MayIUse(paddle::platform::avx)) {
+    *add = AddFloat32Avx;
+  }
+  if (paddle::platform::MayIUse(paddle::platform::avx2)) {
+    if (row_type == EmbeddingRowType::kFloat16) {
+      *copy = Float16RowAvx2<false>;
+      *add = Float16RowAvx2<true>;
+    } else if (row_type == EmbeddingRowType::kUInt8MinMax) {
+      *copy = UInt8MinMaxRowAvx2<false>;
+      *add = UInt8MinMaxRowAvx2<true>;
+    }
+  }
+#endif
+}
+
+}  // namespace
+
+CpuEmbeddingTable::CpuEmbeddingTable(EmbeddingRowType row_type,
+                                     const void* data,
+                                     int64_t height,
+                                     int64_t width)
+    : row_type(row_type), data(data), height(height), width(width) {
+  switch (row_type) {
+    case EmbeddingRowType::kFloat32:
+      row_bytes = width * sizeof(float);
+      break;
+    case EmbeddingRowType::kFloat16:
+      row_bytes = width * sizeof(dtype::float16);
+      break;
+    case EmbeddingRowType::kUInt8MinMax:
+      row_bytes = 2 * sizeof(float) + width;
+      break;
+    default:
+      PADDLE_THROW(phi::errors::Unimplemented(
+          "Unsupported row type %d of the embedding table.",
+          static_cast<int>(row_type)));
+  }
+}
+
+template <typename T, typename IdT>
+void CpuEmbeddingLookup(const CPUContext& context,
+                        const T* table,
+                        int64_t height,
+                        int64_t width,
+                        const IdT* ids,
+                        int64_t num_ids,
+                        int64_t padding_idx,
+                        T* out) {
+  const int64_t row_bytes = width * sizeof(T);
+  const int64_t grain_size =
+      std::max<int64_t>(1, CPUContext::kDefaultGrainSize / (width + 1));
+  context.ParallelFor(num_ids, grain_size, [&](int64_t begin, int64_t end) {
+    for (int64_t i = begin; i < end; ++i) {
+      if (i + kPrefetchDistance < end) {
+        IdT next = ids[i + kPrefetchDistance];
+        if (next >= 0 && next < height) {
+          PrefetchRow(table + next * width, row_bytes);
+        }
+      }
+      if (padding_idx != -1 && ids[i] == padding_idx) {
+        std::memset(out + i * width, 0, row_bytes);
+      } else {
+        CheckId(ids[i], height);
+        std::memcpy(out + i * width, table + ids[i] * width, row_bytes);
+      }
+    }
+  });
+}
+
+template <typename IdT>
+void CpuEmbeddingLookup(const CPUContext& context,
+                        const CpuEmbeddingTable& table,
+                        const IdT* ids,
+                        int64_t num_ids,
+                        int64_t padding_idx,
+                        float* out) {
+  RowFunc copy;
+  RowFunc add;
+  GetRowFuncs(table.row_type, &copy, &add);
+  const char* data = static_cast<const char*>(table.data);
+  const int64_t width = table.width;
+  const int64_t grain_size =
+      std::max<int64_t>(1, CPUContext::kDefaultGrainSize / (width + 1));
+  context.ParallelFor(num_ids, grain_size, [&](int64_t begin, int64_t end) {
+    for (int64_t i = begin; i < end; ++i) {
+      if (i + kPrefetchDistance < end) {
+        IdT next = ids[i + kPrefetchDistance];
+        if (next >= 0 && next < table.height) {
+          PrefetchRow(data + next * table.row_bytes, table.row_bytes);
+        }
+      }
+      if (padding_idx != -1 && ids[i] == padding_idx) {
+        std::memset(out + i * width, 0, width * sizeof(float));
+      } else {
+        CheckId(ids[i], table.height);
+        copy(data + ids[i] * table.row_bytes, width, out + i * width);
+      }
+    }
+  });
+}
+
+template <typename IdT>
+void CpuEmbeddingSeqPool(const CPUContext& context,
+                         const CpuEmbeddingTable& table,
+                         const IdT* ids,
+                         const std::vector<size_t>& offsets,
+                         int64_t idx_width,
+                         int64_t padding_idx,
+                         EmbeddingPoolType pool_type,
+                         float* out) {
+  PADDLE_ENFORCE_GT(offsets.size(),
+                    1UL,
+                    phi::errors::InvalidArgument(
+                        "The LoD offsets of the ids should hold more than one "
+                        "offset, but received %d.",
+                        offsets.size()));
+  RowFunc copy;
+  RowFunc add;
+  GetRowFuncs(table.row_type, &copy, &add);
+  const char* data = static_cast<const char*>(table.data);
+  const int64_t width = table.width;
+  const int64_t num_seqs = offsets.size() - 1;
+  // A task pools a column of a sequence, of offsets.back() / num_seqs ids
+  // on average.
+  const int64_t num_tasks = num_seqs * idx_width;
+  const int64_t ids_per_seq =
+      std::max<int64_t>(1, static_cast<int64_t>(offsets.back()) / num_seqs);
+  const int64_t grain_size = std::max<int64_t>(
+      1, CPUContext::kDefaultGrainSize / (width * ids_per_seq + 1));
+  context.ParallelFor(num_tasks, grain_size, [&](int64_t begin, int64_t end) {
+    for (int64_t task = begin; task < end; ++task) {
+      const int64_t seq = task / idx_width;
+      const int64_t column = task % idx_width;
+      const int64_t first = offsets[seq];
+      const int64_t last = offsets[seq + 1];
+      float* dst = out + task * width;
+      bool empty = true;
+      for (int64_t j = first; j < last; ++j) {
+        if (j + kPrefetchDistance < last) {
+          IdT next = ids[(j + kPrefetchDistance) * idx_width + column];
+          if (next >= 0 && next < table.height) {
+            PrefetchRow(data + next * table.row_bytes, table.row_bytes);
+          }
+        }
+        const IdT id = ids[j * idx_width + column];
+        if (padding_idx != -1 && id == padding_idx) continue;
+        CheckId(id, table.height);
+        (empty ? copy : add)(data + id * table.row_bytes, width, dst);
+        empty = false;
+      }
+      if (empty) {
+        std::memset(dst, 0, width * sizeof(float));
+      } else if (pool_type == EmbeddingPoolType::kMean) {
+        const float scale = 1.0f / (last - first);
+        for (int64_t k = 0; k < width; ++k) dst[k] *= scale;
+      }
+    }
+  });
+}
+
+#define INSTANTIATE_CPU_EMBEDDING_LOOKUP(T)                      \
+  template void CpuEmbeddingLookup<T, int32_t>(const CPUContext&, \
+                                               const T*,          \
+                                               int64_t,           \
+                                               int64_t,           \
+                                               const int32_t*,    \
+                                               int64_t,           \
+                                               int64_t,           \
+                                               T*);               \
+  template void CpuEmbeddingLookup<T, int64_t>(const CPUContext&, \
+                                               const T*,          \
+                                               int64_t,           \
+                                               int64_t,           \
+                                               const int64_t*,    \
+                                               int64_t,           \
+                                               int64_t,           \
+                                               T*);
+
+INSTANTIATE_CPU_EMBEDDING_LOOKUP(float);
+INSTANTIATE_CPU_EMBEDDING_LOOKUP(double);
+INSTANTIATE_CPU_EMBEDDING_LOOKUP(dtype::float16);
+INSTANTIATE_CPU_EMBEDDING_LOOKUP(dtype::bfloat16);
+
+#define INSTANTIATE_CPU_EMBEDDING_TABLE(IdT)                           \
+  template void CpuEmbeddingLookup<IdT>(const CPUContext&,             \
+                                        const CpuEmbeddingTable&,      \
+                                        const IdT*,                    \
+                                        int64_t,                       \
+                                        int64_t,                       \
+                                        float*);                       \
+  template void CpuEmbeddingSeqPool<IdT>(const CPUContext&,            \
+                                         const CpuEmbeddingTable&,     \
+                                         const IdT*,                   \
+                                         const std::vector<size_t>&,   \
+                                         int64_t,                      \
+                                         int64_t,                      \
+                                         EmbeddingPoolType,            \
+                                         float*);
+
+INSTANTIATE_CPU_EMBEDDING_TABLE(int32_t);
+INSTANTIATE_CPU_EMBEDDING_TABLE(int64_t);
+
+}  // namespace funcs
+}  // namespace phi
@@ -0,0 +1,93 @@
+/* Copyright (c) 2022 PaddlePaddle Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License. */
+
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "paddle/phi/backends/cpu/cpu_context.h"
+
+namespace phi {
+namespace funcs {
+
+// The formats of the rows of an embedding table.
+enum class EmbeddingRowType {
+  // width float values.
+  kFloat32 = 0,
+  // width float16 values.
+  kFloat16 = 1,
+  // The 8 bit rows of lookup_table_dequant: a float min and a float max,
+  // then width uint8 values q standing for min + q * (max - min) / 256.
+  kUInt8MinMax = 2,
+};
+
+struct CpuEmbeddingTable {
+  CpuEmbeddingTable(EmbeddingRowType row_type,
+                    const void* data,
+                    int64_t height,
+                    int64_t width);
+
+  EmbeddingRowType row_type;
+  const void* data;
+  int64_t height;
+  int64_t width;
+  // The size of a row in the table, with its min and max if any.
+  int64_t row_bytes;
+};
+
+enum class EmbeddingPoolType { kSum = 0, kMean = 1 };
+
+// out[i] = table[ids[i]], a row of width values, or zeros for the
+// padding_idx (none if it is -1).
+//
+// The ids are split over the intra op threads of the context, and the
+// rows of the ids a few positions ahead are prefetched while a row is
+// copied.
+template <typename T, typename IdT>
+void CpuEmbeddingLookup(const CPUContext& context,
+                        const T* table,
+                        int64_t height,
+                        int64_t width,
+                        const IdT* ids,
+                        int64_t num_ids,
+                        int64_t padding_idx,
+                        T* out);
+
+// As above, for the tables of any row type, dequantized to float.
+template <typename IdT>
+void CpuEmbeddingLookup(const CPUContext& context,
+                        const CpuEmbeddingTable& table,
+                        const IdT* ids,
+                        int64_t num_ids,
+                        int64_t padding_idx,
+                        float* out);
+
+// The lookup pooled over the sequences of the level of LoD offsets: ids
+// holds offsets.back() x idx_width ids, and out holds offsets.size() - 1
+// rows of idx_width x width values. Column j of sequence i pools the rows
+// of the ids at column j of the rows offsets[i] to offsets[i + 1] of ids.
+// The padding ids are skipped, but counted by the mean.
+template <typename IdT>
+void CpuEmbeddingSeqPool(const CPUContext& context,
+                         const CpuEmbeddingTable& table,
+                         const IdT* ids,
+                         const std::vector<size_t>& offsets,
+                         int64_t idx_width,
+                         int64_t padding_idx,
+                         EmbeddingPoolType pool_type,
+                         float* out);
+
+}  // namespace funcs
+}  // namespace phi
@@ -0,0 +1,528 @@
+// Copyright (c) 2022 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "paddle/phi/kernels/funcs/cpu_transpose.h"
+
+#include <algorithm>
+#include <cstring>
+
+#include "paddle/fluid/platform/cpu_info.h"
+#include "paddle/phi/core/ddim.h"
+#include "paddle/phi/core/enforce.h"
+
+// The register transposes are compiled with function level targets, as the
+// microkernels of CpuGemm.
+#if defined(__x86_64__) && !defined(_WIN32) && \
+    (defined(__clang__) || defined(__GNUC__))
+#define PADDLE_CPU_TRANSPOSE_WITH_AVX
+#include <immintrin.h>
+#endif
+
+namespace phi {
+namespace funcs {
+
+namespace {
+
+constexpr int kMaxRank = DDim::kMaxRank;
+// The side of the cache tiles, whose rows of the input and of the output
+// stay in L1.
+constexpr int64_t kTile = 32;
+
+struct Bytes16 {
+  uint64_t lo;
+  uint64_t hi;
+};
+
+// Walks a range of the positions of some dims of the output, keeping their
+// offsets into the input and the output.
+class OffsetCounter {
+ public:
+  OffsetCounter(int rank,
+                const int64_t* dims,
+                const int64_t* in_strides,
+                const int64_t* out_strides,
+                int64_t start)
+      : rank_(rank) {
+    for (int k = rank - 1; k >= 0; --k) {
+      dims_[k] = dims[k];
+      in_strides_[k] = in_strides[k];
+      out_strides_[k] = out_strides[k];
+      coords_[k] = start % dims[k];
+      start /= dims[k];
+      in_offset_ += coords_[k] * in_strides[k];
+      out_offset_ += coords_[k] * out_strides[k];
+    }
+  }
+
+  void Next() {
+    for (int k = rank_ - 1; k >= 0; --k) {
+      in_offset_ += in_strides_[k];
+      out_offset_ += out_strides_[k];
+      if (++coords_[k] < dims_[k]) return;
+      in_offset_ -= coords_[k] * in_strides_[k];
+      out_offset_ -= coords_[k] * out_strides_[k];
+      coords_[k] = 0;
+    }
+  }
+
+  int64_t in_offset() const { return in_offset_; }
+  int64_t out_offset() const { return out_offset_; }
+
+ private:
+  int rank_;
+  int64_t dims_[kMaxRank];
+  int64_t in_strides_[kMaxRank];
+  int64_t out_strides_[kMaxRank];
+  int64_t coords_[kMaxRank];
+  int64_t in_offset_{0};
+  int64_t out_offset_{0};
+};
+
+// dst[y * ldb + x] = src[x * lda + y] for x < rows and y < cols.
+template <typename E>
+inline void TransposeTileRef(const E* src,
+                             int64_t lda,
+                             E* dst,
+                             int64_t ldb,
+                             int64_t rows,
+                             int64_t cols) {
+  for (int64_t x = 0; x < rows; ++x) {
+    for (int64_t y = 0; y < cols; ++y) {
+      dst[y * ldb + x] = src[x * lda + y];
+    }
+  }
+}
+
+#ifdef PADDLE_CPU_TRANSPOSE_WITH_AVX
+__attribute__((target("avx"))) void Transpose8x8Avx(const uint32_t* src,
+                                                    int64_t lda,
+                                                    uint32_t* dst,
+                                                    int64_t ldb) {
+  const float* s = reinterpret_cast<const float*>(src);
+  float* d = reinterpret_cast<float*>(dst);
+  __m256 r0 = _mm256_loadu_ps(s);
+  __m256 r1 = _mm256_loadu_ps(s + lda);
+  __m256 r2 = _mm256_loadu_ps(s + 2 * lda);
+  __m256 r3 = _mm256_loadu_ps(s + 3 * lda);
+  __m256 r4 = _mm256_loadu_ps(s + 4 * lda);
+  __m256 r5 = _mm256_loadu_ps(s + 5 * lda);
+  __m256 r6 = _mm256_loadu_ps(s + 6 * lda);
+  __m256 r7 = _mm256_loadu_ps(s + 7 * lda);
+  __m256 t0 = _mm256_unpacklo_ps(r0, r1);
+  __m256 t1 = _mm256_unpackhi_ps(r0, r1);
+  __m256 t2 = _mm256_unpacklo_ps(r2, r3);
+  __m256 t3 = _mm256_unpackhi_ps(r2, r3);
+  __m256 t4 = _mm256_unpacklo_ps(r4, r5);
+  __m256 t5 = _mm256_unpackhi_ps(r4, r5);
+  __m256 t6 = _mm256_unpacklo_ps(r6, r7);
+  __m256 t7 = _mm256_unpackhi_ps(r6, r7);
+  __m256 s0 = _mm256_shuffle_ps(t0, t2, _MM_SHUFFLE(1, 0, 1, 0));
+  __m256 s1 = _mm256_shuffle_ps(t0, t2, _MM_SHUFFLE(3, 2, 3, 2));
+  __m256 s2 = _mm256_shuffle_ps(t1, t3, _MM_SHUFFLE(1, 0, 1, 0));
+  __m256 s3 = _mm256_shuffle_ps(t1, t3, _MM_SHUFFLE(3, 2, 3, 2));
+  __m256 s4 = _mm256_shuffle_ps(t4, t6, _MM_SHUFFLE(1, 0, 1, 0));
+  __m256 s5 = _mm256_shuffle_ps(t4, t6, _MM_SHUFFLE(3, 2, 3, 2));
+  __m256 s6 = _mm256_shuffle_ps(t5, t7, _MM_SHUFFLE(1, 0, 1, 0));
+  __m256 s7 = _mm256_shuffle_ps(t5, t7, _MM_SHUFFLE(3, 2, 3, 2));
+  _mm256_storeu_ps(d, _mm256_permute2f128_ps(s0, s4, 0x20));
+  _mm256_storeu_ps(d + ldb, _mm256_permute2f128_ps(s1, s5, 0x20));
+  _mm256_storeu_ps(d + 2 * ldb, _mm256_permute2f128_ps(s2, s6, 0x20));
+  _mm256_storeu_ps(d + 3 * ldb, _mm256_permute2f128_ps(s3, s7, 0x20));
+  _mm256_storeu_ps(d + 4 * ldb, _mm256_permute2f128_ps(s0, s4, 0x31));
+  _mm256_storeu_ps(d + 5 * ldb, _mm256_permute2f128_ps(s1, s5, 0x31));
+  _mm256_storeu_ps(d + 6 * ldb, _mm256_permute2f128_ps(s2, s6, 0x31));
+  _mm256_storeu_ps(d + 7 * ldb, _mm256_permute2f128_ps(s3, s7, 0x31));
+}
+
+__attribute__((target("avx"))) void Transpose4x4Avx(const uint64_t* src,
+                                                    int64_t lda,
+                                                    uint64_t* dst,
+                                                    int64_t ldb) {
+  const double* s = reinterpret_cast<const double*>(src);
+  double* d = reinterpret_cast<double*>(dst);
+  __m256d r0 = _mm256_loadu_pd(s);
+  __m256d r1 = _mm256_loadu_pd(s + lda);
+  __m256d r2 = _mm256_loadu_pd(s + 2 * lda);
+  __m256d r3 = _mm256_loadu_pd(s + 3 * lda);
+  __m256d t0 = _mm256_unpacklo_pd(r0, r1);
+  __m256d t1 = _mm256_unpackhi_pd(r0, r1);
+  __m256d t2 = _mm256_unpacklo_pd(r2, r3);
+  __m256d t3 = _mm256_unpackhi_pd(r2, r3);
+  _mm256_storeu_pd(d, _mm256_permute2f128_pd(t0, t2, 0x20));
+  _mm256_storeu_pd(d + ldb, _mm256_permute2f128_pd(t1, t3, 0x20));
+  _mm256_storeu_pd(d + 2 * ldb, _mm256_permute2f128_pd(t0, t2, 0x31));
+  _mm256_storeu_pd(d + 3 * ldb, _mm256_permute2f128_pd(t1, t3, 0x31));
+}
+
+// SSE2 is in every x86-64 CPU.
+void Transpose8x8Sse2(const uint16_t* src,
+                      int64_t lda,
+                      uint16_t* dst,
+                      int64_t ldb) {
+  auto load = [&](int64_t i) {
+    return _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i * lda));
+  };
+  __m128i a0 = load(0), a1 = load(1), a2 = load(2), a3 = load(3);
+  __m128i a4 = load(4), a5 = load(5), a6 = load(6), a7 = load(7);
+  __m128i b0 = _mm_unpacklo_epi16(a0, a1);
+  __m128i b1 = _mm_unpackhi_epi16(a0, a1);
+  __m128i b2 = _mm_unpacklo_epi16(a2, a3);
+  __m128i b3 = _mm_unpackhi_epi16(a2, a3);
+  __m128i b4 = _mm_unpacklo_epi16(a4, a5);
+  __m128i b5 = _mm_unpackhi_epi16(a4, a5);
+  __m128i b6 = _mm_unpacklo_epi16(a6, a7);
+  __m128i b7 = _mm_unpackhi_epi16(a6, a7);
+  __m128i c0 = _mm_unpacklo_epi32(b0, b2);
+  __m128i c1 = _mm_unpackhi_epi32(b0, b2);
+  __m128i c2 = _mm_unpacklo_epi32(b1, b3);
+  __m128i c3 = _mm_unpackhi_epi32(b1, b3);
+  __m128i c4 = _mm_unpacklo_epi32(b4, b6);
+  __m128i c5 = _mm_unpackhi_epi32(b4, b6);
+  __m128i c6 = _mm_unpacklo_epi32(b5, b7);
+  __m128i c7 = _mm_unpackhi_epi32(b5, b7);
+  auto store = [&](int64_t i, __m128i v) {
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i * ldb), v);
+  };
+  store(0, _mm_unpacklo_epi64(c0, c4));
+  store(1, _mm_unpackhi_epi64(c0, c4));
+  store(2, _mm_unpacklo_epi64(c1, c5));
+  store(3, _mm_unpackhi_epi64(c1, c5));
+  store(4, _mm_unpacklo_epi64(c2, c6));
+  store(5, _mm_unpackhi_epi64(c2, c6));
+  store(6, _mm_unpacklo_epi64(c3, c7));
+  store(7, _mm_unpackhi_epi64(c3, c7));
+}
+#endif
+
+// The register transpose of the elements of E, with its side, if any.
+template <typename E>
+struct MicroTranspose {
+  using Func = void (*)(const E*, int64_t, E*, int64_t);
+  static Func Get(int64_t* side) { return nullptr; }
+};
+
+#ifdef PADDLE_CPU_TRANSPOSE_WITH_AVX
+template <>
+struct MicroTranspose<uint16_t> {
+  using Func = void (*)(const uint16_t*, int64_t, uint16_t*, int64_t);
+  static Func Get(int64_t* side) {
+    *side = 8;
+    return Transpose8x8Sse2;
+  }
+};
+
+template <>
+struct MicroTranspose<uint32_t> {
+  using Func = void (*)(const uint32_t*, int64_t, uint32_t*, int64_t);
+  static Func Get(int64_t* side) {
+    if (!paddle::platform::MayIUse(paddle::platform::avx)) return nullptr;
+    *side = 8;
+    return Transpose8x8Avx;
+  }
+};
+
+template <>
+struct MicroTranspose<uint64_t> {
+  using Func = void (*)(const uint64_t*, int64_t, uint64_t*, int64_t);
+  static Func Get(int64_t* side) {
+    if (!paddle::platform::MayIUse(paddle::platform::avx)) return nullptr;
+    *side = 4;
+    return Transpose4x4Avx;
+  }
+};
+#endif
+
+// A tile of rows x cols, in register tiles where they fit.
+template <typename E>
+inline void TransposeTile(const E* src,
+                          int64_t lda,
+                          E* dst,
+                          int64_t ldb,
+                          int64_t rows,
+                          int64_t cols,
+                          typename MicroTranspose<E>::Func micro,
+                          int64_t side) {
+  if (micro == nullptr) {
+    TransposeTileRef(src, lda, dst, ldb, rows, cols);
+    return;
+  }
+  const int64_t full_rows = rows / side * side;
+  const int64_t full_cols = cols / side * side;
+  for (int64_t x = 0; x < full_rows; x += side) {
+    for (int64_t y = 0; y < full_cols; y += side) {
+      micro(src + x * lda + y, lda, dst + y * ldb + x, ldb);
+    }
+  }
+  if (full_cols < cols) {
+    TransposeTileRef(src + full_cols,
+                     lda,
+                     dst + full_cols * ldb,
+                     ldb,
+                     full_rows,
+                     cols - full_cols);
+  }
+  if (full_rows < rows) {
+    TransposeTileRef(src + full_rows * lda,
+                     lda,
+                     dst + full_rows,
+                     ldb,
+                     rows - full_rows,
+                     cols);
+  }
+}
+
+// The dims and the permutation without the unit dims, with the axes adjacent
+// in both the input and the output merged.
+void Simplify(const std::vector<int64_t>& in_dims,
+              const std::vector<int>& axis,
+              std::vector<int64_t>* dims,
+              std::vector<int>* perm) {
+  const int rank = in_dims.size();
+  std::vector<int> new_index(rank, -1);
+  std::vector<int64_t> kept_dims;
+  for (int i = 0; i < rank; ++i) {
+    if (in_dims[i] != 1) {
+      new_index[i] = kept_dims.size();
+      kept_dims.push_back(in_dims[i]);
+    }
+  }
+  std::vector<int> kept_perm;
+  for (int i = 0; i < rank; ++i) {
+    if (new_index[axis[i]] >= 0) kept_perm.push_back(new_index[axis[i]]);
+  }
+  // The groups of consecutive input axes, in the output order.
+  std::vector<int> group_first;
+  std::vector<int> group_last;
+  for (size_t i = 0; i < kept_perm.size(); ++i) {
+    if (i > 0 && kept_perm[i] == group_last.back() + 1) {
+      group_last.back() = kept_perm[i];
+    } else {
+      group_first.push_back(kept_perm[i]);
+      group_last.push_back(kept_perm[i]);
+    }
+  }
+  const int groups = group_first.size();
+  // The input order of the groups is the order of their first axes.
+  std::vector<int> order(groups);
+  for (int g = 0; g < groups; ++g) order[g] = g;
+  std::sort(order.begin(), order.end(), [&](int a, int b) {
+    return group_first[a] < group_first[b];
+  });
+  dims->assign(groups, 1);
+  perm->assign(groups, 0);
+  for (int i = 0; i < groups; ++i) {
+    const int g = order[i];
+    for (int k = group_first[g]; k <= group_last[g]; ++k) {
+      (*dims)[i] *= kept_dims[k];
+    }
+    (*perm)[g] = i;
+  }
+}
+
+template <typename E>
+void TransposeImpl(const CPUContext& context,
+                   const E* in,
+                   E* out,
+                   const std::vector<int64_t>& dims,
+                   const std::vector<int>& perm) {
+  const int rank = dims.size();
+  int64_t numel = 1;
+  for (auto d : dims) numel *= d;
+
+  int64_t in_strides[kMaxRank];
+  int64_t out_dims[kMaxRank];
+  int64_t out_strides[kMaxRank];
+  int64_t strided_in[kMaxRank];
+  int64_t stride = 1;
+  for (int k = rank - 1; k >= 0; --k) {
+    in_strides[k] = stride;
+    stride *= dims[k];
+  }
+  stride = 1;
+  for (int k = rank - 1; k >= 0; --k) {
+    out_dims[k] = dims[perm[k]];
+    out_strides[k] = stride;
+    strided_in[k] = in_strides[perm[k]];
+    stride *= out_dims[k];
+  }
+
+  if (perm[rank - 1] == rank - 1) {
+    // The last dim stays the last one, so the output is made of rows of the
+    // input.
+    const int64_t row = dims[rank - 1];
+    const int64_t rows = numel / row;
+    const int64_t grain_size =
+        std::max<int64_t>(1, CPUContext::kDefaultGrainSize / row);
+    context.ParallelFor(rows, grain_size, [&](int64_t begin, int64_t end) {
+      OffsetCounter counter(
+          rank - 1, out_dims, strided_in, out_strides, begin);
+      for (int64_t r = begin; r < end; ++r) {
+        std::memcpy(out + counter.out_offset(),
+                    in + counter.in_offset(),
+                    row * sizeof(E));
+        counter.Next();
+      }
+    });
+    return;
+  }
+
+  // A batch of 2D transposes between the last dim of the input, which is
+  // out dim j, and the last dim of the output, which is input dim a.
+  const int a = perm[rank - 1];
+  int j = 0;
+  while (perm[j] != rank - 1) ++j;
+  const int64_t rows = dims[a];
+  const int64_t cols = dims[rank - 1];
+  const int64_t lda = in_strides[a];
+  const int64_t ldb = out_strides[j];
+
+  int64_t outer_dims[kMaxRank];
+  int64_t outer_in[kMaxRank];
+  int64_t outer_out[kMaxRank];
+  int outer_rank = 0;
+  int64_t num_outer = 1;
+  for (int k = 0; k < rank - 1; ++k) {
+    if (k == j) continue;
+    outer_dims[outer_rank] = out_dims[k];
+    outer_in[outer_rank] = strided_in[k];
+    outer_out[outer_rank] = out_strides[k];
+    num_outer *= out_dims[k];
+    ++outer_rank;
+  }
+  if (outer_rank == 0) {
+    outer_dims[0] = 1;
+    outer_in[0] = 0;
+    outer_out[0] = 0;
+    outer_rank = 1;
+  }
+
+  int64_t side = 0;
+  auto micro = MicroTranspose<E>::Get(&side);
+  const int64_t row_tiles = (rows + kTile - 1) / kTile;
+  const int64_t col_tiles = (cols + kTile - 1) / kTile;
+  const int64_t tiles_per_outer = row_tiles * col_tiles;
+  const int64_t grain_size =
+      std::max<int64_t>(1, CPUContext::kDefaultGrainSize / (kTile * kTile));
+  context.ParallelFor(
+      num_outer * tiles_per_outer,
+      grain_size,
+      [&](int64_t begin, int64_t end) {
+        int64_t outer = begin / tiles_per_outer;
+        OffsetCounter counter(
+            outer_rank, outer_dims, outer_in, outer_out, outer);
+        for (int64_t t = begin; t < end; ++t) {
+          if (t / tiles_per_outer != outer) {
+            ++outer;
+            counter.Next();
+          }
+          const int64_t tile = t % tiles_per_outer;
+          const int64_t x = tile / col_tiles * kTile;
+          const int64_t y = tile % col_tiles * kTile;
+          TransposeTile(in + counter.in_offset() + x * lda + y,
+                        lda,
+                        out + counter.out_offset() + y * ldb + x,
+                        ldb,
+                        std::min(kTile, rows - x),
+                        std::min(kTile, cols - y),
+                        micro,
+                        side);
+        }
+      });
+}
+
+}  // namespace
+
+void CpuTranspose(const CPUContext& context,
+                  const void* in,
+                  void* out,
+                  const std::vector<int64_t>& in_dims,
+                  const std::vector<int>& axis,
+                  size_t elem_size) {
+  PADDLE_ENFORCE_EQ(
+      in_dims.size(),
+      axis.size(),
+      phi::errors::InvalidArgument(
+          "The rank of the input (%d) and the size of the permutation (%d) "
+          "of the transpose should be the same.",
+          in_dims.size(),
+          axis.size()));
+  PADDLE_ENFORCE_LE(in_dims.size(),
+                    kMaxRank,
+                    phi::errors::InvalidArgument(
+                        "The rank of the transpose should be at most %d, but "
+                        "received %d.",
+                        kMaxRank,
+                        in_dims.size()));
+  int64_t numel = 1;
+  for (auto d : in_dims) numel *= d;
+  if (numel == 0) return;
+
+  std::vector<int64_t> dims;
+  std::vector<int> perm;
+  Simplify(in_dims, axis, &dims, &perm);
+  if (dims.size() <= 1) {
+    const int64_t bytes = numel * elem_size;
+    context.ParallelFor(
+        bytes, CPUContext::kDefaultGrainSize * 4, [&](int64_t b, int64_t e) {
+          std::memcpy(static_cast<char*>(out) + b,
+                      static_cast<const char*>(in) + b,
+                      e - b);
+        });
+    return;
+  }
+  switch (elem_size) {
+    case 1:
+      TransposeImpl(context,
+                    static_cast<const uint8_t*>(in),
+                    static_cast<uint8_t*>(out),
+                    dims,
+                    perm);
+      break;
+    case 2:
+      TransposeImpl(context,
+                    static_cast<const uint16_t*>(in),
+                    static_cast<uint16_t*>(out),
+                    dims,
+                    perm);
+      break;
+    case 4:
+      TransposeImpl(context,
+                    static_cast<const uint32_t*>(in),
+                    static_cast<uint32_t*>(out),
+                    dims,
+                    perm);
+      break;
+    case 8:
+      TransposeImpl(context,
+                    static_cast<const uint64_t*>(in),
+                    static_cast<uint64_t*>(out),
+                    dims,
+                    perm);
+      break;
+    case 16:
+      TransposeImpl(context,
+                    static_cast<const Bytes16*>(in),
+                    static_cast<Bytes16*>(out),
+                    dims,
+                    perm);
+      break;
+    default:
+      PADDLE_THROW(phi::errors::Unimplemented(
+          "The CPU transpose does not support the elements of %d bytes.",
+          elem_size));
+  }
+}
+
+}  // namespace funcs
+}  // namespace phi
@@ -0,0 +1,55 @@
+// Copyright (c) 2022 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "paddle/phi/backends/cpu/cpu_context.h"
+#include "paddle/phi/common/data_type.h"
+#include "paddle/phi/core/dense_tensor.h"
+
+namespace phi {
+namespace funcs {
+
+// out = in with its dims permuted by axis, out dim i being in dim axis[i],
+// for the elements of any type of elem_size bytes.
+//
+// The unit dims are dropped and the axes staying adjacent are merged first,
+// so that most permutations come down to a copy of rows or to a batch of 2D
+// transposes. The latter run in cache tiles of SIMD 8x8 (or 4x4 for 8 byte
+// elements) register transposes. Both are split over the intra op threads
+// of the context.
+void CpuTranspose(const CPUContext& context,
+                  const void* in,
+                  void* out,
+                  const std::vector<int64_t>& in_dims,
+                  const std::vector<int>& axis,
+                  size_t elem_size);
+
+inline void CpuTranspose(const CPUContext& context,
+                         const DenseTensor& in,
+                         const std::vector<int>& axis,
+                         DenseTensor* out) {
+  CpuTranspose(context,
+               in.data(),
+               out->data(),
+               vectorize(in.dims()),
+               axis,
+               SizeOf(in.dtype()));
+}
+
+}  // namespace funcs
+}  // namespace phi
@@ -0,0 +1,81 @@
+/* Copyright (c) 2022 PaddlePaddle Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License. */
+#pragma once
+
+#include <algorithm>
+#include <type_traits>
+
+#include "paddle/phi/backends/cpu/cpu_context.h"
+#include "paddle/phi/kernels/funcs/eigen/common.h"
+#include "paddle/phi/kernels/funcs/eigen/eigen_function.h"
+
+namespace phi {
+namespace funcs {
+
+// out = in.broadcast(bcast) on the device of the context.
+template <typename T, int Rank, typename Context>
+void EigenBroadcastOn(const Context& ctx,
+                      typename EigenTensor<T, Rank>::Type out,
+                      typename EigenTensor<T, Rank>::ConstType in,
+                      const Eigen::DSizes<Eigen::DenseIndex, Rank>& bcast) {
+  auto& place = *ctx.eigen_device();
+  // use 32-bit index to speed up
+  bool use_32bit_index = out.size() < Eigen::NumTraits<int>::highest();
+  if (use_32bit_index) {
+    EigenBroadcast<std::decay_t<decltype(place)>, T, Rank>::Eval(
+        place, To32BitIndex(out), To32BitIndex(in), bcast);
+  } else {
+    EigenBroadcast<std::decay_t<decltype(place)>, T, Rank>::Eval(
+        place, out, in, bcast);
+  }
+}
+
+// On CPU, the large outputs are split along one dimension over the intra op
+// threads of the context, each thread writing its block of the broadcast.
+template <typename T, int Rank>
+void EigenBroadcastOn(const CPUContext& ctx,
+                      typename EigenTensor<T, Rank>::Type out,
+                      typename EigenTensor<T, Rank>::ConstType in,
+                      const Eigen::DSizes<Eigen::DenseIndex, Rank>& bcast) {
+  int num_threads = ctx.GetIntraOpNumThreads();
+  if (num_threads <= 1 || out.size() <= CPUContext::kDefaultGrainSize) {
+    EigenBroadcastOn<T, Rank, CPUContext>(ctx, out, in, bcast);
+    return;
+  }
+  // The outermost dimension with enough rows for all the threads, or else
+  // the largest one.
+  int split = 0;
+  for (int i = 0; i < Rank; ++i) {
+    if (out.dimension(i) >= num_threads) {
+      split = i;
+      break;
+    }
+    if (out.dimension(i) > out.dimension(split)) split = i;
+  }
+  const int64_t extent = out.dimension(split);
+  const int64_t grain_size = std::max<int64_t>(
+      1, CPUContext::kDefaultGrainSize / (out.size() / extent));
+  auto& place = *ctx.eigen_device();
+  ctx.ParallelFor(extent, grain_size, [&](int64_t begin, int64_t end) {
+    Eigen::DSizes<Eigen::DenseIndex, Rank> offsets;
+    Eigen::DSizes<Eigen::DenseIndex, Rank> extents = out.dimensions();
+    offsets[split] = begin;
+    extents[split] = end - begin;
+    out.slice(offsets, extents).device(place) =
+        in.broadcast(bcast).slice(offsets, extents);
+  });
+}
+
+}  // namespace funcs
+}  // namespace phi
@@ -283,7 +283,6 @@ void CommonForwardBroadcastCPU(const DenseTensor &x,
                                const CPUContext &ctx,
                                Functor func,
                                const bool is_xsize_larger = true) {
-  std::vector<int> index_array(max_dim, 0);
   const T *x_data = x.data<T>();
   const T *y_data = y.data<T>();
   PADDLE_ENFORCE_NOT_NULL(
@@ -294,18 +293,33 @@ void CommonForwardBroadcastCPU(const DenseTensor &x,
 
   const int out_size = std::accumulate(
       out_dims_array, out_dims_array + max_dim, 1, std::multiplies<int>());
-  int x_index, y_index;
-  for (int out_index = 0; out_index < out_size; ++out_index) {
-    x_index = GetElementwiseIndex(x_dims_array, max_dim, index_array.data());
-    y_index = GetElementwiseIndex(y_dims_array, max_dim, index_array.data());
-    if (is_xsize_larger) {
-      out_data[out_index] = func(x_data[x_index], y_data[y_index]);
-    } else {
-      out_data[out_index] = func(y_data[y_index], x_data[x_index]);
-    }
-
-    UpdateElementwiseIndexArray(out_dims_array, max_dim, index_array.data());
-  }
+  ctx.ParallelFor(
+      out_size,
+      CPUContext::kDefaultGrainSize,
+      [&](int64_t begin, int64_t end) {
+        // The index of the first output element of the block.
+        std::vector<int> index_array(max_dim, 0);
+        int64_t offset = begin;
+        for (int i = max_dim - 1; i >= 0 && offset > 0; --i) {
+          index_array[i] = offset % out_dims_array[i];
+          offset /= out_dims_array[i];
+        }
+        int x_index, y_index;
+        for (int64_t out_index = begin; out_index < end; ++out_index) {
+          x_index =
+              GetElementwiseIndex(x_dims_array, max_dim, index_array.data());
+          y_index =
+              GetElementwiseIndex(y_dims_array, max_dim, index_array.data());
+          if (is_xsize_larger) {
+            out_data[out_index] = func(x_data[x_index], y_data[y_index]);
+          } else {
+            out_data[out_index] = func(y_data[y_index], x_data[x_index]);
+          }
+
+          UpdateElementwiseIndexArray(
+              out_dims_array, max_dim, index_array.data());
+        }
+      });
 }
 
 template <typename Functor, typename T, typename OutType = T>
@@ -355,6 +369,38 @@ void CommonElementwiseBroadcastForward(const CPUContext &dev_ctx,
                                                  is_xsize_larger);
 }
 
+// z[i] = func(x[i], y[(i / post) % n]) for the nx elements of x, split over
+// the intra op threads. It covers the same dims (n = nx and post = 1), the
+// row wise (post = 1) and the mid wise broadcasts of ElementwiseCompute.
+template <typename Functor, typename T, typename OutType>
+void ElementwiseLoopCPU(const CPUContext &dev_ctx,
+                        const T *x,
+                        const T *y,
+                        OutType *z,
+                        int64_t nx,
+                        int64_t n,
+                        int64_t post,
+                        Functor func) {
+  dev_ctx.ParallelFor(
+      nx, CPUContext::kDefaultGrainSize, [&](int64_t begin, int64_t end) {
+        if (n == nx && post == 1) {
+          for (int64_t i = begin; i < end; ++i) {
+            z[i] = func(x[i], y[i]);
+          }
+          return;
+        }
+        int64_t j = (begin / post) % n;
+        int64_t k = begin % post;
+        for (int64_t i = begin; i < end; ++i) {
+          z[i] = func(x[i], y[j]);
+          if (++k == post) {
+            k = 0;
+            if (++j == n) j = 0;
+          }
+        }
+      });
+}
+
 // It is a common CPU implementation to compute binary calculation with the
 // support of broadcast. Note:
 // 1. CPU implementation cannot support the case when x needs broadcast, thus
@@ -371,7 +417,7 @@ void ElementwiseCompute(const CPUContext &dev_ctx,
                         int axis,
                         Functor func,
                         DenseTensor *z) {
-  dev_ctx.Alloc<OutType>(z);
+  OutType *z_data = dev_ctx.Alloc<OutType>(z);
   auto x_dims = x.dims();
   auto y_dims = y.dims();
   bool is_xsize_larger = true;
@@ -380,10 +426,15 @@ void ElementwiseCompute(const CPUContext &dev_ctx,
     is_xsize_larger = false;
     max_dim = y_dims.size();
   }
-  TransformFunctor<Functor, T, CPUContext, OutType> functor(
-      x, y, z, dev_ctx, func, is_xsize_larger);
   if (x_dims == y_dims) {
-    functor.Run();
+    ElementwiseLoopCPU<Functor, T, OutType>(dev_ctx,
+                                            x.data<T>(),
+                                            y.data<T>(),
+                                            z_data,
+                                            x.numel(),
+                                            x.numel(),
+                                            1,
+                                            func);
     return;
   }
 
@@ -432,13 +483,18 @@ void ElementwiseCompute(const CPUContext &dev_ctx,
     return;
   }
 
-  if (post == 1) {
-    functor.RunRowWise(n, pre);
-    return;
-  } else {
-    functor.RunMidWise(n, pre, post);
-    return;
-  }
+  // The larger tensor is the first operand of func, the functors of the
+  // inverse operations take care of the order.
+  const DenseTensor &larger = is_xsize_larger ? x : y;
+  const DenseTensor &smaller = is_xsize_larger ? y : x;
+  ElementwiseLoopCPU<Functor, T, OutType>(dev_ctx,
+                                          larger.data<T>(),
+                                          smaller.data<T>(),
+                                          z_data,
+                                          larger.numel(),
+                                          n,
+                                          post,
+                                          func);
 }
 
 // for broadcast backwards
@@ -0,0 +1,397 @@
+/* Copyright (c) 2022 PaddlePaddle Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License. */
+
+#include "paddle/phi/kernels/funcs/int8_gemm.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <memory>
+#include <vector>
+
+#include "paddle/phi/kernels/funcs/blas/packed_weight_cache.h"
+
+// The SIMD kernels are compiled with function level targets, so they do not
+// need the whole library to be built with -mavx2 or -mavx512vnni and are only
+// picked when the CPU running them supports the instructions.
+#if defined(__x86_64__) && !defined(_WIN32) && \
+    (defined(__clang__) || (defined(__GNUC__) && __GNUC__ >= 8))
+#define PADDLE_INT8_GEMM_WITH_SIMD
+#include <cpuid.h>
+#include <immintrin.h>
+#endif
+
+namespace phi {
+namespace funcs {
+
+namespace {
+
+// C is computed in tiles of kTileM rows by kPanelN columns, which the intra
+// op threads share.
+constexpr int kPanelN = 16;
+constexpr int kTileM = 64;
+
+// Computes the tile of the rows [m0, m1) and the columns [n0, n0 + nb).
+void Int8GemmRefTile(int m0,
+                     int m1,
+                     int n0,
+                     int nb,
+                     int N,
+                     int K,
+                     const uint8_t* A,
+                     const int8_t* B,
+                     int32_t* C) {
+  for (int i = m0; i < m1; ++i) {
+    int32_t* c = C + static_cast<int64_t>(i) * N + n0;
+    std::fill(c, c + nb, 0);
+    const uint8_t* a = A + static_cast<int64_t>(i) * K;
+    for (int k = 0; k < K; ++k) {
+      int32_t av = a[k];
+      const int8_t* b = B + static_cast<int64_t>(k) * N + n0;
+      for (int j = 0; j < nb; ++j) {
+        c[j] += av * b[j];
+      }
+    }
+  }
+}
+
+#ifdef PADDLE_INT8_GEMM_WITH_SIMD
+
+// Pack B into panels of kPanelN columns, with kGroup consecutive rows of a
+// column next to each other as the dot product instructions take them: the
+// panel of the columns [n0, n0 + kPanelN) is at packed[n0 / kPanelN] and
+// holds panel[k / kGroup][j][k % kGroup], zero padded past K and N.
+template <typename PackT, int kGroup>
+std::shared_ptr<std::vector<PackT>> PackPanels(int N, int K, const int8_t* B) {
+  int64_t panel_size = static_cast<int64_t>((K + kGroup - 1) / kGroup) *
+                       kGroup * kPanelN;
+  int num_panels = (N + kPanelN - 1) / kPanelN;
+  auto packed =
+      std::make_shared<std::vector<PackT>>(num_panels * panel_size, 0);
+  for (int n0 = 0; n0 < N; n0 += kPanelN) {
+    int nb = std::min(kPanelN, N - n0);
+    PackT* panel = packed->data() + n0 / kPanelN * panel_size;
+    for (int k = 0; k < K; ++k) {
+      PackT* dst = panel + (k / kGroup) * kGroup * kPanelN + k % kGroup;
+      const int8_t* src = B + static_cast<int64_t>(k) * N + n0;
+      for (int j = 0; j < nb; ++j) {
+        dst[j * kGroup] = src[j];
+      }
+    }
+  }
+  return packed;
+}
+
+// 4 consecutive bytes of a row of A starting at k, zero padded past K.
+inline int32_t LoadA4(const uint8_t* a, int k, int K) {
+  int32_t v = 0;
+  std::memcpy(&v, a + k, std::min(4, K - k));
+  return v;
+}
+
+// 2 consecutive bytes of a row of A starting at k, each widened to int16.
+inline int32_t LoadA2(const uint8_t* a, int k, int K) {
+  int32_t lo = a[k];
+  int32_t hi = k + 1 < K ? a[k + 1] : 0;
+  return lo | (hi << 16);
+}
+
+// vpdpbusd on the int8 panels, 4 rows of B for each int32 lane.
+__attribute__((target("avx512f,avx512vnni"))) void Int8GemmVnniTile(
+    int m0,
+    int m1,
+    int n0,
+    int nb,
+    int N,
+    int K,
+    const uint8_t* A,
+    const int8_t* panel,
+    int32_t* C) {
+  int k4 = (K + 3) / 4;
+  __mmask16 mask = static_cast<__mmask16>((1u << nb) - 1);
+  // 4 rows of A share each load of the packed panel.
+  int i = m0;
+  for (; i + 4 <= m1; i += 4) {
+    const uint8_t* a0 = A + static_cast<int64_t>(i) * K;
+    const uint8_t* a1 = a0 + K;
+    const uint8_t* a2 = a1 + K;
+    const uint8_t* a3 = a2 + K;
+    __m512i c0 = _mm512_setzero_si512();
+    __m512i c1 = _mm512_setzero_si512();
+    __m512i c2 = _mm512_setzero_si512();
+    __m512i c3 = _mm512_setzero_si512();
+    for (int k = 0; k < k4; ++k) {
+      __m512i b = _mm512_loadu_si512(panel + k * 64);
+      int ka = k * 4;
+      c0 = _mm512_dpbusd_epi32(c0, _mm512_set1_epi32(LoadA4(a0, ka, K)), b);
+      c1 = _mm512_dpbusd_epi32(c1, _mm512_set1_epi32(LoadA4(a1, ka, K)), b);
+      c2 = _mm512_dpbusd_epi32(c2, _mm512_set1_epi32(LoadA4(a2, ka, K)), b);
+      c3 = _mm512_dpbusd_epi32(c3, _mm512_set1_epi32(LoadA4(a3, ka, K)), b);
+    }
+    int32_t* c = C + static_cast<int64_t>(i) * N + n0;
+    _mm512_mask_storeu_epi32(c, mask, c0);
+    _mm512_mask_storeu_epi32(c + N, mask, c1);
+    _mm512_mask_storeu_epi32(c + 2 * N, mask, c2);
+    _mm512_mask_storeu_epi32(c + 3 * N, mask, c3);
+  }
+  for (; i < m1; ++i) {
+    const uint8_t* a = A + static_cast<int64_t>(i) * K;
+    __m512i acc = _mm512_setzero_si512();
+    for (int k = 0; k < k4; ++k) {
+      __m512i b = _mm512_loadu_si512(panel + k * 64);
+      acc =
+          _mm512_dpbusd_epi32(acc, _mm512_set1_epi32(LoadA4(a, k * 4, K)), b);
+    }
+    _mm512_mask_storeu_epi32(C + static_cast<int64_t>(i) * N + n0, mask, acc);
+  }
+}
+
+__attribute__((target("avx2"))) inline void StoreAvx2(
+    int32_t* c, int nb, __m256i lo, __m256i hi) {
+  if (nb == kPanelN) {
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(c), lo);
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(c + 8), hi);
+    return;
+  }
+  alignas(32) int32_t tmp[kPanelN];
+  _mm256_store_si256(reinterpret_cast<__m256i*>(tmp), lo);
+  _mm256_store_si256(reinterpret_cast<__m256i*>(tmp + 8), hi);
+  std::memcpy(c, tmp, nb * sizeof(int32_t));
+}
+
+// vpmaddwd on the panels widened to int16, 2 rows of B for each int32
+// lane. Unlike vpmaddubsw, it can not saturate on the uint8 activations.
+__attribute__((target("avx2"))) void Int8GemmAvx2Tile(int m0,
+                                                      int m1,
+                                                      int n0,
+                                                      int nb,
+                                                      int N,
+                                                      int K,
+                                                      const uint8_t* A,
+                                                      const int16_t* panel,
+                                                      int32_t* C) {
+  int k2 = (K + 1) / 2;
+  int i = m0;
+  for (; i + 4 <= m1; i += 4) {
+    const uint8_t* a0 = A + static_cast<int64_t>(i) * K;
+    const uint8_t* a1 = a0 + K;
+    const uint8_t* a2 = a1 + K;
+    const uint8_t* a3 = a2 + K;
+    __m256i c0l = _mm256_setzero_si256(), c0h = _mm256_setzero_si256();
+    __m256i c1l = _mm256_setzero_si256(), c1h = _mm256_setzero_si256();
+    __m256i c2l = _mm256_setzero_si256(), c2h = _mm256_setzero_si256();
+    __m256i c3l = _mm256_setzero_si256(), c3h = _mm256_setzero_si256();
+    for (int k = 0; k < k2; ++k) {
+      const int16_t* b = panel + k * 2 * kPanelN;
+      __m256i bl = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(b));
+      __m256i bh =
+          _mm256_loadu_si256(reinterpret_cast<const __m256i*>(b + kPanelN));
+      int ka = k * 2;
+      __m256i v = _mm256_set1_epi32(LoadA2(a0, ka, K));
+      c0l = _mm256_add_epi32(c0l, _mm256_madd_epi16(v, bl));
+      c0h = _mm256_add_epi32(c0h, _mm256_madd_epi16(v, bh));
+      v = _mm256_set1_epi32(LoadA2(a1, ka, K));
+      c1l = _mm256_add_epi32(c1l, _mm256_madd_epi16(v, bl));
+      c1h = _mm256_add_epi32(c1h, _mm256_madd_epi16(v, bh));
+      v = _mm256_set1_epi32(LoadA2(a2, ka, K));
+      c2l = _mm256_add_epi32(c2l, _mm256_madd_epi16(v, bl));
+      c2h = _mm256_add_epi32(c2h, _mm256_madd_epi16(v, bh));
+      v = _mm256_set1_epi32(LoadA2(a3, ka, K));
+      c3l = _mm256_add_epi32(c3l, _mm256_madd_epi16(v, bl));
+      c3h = _mm256_add_epi32(c3h, _mm256_madd_epi16(v, bh));
+    }
+    int32_t* c = C + static_cast<int64_t>(i) * N + n0;
+    StoreAvx2(c, nb, c0l, c0h);
+    StoreAvx2(c + N, nb, c1l, c1h);
+    StoreAvx2(c + 2 * N, nb, c2l, c2h);
+    StoreAvx2(c + 3 * N, nb, c3l, c3h);
+  }
+  for (; i < m1; ++i) {
+    const uint8_t* a = A + static_cast<int64_t>(i) * K;
+    __m256i accl = _mm256_setzero_si256();
+    __m256i acch = _mm256_setzero_si256();
+    for (int k = 0; k < k2; ++k) {
+      const int16_t* b = panel + k * 2 * kPanelN;
+      __m256i bl = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(b));
+      __m256i bh =
+          _mm256_loadu_si256(reinterpret_cast<const __m256i*>(b + kPanelN));
+      __m256i v = _mm256_set1_epi32(LoadA2(a, k * 2, K));
+      accl = _mm256_add_epi32(accl, _mm256_madd_epi16(v, bl));
+      acch = _mm256_add_epi32(acch, _mm256_madd_epi16(v, bh));
+    }
+    StoreAvx2(C + static_cast<int64_t>(i) * N + n0, nb, accl, acch);
+  }
+}
+
+// The bits of the xmm and ymm states, and of the opmask and zmm ones, in
+// XCR0: the OS saves them on the context switches.
+constexpr uint32_t kXcr0Avx = 0x06;
+constexpr uint32_t kXcr0Avx512 = 0xe6;
+
+bool OsSavesXcr0(uint32_t bits) {
+  unsigned int eax, ebx, ecx, edx;
+  if (!__get_cpuid(1, &eax, &ebx, &ecx, &edx) || !(ecx & bit_OSXSAVE)) {
+    return false;
+  }
+  uint32_t xcr0_lo, xcr0_hi;
+  __asm__("xgetbv" : "=a"(xcr0_lo), "=d"(xcr0_hi) : "c"(0));
+  return (xcr0_lo & bits) == bits;
+}
+
+// Whether the CPU and the OS support AVX512F and AVX512_VNNI.
+bool CpuHasVnni() {
+  unsigned int eax, ebx, ecx, edx;
+  if (!__get_cpuid_count(7, 0, &eax, &ebx, &ecx, &edx) ||
+      !(ebx & bit_AVX512F) || !(ecx & (1u << 11))) {
+    return false;
+  }
+  return OsSavesXcr0(kXcr0Avx512);
+}
+
+// Whether the CPU and the OS support AVX2.
+bool CpuHasAvx2() {
+  unsigned int eax, ebx, ecx, edx;
+  if (!__get_cpuid_count(7, 0, &eax, &ebx, &ecx, &edx) || !(ebx & bit_AVX2)) {
+    return false;
+  }
+  return OsSavesXcr0(kXcr0Avx);
+}
+
+#endif
+
+enum class Int8GemmIsa { kRef, kAvx2, kVnni };
+
+Int8GemmIsa GetInt8GemmIsa() {
+#ifdef PADDLE_INT8_GEMM_WITH_SIMD
+  static Int8GemmIsa isa = CpuHasVnni()   ? Int8GemmIsa::kVnni
+                           : CpuHasAvx2() ? Int8GemmIsa::kAvx2
+                                          : Int8GemmIsa::kRef;
+  return isa;
+#else
+  return Int8GemmIsa::kRef;
+#endif
+}
+
+// The packed B of the SIMD kernels. The weights registered as constant, like
+// the ones the CPU quantizer of a predictor makes, are packed once, the
+// others in every call.
+template <typename PackFunc>
+std::shared_ptr<void> GetPacked(
+    int N, int K, const int8_t* B, PackFunc pack_func) {
+  std::shared_ptr<void> packed;
+  auto& cache = PackedWeightCache::Instance();
+  if (cache.HasConstants()) {
+    PackedWeightKey key{B, N, K, N, false, 0.0, sizeof(int8_t)};
+    packed = cache.Get(key, [&]() -> std::shared_ptr<void> {
+      return pack_func(N, K, B);
+    });
+  }
+  if (packed == nullptr) {
+    packed = pack_func(N, K, B);
+  }
+  return packed;
+}
+
+}  // namespace
+
+void QuantizeShiftedUint8(int64_t n, const float* x, float scale, uint8_t* y) {
+  for (int64_t i = 0; i < n; ++i) {
+    float q = std::round(x[i] * scale);
+    q = std::min(127.0f, std::max(-127.0f, q));
+    y[i] = static_cast<uint8_t>(static_cast<int>(q) + kInt8GemmShift);
+  }
+}
+
+bool Int8GemmUseVnni() { return GetInt8GemmIsa() == Int8GemmIsa::kVnni; }
+
+bool Int8GemmUseSimd() { return GetInt8GemmIsa() != Int8GemmIsa::kRef; }
+
+void Int8Gemm(const phi::CPUContext& dev_ctx,
+              int M,
+              int N,
+              int K,
+              const uint8_t* A,
+              const int8_t* B,
+              int32_t* C) {
+  if (M <= 0 || N <= 0) return;
+  if (K <= 0) {
+    std::fill(C, C + static_cast<int64_t>(M) * N, 0);
+    return;
+  }
+  Int8GemmIsa isa = GetInt8GemmIsa();
+  std::shared_ptr<void> packed;
+#ifdef PADDLE_INT8_GEMM_WITH_SIMD
+  if (isa == Int8GemmIsa::kVnni) {
+    packed = GetPacked(N, K, B, PackPanels<int8_t, 4>);
+  } else if (isa == Int8GemmIsa::kAvx2) {
+    packed = GetPacked(N, K, B, PackPanels<int16_t, 2>);
+  }
+#endif
+
+  int num_row_tiles = (M + kTileM - 1) / kTileM;
+  int num_panels = (N + kPanelN - 1) / kPanelN;
+  // A tile costs up to kTileM * kPanelN * K multiply-adds.
+  int64_t tile_cost = static_cast<int64_t>(std::min(M, kTileM)) * kPanelN * K;
+  int64_t grain_size =
+      std::max<int64_t>(1, phi::CPUContext::kDefaultGrainSize / tile_cost);
+  dev_ctx.ParallelFor(
+      static_cast<int64_t>(num_row_tiles) * num_panels,
+      grain_size,
+      [&](int64_t begin, int64_t end) {
+        for (int64_t t = begin; t < end; ++t) {
+          int m0 = static_cast<int>(t / num_panels) * kTileM;
+          int m1 = std::min(M, m0 + kTileM);
+          int p = static_cast<int>(t % num_panels);
+          int n0 = p * kPanelN;
+          int nb = std::min(kPanelN, N - n0);
+          switch (isa) {
+#ifdef PADDLE_INT8_GEMM_WITH_SIMD
+            case Int8GemmIsa::kVnni: {
+              auto* panels = static_cast<std::vector<int8_t>*>(packed.get());
+              int64_t panel_size = static_cast<int64_t>((K + 3) / 4) * 64;
+              Int8GemmVnniTile(m0,
+                               m1,
+                               n0,
+                               nb,
+                               N,
+                               K,
+                               A,
+                               panels->data() + p * panel_size,
+                               C);
+              break;
+            }
+            case Int8GemmIsa::kAvx2: {
+              auto* panels = static_cast<std::vector<int16_t>*>(packed.get());
+              int64_t panel_size = static_cast<int64_t>((K + 1) / 2) * 32;
+              Int8GemmAvx2Tile(m0,
+                               m1,
+                               n0,
+                               nb,
+                               N,
+                               K,
+                               A,
+                               panels->data() + p * panel_size,
+                               C);
+              break;
+            }
+#endif
+            default:
+              Int8GemmRefTile(m0, m1, n0, nb, N, K, A, B, C);
+          }
+        }
+      });
+}
+
+}  // namespace funcs
+}  // namespace phi
@@ -0,0 +1,51 @@
+/* Copyright (c) 2022 PaddlePaddle Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License. */
+
+#pragma once
+
+#include <cstdint>
+
+#include "paddle/phi/backends/cpu/cpu_context.h"
+
+namespace phi {
+namespace funcs {
+
+// The signed activations are shifted by this value into the range of uint8,
+// which is the operand type the int8 dot product instructions take.
+constexpr int kInt8GemmShift = 128;
+
+// Quantize x to round(x * scale), saturated to [-127, 127], and shift the
+// result by kInt8GemmShift into uint8.
+void QuantizeShiftedUint8(int64_t n, const float* x, float scale, uint8_t* y);
+
+// C[M, N] = A[M, K] * B[K, N] with int32 accumulation, all row-major, split
+// over the intra op threads of dev_ctx. Runs on AVX512-VNNI or AVX2 when the
+// CPU supports them and on a generic loop otherwise.
+void Int8Gemm(const phi::CPUContext& dev_ctx,
+              int M,
+              int N,
+              int K,
+              const uint8_t* A,
+              const int8_t* B,
+              int32_t* C);
+
+// Whether Int8Gemm runs on AVX512-VNNI.
+bool Int8GemmUseVnni();
+
+// Whether Int8Gemm runs on AVX512-VNNI or AVX2. Its generic loop is slower
+// than the float GEMMs.
+bool Int8GemmUseSimd();
+
+}  // namespace funcs
+}  // namespace phi
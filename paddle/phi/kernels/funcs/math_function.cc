@@ -30,6 +30,7 @@ limitations under the License. */
 #include "paddle/fluid/platform/bfloat16.h"
 #include "paddle/fluid/platform/float16.h"
 #include "paddle/phi/backends/cpu/cpu_context.h"
+#include "paddle/phi/kernels/funcs/cpu_transpose.h"
 #include "paddle/phi/kernels/funcs/eigen/common.h"
 #include "paddle/phi/kernels/funcs/math_function_impl.h"
 #include "unsupported/Eigen/CXX11/Tensor"
@@ -69,6 +70,15 @@ template struct SetConstant<paddle::platform::XPUDeviceContext,
                             phi::dtype::complex<double>>;
 #endif
 
+template <typename T, int Rank>
+void Transpose<phi::CPUContext, T, Rank>::operator()(
+    const phi::CPUContext& context,
+    const paddle::framework::Tensor& in,
+    paddle::framework::Tensor* out,
+    const std::vector<int>& axis) {
+  CpuTranspose(context, in, axis, out);
+}
+
 #define DEFINE_CPU_TRANS(RANK)                                            \
   template struct Transpose<phi::CPUContext, phi::dtype::float16, RANK>;  \
   template struct Transpose<phi::CPUContext, phi::dtype::bfloat16, RANK>; \
@@ -117,7 +127,8 @@ void TransposeNormal<DeviceContext, T>::operator()(
       out_ptr[out_idx] = in_ptr[in_idx];
     }
   };
-  transpose_helper(0, out->numel());
+  context.ParallelFor(
+      out->numel(), phi::CPUContext::kDefaultGrainSize, transpose_helper);
 }
 
 // define transpose normal
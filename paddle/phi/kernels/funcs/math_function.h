@@ -47,6 +47,15 @@ struct Transpose {
                   const std::vector<int>& axis);
 };
 
+// The CPU transposes of any rank run on CpuTranspose.
+template <typename T, int Rank>
+struct Transpose<phi::CPUContext, T, Rank> {
+  void operator()(const phi::CPUContext& context,
+                  const paddle::framework::Tensor& in,
+                  paddle::framework::Tensor* out,
+                  const std::vector<int>& axis);
+};
+
 template <typename DeviceContext, typename T>
 struct SetConstant {
   void operator()(const DeviceContext& context,
@@ -0,0 +1,375 @@
+// Copyright (c) 2022 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+#include <vector>
+
+#include "paddle/phi/backends/cpu/cpu_context.h"
+
+// The sorting and selection of the rows of a matrix on CPU, shared by the
+// argsort, top_k, kthvalue, mode and unique kernels.
+//
+// The values are turned into unsigned keys with the same order, NaN being
+// the largest, so the comparisons are integer ones and the long rows can be
+// radix sorted. The ties are broken by the index, so the results do not
+// depend on the algorithm or on the number of threads.
+
+namespace phi {
+namespace funcs {
+
+template <typename T, typename Enable = void>
+struct SortKeyTraits;
+
+template <typename T>
+struct SortKeyTraits<
+    T,
+    typename std::enable_if<std::is_floating_point<T>::value>::type> {
+  using Key =
+      typename std::conditional<sizeof(T) == 4, uint32_t, uint64_t>::type;
+
+  static Key ToKey(T value) {
+    if (std::isnan(value)) {
+      return ~static_cast<Key>(0);
+    }
+    Key bits;
+    std::memcpy(&bits, &value, sizeof(T));
+    // Flip the negative values entirely and the sign of the positive ones.
+    const Key sign = static_cast<Key>(1) << (sizeof(Key) * 8 - 1);
+    return (bits & sign) ? ~bits : (bits | sign);
+  }
+};
+
+template <typename T>
+struct SortKeyTraits<
+    T,
+    typename std::enable_if<std::is_integral<T>::value>::type> {
+  using Key = typename std::make_unsigned<T>::type;
+
+  static Key ToKey(T value) {
+    const Key sign = std::is_signed<T>::value
+                         ? static_cast<Key>(static_cast<Key>(1)
+                                            << (sizeof(Key) * 8 - 1))
+                         : static_cast<Key>(0);
+    return static_cast<Key>(static_cast<Key>(value) ^ sign);
+  }
+};
+
+template <typename Key>
+struct SortEntry {
+  Key key;
+  int64_t index;
+
+  bool operator<(const SortEntry& other) const {
+    return key < other.key || (key == other.key && index < other.index);
+  }
+};
+
+// The rows shorter than this are sorted by comparisons.
+constexpr int64_t kRadixSortMinWidth = 256;
+
+// top_k and kthvalue keep a heap of the k best entries when k is this many
+// times smaller than the row.
+constexpr int64_t kHeapSelectRatio = 64;
+
+inline int64_t SortRowGrainSize(int64_t width) {
+  return std::max<int64_t>(1,
+                           CPUContext::kDefaultGrainSize /
+                               std::max<int64_t>(1, width));
+}
+
+// The entries of a row in the ascending order of their keys, or in the
+// descending one.
+template <typename T>
+void LoadSortEntries(const T* row,
+                     int64_t begin,
+                     int64_t end,
+                     bool descending,
+                     SortEntry<typename SortKeyTraits<T>::Key>* entries) {
+  using Key = typename SortKeyTraits<T>::Key;
+  for (int64_t j = begin; j < end; ++j) {
+    Key key = SortKeyTraits<T>::ToKey(row[j]);
+    entries[j - begin].key = descending ? static_cast<Key>(~key) : key;
+    entries[j - begin].index = j;
+  }
+}
+
+// A stable least significant digit radix sort on the bytes of the keys,
+// skipping the bytes which are the same in all the keys.
+template <typename Key>
+void RadixSortEntries(SortEntry<Key>* entries,
+                      int64_t n,
+                      std::vector<SortEntry<Key>>* buffer) {
+  constexpr int kPasses = sizeof(Key);
+  int64_t counts[kPasses][256];
+  std::memset(counts, 0, sizeof(counts));
+  for (int64_t i = 0; i < n; ++i) {
+    Key key = entries[i].key;
+    for (int p = 0; p < kPasses; ++p) {
+      ++counts[p][(key >> (8 * p)) & 0xFF];
+    }
+  }
+
+  buffer->resize(n);
+  SortEntry<Key>* src = entries;
+  SortEntry<Key>* dst = buffer->data();
+  for (int p = 0; p < kPasses; ++p) {
+    int64_t* count = counts[p];
+    if (count[(src[0].key >> (8 * p)) & 0xFF] == n) {
+      continue;
+    }
+    int64_t offset = 0;
+    for (int d = 0; d < 256; ++d) {
+      int64_t c = count[d];
+      count[d] = offset;
+      offset += c;
+    }
+    for (int64_t i = 0; i < n; ++i) {
+      dst[count[(src[i].key >> (8 * p)) & 0xFF]++] = src[i];
+    }
+    std::swap(src, dst);
+  }
+  if (src != entries) {
+    std::copy(src, src + n, entries);
+  }
+}
+
+template <typename Key>
+void SortEntries(SortEntry<Key>* entries,
+                 int64_t n,
+                 std::vector<SortEntry<Key>>* buffer) {
+  if (n < kRadixSortMinWidth) {
+    std::sort(entries, entries + n);
+  } else {
+    RadixSortEntries(entries, n, buffer);
+  }
+}
+
+// Keep the k smallest entries seen in a max heap.
+template <typename Key>
+inline void PushHeapEntry(const SortEntry<Key>& entry,
+                          int64_t k,
+                          std::vector<SortEntry<Key>>* heap) {
+  if (static_cast<int64_t>(heap->size()) < k) {
+    heap->push_back(entry);
+    std::push_heap(heap->begin(), heap->end());
+  } else if (entry < heap->front()) {
+    std::pop_heap(heap->begin(), heap->end());
+    heap->back() = entry;
+    std::push_heap(heap->begin(), heap->end());
+  }
+}
+
+template <typename T>
+void HeapSelect(const T* row,
+                int64_t begin,
+                int64_t end,
+                int64_t k,
+                bool descending,
+                std::vector<SortEntry<typename SortKeyTraits<T>::Key>>* heap) {
+  using Key = typename SortKeyTraits<T>::Key;
+  heap->clear();
+  for (int64_t j = begin; j < end; ++j) {
+    Key key = SortKeyTraits<T>::ToKey(row[j]);
+    PushHeapEntry<Key>({descending ? static_cast<Key>(~key) : key, j},
+                       k,
+                       heap);
+  }
+}
+
+// Sort each row of the height x width matrix in, writing the sorted values
+// to out and their positions in the row to indices.
+template <typename T>
+void SortRows(const CPUContext& dev_ctx,
+              const T* in,
+              int64_t height,
+              int64_t width,
+              bool descending,
+              T* out,
+              int64_t* indices) {
+  using Entry = SortEntry<typename SortKeyTraits<T>::Key>;
+  dev_ctx.ParallelFor(
+      height, SortRowGrainSize(width), [&](int64_t begin, int64_t end) {
+        std::vector<Entry> entries(width);
+        std::vector<Entry> buffer;
+        for (int64_t i = begin; i < end; ++i) {
+          const T* row = in + i * width;
+          LoadSortEntries(row, 0, width, descending, entries.data());
+          SortEntries(entries.data(), width, &buffer);
+          for (int64_t j = 0; j < width; ++j) {
+            out[i * width + j] = row[entries[j].index];
+            indices[i * width + j] = entries[j].index;
+          }
+        }
+      });
+}
+
+// The k largest (or smallest) values of each row of the height x width
+// matrix in, in the descending (or ascending) order. A single long row is
+// split over the threads, each keeping the best k of its part.
+template <typename T>
+void TopKRows(const CPUContext& dev_ctx,
+              const T* in,
+              int64_t height,
+              int64_t width,
+              int64_t k,
+              bool largest,
+              T* out,
+              int64_t* indices) {
+  using Entry = SortEntry<typename SortKeyTraits<T>::Key>;
+  auto write_row = [&](int64_t i, const T* row, const Entry* best) {
+    for (int64_t j = 0; j < k; ++j) {
+      out[i * k + j] = row[best[j].index];
+      indices[i * k + j] = best[j].index;
+    }
+  };
+
+  if (k * kHeapSelectRatio >= width) {
+    dev_ctx.ParallelFor(
+        height, SortRowGrainSize(width), [&](int64_t begin, int64_t end) {
+          std::vector<Entry> entries(width);
+          for (int64_t i = begin; i < end; ++i) {
+            const T* row = in + i * width;
+            LoadSortEntries(row, 0, width, largest, entries.data());
+            std::nth_element(
+                entries.begin(), entries.begin() + k - 1, entries.end());
+            std::sort(entries.begin(), entries.begin() + k - 1);
+            write_row(i, row, entries.data());
+          }
+        });
+    return;
+  }
+
+  const int64_t num_threads = dev_ctx.GetIntraOpNumThreads();
+  if (height < num_threads && width >= 4 * CPUContext::kDefaultGrainSize) {
+    const int64_t part_width = (width + num_threads - 1) / num_threads;
+    std::vector<std::vector<Entry>> heaps(num_threads);
+    std::vector<Entry> best;
+    for (int64_t i = 0; i < height; ++i) {
+      const T* row = in + i * width;
+      dev_ctx.ParallelFor(num_threads, 1, [&](int64_t begin, int64_t end) {
+        for (int64_t p = begin; p < end; ++p) {
+          HeapSelect(row,
+                     std::min(width, p * part_width),
+                     std::min(width, (p + 1) * part_width),
+                     k,
+                     largest,
+                     &heaps[p]);
+        }
+      });
+      best.clear();
+      for (auto& heap : heaps) {
+        for (auto& entry : heap) {
+          PushHeapEntry(entry, k, &best);
+        }
+      }
+      std::sort_heap(best.begin(), best.end());
+      write_row(i, row, best.data());
+    }
+    return;
+  }
+
+  dev_ctx.ParallelFor(
+      height, SortRowGrainSize(width), [&](int64_t begin, int64_t end) {
+        std::vector<Entry> heap;
+        heap.reserve(k);
+        for (int64_t i = begin; i < end; ++i) {
+          const T* row = in + i * width;
+          HeapSelect(row, 0, width, k, largest, &heap);
+          std::sort_heap(heap.begin(), heap.end());
+          write_row(i, row, heap.data());
+        }
+      });
+}
+
+// The k-th smallest value of each row of the height x width matrix in.
+template <typename T>
+void KthValueRows(const CPUContext& dev_ctx,
+                  const T* in,
+                  int64_t height,
+                  int64_t width,
+                  int64_t k,
+                  T* out,
+                  int64_t* indices) {
+  using Entry = SortEntry<typename SortKeyTraits<T>::Key>;
+  const bool use_heap = k * kHeapSelectRatio < width;
+  dev_ctx.ParallelFor(
+      height, SortRowGrainSize(width), [&](int64_t begin, int64_t end) {
+        std::vector<Entry> entries;
+        for (int64_t i = begin; i < end; ++i) {
+          const T* row = in + i * width;
+          int64_t index;
+          if (use_heap) {
+            HeapSelect(row, 0, width, k, false, &entries);
+            index = entries.front().index;
+          } else {
+            entries.resize(width);
+            LoadSortEntries(row, 0, width, false, entries.data());
+            std::nth_element(
+                entries.begin(), entries.begin() + k - 1, entries.end());
+            index = entries[k - 1].index;
+          }
+          out[i] = row[index];
+          indices[i] = index;
+        }
+      });
+}
+
+// The most frequent value of each row of the height x width matrix in, the
+// smallest one of those as frequent, with its last position in the row.
+template <typename T>
+void ModeRows(const CPUContext& dev_ctx,
+              const T* in,
+              int64_t height,
+              int64_t width,
+              T* out,
+              int64_t* indices) {
+  using Entry = SortEntry<typename SortKeyTraits<T>::Key>;
+  dev_ctx.ParallelFor(
+      height, SortRowGrainSize(width), [&](int64_t begin, int64_t end) {
+        std::vector<Entry> entries(width);
+        std::vector<Entry> buffer;
+        for (int64_t i = begin; i < end; ++i) {
+          const T* row = in + i * width;
+          LoadSortEntries(row, 0, width, false, entries.data());
+          SortEntries(entries.data(), width, &buffer);
+          T mode = 0;
+          int64_t index = 0;
+          int64_t cur_freq = 0;
+          int64_t max_freq = 0;
+          for (int64_t j = 0; j < width; ++j) {
+            ++cur_freq;
+            if (j == width - 1 ||
+                row[entries[j + 1].index] != row[entries[j].index]) {
+              if (cur_freq > max_freq) {
+                max_freq = cur_freq;
+                mode = row[entries[j].index];
+                index = entries[j].index;
+              }
+              cur_freq = 0;
+            }
+          }
+          out[i] = mode;
+          indices[i] = index;
+        }
+      });
+}
+
+}  // namespace funcs
+}  // namespace phi
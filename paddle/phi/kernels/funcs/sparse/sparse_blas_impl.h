@@ -0,0 +1,515 @@
+/* Copyright (c) 2022 PaddlePaddle Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License. */
+
+#pragma once
+
+#include <algorithm>
+#include <vector>
+
+#include "paddle/phi/backends/cpu/cpu_context.h"
+#include "paddle/phi/common/amp_type_traits.h"
+#include "paddle/phi/core/ddim.h"
+#include "paddle/phi/core/dense_tensor.h"
+#include "paddle/phi/core/enforce.h"
+#include "paddle/phi/core/sparse_coo_tensor.h"
+#include "paddle/phi/core/sparse_csr_tensor.h"
+#include "paddle/phi/core/visit_type.h"
+
+namespace phi {
+namespace funcs {
+namespace sparse {
+
+/************* SPARSE MATRIX BATCH (COO/CSR) ************/
+
+// The number of output columns computed together, so that the rows of the
+// dense operand read for them stay in the cache across the sparse rows.
+constexpr int64_t kSpmmColumnBlock = 256;
+
+// A batch of sparse matrices in the CSR layout. The rows of all the matrices
+// are numbered globally: row r of matrix b is the row b * rows + r.
+template <typename T, typename IntT>
+struct CsrBatch {
+  int64_t batch_size{1};
+  int64_t rows{0};
+  int64_t cols{0};
+  // The batch_size * rows + 1 offsets of the rows in col_index and values.
+  std::vector<int64_t> offsets;
+  const IntT* col_index{nullptr};
+  const T* values{nullptr};
+  // The storage of col_index and values when they are not the tensor's.
+  std::vector<IntT> col_buffer;
+  std::vector<T> value_buffer;
+};
+
+inline void GetMatrixDims(const DDim& dims,
+                          int64_t* batch_size,
+                          int64_t* rows,
+                          int64_t* cols) {
+  int ndims = dims.size();
+  PADDLE_ENFORCE_GE(
+      ndims,
+      2,
+      phi::errors::InvalidArgument("the dim size of the matrix must be "
+                                   "greater than or eaqual to 2."));
+  *batch_size = 1;
+  for (int i = 0; i < ndims - 2; ++i) {
+    *batch_size *= dims[i];
+  }
+  *rows = dims[ndims - 2];
+  *cols = dims[ndims - 1];
+}
+
+inline DataType GetIndexType(const SparseCsrTensor& x) {
+  return x.non_zero_crows().dtype();
+}
+
+inline DataType GetIndexType(const SparseCooTensor& x) {
+  return x.non_zero_indices().dtype();
+}
+
+template <typename T, typename IntT>
+void MakeCsrBatch(const SparseCsrTensor& x, CsrBatch<T, IntT>* csr) {
+  GetMatrixDims(x.dims(), &csr->batch_size, &csr->rows, &csr->cols);
+  PADDLE_ENFORCE_EQ(x.non_zero_crows().numel(),
+                    csr->batch_size * (csr->rows + 1),
+                    phi::errors::PreconditionNotMet(
+                        "the length of SparseCsrTensor crows is not right."));
+  // The crows of each matrix start from 0.
+  const IntT* crows = x.non_zero_crows().data<IntT>();
+  csr->offsets.resize(csr->batch_size * csr->rows + 1);
+  int64_t base = 0;
+  for (int64_t b = 0; b < csr->batch_size; ++b) {
+    const IntT* batch_crows = crows + b * (csr->rows + 1);
+    for (int64_t r = 0; r < csr->rows; ++r) {
+      csr->offsets[b * csr->rows + r] = base + batch_crows[r];
+    }
+    base += batch_crows[csr->rows];
+  }
+  csr->offsets.back() = base;
+  PADDLE_ENFORCE_EQ(base,
+                    x.nnz(),
+                    phi::errors::PreconditionNotMet(
+                        "the crows of SparseCsrTensor do not match its nnz."));
+  csr->col_index = x.non_zero_cols().data<IntT>();
+  csr->values = x.non_zero_elements().data<T>();
+}
+
+template <typename T, typename IntT>
+void MakeCsrBatch(const SparseCooTensor& x, CsrBatch<T, IntT>* csr) {
+  GetMatrixDims(x.dims(), &csr->batch_size, &csr->rows, &csr->cols);
+  int ndims = x.dims().size();
+  PADDLE_ENFORCE_EQ(x.sparse_dim(),
+                    ndims,
+                    phi::errors::InvalidArgument(
+                        "the sparse_dim of SparseCooTensor must be equal to "
+                        "its dim size in the matrix multiplication."));
+  const int64_t nnz = x.nnz();
+  const IntT* indices = x.non_zero_indices().data<IntT>();
+  const T* values = x.non_zero_elements().data<T>();
+
+  // A stable counting sort of the nonzeros by their global rows.
+  std::vector<int64_t> rows(nnz);
+  csr->offsets.assign(csr->batch_size * csr->rows + 1, 0);
+  for (int64_t i = 0; i < nnz; ++i) {
+    int64_t row = 0;
+    for (int d = 0; d < ndims - 1; ++d) {
+      row = row * x.dims()[d] + indices[d * nnz + i];
+    }
+    rows[i] = row;
+    ++csr->offsets[row + 1];
+  }
+  for (size_t r = 1; r < csr->offsets.size(); ++r) {
+    csr->offsets[r] += csr->offsets[r - 1];
+  }
+  std::vector<int64_t> next(csr->offsets.begin(), csr->offsets.end() - 1);
+  csr->col_buffer.resize(nnz);
+  csr->value_buffer.resize(nnz);
+  const IntT* cols = indices + (ndims - 1) * nnz;
+  for (int64_t i = 0; i < nnz; ++i) {
+    int64_t pos = next[rows[i]]++;
+    csr->col_buffer[pos] = cols[i];
+    csr->value_buffer[pos] = values[i];
+  }
+  csr->col_index = csr->col_buffer.data();
+  csr->values = csr->value_buffer.data();
+}
+
+// out = the transpose of each matrix of x, in the CSR layout.
+template <typename T, typename IntT>
+void TransposeCsrBatch(const CsrBatch<T, IntT>& x, CsrBatch<T, IntT>* out) {
+  out->batch_size = x.batch_size;
+  out->rows = x.cols;
+  out->cols = x.rows;
+  const int64_t nnz = x.offsets.back();
+  out->offsets.assign(out->batch_size * out->rows + 1, 0);
+  for (int64_t b = 0; b < x.batch_size; ++b) {
+    for (int64_t i = x.offsets[b * x.rows]; i < x.offsets[(b + 1) * x.rows];
+         ++i) {
+      ++out->offsets[b * out->rows + x.col_index[i] + 1];
+    }
+  }
+  for (size_t r = 1; r < out->offsets.size(); ++r) {
+    out->offsets[r] += out->offsets[r - 1];
+  }
+  std::vector<int64_t> next(out->offsets.begin(), out->offsets.end() - 1);
+  out->col_buffer.resize(nnz);
+  out->value_buffer.resize(nnz);
+  for (int64_t b = 0; b < x.batch_size; ++b) {
+    for (int64_t r = 0; r < x.rows; ++r) {
+      int64_t row = b * x.rows + r;
+      for (int64_t i = x.offsets[row]; i < x.offsets[row + 1]; ++i) {
+        int64_t pos = next[b * out->rows + x.col_index[i]]++;
+        out->col_buffer[pos] = static_cast<IntT>(r);
+        out->value_buffer[pos] = x.values[i];
+      }
+    }
+  }
+  out->col_index = out->col_buffer.data();
+  out->values = out->value_buffer.data();
+}
+
+// Split the rows into ranges of about the same cost, a row costing its
+// nonzeros times nnz_cost plus row_cost, so that a few long rows do not leave
+// the other threads idle. Return the bounds of the ranges.
+inline std::vector<int64_t> PartitionRowsByNnz(
+    const phi::CPUContext& dev_ctx,
+    const std::vector<int64_t>& offsets,
+    int64_t nnz_cost,
+    int64_t row_cost) {
+  const int64_t rows = offsets.size() - 1;
+  auto cost = [&](int64_t r) { return offsets[r] * nnz_cost + r * row_cost; };
+  const int64_t total = cost(rows);
+  int64_t num_parts = std::min<int64_t>(
+      dev_ctx.GetIntraOpNumThreads(),
+      (total + phi::CPUContext::kDefaultGrainSize - 1) /
+          phi::CPUContext::kDefaultGrainSize);
+  num_parts = std::max<int64_t>(std::min(num_parts, rows), 1);
+
+  std::vector<int64_t> bounds = {0};
+  int64_t r = 0;
+  for (int64_t p = 1; p < num_parts; ++p) {
+    int64_t target = total / num_parts * p;
+    while (r < rows && cost(r) < target) ++r;
+    if (r > bounds.back()) bounds.push_back(r);
+  }
+  if (rows > bounds.back()) bounds.push_back(rows);
+  return bounds;
+}
+
+// out = alpha * a @ b + beta * out, b and out being dense batches of
+// a.cols x n and a.rows x n matrices.
+template <typename T, typename IntT>
+void CsrDenseMatmul(const phi::CPUContext& dev_ctx,
+                    const CsrBatch<T, IntT>& a,
+                    const T* b,
+                    int64_t n,
+                    T alpha,
+                    T beta,
+                    T* out) {
+  using MT = typename phi::dtype::MPTypeTrait<T>::Type;
+  const MT alpha_mt = static_cast<MT>(alpha);
+  const MT beta_mt = static_cast<MT>(beta);
+  const bool scale_out = beta_mt != static_cast<MT>(0);
+  auto bounds = PartitionRowsByNnz(dev_ctx, a.offsets, n, n);
+  dev_ctx.ParallelFor(
+      bounds.size() - 1, 1, [&](int64_t begin_part, int64_t end_part) {
+        std::vector<MT> acc(std::min(n, kSpmmColumnBlock));
+        for (int64_t col = 0; col < n; col += kSpmmColumnBlock) {
+          const int64_t width = std::min(n - col, kSpmmColumnBlock);
+          for (int64_t row = bounds[begin_part]; row < bounds[end_part];
+               ++row) {
+            std::fill(acc.begin(), acc.begin() + width, static_cast<MT>(0));
+            const T* b_mat = b + (row / a.rows) * a.cols * n + col;
+            for (int64_t i = a.offsets[row]; i < a.offsets[row + 1]; ++i) {
+              const MT value = static_cast<MT>(a.values[i]);
+              const T* b_row = b_mat + a.col_index[i] * n;
+              for (int64_t j = 0; j < width; ++j) {
+                acc[j] += value * static_cast<MT>(b_row[j]);
+              }
+            }
+            T* out_row = out + row * n + col;
+            for (int64_t j = 0; j < width; ++j) {
+              MT result = alpha_mt * acc[j];
+              // out may be uninitialized when beta is 0.
+              if (scale_out) result += beta_mt * static_cast<MT>(out_row[j]);
+              out_row[j] = static_cast<T>(result);
+            }
+          }
+        }
+      });
+}
+
+// out = the transpose of the last two dims of x, a batch of rows x cols
+// matrices.
+template <typename T>
+void TransposeDenseBatch(const T* x,
+                         int64_t batch_size,
+                         int64_t rows,
+                         int64_t cols,
+                         std::vector<T>* out) {
+  constexpr int64_t kBlock = 32;
+  out->resize(batch_size * rows * cols);
+  for (int64_t b = 0; b < batch_size; ++b) {
+    const T* src = x + b * rows * cols;
+    T* dst = out->data() + b * rows * cols;
+    for (int64_t r0 = 0; r0 < rows; r0 += kBlock) {
+      for (int64_t c0 = 0; c0 < cols; c0 += kBlock) {
+        for (int64_t r = r0; r < std::min(rows, r0 + kBlock); ++r) {
+          for (int64_t c = c0; c < std::min(cols, c0 + kBlock); ++c) {
+            dst[c * rows + r] = src[r * cols + c];
+          }
+        }
+      }
+    }
+  }
+}
+
+template <typename T>
+T DotProduct(const T* x, const T* y, int64_t k) {
+  using MT = typename phi::dtype::MPTypeTrait<T>::Type;
+  MT sum = static_cast<MT>(0);
+  for (int64_t i = 0; i < k; ++i) {
+    sum += static_cast<MT>(x[i]) * static_cast<MT>(y[i]);
+  }
+  return static_cast<T>(sum);
+}
+
+template <typename T>
+T ScaleAdd(T alpha, T value, T beta, T out) {
+  using MT = typename phi::dtype::MPTypeTrait<T>::Type;
+  MT result = static_cast<MT>(alpha) * static_cast<MT>(value);
+  // out may be uninitialized when beta is 0.
+  if (static_cast<MT>(beta) != static_cast<MT>(0)) {
+    result += static_cast<MT>(beta) * static_cast<MT>(out);
+  }
+  return static_cast<T>(result);
+}
+
+// The values of out at its nonzeros are alpha * a @ b' + beta * out, where a
+// and b are dense batches of out.rows x k and out.cols x k matrices.
+template <typename T, typename IntT>
+void MaskedMatmul(const phi::CPUContext& dev_ctx,
+                  const T* a,
+                  const T* b,
+                  int64_t k,
+                  T alpha,
+                  T beta,
+                  const SparseCsrTensor& mask,
+                  T* values) {
+  CsrBatch<T, IntT> out;
+  MakeCsrBatch(mask, &out);
+  auto bounds = PartitionRowsByNnz(dev_ctx, out.offsets, k, 1);
+  dev_ctx.ParallelFor(
+      bounds.size() - 1, 1, [&](int64_t begin_part, int64_t end_part) {
+        for (int64_t row = bounds[begin_part]; row < bounds[end_part]; ++row) {
+          const T* a_row = a + row * k;
+          const T* b_mat = b + (row / out.rows) * out.cols * k;
+          for (int64_t i = out.offsets[row]; i < out.offsets[row + 1]; ++i) {
+            T dot = DotProduct(a_row, b_mat + out.col_index[i] * k, k);
+            values[i] = ScaleAdd(alpha, dot, beta, values[i]);
+          }
+        }
+      });
+}
+
+template <typename T, typename IntT>
+void MaskedMatmul(const phi::CPUContext& dev_ctx,
+                  const T* a,
+                  const T* b,
+                  int64_t k,
+                  T alpha,
+                  T beta,
+                  const SparseCooTensor& mask,
+                  T* values) {
+  int64_t batch_size, rows, cols;
+  GetMatrixDims(mask.dims(), &batch_size, &rows, &cols);
+  int ndims = mask.dims().size();
+  PADDLE_ENFORCE_EQ(mask.sparse_dim(),
+                    ndims,
+                    phi::errors::InvalidArgument(
+                        "the sparse_dim of SparseCooTensor must be equal to "
+                        "its dim size in the matrix multiplication."));
+  const int64_t nnz = mask.nnz();
+  const IntT* indices = mask.non_zero_indices().data<IntT>();
+  const int64_t grain_size =
+      std::max<int64_t>(1, phi::CPUContext::kDefaultGrainSize / (k + 1));
+  dev_ctx.ParallelFor(nnz, grain_size, [&](int64_t begin, int64_t end) {
+    for (int64_t i = begin; i < end; ++i) {
+      int64_t row = 0;
+      for (int d = 0; d < ndims - 1; ++d) {
+        row = row * mask.dims()[d] + indices[d * nnz + i];
+      }
+      int64_t col = indices[(ndims - 1) * nnz + i];
+      const T* b_row = b + ((row / rows) * cols + col) * k;
+      T dot = DotProduct(a + row * k, b_row, k);
+      values[i] = ScaleAdd(alpha, dot, beta, values[i]);
+    }
+  });
+}
+
+template <typename T, typename IntT, typename TensorType>
+void Spmm(const phi::CPUContext& dev_ctx,
+          bool transa,
+          bool transb,
+          T alpha,
+          const TensorType& mat_a,
+          const phi::DenseTensor& mat_b,
+          T beta,
+          phi::DenseTensor* mat_out) {
+  CsrBatch<T, IntT> a;
+  CsrBatch<T, IntT> a_trans;
+  MakeCsrBatch(mat_a, &a);
+  if (transa) TransposeCsrBatch(a, &a_trans);
+  const auto& op_a = transa ? a_trans : a;
+
+  int64_t batch_size, b_rows, b_cols;
+  GetMatrixDims(mat_b.dims(), &batch_size, &b_rows, &b_cols);
+  std::vector<T> b_trans;
+  const T* b = mat_b.data<T>();
+  if (transb) {
+    TransposeDenseBatch(b, batch_size, b_rows, b_cols, &b_trans);
+    b = b_trans.data();
+    std::swap(b_rows, b_cols);
+  }
+  PADDLE_ENFORCE_EQ(
+      batch_size == op_a.batch_size && b_rows == op_a.cols &&
+          mat_out->numel() == batch_size * op_a.rows * b_cols,
+      true,
+      phi::errors::PreconditionNotMet(
+          "The shapes of the sparse matrix %s, the dense matrix %s and the "
+          "output %s do not match in the matrix multiplication.",
+          mat_a.dims(),
+          mat_b.dims(),
+          mat_out->dims()));
+  CsrDenseMatmul(dev_ctx, op_a, b, b_cols, alpha, beta, mat_out->data<T>());
+}
+
+template <typename T, typename IntT, typename TensorType>
+void Spmv(const phi::CPUContext& dev_ctx,
+          bool transa,
+          T alpha,
+          const TensorType& mat_a,
+          const phi::DenseTensor& vec_x,
+          T beta,
+          phi::DenseTensor* vec_out) {
+  CsrBatch<T, IntT> a;
+  CsrBatch<T, IntT> a_trans;
+  MakeCsrBatch(mat_a, &a);
+  if (transa) TransposeCsrBatch(a, &a_trans);
+  const auto& op_a = transa ? a_trans : a;
+  PADDLE_ENFORCE_EQ(
+      op_a.batch_size == 1 && vec_x.numel() == op_a.cols &&
+          vec_out->numel() == op_a.rows,
+      true,
+      phi::errors::PreconditionNotMet(
+          "The shapes of the sparse matrix %s, the vector %s and the output "
+          "%s do not match in the matrix-vector multiplication.",
+          mat_a.dims(),
+          vec_x.dims(),
+          vec_out->dims()));
+  CsrDenseMatmul(
+      dev_ctx, op_a, vec_x.data<T>(), 1, alpha, beta, vec_out->data<T>());
+}
+
+/************* SPARSE*DENSE->DENSE MATMUL ************/
+template <>
+template <typename T, typename TensorType>
+void SparseBlas<phi::CPUContext>::SPMM(bool transa,
+                                       bool transb,
+                                       T alpha,
+                                       const TensorType& mat_a,
+                                       const phi::DenseTensor& mat_b,
+                                       T beta,
+                                       phi::DenseTensor* mat_out) const {
+  PD_VISIT_INTEGRAL_TYPES(GetIndexType(mat_a), "SparseBlas SPMM", ([&] {
+                            Spmm<T, data_t>(dev_ctx_,
+                                            transa,
+                                            transb,
+                                            alpha,
+                                            mat_a,
+                                            mat_b,
+                                            beta,
+                                            mat_out);
+                          }));
+}
+
+/************* SPARSE*DENSE->DENSE MV ************/
+template <>
+template <typename T, typename TensorType>
+void SparseBlas<phi::CPUContext>::SPMV(bool transa,
+                                       T alpha,
+                                       const TensorType& mat_a,
+                                       const phi::DenseTensor& vec_x,
+                                       T beta,
+                                       phi::DenseTensor* vec_out) const {
+  PD_VISIT_INTEGRAL_TYPES(
+      GetIndexType(mat_a), "SparseBlas SPMV", ([&] {
+        Spmv<T, data_t>(dev_ctx_, transa, alpha, mat_a, vec_x, beta, vec_out);
+      }));
+}
+
+/************* DENSE*DENSE->SPARSE MATMUL ************/
+template <>
+template <typename T, typename TensorType>
+void SparseBlas<phi::CPUContext>::SDDMM(bool transa,
+                                        bool transb,
+                                        T alpha,
+                                        const phi::DenseTensor& mat_a,
+                                        const phi::DenseTensor& mat_b,
+                                        T beta,
+                                        TensorType* mat_out) const {
+  // The dot products read the rows of a and the columns of b, so a is made
+  // row major and b column major.
+  int64_t batch_size, a_rows, a_cols;
+  GetMatrixDims(mat_a.dims(), &batch_size, &a_rows, &a_cols);
+  std::vector<T> a_trans;
+  const T* a = mat_a.data<T>();
+  if (transa) {
+    TransposeDenseBatch(a, batch_size, a_rows, a_cols, &a_trans);
+    a = a_trans.data();
+    std::swap(a_rows, a_cols);
+  }
+  int64_t b_batch_size, b_rows, b_cols;
+  GetMatrixDims(mat_b.dims(), &b_batch_size, &b_rows, &b_cols);
+  std::vector<T> b_trans;
+  const T* b = mat_b.data<T>();
+  if (!transb) {
+    TransposeDenseBatch(b, b_batch_size, b_rows, b_cols, &b_trans);
+    b = b_trans.data();
+    std::swap(b_rows, b_cols);
+  }
+  int64_t out_batch_size, out_rows, out_cols;
+  GetMatrixDims(mat_out->dims(), &out_batch_size, &out_rows, &out_cols);
+  PADDLE_ENFORCE_EQ(
+      batch_size == b_batch_size && batch_size == out_batch_size &&
+          a_cols == b_cols && a_rows == out_rows && b_rows == out_cols,
+      true,
+      phi::errors::PreconditionNotMet(
+          "The shapes of the dense matrices %s, %s and the sparse output %s "
+          "do not match in the masked matrix multiplication.",
+          mat_a.dims(),
+          mat_b.dims(),
+          mat_out->dims()));
+
+  T* values = mat_out->mutable_non_zero_elements()->template data<T>();
+  PD_VISIT_INTEGRAL_TYPES(
+      GetIndexType(*mat_out), "SparseBlas SDDMM", ([&] {
+        MaskedMatmul<T, data_t>(
+            dev_ctx_, a, b, a_cols, alpha, beta, *mat_out, values);
+      }));
+}
+
+}  // namespace sparse
+}  // namespace funcs
+}  // namespace phi
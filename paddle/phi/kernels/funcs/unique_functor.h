@@ -17,6 +17,7 @@
 #include "paddle/phi/core/dense_tensor.h"
 #include "paddle/phi/kernels/funcs/concat_and_split_functor.h"
 #include "paddle/phi/kernels/funcs/math_function.h"
+#include "paddle/phi/kernels/funcs/sort_function.h"
 
 namespace phi {
 namespace funcs {
@@ -142,51 +143,50 @@ static void UniqueFlattendTensor(const Context& context,
                                  bool return_inverse,
                                  bool return_counts) {
   const InT* in_data = in.data<InT>();
-  std::set<InT> unique(in_data, in_data + in.numel());
-  out->Resize(phi::make_ddim({static_cast<int64_t>(unique.size())}));
+  const int64_t numel = in.numel();
+  // The sorted values with their positions, the equal ones in the order of
+  // their positions.
+  std::vector<InT> sorted(numel);
+  std::vector<int64_t> order(numel);
+  SortRows<InT>(context, in_data, 1, numel, false, sorted.data(), order.data());
+  std::vector<int64_t> run_begins;
+  for (int64_t i = 0; i < numel; ++i) {
+    if (i == 0 || sorted[i] != sorted[i - 1]) {
+      run_begins.push_back(i);
+    }
+  }
+  const int64_t num_unique = run_begins.size();
+  run_begins.push_back(numel);
+
+  out->Resize(phi::make_ddim({num_unique}));
   auto* out_data = context.template Alloc<InT>(out);
-  std::copy(unique.begin(), unique.end(), out_data);
+  for (int64_t i = 0; i < num_unique; ++i) {
+    out_data[i] = sorted[run_begins[i]];
+  }
 
   if (return_index) {
-    indices->Resize(phi::make_ddim({out->numel()}));
+    indices->Resize(phi::make_ddim({num_unique}));
     auto indices_data = context.template Alloc<IndexT>(indices);
-    std::unordered_map<InT, IndexT> indices_map;
-    indices_map.reserve(out->numel());
-    for (int64_t i = 0; i < in.numel(); ++i) {
-      if (indices_map.find(in_data[i]) != indices_map.end()) continue;
-      indices_map[in_data[i]] = i;
-    }
-    for (int64_t i = 0; i < out->numel(); ++i) {
-      indices_data[i] = indices_map[out_data[i]];
+    for (int64_t i = 0; i < num_unique; ++i) {
+      indices_data[i] = static_cast<IndexT>(order[run_begins[i]]);
     }
   }
 
   if (return_inverse) {
-    index->Resize(phi::make_ddim({in.numel()}));
+    index->Resize(phi::make_ddim({numel}));
     auto inverse_data = context.template Alloc<IndexT>(index);
-    std::unordered_map<InT, IndexT> inverse_map;
-    inverse_map.reserve(out->numel());
-    for (int64_t i = 0; i < out->numel(); ++i) {
-      inverse_map[out_data[i]] = i;
-    }
-    for (int64_t i = 0; i < in.numel(); ++i) {
-      inverse_data[i] = inverse_map[in_data[i]];
+    for (int64_t i = 0; i < num_unique; ++i) {
+      for (int64_t j = run_begins[i]; j < run_begins[i + 1]; ++j) {
+        inverse_data[order[j]] = static_cast<IndexT>(i);
+      }
     }
   }
 
   if (return_counts) {
-    count->Resize(phi::make_ddim({out->numel()}));
+    count->Resize(phi::make_ddim({num_unique}));
     auto count_data = context.template Alloc<IndexT>(count);
-    std::unordered_map<InT, IndexT> counts_map;
-    counts_map.reserve(out->numel());
-    for (int64_t i = 0; i < out->numel(); ++i) {
-      counts_map[out_data[i]] = 0;
-    }
-    for (int64_t i = 0; i < in.numel(); i++) {
-      counts_map[in_data[i]] += 1;
-    }
-    for (int64_t i = 0; i < out->numel(); i++) {
-      count_data[i] = counts_map[out_data[i]];
+    for (int64_t i = 0; i < num_unique; ++i) {
+      count_data[i] = static_cast<IndexT>(run_begins[i + 1] - run_begins[i]);
     }
   }
 }
@@ -14,30 +14,37 @@
 
 #pragma once
 
+#include <functional>
+#include <limits>
+#include <type_traits>
+
 #include "paddle/fluid/operators/math/im2col.h"
 #include "paddle/fluid/operators/math/vol2col.h"
+#include "paddle/phi/backends/cpu/cpu_context.h"
+#include "paddle/phi/kernels/autotune/cache.h"
+#include "paddle/phi/kernels/autotune/cpu_timer.h"
+#include "paddle/phi/kernels/autotune/switch_autotune.h"
 #include "paddle/phi/kernels/conv_kernel.h"
 #include "paddle/phi/kernels/cpu/conv_util.h"
 #include "paddle/phi/kernels/funcs/batch_norm_utils.h"
 #include "paddle/phi/kernels/funcs/blas/blas.h"
+#include "paddle/phi/kernels/funcs/cpu_conv.h"
 #include "paddle/phi/kernels/funcs/math_function.h"
 
 namespace phi {
 
+// The conv of every device: im2col (or vol2col) + GEMM.
 template <typename T, typename Context>
-void ConvKernel(const Context& dev_ctx,
-                const DenseTensor& input,
-                const DenseTensor& filter_t,
-                const std::vector<int>& strides,
-                const std::vector<int>& paddings_t,
-                const std::string& padding_algorithm,
-                int groups,
-                const std::vector<int>& dilations_t,
-                const std::string& data_format,
-                bool use_addto,
-                int workspace_size_MB,
-                bool exhaustive_search,
-                DenseTensor* output) {
+void ConvIm2ColKernel(const Context& dev_ctx,
+                      const DenseTensor& input,
+                      const DenseTensor& filter_t,
+                      const std::vector<int>& strides,
+                      const std::vector<int>& paddings_t,
+                      const std::string& padding_algorithm,
+                      int groups,
+                      const std::vector<int>& dilations_t,
+                      const std::string& data_format,
+                      DenseTensor* output) {
   std::vector<int> paddings = paddings_t;
   std::vector<int> dilations = dilations_t;
   DenseTensor filter = filter_t;
@@ -180,4 +187,178 @@ void ConvKernel(const Context& dev_ctx,
   }
 }
 
+// Runs the conv with the algorithm of the device, im2col_conv by default.
+template <typename T, typename Context>
+void RunConvAlgorithm(const Context& dev_ctx,
+                      const DenseTensor& input,
+                      const DenseTensor& filter,
+                      const std::vector<int>& strides,
+                      const std::vector<int>& paddings_t,
+                      const std::string& padding_algorithm,
+                      int groups,
+                      const std::vector<int>& dilations_t,
+                      const std::string& data_format,
+                      const std::function<void()>& im2col_conv,
+                      DenseTensor* output) {
+  im2col_conv();
+}
+
+// The CPU conv2d picks one of funcs::CpuConvAlgo for the shape. With
+// autotune on, the algorithms are timed on the first run of a shape and the
+// fastest one is kept in the AutoTuneCache; otherwise a cached choice or the
+// heuristic of funcs::SelectCpuConvAlgo is used. Winograd changes the
+// numerics, so it is only timed for float when autotune is turned on.
+template <typename T>
+void RunConvAlgorithm(const CPUContext& dev_ctx,
+                      const DenseTensor& input,
+                      const DenseTensor& filter,
+                      const std::vector<int>& strides,
+                      const std::vector<int>& paddings_t,
+                      const std::string& padding_algorithm,
+                      int groups,
+                      const std::vector<int>& dilations_t,
+                      const std::string& data_format,
+                      const std::function<void()>& im2col_conv,
+                      DenseTensor* output) {
+  if (input.dims().size() != 4 ||
+      !(std::is_same<T, float>::value || std::is_same<T, double>::value)) {
+    im2col_conv();
+    return;
+  }
+  const bool channel_last = data_format == "NHWC";
+  const auto& in_dims = input.dims();
+  const auto& filter_dims = filter.dims();
+  const auto& out_dims = output->dims();
+
+  std::vector<int> paddings = paddings_t;
+  std::vector<int> dilations = dilations_t;
+  DDim in_data_dims = channel_last ? slice_ddim(in_dims, 1, 3)
+                                   : slice_ddim(in_dims, 2, 4);
+  std::vector<int> ksize = vectorize<int>(slice_ddim(filter_dims, 2, 4));
+  UpdatePaddingAndDilation(
+      &paddings, &dilations, padding_algorithm, in_data_dims, strides, ksize);
+
+  funcs::CpuConv2dShape shape;
+  shape.batch_size = static_cast<int>(in_dims[0]);
+  shape.in_channels = static_cast<int>(in_dims[channel_last ? 3 : 1]);
+  shape.in_h = static_cast<int>(in_data_dims[0]);
+  shape.in_w = static_cast<int>(in_data_dims[1]);
+  shape.out_channels = static_cast<int>(filter_dims[0]);
+  shape.out_h = static_cast<int>(out_dims[channel_last ? 1 : 2]);
+  shape.out_w = static_cast<int>(out_dims[channel_last ? 2 : 3]);
+  shape.kernel_h = ksize[0];
+  shape.kernel_w = ksize[1];
+  shape.stride_h = strides[0];
+  shape.stride_w = strides[1];
+  shape.pad_top = paddings[0];
+  shape.pad_left = paddings[2];
+  shape.dilation_h = dilations[0];
+  shape.dilation_w = dilations[1];
+  shape.groups = groups;
+  shape.channel_last = channel_last;
+
+  auto run = [&](funcs::CpuConvAlgo algo) {
+    if (algo == funcs::CpuConvAlgo::kIm2ColGemm) {
+      im2col_conv();
+    } else {
+      funcs::CpuConv2d<T>(dev_ctx,
+                          algo,
+                          shape,
+                          input.data<T>(),
+                          filter.data<T>(),
+                          dev_ctx.template Alloc<T>(output));
+    }
+  };
+
+  size_t key = autotune::GetKey(autotune::ConvKey(vectorize(in_dims),
+                                                  vectorize(filter_dims),
+                                                  strides,
+                                                  paddings,
+                                                  dilations,
+                                                  input.dtype()),
+                                groups,
+                                channel_last,
+                                dev_ctx.GetIntraOpNumThreads());
+  // Winograd changes the numerics, so only float may use it.
+  auto usable = [&shape](funcs::CpuConvAlgo algo) {
+    if (algo == funcs::CpuConvAlgo::kWinogradF2 ||
+        algo == funcs::CpuConvAlgo::kWinogradF4) {
+      if (!std::is_same<T, float>::value) return false;
+    }
+    return funcs::CpuConvSupports(algo, shape);
+  };
+  auto& cache = autotune::AutoTuneCache::Instance().GetCpuConvForward();
+  // A choice loaded by AutoTuneCache::Load from another build may not be
+  // usable for the shape, and is dropped.
+  int64_t cached = cache.Find(key) ? cache.Get(key) : -1;
+  if (cached >= 0 &&
+      cached < static_cast<int64_t>(funcs::CpuConvAlgo::kCount) &&
+      usable(static_cast<funcs::CpuConvAlgo>(cached))) {
+    run(static_cast<funcs::CpuConvAlgo>(cached));
+  } else if (autotune::AutoTuneStatus::Instance().UseAutoTune()) {
+    // Each algorithm runs once to warm up and once timed, and the output of
+    // the last run is as good as any.
+    auto best_algo = funcs::CpuConvAlgo::kIm2ColGemm;
+    float best_time = std::numeric_limits<float>::max();
+    for (int i = 0; i < static_cast<int>(funcs::CpuConvAlgo::kCount); ++i) {
+      auto algo = static_cast<funcs::CpuConvAlgo>(i);
+      if (!usable(algo)) continue;
+      run(algo);
+      CpuTimer timer;
+      timer.Start();
+      run(algo);
+      timer.Stop();
+      float time = timer.ElapsedTime();
+      VLOG(3) << "CPU conv algorithm " << funcs::CpuConvAlgoName(algo)
+              << " takes " << time << " ms";
+      if (time < best_time) {
+        best_time = time;
+        best_algo = algo;
+      }
+    }
+    cache.Set(key, static_cast<int64_t>(best_algo));
+  } else {
+    run(funcs::SelectCpuConvAlgo(shape));
+  }
+}
+
+template <typename T, typename Context>
+void ConvKernel(const Context& dev_ctx,
+                const DenseTensor& input,
+                const DenseTensor& filter,
+                const std::vector<int>& strides,
+                const std::vector<int>& paddings,
+                const std::string& padding_algorithm,
+                int groups,
+                const std::vector<int>& dilations,
+                const std::string& data_format,
+                bool use_addto,
+                int workspace_size_MB,
+                bool exhaustive_search,
+                DenseTensor* output) {
+  auto im2col_conv = [&]() {
+    ConvIm2ColKernel<T, Context>(dev_ctx,
+                                 input,
+                                 filter,
+                                 strides,
+                                 paddings,
+                                 padding_algorithm,
+                                 groups,
+                                 dilations,
+                                 data_format,
+                                 output);
+  };
+  RunConvAlgorithm<T>(dev_ctx,
+                      input,
+                      filter,
+                      strides,
+                      paddings,
+                      padding_algorithm,
+                      groups,
+                      dilations,
+                      data_format,
+                      im2col_conv,
+                      output);
+}
+
 }  // namespace phi
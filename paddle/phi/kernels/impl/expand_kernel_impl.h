@@ -17,8 +17,8 @@
 #include <algorithm>
 #include <vector>
 
+#include "paddle/phi/kernels/funcs/eigen/broadcast_function.h"
 #include "paddle/phi/kernels/funcs/eigen/common.h"
-#include "paddle/phi/kernels/funcs/eigen/eigen_function.h"
 #define MAX_RANK_SUPPORTED 6
 
 namespace phi {
@@ -92,16 +92,7 @@ void Expand(const Context& ctx,
   out->data<T>();
 
   auto y = EigenTensor<T, Rank>::From(*out, out_dims);
-  auto& place = *ctx.eigen_device();
-  // use 32-bit index to speed up
-  bool use_32bit_index = y.size() < Eigen::NumTraits<int>::highest();
-  if (use_32bit_index) {
-    phi::funcs::EigenBroadcast<std::decay_t<decltype(place)>, T, Rank>::Eval(
-        place, To32BitIndex(y), To32BitIndex(x0), bcast_dims);
-  } else {
-    phi::funcs::EigenBroadcast<std::decay_t<decltype(place)>, T, Rank>::Eval(
-        place, y, x0, bcast_dims);
-  }
+  funcs::EigenBroadcastOn<T, Rank>(ctx, y, x0, bcast_dims);
 }
 
 template <typename T, typename Context>
@@ -16,8 +16,8 @@
 #include <type_traits>
 #include <vector>
 
+#include "paddle/phi/kernels/funcs/eigen/broadcast_function.h"
 #include "paddle/phi/kernels/funcs/eigen/common.h"
-#include "paddle/phi/kernels/funcs/eigen/eigen_function.h"
 #include "paddle/phi/kernels/tile_kernel.h"
 
 namespace phi {
@@ -70,16 +70,7 @@ void Tile(const Context& dev_ctx,
   dev_ctx.template Alloc<T>(out);
 
   auto eigen_out = EigenTensor<T, Rank>::From(*out, out_dims);
-  auto& place = *dev_ctx.eigen_device();
-  // use 32-bit index to speed up
-  bool use_32bit_index = eigen_out.size() < Eigen::NumTraits<int>::highest();
-  if (use_32bit_index) {
-    funcs::EigenBroadcast<std::decay_t<decltype(place)>, T, Rank>::Eval(
-        place, To32BitIndex(eigen_out), To32BitIndex(eigen_x), bcast_dims);
-  } else {
-    funcs::EigenBroadcast<std::decay_t<decltype(place)>, T, Rank>::Eval(
-        place, eigen_out, eigen_x, bcast_dims);
-  }
+  funcs::EigenBroadcastOn<T, Rank>(dev_ctx, eigen_out, eigen_x, bcast_dims);
 }
 
 template <typename T, typename Context>
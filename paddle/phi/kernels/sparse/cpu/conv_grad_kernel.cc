@@ -116,12 +116,14 @@ void Conv3dCooGradCPUKernel(const CPUContext& dev_ctx,
     }
   }
 
-  Gather<T, IntT>(x.non_zero_elements().data<T>(),
+  Gather<T, IntT>(dev_ctx,
+                  x.non_zero_elements().data<T>(),
                   rulebook_ptr + rulebook_len,
                   rulebook_len,
                   in_channels,
                   in_features_ptr);
-  Gather<T, IntT>(out_grad.non_zero_elements().data<T>(),
+  Gather<T, IntT>(dev_ctx,
+                  out_grad.non_zero_elements().data<T>(),
                   rulebook_ptr + rulebook_len * 2,
                   rulebook_len,
                   out_channels,
@@ -169,12 +171,18 @@ void Conv3dCooGradCPUKernel(const CPUContext& dev_ctx,
               tmp_d_x_ptr);
   }
 
-  // 4. scatter
-  Scatter<T, IntT>(d_x_features_ptr,
-                   rulebook.data<IntT>() + rulebook_len,
-                   rulebook_len,
-                   in_channels,
-                   x_grad_values_ptr);
+  // 4. scatter, the inputs of each kernel offset being distinct
+  for (int i = 0; i < kernel_size; i++) {
+    if (counter[i] <= 0 || (subm && i == half_kernel_size)) {
+      continue;
+    }
+    Scatter<T, IntT>(dev_ctx,
+                     d_x_features_ptr + offsets[i] * in_channels,
+                     rulebook_ptr + rulebook_len + offsets[i],
+                     counter[i],
+                     in_channels,
+                     x_grad_values_ptr);
+  }
 }
 
 template <typename T, typename Context>
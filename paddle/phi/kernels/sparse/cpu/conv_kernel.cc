@@ -12,6 +12,8 @@ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
 See the License for the specific language governing permissions and
 limitations under the License. */
 
+#include <algorithm>
+
 #include "paddle/phi/core/kernel_registry.h"
 #include "paddle/phi/core/tensor_meta.h"
 #include "paddle/phi/core/visit_type.h"
@@ -70,28 +72,32 @@ void Conv3dCooCPUKernel(const CPUContext& dev_ctx,
       DataType::INT32, {kernel_size}, DataLayout::NCHW);
   DenseTensor counter_per_kernel = phi::Empty(dev_ctx, std::move(counter_meta));
 
-  ProductRuleBook<T, CPUContext, IntT>(dev_ctx,
-                                       x,
-                                       kernel_sizes,
-                                       subm_paddings,
-                                       dilations,
-                                       subm_strides,
-                                       out_dims,
-                                       subm,
-                                       rulebook,
-                                       &counter_per_kernel);
-
-  UpdateRulebookAndOutIndex<T, CPUContext, IntT>(
-      dev_ctx, x, kernel_size, out_channels, out_dims, rulebook, out);
+  ProductRuleBookWithCache<T, CPUContext, IntT>(dev_ctx,
+                                                x,
+                                                kernel_sizes,
+                                                subm_paddings,
+                                                dilations,
+                                                subm_strides,
+                                                out_dims,
+                                                subm,
+                                                out_channels,
+                                                rulebook,
+                                                &counter_per_kernel,
+                                                out);
 
   int n = rulebook->dims()[1];
   const int* counter_ptr = counter_per_kernel.data<int>();
+  std::vector<int> offsets(kernel_size + 1);
+  phi::funcs::sparse::PrefixSum(counter_ptr, &offsets[0], kernel_size);
+  const int max_count =
+      *std::max_element(counter_ptr, counter_ptr + kernel_size);
 
-  // 2. gather
+  // 2. gather, gemm and scatter the rules of every kernel offset in turn, so
+  // that the features of one offset stay in the cache between the steps.
   DenseTensorMeta in_features_meta(
-      x.dtype(), {n, in_channels}, DataLayout::NHWC);
+      x.dtype(), {max_count, in_channels}, DataLayout::NHWC);
   DenseTensorMeta out_features_meta(
-      x.dtype(), {n, out_channels}, DataLayout::NHWC);
+      x.dtype(), {max_count, out_channels}, DataLayout::NHWC);
   phi::DenseTensor in_features =
       phi::Empty(dev_ctx, std::move(in_features_meta));
   phi::DenseTensor out_features =
@@ -99,55 +105,47 @@ void Conv3dCooCPUKernel(const CPUContext& dev_ctx,
   T* in_features_ptr = in_features.data<T>();
   T* out_features_ptr = out_features.data<T>();
 
-  Gather<T, IntT>(x.non_zero_elements().data<T>(),
-                  rulebook->data<IntT>() + n,
-                  n,
-                  in_channels,
-                  in_features_ptr);
+  T* out_values_ptr = out->mutable_non_zero_elements()->data<T>();
+  memset(out_values_ptr, 0, sizeof(T) * out->nnz() * out_channels);
 
-  // 3. call gemm for every werght
   auto blas = phi::funcs::GetBlas<CPUContext, T>(dev_ctx);
-  std::vector<int> offsets(kernel_size + 1);
-  int offset = 0;
-  for (int i = 0; i < kernel_size; i++) {
-    offsets[i] = offset;
-    offset += counter_ptr[i];
-  }
-  offsets[kernel_size] = offset;
-
   const T* kernel_ptr = kernel.data<T>();
+  const IntT* rulebook_ptr = rulebook->data<IntT>();
   for (int i = 0; i < kernel_size; i++) {
     if (counter_ptr[i] <= 0) {
       continue;
     }
 
+    Gather<T, IntT>(dev_ctx,
+                    x.non_zero_elements().data<T>(),
+                    rulebook_ptr + n + offsets[i],
+                    counter_ptr[i],
+                    in_channels,
+                    in_features_ptr);
+
     // call gemm: (n, in_channels) * (in_channels, out_channels)
     const int M = counter_ptr[i];
     const int K = in_channels;   // in_channels
     const int N = out_channels;  // out_channels
-    T* tmp_in_ptr = in_features_ptr + offsets[i] * in_channels;
     const T* tmp_kernel_ptr = kernel_ptr + i * K * N;
-    T* tmp_out_ptr = out_features_ptr + offsets[i] * out_channels;
     blas.GEMM(CblasNoTrans,
               CblasNoTrans,
               M,
               N,
               K,
               static_cast<T>(1),
-              tmp_in_ptr,
+              in_features_ptr,
               tmp_kernel_ptr,
               static_cast<T>(0),
-              tmp_out_ptr);
+              out_features_ptr);
+
+    Scatter<T, IntT>(dev_ctx,
+                     out_features_ptr,
+                     rulebook_ptr + n * 2 + offsets[i],
+                     counter_ptr[i],
+                     out_channels,
+                     out_values_ptr);
   }
-
-  // 4. scatter
-  T* out_values_ptr = out->mutable_non_zero_elements()->data<T>();
-  memset(out_values_ptr, 0, sizeof(T) * out->nnz() * out_channels);
-  Scatter<T, IntT>(out_features_ptr,
-                   rulebook->data<IntT>() + n * 2,
-                   n,
-                   out_channels,
-                   out_values_ptr);
 }
 
 template <typename T, typename Context>
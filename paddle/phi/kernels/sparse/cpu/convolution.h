@@ -14,8 +14,16 @@ limitations under the License. */
 
 #pragma once
 
-#include <set>
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <vector>
 
+#include "gflags/gflags.h"
+#include "paddle/phi/backends/cpu/cpu_context.h"
 #include "paddle/phi/core/dense_tensor.h"
 #include "paddle/phi/core/kernel_registry.h"
 #include "paddle/phi/core/sparse_coo_tensor.h"
@@ -23,14 +31,100 @@ limitations under the License. */
 #include "paddle/phi/kernels/funcs/blas/blas.h"
 #include "paddle/phi/kernels/sparse/conv_kernel.h"
 
+DECLARE_bool(sparse_conv_rulebook_cache);
+
 namespace phi {
 namespace sparse {
 
 using Dims4D = phi::funcs::sparse::Dims4D;
 
+// An open addressing hash table of the linear indices of points, which may
+// be inserted and found from many threads at once. Each key owns a slot
+// holding a value, written by the caller once the keys are inserted.
+template <typename IntT>
+class PointTable {
+ public:
+  explicit PointTable(int64_t num_points) {
+    int64_t capacity = 16;
+    shift_ = 60;
+    while (capacity < num_points * 2) {
+      capacity <<= 1;
+      --shift_;
+    }
+    mask_ = capacity - 1;
+    keys_.reset(new std::atomic<IntT>[capacity]);
+    for (int64_t i = 0; i < capacity; ++i) {
+      keys_[i].store(kEmpty, std::memory_order_relaxed);
+    }
+    values_.resize(capacity);
+  }
+
+  // Return false if the key is inserted already.
+  bool Insert(IntT key) {
+    for (int64_t slot = Hash(key);; slot = (slot + 1) & mask_) {
+      IntT expected = kEmpty;
+      if (keys_[slot].compare_exchange_strong(
+              expected, key, std::memory_order_relaxed)) {
+        return true;
+      }
+      if (expected == key) {
+        return false;
+      }
+    }
+  }
+
+  // Return the slot of the key, or -1 if it is not inserted.
+  int64_t Find(IntT key) const {
+    for (int64_t slot = Hash(key);; slot = (slot + 1) & mask_) {
+      IntT stored = keys_[slot].load(std::memory_order_relaxed);
+      if (stored == key) {
+        return slot;
+      }
+      if (stored == kEmpty) {
+        return -1;
+      }
+    }
+  }
+
+  std::vector<IntT> Keys() const {
+    std::vector<IntT> keys;
+    for (int64_t slot = 0; slot <= mask_; ++slot) {
+      IntT key = keys_[slot].load(std::memory_order_relaxed);
+      if (key != kEmpty) {
+        keys.push_back(key);
+      }
+    }
+    return keys;
+  }
+
+  IntT& value(int64_t slot) { return values_[slot]; }
+  const IntT& value(int64_t slot) const { return values_[slot]; }
+
+ private:
+  static constexpr IntT kEmpty = static_cast<IntT>(-1);
+
+  int64_t Hash(IntT key) const {
+    // Fibonacci hashing spreads the neighbouring points over the table.
+    return static_cast<int64_t>(
+        (static_cast<uint64_t>(key) * 0x9E3779B97F4A7C15ULL) >> shift_);
+  }
+
+  std::unique_ptr<std::atomic<IntT>[]> keys_;
+  std::vector<IntT> values_;
+  int64_t mask_;
+  int shift_;
+};
+
+template <typename IntT>
+constexpr IntT PointTable<IntT>::kEmpty;
+
 // such as: kernel(3, 3, 3), kernel_size = 27
 // counter_per_weight: (kernel_size)
-// TODO(zhangkaihuo): optimize performance with multithreading
+//
+// The nonzeros are split into chunks over the intra op threads, which count
+// their rules of every kernel offset first and then write them at the
+// offsets given by the counts, so the rulebook is in the same order as a
+// serial walk: by kernel offset, then by input.
 template <typename T, typename Context, typename IntT = int>
 void ProductRuleBook(const Context& dev_ctx,
                      const SparseCooTensor& x,
@@ -49,8 +143,6 @@ void ProductRuleBook(const Context& dev_ctx,
   int kernel_size = kernel_sizes[0] * kernel_sizes[1] * kernel_sizes[2];
   memset(counter_ptr, 0, kernel_size * sizeof(int));
 
-  int rulebook_len = 0;
-  // calc the rulebook_len
   const auto& x_dims = x.dims();
   const Dims4D c_x_dims(x_dims[0], x_dims[3], x_dims[2], x_dims[1]);
   const Dims4D c_kernel_dims(
@@ -60,71 +152,94 @@ void ProductRuleBook(const Context& dev_ctx,
   const Dims4D c_strides(1, strides[2], strides[1], strides[0]);
   const Dims4D c_dilations(1, dilations[2], dilations[1], dilations[0]);
 
-  std::set<IntT> hash_in;
+  std::unique_ptr<PointTable<IntT>> hash_in;
   if (subm) {
-    for (int i = 0; i < non_zero_num; i++) {
-      IntT batch = indices_ptr[i];
-      IntT in_z = indices_ptr[i + non_zero_num];
-      IntT in_y = indices_ptr[i + 2 * non_zero_num];
-      IntT in_x = indices_ptr[i + 3 * non_zero_num];
-      IntT index = phi::funcs::sparse::PointToIndex<DDim>(
-          batch, in_x, in_y, in_z, x_dims);
-      hash_in.insert(index);
-    }
+    hash_in.reset(new PointTable<IntT>(non_zero_num));
+    dev_ctx.ParallelFor(non_zero_num,
+                        CPUContext::kDefaultGrainSize,
+                        [&](int64_t begin, int64_t end) {
+                          for (int64_t i = begin; i < end; i++) {
+                            IntT batch = indices_ptr[i];
+                            IntT in_z = indices_ptr[i + non_zero_num];
+                            IntT in_y = indices_ptr[i + 2 * non_zero_num];
+                            IntT in_x = indices_ptr[i + 3 * non_zero_num];
+                            hash_in->Insert(
+                                phi::funcs::sparse::PointToIndex<DDim>(
+                                    batch, in_x, in_y, in_z, x_dims));
+                          }
+                        });
   }
 
-  auto f_calc_rulebook = [&](IntT* rulebook_ptr) {
-    int kernel_index = 0, rulebook_index = 0;
+  // Call f(kernel_index, out_index) for every rule of the input i, in the
+  // order of the kernel offsets.
+  auto for_each_rule = [&](int64_t i, const auto& f) {
+    IntT batch = indices_ptr[i];
+    IntT in_z = indices_ptr[i + non_zero_num];
+    IntT in_y = indices_ptr[i + 2 * non_zero_num];
+    IntT in_x = indices_ptr[i + 3 * non_zero_num];
+    int kernel_index = 0;
     for (int kz = 0; kz < kernel_sizes[0]; kz++) {
       for (int ky = 0; ky < kernel_sizes[1]; ky++) {
-        for (int kx = 0; kx < kernel_sizes[2]; kx++) {
-          ++kernel_index;
-          for (int64_t i = 0; i < non_zero_num; i++) {
-            IntT batch = indices_ptr[i];
-            IntT in_z = indices_ptr[i + non_zero_num];
-            IntT in_y = indices_ptr[i + 2 * non_zero_num];
-            IntT in_x = indices_ptr[i + 3 * non_zero_num];
-            IntT out_z = (in_z + paddings[0] - kz * dilations[0]) / strides[0];
-            IntT out_y = (in_y + paddings[1] - ky * dilations[1]) / strides[1];
-            IntT out_x = (in_x + paddings[2] - kx * dilations[2]) / strides[2];
-            if (phi::funcs::sparse::Check(c_x_dims,
-                                          c_kernel_dims,
-                                          c_paddings,
-                                          c_dilations,
-                                          c_strides,
-                                          in_x,
-                                          in_y,
-                                          in_z,
-                                          kx,
-                                          ky,
-                                          kz)) {
-              if (subm) {
-                IntT out_index = phi::funcs::sparse::PointToIndex<DDim>(
-                    batch, out_x, out_y, out_z, out_dims);
-                if (hash_in.find(out_index) == hash_in.end()) {
-                  continue;
-                }
-              }
-
-              if (rulebook_ptr == nullptr) {
-                counter_ptr[kernel_index - 1] += 1;
-                ++rulebook_len;
-              } else {
-                rulebook_ptr[rulebook_index] = kernel_index - 1;
-                rulebook_ptr[rulebook_index + rulebook_len] = i;  // in_i
-                rulebook_ptr[rulebook_index + rulebook_len * 2] =
-                    phi::funcs::sparse::PointToIndex<DDim>(
-                        batch, out_x, out_y, out_z, out_dims);  // out_index
-                ++rulebook_index;
-              }
-            }
+        for (int kx = 0; kx < kernel_sizes[2]; kx++, kernel_index++) {
+          if (!phi::funcs::sparse::Check(c_x_dims,
+                                         c_kernel_dims,
+                                         c_paddings,
+                                         c_dilations,
+                                         c_strides,
+                                         in_x,
+                                         in_y,
+                                         in_z,
+                                         kx,
+                                         ky,
+                                         kz)) {
+            continue;
+          }
+          IntT out_z = (in_z + paddings[0] - kz * dilations[0]) / strides[0];
+          IntT out_y = (in_y + paddings[1] - ky * dilations[1]) / strides[1];
+          IntT out_x = (in_x + paddings[2] - kx * dilations[2]) / strides[2];
+          IntT out_index = phi::funcs::sparse::PointToIndex<DDim>(
+              batch, out_x, out_y, out_z, out_dims);
+          if (subm && hash_in->Find(out_index) < 0) {
+            continue;
           }
+          f(kernel_index, out_index);
         }
       }
     }
   };
 
-  f_calc_rulebook(nullptr);
+  const int64_t num_threads = dev_ctx.GetIntraOpNumThreads();
+  const int64_t chunk_size = std::max<int64_t>(
+      std::max<int64_t>(1, CPUContext::kDefaultGrainSize / kernel_size),
+      (non_zero_num + num_threads - 1) / num_threads);
+  const int64_t num_chunks = (non_zero_num + chunk_size - 1) / chunk_size;
+  auto for_each_chunk = [&](const auto& f) {
+    dev_ctx.ParallelFor(num_chunks, 1, [&](int64_t begin, int64_t end) {
+      for (int64_t c = begin; c < end; c++) {
+        f(c, c * chunk_size, std::min(non_zero_num, (c + 1) * chunk_size));
+      }
+    });
+  };
+
+  // chunk_offsets[c * kernel_size + k]: the number of rules of the kernel
+  // offset k in the chunk c, and then where the chunk writes them.
+  std::vector<int64_t> chunk_offsets(num_chunks * kernel_size, 0);
+  for_each_chunk([&](int64_t c, int64_t begin, int64_t end) {
+    int64_t* counts = &chunk_offsets[c * kernel_size];
+    for (int64_t i = begin; i < end; i++) {
+      for_each_rule(i, [&](int k, IntT) { ++counts[k]; });
+    }
+  });
+  int64_t rulebook_len = 0;
+  for (int k = 0; k < kernel_size; k++) {
+    for (int64_t c = 0; c < num_chunks; c++) {
+      int64_t count = chunk_offsets[c * kernel_size + k];
+      chunk_offsets[c * kernel_size + k] = rulebook_len;
+      counter_ptr[k] += count;
+      rulebook_len += count;
+    }
+  }
+
   // alloc the rulebook
   *rulebook = phi::Empty(
       dev_ctx,
@@ -132,9 +247,22 @@ void ProductRuleBook(const Context& dev_ctx,
                       {3, rulebook_len},
                       DataLayout::NCHW));
   IntT* rulebook_ptr = rulebook->data<IntT>();
-  f_calc_rulebook(rulebook_ptr);
+  for_each_chunk([&](int64_t c, int64_t begin, int64_t end) {
+    int64_t* next = &chunk_offsets[c * kernel_size];
+    for (int64_t i = begin; i < end; i++) {
+      for_each_rule(i, [&](int k, IntT out_index) {
+        int64_t rulebook_index = next[k]++;
+        rulebook_ptr[rulebook_index] = k;
+        rulebook_ptr[rulebook_index + rulebook_len] = i;  // in_i
+        rulebook_ptr[rulebook_index + rulebook_len * 2] = out_index;
+      });
+    }
+  });
 }
 
+// Replace the out indices of the rulebook by the positions of the points
+// in the out tensor, whose indices are the sorted unique ones of the
+// rulebook.
 template <typename T, typename Context, typename IntT = int>
 void UpdateRulebookAndOutIndex(const Context& dev_ctx,
                                const SparseCooTensor& x,
@@ -143,14 +271,19 @@ void UpdateRulebookAndOutIndex(const Context& dev_ctx,
                                const DDim& out_dims,
                                DenseTensor* rulebook,
                                SparseCooTensor* out) {
-  std::set<IntT> out_indexs;
-  int n = rulebook->dims()[1];
-  IntT* rulebook_ptr = rulebook->data<IntT>();
-  for (int i = 0; i < n; i++) {
-    out_indexs.insert(rulebook_ptr[i + n * 2]);
-  }
+  const int64_t n = rulebook->dims()[1];
+  IntT* out_index_ptr = rulebook->data<IntT>() + n * 2;
+  PointTable<IntT> hash_out(n);
+  dev_ctx.ParallelFor(
+      n, CPUContext::kDefaultGrainSize, [&](int64_t begin, int64_t end) {
+        for (int64_t i = begin; i < end; i++) {
+          hash_out.Insert(out_index_ptr[i]);
+        }
+      });
+  std::vector<IntT> out_indexs = hash_out.Keys();
+  std::sort(out_indexs.begin(), out_indexs.end());
 
-  int out_non_zero_num = out_indexs.size();
+  const int64_t out_non_zero_num = out_indexs.size();
   const int64_t sparse_dim = 4;
   DenseTensorMeta indices_meta(
       paddle::experimental::CppTypeToDataType<IntT>::Type(),
@@ -162,43 +295,241 @@ void UpdateRulebookAndOutIndex(const Context& dev_ctx,
   phi::DenseTensor out_indices = phi::Empty(dev_ctx, std::move(indices_meta));
   phi::DenseTensor out_values = phi::Empty(dev_ctx, std::move(values_meta));
   IntT* out_indices_ptr = out_indices.data<IntT>();
-  int i = 0;
-  for (auto it = out_indexs.begin(); it != out_indexs.end(); it++, i++) {
-    const IntT index = *it;
-    IntT batch, x, y, z;
-    phi::funcs::sparse::IndexToPoint<DDim>(index, out_dims, &batch, &x, &y, &z);
-    out_indices_ptr[i] = batch;
-    out_indices_ptr[i + out_non_zero_num] = z;
-    out_indices_ptr[i + out_non_zero_num * 2] = y;
-    out_indices_ptr[i + out_non_zero_num * 3] = x;
-  }
-  for (i = 0; i < n; i++) {
-    IntT out_index = rulebook_ptr[i + n * 2];
-    rulebook_ptr[i + n * 2] =
-        std::distance(out_indexs.begin(), out_indexs.find(out_index));
-  }
+  dev_ctx.ParallelFor(
+      out_non_zero_num,
+      CPUContext::kDefaultGrainSize,
+      [&](int64_t begin, int64_t end) {
+        for (int64_t i = begin; i < end; i++) {
+          const IntT index = out_indexs[i];
+          IntT batch, x, y, z;
+          phi::funcs::sparse::IndexToPoint<DDim>(
+              index, out_dims, &batch, &x, &y, &z);
+          out_indices_ptr[i] = batch;
+          out_indices_ptr[i + out_non_zero_num] = z;
+          out_indices_ptr[i + out_non_zero_num * 2] = y;
+          out_indices_ptr[i + out_non_zero_num * 3] = x;
+          hash_out.value(hash_out.Find(index)) = i;
+        }
+      });
+  dev_ctx.ParallelFor(
+      n, CPUContext::kDefaultGrainSize, [&](int64_t begin, int64_t end) {
+        for (int64_t i = begin; i < end; i++) {
+          out_index_ptr[i] = hash_out.value(hash_out.Find(out_index_ptr[i]));
+        }
+      });
 
   out->SetMember(out_indices, out_values, out_dims, true);
 }
 
-template <typename T, typename IntT = int>
-void Gather(
-    const T* x, const IntT* indexs, const int n, const int channels, T* out) {
-  for (int i = 0; i < n; i++) {
-    IntT real_i = indexs[i];
-    memcpy(out + i * channels, x + real_i * channels, channels * sizeof(T));
+// The rulebooks and out indices of the recent convolutions and poolings,
+// reused by the layers which see the same indices through the same window,
+// like the stacked submanifold convolutions of a point cloud backbone. The
+// indices are matched by their content, first by a hash and then byte by
+// byte, and the entries hold their own copies of the indices, so that they
+// neither see the changes of the tensors of the callers nor keep them alive.
+template <typename IntT>
+class RulebookCache {
+ public:
+  struct Entry {
+    // The dims of x and out, the window and whether it is submanifold.
+    std::vector<int64_t> signature;
+    uint64_t indices_hash;
+    DenseTensor indices;
+    DenseTensor rulebook;
+    std::vector<int> counter;
+    DenseTensor out_indices;
+  };
+
+  static RulebookCache* Instance() {
+    static RulebookCache cache;
+    return &cache;
   }
-}
 
-template <typename T, typename IntT = int>
-void Scatter(
-    const T* x, const IntT* indexs, const int n, const int channels, T* out) {
-  for (int i = 0; i < n; i++) {
-    IntT real_i = indexs[i];
-    for (int j = 0; j < channels; j++) {
-      out[real_i * channels + j] += x[i * channels + j];
+  // The FNV-1a hash of the values of indices.
+  static uint64_t Hash(const DenseTensor& indices) {
+    const IntT* data = indices.data<IntT>();
+    uint64_t hash = 14695981039346656037ULL;
+    for (int64_t i = 0; i < indices.numel(); i++) {
+      hash = (hash ^ static_cast<uint64_t>(data[i])) * 1099511628211ULL;
+    }
+    return hash;
+  }
+
+  bool Find(const std::vector<int64_t>& signature,
+            const DenseTensor& indices,
+            uint64_t indices_hash,
+            Entry* entry) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (auto it = entries_.begin(); it != entries_.end(); ++it) {
+      if (it->signature == signature && it->indices_hash == indices_hash &&
+          SameIndices(it->indices, indices)) {
+        entries_.splice(entries_.begin(), entries_, it);
+        *entry = entries_.front();
+        return true;
+      }
     }
+    return false;
+  }
+
+  void Insert(Entry&& entry) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    entries_.push_front(std::move(entry));
+    if (entries_.size() > kCapacity) {
+      entries_.pop_back();
+    }
+  }
+
+ private:
+  static constexpr size_t kCapacity = 8;
+
+  static bool SameIndices(const DenseTensor& a, const DenseTensor& b) {
+    return a.dims() == b.dims() &&
+           memcmp(a.data<IntT>(), b.data<IntT>(), a.numel() * sizeof(IntT)) ==
+               0;
   }
+
+  std::mutex mutex_;
+  std::list<Entry> entries_;
+};
+
+template <typename IntT, typename Context>
+DenseTensor CopyIndices(const Context& dev_ctx, const DenseTensor& indices) {
+  DenseTensor copy = phi::EmptyLike<IntT>(dev_ctx, indices);
+  memcpy(copy.data<IntT>(),
+         indices.data<IntT>(),
+         indices.numel() * sizeof(IntT));
+  return copy;
+}
+
+// ProductRuleBook and UpdateRulebookAndOutIndex, or the rulebook and out
+// indices of a recent call on the same indices with the same window.
+template <typename T, typename Context, typename IntT = int>
+void ProductRuleBookWithCache(const Context& dev_ctx,
+                              const SparseCooTensor& x,
+                              const std::vector<int>& kernel_sizes,
+                              const std::vector<int>& paddings,
+                              const std::vector<int>& dilations,
+                              const std::vector<int>& strides,
+                              const DDim& out_dims,
+                              const bool subm,
+                              const int out_channels,
+                              DenseTensor* rulebook,
+                              DenseTensor* counter_per_kernel,
+                              SparseCooTensor* out) {
+  const int kernel_size = kernel_sizes[0] * kernel_sizes[1] * kernel_sizes[2];
+  if (!FLAGS_sparse_conv_rulebook_cache) {
+    ProductRuleBook<T, Context, IntT>(dev_ctx,
+                                      x,
+                                      kernel_sizes,
+                                      paddings,
+                                      dilations,
+                                      strides,
+                                      out_dims,
+                                      subm,
+                                      rulebook,
+                                      counter_per_kernel);
+    UpdateRulebookAndOutIndex<T, Context, IntT>(
+        dev_ctx, x, kernel_size, out_channels, out_dims, rulebook, out);
+    return;
+  }
+
+  std::vector<int64_t> signature;
+  for (int i = 0; i < 4; i++) {
+    signature.push_back(x.dims()[i]);
+    signature.push_back(out_dims[i]);
+  }
+  for (int i = 0; i < 3; i++) {
+    signature.push_back(kernel_sizes[i]);
+    signature.push_back(paddings[i]);
+    signature.push_back(dilations[i]);
+    signature.push_back(strides[i]);
+  }
+  signature.push_back(subm);
+
+  auto* cache = RulebookCache<IntT>::Instance();
+  const DenseTensor& x_indices = x.non_zero_indices();
+  uint64_t indices_hash = RulebookCache<IntT>::Hash(x_indices);
+  typename RulebookCache<IntT>::Entry entry;
+  if (cache->Find(signature, x_indices, indices_hash, &entry)) {
+    // The kernels only read the rulebook, which is shared, while every
+    // output gets its own copy of the out indices.
+    *rulebook = entry.rulebook;
+    memcpy(counter_per_kernel->data<int>(),
+           entry.counter.data(),
+           kernel_size * sizeof(int));
+    DenseTensorMeta values_meta(
+        x.dtype(),
+        {entry.out_indices.dims()[1], static_cast<int64_t>(out_channels)},
+        x.non_zero_elements().layout());
+    out->SetMember(CopyIndices<IntT>(dev_ctx, entry.out_indices),
+                   phi::Empty(dev_ctx, std::move(values_meta)),
+                   out_dims,
+                   true);
+    return;
+  }
+
+  ProductRuleBook<T, Context, IntT>(dev_ctx,
+                                    x,
+                                    kernel_sizes,
+                                    paddings,
+                                    dilations,
+                                    strides,
+                                    out_dims,
+                                    subm,
+                                    rulebook,
+                                    counter_per_kernel);
+  UpdateRulebookAndOutIndex<T, Context, IntT>(
+      dev_ctx, x, kernel_size, out_channels, out_dims, rulebook, out);
+
+  const int* counter_ptr = counter_per_kernel->data<int>();
+  entry.signature = std::move(signature);
+  entry.indices_hash = indices_hash;
+  entry.indices = CopyIndices<IntT>(dev_ctx, x_indices);
+  entry.rulebook = *rulebook;
+  entry.counter.assign(counter_ptr, counter_ptr + kernel_size);
+  entry.out_indices = CopyIndices<IntT>(dev_ctx, out->non_zero_indices());
+  cache->Insert(std::move(entry));
+}
+
+template <typename T, typename IntT = int>
+void Gather(const CPUContext& dev_ctx,
+            const T* x,
+            const IntT* indexs,
+            const int n,
+            const int channels,
+            T* out) {
+  dev_ctx.ParallelFor(
+      n,
+      std::max<int64_t>(1, CPUContext::kDefaultGrainSize / channels),
+      [&](int64_t begin, int64_t end) {
+        for (int64_t i = begin; i < end; i++) {
+          IntT real_i = indexs[i];
+          memcpy(
+              out + i * channels, x + real_i * channels, channels * sizeof(T));
+        }
+      });
+}
+
+// The indexs must be distinct, like the inputs or the outputs of the rules
+// of one kernel offset, for the rows are added in parallel.
+template <typename T, typename IntT = int>
+void Scatter(const CPUContext& dev_ctx,
+             const T* x,
+             const IntT* indexs,
+             const int n,
+             const int channels,
+             T* out) {
+  dev_ctx.ParallelFor(
+      n,
+      std::max<int64_t>(1, CPUContext::kDefaultGrainSize / channels),
+      [&](int64_t begin, int64_t end) {
+        for (int64_t i = begin; i < end; i++) {
+          IntT real_i = indexs[i];
+          for (int j = 0; j < channels; j++) {
+            out[real_i * channels + j] += x[i * channels + j];
+          }
+        }
+      });
 }
 
 }  // namespace sparse
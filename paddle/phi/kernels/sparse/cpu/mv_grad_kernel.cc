@@ -14,32 +14,123 @@ limitations under the License. */
 
 #include "paddle/phi/kernels/sparse/mv_grad_kernel.h"
 
+#include <algorithm>
+
 #include "paddle/phi/backends/cpu/cpu_context.h"
 #include "paddle/phi/core/kernel_registry.h"
+#include "paddle/phi/core/visit_type.h"
+#include "paddle/phi/kernels/funcs/sparse/sparse_blas.h"
+#include "paddle/phi/kernels/sparse/empty_kernel.h"
 
 namespace phi {
 namespace sparse {
 
+template <typename T, typename IntT>
+void MvCooGradCPUKernel(const CPUContext &dev_ctx,
+                        const T *dout,
+                        const T *vec,
+                        const IntT *dx_indices,
+                        T *dx_values,
+                        int64_t nnz) {
+  dev_ctx.ParallelFor(
+      nnz, CPUContext::kDefaultGrainSize, [&](int64_t begin, int64_t end) {
+        for (int64_t idx = begin; idx < end; ++idx) {
+          IntT i = dx_indices[idx];
+          IntT j = dx_indices[idx + nnz];
+          dx_values[idx] = dout[i] * vec[j];
+        }
+      });
+}
+
+template <typename T, typename IntT>
+void MvCsrGradCPUKernel(const CPUContext &dev_ctx,
+                        const T *dout,
+                        const T *vec,
+                        const IntT *dx_crows,
+                        const IntT *dx_cols,
+                        T *dx_values,
+                        int64_t row_number) {
+  int64_t nnz = dx_crows[row_number];
+  // About kDefaultGrainSize nonzeros in each block of rows.
+  int64_t grain_size = std::max<int64_t>(
+      1,
+      CPUContext::kDefaultGrainSize * row_number / std::max<int64_t>(nnz, 1));
+  dev_ctx.ParallelFor(row_number, grain_size, [&](int64_t begin, int64_t end) {
+    for (int64_t i = begin; i < end; ++i) {
+      for (IntT k = dx_crows[i]; k < dx_crows[i + 1]; ++k) {
+        dx_values[k] = dout[i] * vec[dx_cols[k]];
+      }
+    }
+  });
+}
+
 template <typename T, typename Context>
-void MvCooGradKernel(const Context& dev_ctx,
-                     const SparseCooTensor& x,
-                     const DenseTensor& vec,
-                     const DenseTensor& dout,
-                     SparseCooTensor* dx,
-                     DenseTensor* dvec) {
-  PADDLE_THROW(phi::errors::Unimplemented(
-      "Not support CPU backward kernel of 'sparse.mv' now."));
+void MvCooGradKernel(const Context &dev_ctx,
+                     const SparseCooTensor &x,
+                     const DenseTensor &vec,
+                     const DenseTensor &dout,
+                     SparseCooTensor *dx,
+                     DenseTensor *dvec) {
+  // dx{SparseCoo} = dout{Dense} * vec'{Dense}
+  if (dx) {
+    // InferMeta of SparseCooTensor 'dx', CreateLikeInferMeta
+    EmptyLikeCooKernel<T, Context>(dev_ctx, x, dx);
+    PD_VISIT_INTEGRAL_TYPES(
+        dx->non_zero_indices().dtype(), "MvCooGradKernel", ([&] {
+          MvCooGradCPUKernel<T>(dev_ctx,
+                                dout.data<T>(),
+                                vec.data<T>(),
+                                dx->non_zero_indices().data<data_t>(),
+                                dx->mutable_non_zero_elements()->data<T>(),
+                                dx->nnz());
+        }));
+  }
+
+  // dvec{Dense} = x'{SparseCoo} * dout{Dense}
+  if (dvec) {
+    // InferMeta of DenseTensor 'dvec'
+    dvec->Resize(vec.dims());
+    dev_ctx.template Alloc<T>(dvec);
+
+    auto sparse_blas = phi::funcs::sparse::GetSparseBlas<Context, T>(dev_ctx);
+    sparse_blas.SPMV(true, static_cast<T>(1), x, dout, static_cast<T>(0), dvec);
+  }
 }
 
 template <typename T, typename Context>
-void MvCsrGradKernel(const Context& dev_ctx,
-                     const SparseCsrTensor& x,
-                     const DenseTensor& vec,
-                     const DenseTensor& dout,
-                     SparseCsrTensor* dx,
-                     DenseTensor* dvec) {
-  PADDLE_THROW(phi::errors::Unimplemented(
-      "Not support CPU backward kernel of 'sparse.mv' now."));
+void MvCsrGradKernel(const Context &dev_ctx,
+                     const SparseCsrTensor &x,
+                     const DenseTensor &vec,
+                     const DenseTensor &dout,
+                     SparseCsrTensor *dx,
+                     DenseTensor *dvec) {
+  // dx{SparseCsr} = dout{Dense} * vec'{Dense}
+  if (dx) {
+    // InferMeta of SparseCsrTensor 'dx', CreateLikeInferMeta
+    EmptyLikeCsrKernel<T, Context>(dev_ctx, x, dx);
+
+    int64_t row_number = dx->dims()[0];
+    PD_VISIT_INTEGRAL_TYPES(
+        dx->non_zero_crows().dtype(), "MvCsrGradKernel", ([&] {
+          MvCsrGradCPUKernel<T>(dev_ctx,
+                                dout.data<T>(),
+                                vec.data<T>(),
+                                dx->non_zero_crows().data<data_t>(),
+                                dx->non_zero_cols().data<data_t>(),
+                                dx->mutable_non_zero_elements()->data<T>(),
+                                row_number);
+        }));
+  }
+
+  // dvec{Dense} = x'{SparseCsr} * dout{Dense}
+  if (dvec) {
+    // InferMeta of DenseTensor 'dvec'
+    dvec->Resize(vec.dims());
+    dev_ctx.template Alloc<T>(dvec);
+
+    auto sparse_blas = phi::funcs::sparse::GetSparseBlas<Context, T>(dev_ctx);
+    sparse_blas.SPMV(true, static_cast<T>(1), x, dout, static_cast<T>(0), dvec);
+  }
 }
 
 }  // namespace sparse
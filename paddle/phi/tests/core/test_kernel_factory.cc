@@ -48,6 +48,19 @@ TEST(KernelFactory, SelectedKernelMap) {
   }
 }
 
+TEST(KernelSelectCache, Select) {
+  phi::KernelKey key(
+      phi::Backend::CPU, phi::DataLayout::NCHW, phi::DataType::FLOAT32);
+  phi::KernelSelectCache cache("scale");
+  const auto& kernel = cache.Select(key);
+  const auto& selected =
+      phi::KernelFactory::Instance().SelectKernelOrThrowError("scale", key);
+  EXPECT_EQ(kernel.GetVariadicKernelFn<void*>(),
+            selected.GetVariadicKernelFn<void*>());
+  // Selected again from the cache
+  EXPECT_EQ(&cache.Select(key), &kernel);
+}
+
 template <typename T, typename Context>
 void TestKernel(const Context& dev_ctx,
                 const DenseTensor& x,
@@ -0,0 +1,41 @@
+/* Copyright (c) 2022 PaddlePaddle Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License. */
+
+#pragma once
+
+#include <memory>
+
+#include "paddle/fluid/memory/allocation/allocator_facade.h"
+#include "paddle/phi/backends/cpu/cpu_context.h"
+
+namespace phi {
+namespace tests {
+
+// The intra op threads the CPU kernels are checked with: serial, and split
+// over a few threads.
+constexpr int kTestIntraOpNumThreads[] = {1, 4};
+
+// A CPU context on the allocator of the facade, running the kernels that
+// split their work over num_threads threads.
+inline std::unique_ptr<phi::CPUContext> CreateContext(int num_threads) {
+  auto dev_ctx = std::make_unique<phi::CPUContext>();
+  dev_ctx->SetAllocator(paddle::memory::allocation::AllocatorFacade::Instance()
+                            .GetAllocator(paddle::platform::CPUPlace())
+                            .get());
+  dev_ctx->SetIntraOpNumThreads(num_threads);
+  return dev_ctx;
+}
+
+}  // namespace tests
+}  // namespace phi
@@ -0,0 +1,180 @@
+/* Copyright (c) 2022 PaddlePaddle Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License. */
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+#include "paddle/phi/backends/cpu/cpu_context.h"
+#include "paddle/phi/kernels/funcs/cpu_conv.h"
+
+namespace phi {
+namespace tests {
+
+using phi::funcs::CpuConv2dShape;
+using phi::funcs::CpuConvAlgo;
+
+template <typename T>
+void NaiveConv2d(const CpuConv2dShape& s, const T* x, const T* w, T* y) {
+  const int in_step = s.in_channels / s.groups;
+  const int out_step = s.out_channels / s.groups;
+  for (int n = 0; n < s.batch_size; ++n) {
+    for (int o = 0; o < s.out_channels; ++o) {
+      for (int oh = 0; oh < s.out_h; ++oh) {
+        for (int ow = 0; ow < s.out_w; ++ow) {
+          double sum = 0;
+          for (int c = 0; c < in_step; ++c) {
+            const int ic = o / out_step * in_step + c;
+            for (int kh = 0; kh < s.kernel_h; ++kh) {
+              for (int kw = 0; kw < s.kernel_w; ++kw) {
+                int ih = oh * s.stride_h - s.pad_top + kh * s.dilation_h;
+                int iw = ow * s.stride_w - s.pad_left + kw * s.dilation_w;
+                if (ih < 0 || ih >= s.in_h || iw < 0 || iw >= s.in_w) {
+                  continue;
+                }
+                int64_t x_index =
+                    s.channel_last
+                        ? ((n * s.in_h + ih) * s.in_w + iw) * s.in_channels +
+                              ic
+                        : ((n * s.in_channels + ic) * s.in_h + ih) * s.in_w +
+                              iw;
+                sum += x[x_index] *
+                       w[((o * in_step + c) * s.kernel_h + kh) * s.kernel_w +
+                         kw];
+              }
+            }
+          }
+          int64_t y_index =
+              s.channel_last
+                  ? ((n * s.out_h + oh) * s.out_w + ow) * s.out_channels + o
+                  : ((n * s.out_channels + o) * s.out_h + oh) * s.out_w + ow;
+          y[y_index] = sum;
+        }
+      }
+    }
+  }
+}
+
+// Checks all the algorithms supporting the conv against NaiveConv2d, in
+// NCHW and NHWC.
+template <typename T>
+void CpuConvTest(int batch_size,
+                 int in_channels,
+                 int in_h,
+                 int in_w,
+                 int out_channels,
+                 int kernel_size,
+                 int stride,
+                 int pad_top,
+                 int pad_bottom,
+                 int pad_left,
+                 int pad_right,
+                 int dilation,
+                 int groups,
+                 int expected_algos) {
+  phi::CPUContext context(paddle::platform::CPUPlace());
+  context.SetIntraOpNumThreads(4);
+  const int extent = dilation * (kernel_size - 1) + 1;
+  for (bool channel_last : {false, true}) {
+    CpuConv2dShape shape{batch_size,
+                         in_channels,
+                         in_h,
+                         in_w,
+                         out_channels,
+                         (in_h + pad_top + pad_bottom - extent) / stride + 1,
+                         (in_w + pad_left + pad_right - extent) / stride + 1,
+                         kernel_size,
+                         kernel_size,
+                         stride,
+                         stride,
+                         pad_top,
+                         pad_left,
+                         dilation,
+                         dilation,
+                         groups,
+                         channel_last};
+    std::vector<T> x(batch_size * in_channels * in_h * in_w);
+    std::vector<T> w(out_channels * in_channels / groups * kernel_size *
+                     kernel_size);
+    std::vector<T> ref(batch_size * out_channels * shape.out_h * shape.out_w);
+    for (size_t i = 0; i < x.size(); ++i) x[i] = (i * 7 % 19) * 0.1 - 0.9;
+    for (size_t i = 0; i < w.size(); ++i) w[i] = (i * 5 % 11) * 0.1 - 0.5;
+    NaiveConv2d(shape, x.data(), w.data(), ref.data());
+
+    int num_algos = 0;
+    for (int i = 1; i < static_cast<int>(CpuConvAlgo::kCount); ++i) {
+      auto algo = static_cast<CpuConvAlgo>(i);
+      if (!phi::funcs::CpuConvSupports(algo, shape)) continue;
+      ++num_algos;
+      std::vector<T> y(ref.size());
+      phi::funcs::CpuConv2d<T>(
+          context, algo, shape, x.data(), w.data(), y.data());
+      for (size_t j = 0; j < y.size(); ++j) {
+        // Winograd F(4x4, 3x3) loses a few bits of float.
+        ASSERT_NEAR(ref[j], y[j], 1e-4 * std::max<T>(1, std::abs(ref[j])))
+            << "at " << j << " of " << phi::funcs::CpuConvAlgoName(algo)
+            << (channel_last ? " NHWC" : " NCHW");
+      }
+    }
+    EXPECT_EQ(num_algos, expected_algos);
+  }
+}
+
+TEST(cpu_conv, gemm_1x1) {
+  CpuConvTest<float>(2, 3, 5, 7, 4, 1, 1, 0, 0, 0, 0, 1, 1, 1);
+  CpuConvTest<float>(2, 6, 5, 7, 4, 1, 1, 0, 0, 0, 0, 1, 2, 1);
+  CpuConvTest<double>(1, 16, 4, 4, 8, 1, 1, 0, 0, 0, 0, 1, 1, 1);
+  // Not supported with a stride.
+  CpuConvTest<float>(2, 3, 5, 7, 4, 1, 2, 0, 0, 0, 0, 1, 1, 0);
+}
+
+TEST(cpu_conv, winograd) {
+  CpuConvTest<double>(1, 8, 9, 11, 5, 3, 1, 1, 1, 1, 1, 1, 1, 2);
+  CpuConvTest<float>(2, 8, 9, 11, 5, 3, 1, 1, 1, 1, 1, 1, 1, 2);
+  // Asymmetric paddings and partial tiles.
+  CpuConvTest<float>(2, 17, 13, 10, 19, 3, 1, 0, 2, 1, 0, 1, 1, 2);
+  // More channels and tiles than a block.
+  CpuConvTest<float>(3, 200, 3, 3, 300, 3, 1, 1, 1, 1, 1, 1, 1, 2);
+  CpuConvTest<float>(1, 32, 30, 31, 40, 3, 1, 1, 1, 1, 1, 1, 1, 2);
+  // Not supported with groups or a dilation.
+  CpuConvTest<float>(1, 8, 9, 11, 4, 3, 1, 1, 1, 1, 1, 1, 2, 0);
+  CpuConvTest<float>(1, 8, 9, 11, 4, 3, 1, 2, 2, 2, 2, 2, 1, 0);
+}
+
+TEST(cpu_conv, depthwise) {
+  CpuConvTest<float>(2, 8, 9, 11, 8, 3, 2, 1, 1, 1, 1, 1, 8, 1);
+  CpuConvTest<float>(2, 5, 9, 11, 5, 5, 1, 2, 2, 2, 2, 2, 5, 1);
+  CpuConvTest<float>(2, 5, 9, 11, 5, 3, 3, 0, 1, 2, 0, 1, 5, 1);
+  CpuConvTest<double>(1, 4, 2, 2, 4, 3, 1, 1, 1, 1, 1, 1, 4, 1);
+}
+
+TEST(cpu_conv, select) {
+  CpuConv2dShape shape{1, 64, 56, 56, 64, 56, 56, 3, 3, 1, 1, 1, 1, 1, 1, 1};
+  shape.channel_last = true;
+  EXPECT_EQ(phi::funcs::SelectCpuConvAlgo(shape), CpuConvAlgo::kIm2ColGemm);
+  shape.out_h = shape.out_w = shape.in_h = shape.in_w = 7;
+  shape.in_channels = shape.out_channels = 512;
+  EXPECT_EQ(phi::funcs::SelectCpuConvAlgo(shape), CpuConvAlgo::kIm2ColGemm);
+  shape.stride_h = shape.stride_w = 2;
+  shape.out_h = shape.out_w = 4;
+  EXPECT_EQ(phi::funcs::SelectCpuConvAlgo(shape), CpuConvAlgo::kIm2ColGemm);
+  shape.groups = shape.in_channels;
+  shape.out_channels = shape.in_channels;
+  EXPECT_EQ(phi::funcs::SelectCpuConvAlgo(shape), CpuConvAlgo::kDepthwise);
+}
+
+}  // namespace tests
+}  // namespace phi
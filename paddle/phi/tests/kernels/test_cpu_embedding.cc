@@ -0,0 +1,199 @@
+/* Copyright (c) 2022 PaddlePaddle Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License. */
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <vector>
+
+#include "paddle/phi/backends/cpu/cpu_context.h"
+#include "paddle/phi/common/float16.h"
+#include "paddle/phi/kernels/funcs/cpu_embedding.h"
+
+namespace phi {
+namespace tests {
+
+using phi::funcs::CpuEmbeddingTable;
+using phi::funcs::EmbeddingPoolType;
+using phi::funcs::EmbeddingRowType;
+
+// A table of height rows in the three row types, with the float values of
+// each.
+struct Tables {
+  Tables(int64_t height, int64_t width) : height(height), width(width) {
+    float32.resize(height * width);
+    float16.resize(height * width);
+    uint8_rows.resize(height * (8 + width));
+    dequantized.resize(height * width);
+    for (int64_t i = 0; i < height * width; ++i) {
+      float32[i] = (i * 37 % 101) / 10.f - 5.f;
+      float16[i] = static_cast<dtype::float16>(float32[i]);
+    }
+    for (int64_t r = 0; r < height; ++r) {
+      float min = -1.f - r * 0.1f;
+      float max = 2.f + r * 0.05f;
+      char* row = uint8_rows.data() + r * (8 + width);
+      std::memcpy(row, &min, sizeof(float));
+      std::memcpy(row + 4, &max, sizeof(float));
+      for (int64_t k = 0; k < width; ++k) {
+        uint8_t q = (r * 31 + k * 7) % 256;
+        row[8 + k] = q;
+        dequantized[r * width + k] = (max - min) / 256 * q + min;
+      }
+    }
+  }
+
+  CpuEmbeddingTable Get(EmbeddingRowType row_type) const {
+    const void* data = row_type == EmbeddingRowType::kFloat32
+                           ? static_cast<const void*>(float32.data())
+                       : row_type == EmbeddingRowType::kFloat16
+                           ? static_cast<const void*>(float16.data())
+                           : static_cast<const void*>(uint8_rows.data());
+    return CpuEmbeddingTable(row_type, data, height, width);
+  }
+
+  float Value(EmbeddingRowType row_type, int64_t id, int64_t k) const {
+    switch (row_type) {
+      case EmbeddingRowType::kFloat32:
+        return float32[id * width + k];
+      case EmbeddingRowType::kFloat16:
+        return static_cast<float>(float16[id * width + k]);
+      default:
+        return dequantized[id * width + k];
+    }
+  }
+
+  int64_t height;
+  int64_t width;
+  std::vector<float> float32;
+  std::vector<dtype::float16> float16;
+  std::vector<char> uint8_rows;
+  std::vector<float> dequantized;
+};
+
+const EmbeddingRowType kRowTypes[] = {EmbeddingRowType::kFloat32,
+                                      EmbeddingRowType::kFloat16,
+                                      EmbeddingRowType::kUInt8MinMax};
+
+TEST(cpu_embedding, lookup) {
+  paddle::platform::CPUPlace place;
+  phi::CPUContext context(place);
+  const int64_t height = 50;
+  const int64_t padding_idx = 3;
+  std::vector<int64_t> ids(301);
+  for (size_t i = 0; i < ids.size(); ++i) ids[i] = i * 17 % height;
+  for (int num_threads : {1, 4}) {
+    context.SetIntraOpNumThreads(num_threads);
+    // Widths below, at and above the vector length.
+    for (int64_t width : {1, 8, 20, 100}) {
+      Tables tables(height, width);
+      std::vector<float> out(ids.size() * width);
+      funcs::CpuEmbeddingLookup<float, int64_t>(context,
+                                                tables.float32.data(),
+                                                height,
+                                                width,
+                                                ids.data(),
+                                                ids.size(),
+                                                padding_idx,
+                                                out.data());
+      for (size_t i = 0; i < ids.size(); ++i) {
+        for (int64_t k = 0; k < width; ++k) {
+          float expected = ids[i] == padding_idx
+                               ? 0.f
+                               : tables.float32[ids[i] * width + k];
+          ASSERT_EQ(out[i * width + k], expected);
+        }
+      }
+      for (auto row_type : kRowTypes) {
+        funcs::CpuEmbeddingLookup<int64_t>(context,
+                                           tables.Get(row_type),
+                                           ids.data(),
+                                           ids.size(),
+                                           -1,
+                                           out.data());
+        for (size_t i = 0; i < ids.size(); ++i) {
+          for (int64_t k = 0; k < width; ++k) {
+            ASSERT_NEAR(out[i * width + k],
+                        tables.Value(row_type, ids[i], k),
+                        1e-5);
+          }
+        }
+      }
+    }
+  }
+
+  Tables tables(height, 4);
+  std::vector<int32_t> bad_ids = {0, static_cast<int32_t>(height)};
+  std::vector<float> out(bad_ids.size() * 4);
+  EXPECT_ANY_THROW(funcs::CpuEmbeddingLookup(context,
+                                             tables.float32.data(),
+                                             height,
+                                             4,
+                                             bad_ids.data(),
+                                             bad_ids.size(),
+                                             -1,
+                                             out.data()));
+}
+
+TEST(cpu_embedding, seq_pool) {
+  paddle::platform::CPUPlace place;
+  phi::CPUContext context(place);
+  context.SetIntraOpNumThreads(4);
+  const int64_t height = 50;
+  const int64_t width = 20;
+  const int64_t idx_width = 2;
+  const int64_t padding_idx = 3;
+  // An empty sequence, and sequences of one and of many ids.
+  const std::vector<size_t> offsets = {0, 3, 3, 40, 41, 150};
+  std::vector<int64_t> ids(offsets.back() * idx_width);
+  for (size_t i = 0; i < ids.size(); ++i) ids[i] = i * 13 % height;
+  Tables tables(height, width);
+  const int64_t num_seqs = offsets.size() - 1;
+  for (auto row_type : kRowTypes) {
+    for (auto pool_type : {EmbeddingPoolType::kSum, EmbeddingPoolType::kMean}) {
+      std::vector<float> out(num_seqs * idx_width * width, 7.f);
+      funcs::CpuEmbeddingSeqPool<int64_t>(context,
+                                          tables.Get(row_type),
+                                          ids.data(),
+                                          offsets,
+                                          idx_width,
+                                          padding_idx,
+                                          pool_type,
+                                          out.data());
+      for (int64_t i = 0; i < num_seqs; ++i) {
+        for (int64_t j = 0; j < idx_width; ++j) {
+          for (int64_t k = 0; k < width; ++k) {
+            double expected = 0;
+            for (size_t l = offsets[i]; l < offsets[i + 1]; ++l) {
+              int64_t id = ids[l * idx_width + j];
+              if (id != padding_idx) expected += tables.Value(row_type, id, k);
+            }
+            if (pool_type == EmbeddingPoolType::kMean &&
+                offsets[i + 1] > offsets[i]) {
+              expected /= offsets[i + 1] - offsets[i];
+            }
+            ASSERT_NEAR(out[(i * idx_width + j) * width + k],
+                        expected,
+                        1e-4 * std::max(1.0, std::abs(expected)));
+          }
+        }
+      }
+    }
+  }
+}
+
+}  // namespace tests
+}  // namespace phi
@@ -0,0 +1,276 @@
+/* Copyright (c) 2022 PaddlePaddle Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License. */
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <vector>
+
+#include "paddle/phi/backends/cpu/cpu_context.h"
+#include "paddle/phi/kernels/funcs/blas/blas.h"
+#include "paddle/phi/kernels/funcs/blas/cpu_gemm.h"
+
+namespace phi {
+namespace tests {
+
+template <typename T>
+void CpuGemmTest(const phi::CPUContext& context,
+                 bool trans_a,
+                 bool trans_b,
+                 int m,
+                 int n,
+                 int k,
+                 T alpha,
+                 T beta) {
+  int lda = trans_a ? m : k;
+  int ldb = trans_b ? k : n;
+  // The padding columns of C must not be written.
+  int ldc = n + 3;
+  std::vector<T> a(m * k);
+  std::vector<T> b(k * n);
+  std::vector<T> c(m * ldc);
+  for (size_t i = 0; i < a.size(); ++i) a[i] = (i % 13) * 0.1 - 0.5;
+  for (size_t i = 0; i < b.size(); ++i) b[i] = (i % 7) * 0.3 - 1;
+  for (size_t i = 0; i < c.size(); ++i) c[i] = i % 5;
+  std::vector<T> packed_c(c);
+
+  std::vector<T> ref(c);
+  for (int i = 0; i < m; ++i) {
+    for (int j = 0; j < n; ++j) {
+      double sum = 0;
+      for (int l = 0; l < k; ++l) {
+        double av = trans_a ? a[l * lda + i] : a[i * lda + l];
+        double bv = trans_b ? b[j * ldb + l] : b[l * ldb + j];
+        sum += av * bv;
+      }
+      ref[i * ldc + j] = alpha * sum + beta * ref[i * ldc + j];
+    }
+  }
+  phi::funcs::CpuGemm<T>(context,
+                         trans_a,
+                         trans_b,
+                         m,
+                         n,
+                         k,
+                         alpha,
+                         a.data(),
+                         lda,
+                         b.data(),
+                         ldb,
+                         beta,
+                         c.data(),
+                         ldc);
+  for (size_t i = 0; i < c.size(); ++i) {
+    ASSERT_NEAR(ref[i], c[i], 1e-4 * std::max<T>(1, std::abs(ref[i])))
+        << "at " << i << " of " << trans_a << trans_b << " " << m << "x" << n
+        << "x" << k;
+  }
+
+  // And with b packed beforehand, like the weights of PackedWeightCache.
+  std::vector<T> packed_b(phi::funcs::CpuGemmPackedBSize<T>(n, k));
+  phi::funcs::CpuGemmPackB<T>(
+      context, trans_b, n, k, b.data(), ldb, packed_b.data());
+  phi::funcs::CpuGemmPackedB<T>(context,
+                                trans_a,
+                                m,
+                                n,
+                                k,
+                                alpha,
+                                a.data(),
+                                lda,
+                                packed_b.data(),
+                                beta,
+                                packed_c.data(),
+                                ldc);
+  for (size_t i = 0; i < c.size(); ++i) {
+    ASSERT_NEAR(ref[i], packed_c[i], 1e-4 * std::max<T>(1, std::abs(ref[i])))
+        << "at " << i << " of the packed " << trans_a << trans_b << " " << m
+        << "x" << n << "x" << k;
+  }
+}
+
+TEST(cpu_gemm, gemm) {
+  paddle::platform::CPUPlace place;
+  phi::CPUContext context(place);
+  LOG(INFO) << "CpuGemm runs on the " << phi::funcs::CpuGemmKernelName<float>()
+            << " kernel.";
+  for (int num_threads : {1, 4}) {
+    context.SetIntraOpNumThreads(num_threads);
+    for (bool trans_a : {false, true}) {
+      for (bool trans_b : {false, true}) {
+        for (int m : {1, 7, 97}) {
+          for (int n : {1, 17, 130}) {
+            for (int k : {0, 5, 300}) {
+              CpuGemmTest<float>(context, trans_a, trans_b, m, n, k, 1.f, 0.f);
+              CpuGemmTest<float>(
+                  context, trans_a, trans_b, m, n, k, 1.5f, 0.5f);
+              CpuGemmTest<double>(context, trans_a, trans_b, m, n, k, 2., 1.);
+            }
+          }
+        }
+      }
+    }
+    // More columns than a block of B.
+    CpuGemmTest<float>(context, false, false, 3, 5000, 20, 1.f, 1.f);
+  }
+}
+
+TEST(cpu_gemm, batched_gemm) {
+  paddle::platform::CPUPlace place;
+  phi::CPUContext context(place);
+  context.SetIntraOpNumThreads(4);
+  const int m = 5;
+  const int n = 9;
+  const int k = 7;
+  for (int batch_count : {1, 8}) {
+    std::vector<float> a(batch_count * m * k);
+    std::vector<float> b(batch_count * k * n);
+    for (size_t i = 0; i < a.size(); ++i) a[i] = (i % 11) * 0.5f;
+    for (size_t i = 0; i < b.size(); ++i) b[i] = (i % 3) - 1.f;
+    std::vector<float> ref(batch_count * m * n);
+    for (int i = 0; i < batch_count; ++i) {
+      phi::funcs::CpuGemm<float>(context,
+                                 false,
+                                 false,
+                                 m,
+                                 n,
+                                 k,
+                                 1.f,
+                                 a.data() + i * m * k,
+                                 k,
+                                 b.data() + i * k * n,
+                                 n,
+                                 0.f,
+                                 ref.data() + i * m * n,
+                                 n);
+    }
+    std::vector<float> out(ref.size());
+    phi::funcs::CpuGemmStridedBatched<float>(context,
+                                             false,
+                                             false,
+                                             m,
+                                             n,
+                                             k,
+                                             1.f,
+                                             a.data(),
+                                             m * k,
+                                             b.data(),
+                                             k * n,
+                                             0.f,
+                                             out.data(),
+                                             m * n,
+                                             batch_count);
+    EXPECT_EQ(ref, out);
+
+    std::vector<const float*> a_array;
+    std::vector<const float*> b_array;
+    std::vector<float*> c_array;
+    std::fill(out.begin(), out.end(), 0.f);
+    for (int i = 0; i < batch_count; ++i) {
+      a_array.push_back(a.data() + i * m * k);
+      b_array.push_back(b.data() + i * k * n);
+      c_array.push_back(out.data() + i * m * n);
+    }
+    phi::funcs::CpuGemmBatched<float>(context,
+                                      false,
+                                      false,
+                                      m,
+                                      n,
+                                      k,
+                                      1.f,
+                                      a_array.data(),
+                                      b_array.data(),
+                                      0.f,
+                                      c_array.data(),
+                                      batch_count);
+    EXPECT_EQ(ref, out);
+  }
+}
+
+// The GFLOPS of CpuGemm and of the CBLAS library of the build, on the shapes
+// of the fc and the 1x1 convolutions of common models.
+TEST(cpu_gemm, gemm_speed) {
+  struct Shape {
+    int m;
+    int n;
+    int k;
+  };
+  const std::vector<Shape> shapes = {
+      {1, 1000, 2048},   // ResNet50 fc, batch 1
+      {32, 1000, 2048},  // ResNet50 fc, batch 32
+      {3136, 64, 256},   // ResNet50 conv2 1x1
+      {784, 512, 128},   // ResNet50 conv3 1x1
+      {128, 768, 768},   // BERT base attention, 128 tokens
+      {128, 3072, 768},  // BERT base ffn
+      {128, 768, 3072},
+      {32, 2048, 512},  // LSTM gates, batch 32
+  };
+  paddle::platform::CPUPlace place;
+  phi::CPUContext context(place);
+  for (const auto& shape : shapes) {
+    std::vector<float> a(shape.m * shape.k, 0.5f);
+    std::vector<float> b(shape.k * shape.n, 0.25f);
+    std::vector<float> c(shape.m * shape.n);
+    double flops = 2.0 * shape.m * shape.n * shape.k;
+    int repeat = std::max(1, static_cast<int>(1e9 / flops));
+    auto gflops = [&](bool builtin) {
+      auto start = std::chrono::steady_clock::now();
+      for (int i = 0; i < repeat; ++i) {
+        if (builtin) {
+          phi::funcs::CpuGemm<float>(context,
+                                     false,
+                                     false,
+                                     shape.m,
+                                     shape.n,
+                                     shape.k,
+                                     1.f,
+                                     a.data(),
+                                     shape.k,
+                                     b.data(),
+                                     shape.n,
+                                     0.f,
+                                     c.data(),
+                                     shape.n);
+        } else {
+          phi::funcs::CBlas<float>::GEMM(CblasRowMajor,
+                                         CblasNoTrans,
+                                         CblasNoTrans,
+                                         shape.m,
+                                         shape.n,
+                                         shape.k,
+                                         1.f,
+                                         a.data(),
+                                         shape.k,
+                                         b.data(),
+                                         shape.n,
+                                         0.f,
+                                         c.data(),
+                                         shape.n);
+        }
+      }
+      std::chrono::duration<double> elapsed =
+          std::chrono::steady_clock::now() - start;
+      return flops * repeat / elapsed.count() * 1e-9;
+    };
+    double builtin = gflops(true);
+    double cblas = gflops(false);
+    LOG(INFO) << shape.m << "x" << shape.n << "x" << shape.k << ": CpuGemm "
+              << builtin << " GFLOPS, CBLAS " << cblas << " GFLOPS";
+  }
+}
+
+}  // namespace tests
+}  // namespace phi
@@ -0,0 +1,109 @@
+/* Copyright (c) 2022 PaddlePaddle Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License. */
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <cstring>
+#include <numeric>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "paddle/phi/backends/cpu/cpu_context.h"
+#include "paddle/phi/kernels/funcs/cpu_transpose.h"
+
+namespace phi {
+namespace tests {
+
+// Compares CpuTranspose with an element by element walk of the output, on
+// the elements of elem_size bytes.
+void CpuTransposeTest(const phi::CPUContext& context,
+                      const std::vector<int64_t>& dims,
+                      const std::vector<int>& axis,
+                      size_t elem_size) {
+  const int rank = dims.size();
+  int64_t numel = 1;
+  for (auto d : dims) numel *= d;
+  std::vector<uint8_t> in(numel * elem_size);
+  std::vector<uint8_t> out(in.size(), 0xcd);
+  std::vector<uint8_t> ref(in.size());
+  for (size_t i = 0; i < in.size(); ++i) in[i] = (i * 131 + 7) & 0xff;
+
+  std::vector<int64_t> strides(rank);
+  int64_t stride = 1;
+  for (int k = rank - 1; k >= 0; --k) {
+    strides[k] = stride;
+    stride *= dims[k];
+  }
+  std::vector<int64_t> index(rank, 0);
+  for (int64_t i = 0; i < numel; ++i) {
+    int64_t offset = 0;
+    for (int k = 0; k < rank; ++k) offset += index[k] * strides[axis[k]];
+    std::memcpy(&ref[i * elem_size], &in[offset * elem_size], elem_size);
+    for (int k = rank - 1; k >= 0; --k) {
+      if (++index[k] < dims[axis[k]]) break;
+      index[k] = 0;
+    }
+  }
+  phi::funcs::CpuTranspose(
+      context, in.data(), out.data(), dims, axis, elem_size);
+  std::string shape;
+  for (int k = 0; k < rank; ++k) {
+    shape += std::to_string(dims[k]) + "/" + std::to_string(axis[k]) + " ";
+  }
+  ASSERT_TRUE(out == ref) << "dims/axis " << shape << "of " << elem_size
+                          << " byte elements";
+}
+
+TEST(cpu_transpose, random_permutations) {
+  paddle::platform::CPUPlace place;
+  phi::CPUContext context(place);
+  std::mt19937 rng(0);
+  for (int num_threads : {1, 4}) {
+    context.SetIntraOpNumThreads(num_threads);
+    for (int i = 0; i < 200; ++i) {
+      int rank = 1 + rng() % 6;
+      std::vector<int64_t> dims(rank);
+      // Unit dims, and dims not multiple of the register tiles.
+      for (auto& d : dims) d = rng() % 4 == 0 ? 1 : 1 + rng() % 24;
+      std::vector<int> axis(rank);
+      std::iota(axis.begin(), axis.end(), 0);
+      std::shuffle(axis.begin(), axis.end(), rng);
+      for (size_t elem_size : {1, 2, 4, 8, 16}) {
+        CpuTransposeTest(context, dims, axis, elem_size);
+      }
+    }
+  }
+}
+
+TEST(cpu_transpose, layouts) {
+  paddle::platform::CPUPlace place;
+  phi::CPUContext context(place);
+  context.SetIntraOpNumThreads(4);
+  // NCHW to NHWC and back.
+  CpuTransposeTest(context, {8, 64, 28, 28}, {0, 2, 3, 1}, 4);
+  CpuTransposeTest(context, {8, 28, 28, 64}, {0, 3, 1, 2}, 4);
+  // NCDHW to NDHWC.
+  CpuTransposeTest(context, {2, 16, 8, 9, 10}, {0, 2, 3, 4, 1}, 2);
+  // The attention heads, which keep the last dim.
+  CpuTransposeTest(context, {4, 128, 12, 64}, {0, 2, 1, 3}, 4);
+  CpuTransposeTest(context, {513, 1031}, {1, 0}, 8);
+  CpuTransposeTest(
+      context, {2, 3, 4, 5, 2, 3, 2, 2, 2}, {8, 1, 6, 3, 4, 5, 2, 7, 0}, 4);
+  CpuTransposeTest(context, {0, 3}, {1, 0}, 4);
+}
+
+}  // namespace tests
+}  // namespace phi
@@ -0,0 +1,98 @@
+/* Copyright (c) 2022 PaddlePaddle Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License. */
+
+#include "paddle/phi/kernels/funcs/int8_gemm.h"
+
+#include <random>
+#include <vector>
+
+#include "glog/logging.h"
+#include "gtest/gtest.h"
+
+namespace phi {
+namespace tests {
+
+void RefInt8Gemm(int M,
+                 int N,
+                 int K,
+                 const uint8_t* A,
+                 const int8_t* B,
+                 int32_t* C) {
+  for (int i = 0; i < M; ++i) {
+    for (int j = 0; j < N; ++j) {
+      int32_t sum = 0;
+      for (int k = 0; k < K; ++k) {
+        sum += static_cast<int32_t>(A[i * K + k]) * B[k * N + j];
+      }
+      C[i * N + j] = sum;
+    }
+  }
+}
+
+void TestInt8Gemm(const phi::CPUContext& dev_ctx, int M, int N, int K) {
+  std::mt19937 rng(M * 131 + N * 17 + K);
+  std::uniform_int_distribution<int> dist_a(0, 255);
+  std::uniform_int_distribution<int> dist_b(-127, 127);
+  std::vector<uint8_t> a(M * K);
+  std::vector<int8_t> b(K * N);
+  for (auto& v : a) v = static_cast<uint8_t>(dist_a(rng));
+  for (auto& v : b) v = static_cast<int8_t>(dist_b(rng));
+
+  std::vector<int32_t> ref(M * N), out(M * N, -1);
+  RefInt8Gemm(M, N, K, a.data(), b.data(), ref.data());
+  funcs::Int8Gemm(dev_ctx, M, N, K, a.data(), b.data(), out.data());
+  for (int i = 0; i < M * N; ++i) {
+    ASSERT_EQ(ref[i], out[i]) << "M=" << M << " N=" << N << " K=" << K
+                              << " at " << i;
+  }
+}
+
+TEST(Int8Gemm, shapes) {
+  LOG(INFO) << "Int8Gemm uses VNNI: " << funcs::Int8GemmUseVnni()
+            << ", SIMD: " << funcs::Int8GemmUseSimd();
+  phi::CPUContext dev_ctx;
+  // Cover the row and column tails of the blocked kernels and a K that is
+  // not a multiple of 4.
+  for (int M : {1, 3, 4, 7}) {
+    for (int N : {1, 15, 16, 33, 300}) {
+      for (int K : {1, 5, 64, 67}) {
+        TestInt8Gemm(dev_ctx, M, N, K);
+      }
+    }
+  }
+}
+
+TEST(Int8Gemm, parallel) {
+  phi::CPUContext dev_ctx;
+  dev_ctx.SetIntraOpNumThreads(4);
+  // Several tiles of rows and of columns, with their tails.
+  for (int M : {1, 70, 200}) {
+    for (int N : {33, 300}) {
+      TestInt8Gemm(dev_ctx, M, N, 1000);
+    }
+  }
+}
+
+TEST(Int8Gemm, quantize) {
+  std::vector<float> x = {-2.f, -1.f, -0.004f, 0.f, 0.5f, 1.f, 3.f};
+  std::vector<uint8_t> y(x.size());
+  funcs::QuantizeShiftedUint8(x.size(), x.data(), 127.f, y.data());
+  std::vector<int> expected = {1, 1, 127, 128, 192, 255, 255};
+  for (size_t i = 0; i < x.size(); ++i) {
+    EXPECT_EQ(expected[i], static_cast<int>(y[i]));
+  }
+}
+
+}  // namespace tests
+}  // namespace phi
@@ -0,0 +1,122 @@
+/* Copyright (c) 2022 PaddlePaddle Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License. */
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <memory>
+#include <stdexcept>
+#include <vector>
+
+#include "paddle/phi/api/lib/utils/allocator.h"
+#include "paddle/phi/backends/cpu/cpu_context.h"
+#include "paddle/phi/core/dense_tensor.h"
+#include "paddle/phi/core/kernel_registry.h"
+#include "paddle/phi/kernels/cast_kernel.h"
+#include "paddle/phi/kernels/elementwise_add_kernel.h"
+#include "paddle/phi/kernels/expand_kernel.h"
+#include "paddle/phi/kernels/reduce_sum_kernel.h"
+#include "paddle/phi/kernels/transpose_kernel.h"
+#include "paddle/phi/tests/kernels/cpu_context_utils.h"
+
+namespace phi {
+namespace tests {
+
+phi::DenseTensor CreateTensor(const phi::DDim& dims, float start) {
+  static paddle::experimental::DefaultAllocator alloc(
+      paddle::platform::CPUPlace());
+  phi::DenseTensor dense_x(&alloc,
+                           phi::DenseTensorMeta(phi::DataType::FLOAT32,
+                                                dims,
+                                                phi::DataLayout::NCHW));
+  auto* data = dense_x.mutable_data<float>(paddle::platform::CPUPlace());
+  for (int64_t i = 0; i < dense_x.numel(); ++i) {
+    data[i] = start + (i % 97) * 0.5f;
+  }
+  return dense_x;
+}
+
+template <typename T>
+void ExpectEqual(const phi::DenseTensor& expected,
+                 const phi::DenseTensor& actual) {
+  ASSERT_EQ(expected.dims(), actual.dims());
+  for (int64_t i = 0; i < expected.numel(); ++i) {
+    T value = expected.data<T>()[i];
+    // The blocks may sum in another order.
+    ASSERT_NEAR(value,
+                actual.data<T>()[i],
+                1e-5 * std::max<T>(1, std::abs(value)))
+        << "at " << i;
+  }
+}
+
+TEST(DEV_API, parallel_for) {
+  auto dev_ctx = CreateContext(4);
+  ASSERT_EQ(dev_ctx->GetIntraOpNumThreads(), 4);
+  for (int64_t n : {0, 1, 10, 1000, 123457}) {
+    for (int64_t grain_size : {1, 64, 100000}) {
+      std::vector<std::atomic<int>> visits(n);
+      for (auto& v : visits) v = 0;
+      dev_ctx->ParallelFor(n, grain_size, [&](int64_t begin, int64_t end) {
+        EXPECT_TRUE(end - begin >= grain_size || end == n);
+        for (int64_t i = begin; i < end; ++i) ++visits[i];
+      });
+      for (auto& v : visits) ASSERT_EQ(v.load(), 1);
+    }
+  }
+  EXPECT_THROW(dev_ctx->ParallelFor(1000,
+                                    10,
+                                    [](int64_t begin, int64_t end) {
+                                      if (begin > 0) {
+                                        throw std::runtime_error("block");
+                                      }
+                                    }),
+               std::runtime_error);
+}
+
+TEST(DEV_API, parallel_kernels) {
+  auto serial_ctx = CreateContext(1);
+  auto parallel_ctx = CreateContext(4);
+  auto x = CreateTensor(phi::make_ddim({64, 3, 1024}), 1.f);
+  auto same = CreateTensor(phi::make_ddim({64, 3, 1024}), -3.f);
+  auto y = CreateTensor(phi::make_ddim({3, 1024}), 2.f);
+
+  ExpectEqual<float>(phi::Add<float>(*serial_ctx, x, same),
+                     phi::Add<float>(*parallel_ctx, x, same));
+  ExpectEqual<float>(phi::Add<float>(*serial_ctx, x, y),
+                     phi::Add<float>(*parallel_ctx, x, y));
+  ExpectEqual<double>(
+      phi::Cast<float>(*serial_ctx, x, phi::DataType::FLOAT64),
+      phi::Cast<float>(*parallel_ctx, x, phi::DataType::FLOAT64));
+  ExpectEqual<float>(phi::Transpose<float>(*serial_ctx, x, {2, 0, 1}),
+                     phi::Transpose<float>(*parallel_ctx, x, {2, 0, 1}));
+  for (auto axis : std::vector<std::vector<int64_t>>{{0}, {1}, {2}, {0, 2}}) {
+    ExpectEqual<float>(
+        phi::Sum<float>(*serial_ctx, x, axis, phi::DataType::FLOAT32, false),
+        phi::Sum<float>(*parallel_ctx, x, axis, phi::DataType::FLOAT32, false));
+  }
+
+  phi::DenseTensor serial_out;
+  phi::DenseTensor parallel_out;
+  phi::ExpandKernel<float, phi::CPUContext>(
+      *serial_ctx, y, phi::IntArray({32, 3, 1024}), &serial_out);
+  phi::ExpandKernel<float, phi::CPUContext>(
+      *parallel_ctx, y, phi::IntArray({32, 3, 1024}), &parallel_out);
+  ExpectEqual<float>(serial_out, parallel_out);
+}
+
+}  // namespace tests
+}  // namespace phi
@@ -12,8 +12,15 @@
 // See the License for the specific language governing permissions and
 // limitations under the License.
 
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <vector>
+
 #include "gtest/gtest.h"
 #include "paddle/phi/kernels/funcs/blas/blas.h"
+#include "paddle/phi/kernels/funcs/blas/cpu_gemm.h"
+#include "paddle/phi/kernels/funcs/blas/packed_weight_cache.h"
 #include "paddle/phi/kernels/funcs/math_function.h"
 
 namespace phi {
@@ -351,5 +358,115 @@ TEST(math_function, gemm_warp) {
   GemmWarpTest<double>(8, 5, 6, 2.0, 1.0);
 }
 
+template <typename T>
+void PackedGemmTest(
+    bool trans_a, bool trans_b, int m, int n, int k, T alpha, T beta) {
+  paddle::platform::CPUPlace cpu_place;
+  phi::CPUContext context(cpu_place);
+  std::vector<T> a(m * k);
+  std::vector<T> b(k * n);
+  std::vector<T> c(m * n);
+  for (size_t i = 0; i < a.size(); ++i) a[i] = static_cast<T>(i % 13) - 6;
+  for (size_t i = 0; i < b.size(); ++i) b[i] = static_cast<T>(i % 7) - 3;
+  for (size_t i = 0; i < c.size(); ++i) c[i] = static_cast<T>(i % 5);
+  int lda = trans_a ? m : k;
+  int ldb = trans_b ? k : n;
+
+  std::vector<T> ref(c);
+  GetBlas<T>(context).GEMM(trans_a,
+                           trans_b,
+                           m,
+                           n,
+                           k,
+                           alpha,
+                           a.data(),
+                           lda,
+                           b.data(),
+                           ldb,
+                           beta,
+                           ref.data(),
+                           n);
+
+  auto& cache = phi::funcs::PackedWeightCache::Instance();
+  cache.RegisterConstant(b.data(), b.size() * sizeof(T));
+  // The first run packs b and the second one reuses the pack.
+  for (int run = 0; run < 2; ++run) {
+    std::vector<T> out(c);
+    GetBlas<T>(context).GEMM(trans_a,
+                             trans_b,
+                             m,
+                             n,
+                             k,
+                             alpha,
+                             a.data(),
+                             lda,
+                             b.data(),
+                             ldb,
+                             beta,
+                             out.data(),
+                             n);
+    for (int i = 0; i < m * n; ++i) {
+      EXPECT_NEAR(ref[i], out[i], 1e-4 * std::max<T>(1, std::abs(ref[i])));
+    }
+  }
+#ifdef PADDLE_WITH_MKLML
+  EXPECT_EQ(cache.Size(), 1UL);
+#else
+  // Without MKL only the GEMMs of CpuGemm use packed weights.
+  EXPECT_EQ(cache.Size(), phi::funcs::UseCpuGemm<T>() ? 1UL : 0UL);
+#endif
+  cache.UnregisterConstant(b.data());
+  EXPECT_EQ(cache.Size(), 0UL);
+}
+
+TEST(math_function, gemm_packed_weight) {
+  for (bool trans_a : {false, true}) {
+    for (bool trans_b : {false, true}) {
+      PackedGemmTest<float>(trans_a, trans_b, 1, 33, 17, 1.f, 0.f);
+      PackedGemmTest<float>(trans_a, trans_b, 7, 16, 5, 2.f, 1.f);
+      PackedGemmTest<float>(trans_a, trans_b, 32, 100, 64, 0.5f, 0.5f);
+      PackedGemmTest<double>(trans_a, trans_b, 3, 20, 9, 2.0, 1.0);
+    }
+  }
+}
+
+// Compares the GEMMs of a 1024 x 1024 weight with and without the cache.
+TEST(math_function, gemm_packed_weight_speed) {
+  const int n = 1024;
+  const int k = 1024;
+  const int repeat = 20;
+  paddle::platform::CPUPlace cpu_place;
+  phi::CPUContext context(cpu_place);
+  auto blas = GetBlas<float>(context);
+  std::vector<float> w(k * n);
+  for (size_t i = 0; i < w.size(); ++i) w[i] = (i % 11) * 0.01f;
+  auto time = [&](int m, const float* x, float* out) {
+    blas.MatMul(m, n, k, x, w.data(), out);
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < repeat; ++i) {
+      blas.MatMul(m, n, k, x, w.data(), out);
+    }
+    std::chrono::duration<double, std::milli> elapsed =
+        std::chrono::steady_clock::now() - start;
+    return elapsed.count() / repeat;
+  };
+  auto& cache = phi::funcs::PackedWeightCache::Instance();
+  for (int m : {1, 2, 4, 8, 16, 32}) {
+    std::vector<float> x(m * k, 1.f);
+    std::vector<float> out(m * n);
+    std::vector<float> packed_out(m * n);
+    double plain_ms = time(m, x.data(), out.data());
+    cache.RegisterConstant(w.data(), w.size() * sizeof(float));
+    double packed_ms = time(m, x.data(), packed_out.data());
+    cache.UnregisterConstant(w.data());
+    for (int i = 0; i < m * n; ++i) {
+      EXPECT_NEAR(
+          out[i], packed_out[i], 1e-3 * std::max(1.f, std::abs(out[i])));
+    }
+    LOG(INFO) << "batch " << m << ": " << plain_ms << " ms without the packed "
+              << "weight cache, " << packed_ms << " ms with it";
+  }
+}
+
 }  // namespace tests
 }  // namespace phi
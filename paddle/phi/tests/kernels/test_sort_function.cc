@@ -0,0 +1,280 @@
+/* Copyright (c) 2022 PaddlePaddle Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License. */
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <memory>
+#include <numeric>
+#include <random>
+#include <set>
+#include <unordered_map>
+#include <vector>
+
+#include "paddle/phi/backends/cpu/cpu_context.h"
+#include "paddle/phi/core/dense_tensor.h"
+#include "paddle/phi/kernels/funcs/sort_function.h"
+#include "paddle/phi/kernels/funcs/unique_functor.h"
+#include "paddle/phi/tests/kernels/cpu_context_utils.h"
+
+namespace phi {
+namespace tests {
+
+// Few distinct values, so that the rows have many duplicates, with the
+// negative ones, the infinities and NaN for the floating point types.
+template <typename T>
+std::vector<T> RandomValues(int64_t n, bool with_nan, std::mt19937* rng) {
+  std::vector<T> pool = {static_cast<T>(-3),
+                         static_cast<T>(-1),
+                         static_cast<T>(0),
+                         static_cast<T>(2),
+                         static_cast<T>(7),
+                         std::numeric_limits<T>::max(),
+                         std::numeric_limits<T>::lowest()};
+  if (std::is_floating_point<T>::value) {
+    pool.push_back(static_cast<T>(-0.25));
+    pool.push_back(static_cast<T>(0.5));
+    pool.push_back(std::numeric_limits<T>::infinity());
+    pool.push_back(-std::numeric_limits<T>::infinity());
+    if (with_nan) pool.push_back(std::numeric_limits<T>::quiet_NaN());
+  }
+  std::vector<T> values(n);
+  for (auto& v : values) {
+    // Half of them from the pool, the others spread over a wider range.
+    v = (*rng)() % 2 ? pool[(*rng)() % pool.size()]
+                     : static_cast<T>(static_cast<int>((*rng)() % 2001) - 1000);
+  }
+  return values;
+}
+
+template <typename T>
+bool SameValue(T a, T b) {
+  return (std::isnan(static_cast<double>(a)) &&
+          std::isnan(static_cast<double>(b))) ||
+         a == b;
+}
+
+// The order of the kernels before the sort engine, NaN being the largest,
+// with the ties kept in the order of their positions.
+template <typename T>
+std::vector<int64_t> ReferenceOrder(const T* row,
+                                    int64_t width,
+                                    bool descending) {
+  auto less = [](T a, T b) {
+    return !std::isnan(static_cast<double>(a)) &&
+           (std::isnan(static_cast<double>(b)) || a < b);
+  };
+  std::vector<int64_t> order(width);
+  std::iota(order.begin(), order.end(), 0);
+  std::stable_sort(order.begin(), order.end(), [&](int64_t a, int64_t b) {
+    return descending ? less(row[b], row[a]) : less(row[a], row[b]);
+  });
+  return order;
+}
+
+template <typename T>
+void SortRowsTest(const phi::CPUContext& dev_ctx,
+                  int64_t height,
+                  int64_t width,
+                  bool descending,
+                  std::mt19937* rng) {
+  auto in = RandomValues<T>(height * width, true, rng);
+  std::vector<T> out(in.size());
+  std::vector<int64_t> indices(in.size());
+  phi::funcs::SortRows<T>(dev_ctx,
+                          in.data(),
+                          height,
+                          width,
+                          descending,
+                          out.data(),
+                          indices.data());
+  for (int64_t i = 0; i < height; ++i) {
+    const T* row = in.data() + i * width;
+    auto order = ReferenceOrder(row, width, descending);
+    for (int64_t j = 0; j < width; ++j) {
+      ASSERT_EQ(indices[i * width + j], order[j])
+          << "row " << i << " of width " << width << " at " << j;
+      ASSERT_TRUE(SameValue(out[i * width + j], row[order[j]]));
+    }
+  }
+}
+
+TEST(sort_function, sort_rows) {
+  std::mt19937 rng(0);
+  for (int num_threads : kTestIntraOpNumThreads) {
+    auto dev_ctx = CreateContext(num_threads);
+    // The widths below kRadixSortMinWidth are sorted by comparisons, the
+    // others by the radix sort.
+    for (int64_t width : {1, 7, 255, 256, 1000, 4099}) {
+      for (bool descending : {false, true}) {
+        SortRowsTest<float>(*dev_ctx, 5, width, descending, &rng);
+        SortRowsTest<double>(*dev_ctx, 3, width, descending, &rng);
+        SortRowsTest<int64_t>(*dev_ctx, 3, width, descending, &rng);
+        SortRowsTest<int>(*dev_ctx, 2, width, descending, &rng);
+      }
+    }
+  }
+}
+
+template <typename T>
+void TopKRowsTest(const phi::CPUContext& dev_ctx,
+                  int64_t height,
+                  int64_t width,
+                  int64_t k,
+                  bool largest,
+                  std::mt19937* rng) {
+  auto in = RandomValues<T>(height * width, true, rng);
+  std::vector<T> out(height * k);
+  std::vector<int64_t> indices(height * k);
+  phi::funcs::TopKRows<T>(dev_ctx,
+                          in.data(),
+                          height,
+                          width,
+                          k,
+                          largest,
+                          out.data(),
+                          indices.data());
+  for (int64_t i = 0; i < height; ++i) {
+    const T* row = in.data() + i * width;
+    auto order = ReferenceOrder(row, width, largest);
+    for (int64_t j = 0; j < k; ++j) {
+      ASSERT_EQ(indices[i * k + j], order[j])
+          << "row " << i << " of width " << width << ", k " << k;
+      ASSERT_TRUE(SameValue(out[i * k + j], row[order[j]]));
+    }
+  }
+}
+
+TEST(sort_function, top_k_rows) {
+  std::mt19937 rng(1);
+  for (int num_threads : kTestIntraOpNumThreads) {
+    auto dev_ctx = CreateContext(num_threads);
+    for (bool largest : {true, false}) {
+      // Partial sort.
+      TopKRowsTest<float>(*dev_ctx, 6, 300, 20, largest, &rng);
+      // A heap per row.
+      TopKRowsTest<float>(*dev_ctx, 6, 3000, 5, largest, &rng);
+      TopKRowsTest<int64_t>(*dev_ctx, 6, 3000, 5, largest, &rng);
+      // Single long rows split over the threads, with the heaps merged.
+      int64_t long_width = 4 * phi::CPUContext::kDefaultGrainSize + 123;
+      TopKRowsTest<float>(*dev_ctx, 1, long_width, 10, largest, &rng);
+      TopKRowsTest<double>(*dev_ctx, 2, long_width, 1, largest, &rng);
+    }
+  }
+}
+
+TEST(sort_function, kth_value_rows) {
+  std::mt19937 rng(2);
+  auto dev_ctx = CreateContext(4);
+  // The heap is used when k is small against the width.
+  for (int64_t width : {10, 300, 5000}) {
+    for (int64_t k : {int64_t(1), int64_t(3), width}) {
+      const int64_t height = 4;
+      auto in = RandomValues<float>(height * width, true, &rng);
+      std::vector<float> out(height);
+      std::vector<int64_t> indices(height);
+      phi::funcs::KthValueRows<float>(
+          *dev_ctx, in.data(), height, width, k, out.data(), indices.data());
+      for (int64_t i = 0; i < height; ++i) {
+        const float* row = in.data() + i * width;
+        auto order = ReferenceOrder(row, width, false);
+        ASSERT_EQ(indices[i], order[k - 1])
+            << "row " << i << " of width " << width << ", k " << k;
+        ASSERT_TRUE(SameValue(out[i], row[order[k - 1]]));
+      }
+    }
+  }
+}
+
+// The flattened unique before the sort engine, on a std::set and maps.
+template <typename T>
+void ReferenceUnique(const std::vector<T>& in,
+                     std::vector<T>* out,
+                     std::vector<int64_t>* indices,
+                     std::vector<int64_t>* inverse,
+                     std::vector<int64_t>* counts) {
+  std::set<T> unique(in.begin(), in.end());
+  out->assign(unique.begin(), unique.end());
+  std::unordered_map<T, int64_t> first;
+  std::unordered_map<T, int64_t> position;
+  std::unordered_map<T, int64_t> count;
+  for (int64_t i = 0; i < static_cast<int64_t>(in.size()); ++i) {
+    first.emplace(in[i], i);
+    ++count[in[i]];
+  }
+  for (int64_t i = 0; i < static_cast<int64_t>(out->size()); ++i) {
+    position[(*out)[i]] = i;
+  }
+  indices->clear();
+  counts->clear();
+  for (auto& value : *out) {
+    indices->push_back(first[value]);
+    counts->push_back(count[value]);
+  }
+  inverse->clear();
+  for (auto& value : in) {
+    inverse->push_back(position[value]);
+  }
+}
+
+template <typename T>
+void UniqueFlattendTest(const phi::CPUContext& dev_ctx,
+                        int64_t numel,
+                        std::mt19937* rng) {
+  // std::set can not order NaN, so the reference runs without it.
+  auto values = RandomValues<T>(numel, false, rng);
+  phi::DenseTensor in;
+  in.Resize(phi::make_ddim({numel}));
+  std::copy(values.begin(), values.end(), dev_ctx.Alloc<T>(&in));
+
+  phi::DenseTensor out, indices, inverse, counts;
+  phi::funcs::UniqueFlattendTensor<phi::CPUContext, T, int64_t>(
+      dev_ctx, in, &out, &indices, &inverse, &counts, true, true, true);
+
+  std::vector<T> ref_out;
+  std::vector<int64_t> ref_indices, ref_inverse, ref_counts;
+  ReferenceUnique(values, &ref_out, &ref_indices, &ref_inverse, &ref_counts);
+  auto expect = [](const std::vector<int64_t>& expected,
+                   const phi::DenseTensor& actual) {
+    ASSERT_EQ(static_cast<int64_t>(expected.size()), actual.numel());
+    for (size_t i = 0; i < expected.size(); ++i) {
+      ASSERT_EQ(expected[i], actual.data<int64_t>()[i]) << "at " << i;
+    }
+  };
+  ASSERT_EQ(static_cast<int64_t>(ref_out.size()), out.numel());
+  for (size_t i = 0; i < ref_out.size(); ++i) {
+    ASSERT_EQ(ref_out[i], out.data<T>()[i]) << "at " << i;
+  }
+  expect(ref_indices, indices);
+  expect(ref_inverse, inverse);
+  expect(ref_counts, counts);
+}
+
+TEST(sort_function, unique_flattend) {
+  std::mt19937 rng(3);
+  for (int num_threads : kTestIntraOpNumThreads) {
+    auto dev_ctx = CreateContext(num_threads);
+    for (int64_t numel : {1, 17, 255, 256, 10000, 200000}) {
+      UniqueFlattendTest<float>(*dev_ctx, numel, &rng);
+      UniqueFlattendTest<double>(*dev_ctx, numel, &rng);
+      UniqueFlattendTest<int64_t>(*dev_ctx, numel, &rng);
+      UniqueFlattendTest<int>(*dev_ctx, numel, &rng);
+    }
+  }
+}
+
+}  // namespace tests
+}  // namespace phi
@@ -16,6 +16,8 @@ limitations under the License. */
 
 #include <memory>
 
+#include "gflags/gflags.h"
+#include "paddle/fluid/framework/scope_guard.h"
 #include "paddle/fluid/memory/allocation/allocator_facade.h"
 #include "paddle/phi/api/lib/utils/allocator.h"
 #include "paddle/phi/backends/gpu/gpu_context.h"
@@ -26,6 +28,8 @@ limitations under the License. */
 #include "paddle/phi/kernels/sparse/conv_grad_kernel.h"
 #include "paddle/phi/kernels/sparse/conv_kernel.h"
 
+DECLARE_bool(sparse_conv_rulebook_cache);
+
 namespace phi {
 namespace tests {
 
@@ -137,6 +141,57 @@ void TestConv3dBase(const std::vector<IntT>& indices,
 
     f_verify(out.non_zero_elements().data<T>(), correct_out_features);
 
+    // Again with intra op threads, building the rulebook in parallel
+    // instead of taking the one of the call above from the cache.
+    phi::CPUContext parallel_ctx;
+    parallel_ctx.SetAllocator(
+        paddle::memory::allocation::AllocatorFacade::Instance()
+            .GetAllocator(paddle::platform::CPUPlace())
+            .get());
+    parallel_ctx.SetIntraOpNumThreads(4);
+    auto f_run_parallel = [&](DenseTensor* parallel_rulebook,
+                              SparseCooTensor* parallel_out_ptr) {
+      SparseCooTensor& parallel_out = *parallel_out_ptr;
+      parallel_out = sparse::Conv3dCoo<T>(parallel_ctx,
+                                          x_tensor,
+                                          kernel_tensor,
+                                          paddings,
+                                          dilations,
+                                          strides,
+                                          1,
+                                          subm,
+                                          parallel_rulebook);
+      ASSERT_EQ(rulebook.numel(), parallel_rulebook->numel());
+      ASSERT_EQ(memcmp(rulebook.data<IntT>(),
+                       parallel_rulebook->data<IntT>(),
+                       rulebook.numel() * sizeof(IntT)),
+                0);
+      ASSERT_EQ(memcmp(correct_out_indices.data(),
+                       parallel_out.non_zero_indices().data<IntT>(),
+                       correct_out_indices.size() * sizeof(IntT)),
+                0);
+      f_verify(parallel_out.non_zero_elements().data<T>(),
+               correct_out_features);
+    };
+    {
+      FLAGS_sparse_conv_rulebook_cache = false;
+      DEFINE_PADDLE_SCOPE_GUARD(
+          [] { FLAGS_sparse_conv_rulebook_cache = true; });
+      DenseTensor parallel_rulebook;
+      SparseCooTensor parallel_out;
+      f_run_parallel(&parallel_rulebook, &parallel_out);
+    }
+    // And with the rulebook of the first call from the cache, while the out
+    // indices are copied for every output.
+    DenseTensor cached_rulebook;
+    SparseCooTensor cached_out;
+    f_run_parallel(&cached_rulebook, &cached_out);
+    ASSERT_TRUE(cached_rulebook.IsSharedBufferWith(rulebook));
+    ASSERT_FALSE(cached_out.non_zero_indices().IsSharedBufferWith(
+        out.non_zero_indices()));
+    ASSERT_FALSE(cached_out.non_zero_indices().IsSharedBufferWith(
+        x_tensor.non_zero_indices()));
+
     if (backward) {
       std::tuple<SparseCooTensor, DenseTensor> grads =
           sparse::Conv3dCooGrad<T>(dev_ctx_cpu,
@@ -0,0 +1,175 @@
+/* Copyright (c) 2022 PaddlePaddle Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License. */
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <memory>
+#include <random>
+
+#include "glog/logging.h"
+#include "paddle/phi/api/lib/utils/allocator.h"
+#include "paddle/phi/backends/cpu/cpu_context.h"
+#include "paddle/phi/core/dense_tensor.h"
+#include "paddle/phi/core/kernel_registry.h"
+#include "paddle/phi/kernels/empty_kernel.h"
+#include "paddle/phi/kernels/matmul_kernel.h"
+#include "paddle/phi/kernels/sparse/addmm_kernel.h"
+#include "paddle/phi/kernels/sparse/matmul_kernel.h"
+#include "paddle/phi/kernels/sparse/mv_kernel.h"
+#include "paddle/phi/kernels/sparse/sparse_utils_kernel.h"
+#include "paddle/phi/tests/kernels/cpu_context_utils.h"
+
+namespace phi {
+namespace tests {
+
+// A dense tensor whose elements are zero with the probability of sparsity.
+phi::DenseTensor CreateRandomTensor(const phi::DDim& dims,
+                                    float sparsity,
+                                    int seed) {
+  static paddle::experimental::DefaultAllocator alloc(
+      paddle::platform::CPUPlace());
+  phi::DenseTensor dense_x(&alloc,
+                           phi::DenseTensorMeta(phi::DataType::FLOAT32,
+                                                dims,
+                                                phi::DataLayout::NCHW));
+  auto* data = dense_x.mutable_data<float>(paddle::platform::CPUPlace());
+  std::mt19937 rng(seed);
+  std::uniform_real_distribution<float> dist(0.f, 1.f);
+  for (int64_t i = 0; i < dense_x.numel(); ++i) {
+    data[i] = dist(rng) < sparsity ? 0.f : dist(rng) - 0.5f;
+  }
+  return dense_x;
+}
+
+void ExpectNear(const phi::DenseTensor& expected,
+                const phi::DenseTensor& actual) {
+  ASSERT_EQ(expected.dims(), actual.dims());
+  for (int64_t i = 0; i < expected.numel(); ++i) {
+    float value = expected.data<float>()[i];
+    ASSERT_NEAR(value,
+                actual.data<float>()[i],
+                1e-4 * std::max(1.f, std::abs(value)))
+        << "at " << i;
+  }
+}
+
+void CheckMatmul(const phi::DDim& x_dims, int64_t n) {
+  auto ref_ctx = CreateContext(1);
+  auto x = CreateRandomTensor(x_dims, 0.9f, 1);
+  auto y_dims = x_dims;
+  y_dims[x_dims.size() - 2] = x_dims[x_dims.size() - 1];
+  y_dims[x_dims.size() - 1] = n;
+  auto y = CreateRandomTensor(y_dims, 0.f, 2);
+  auto out_dims = x_dims;
+  out_dims[x_dims.size() - 1] = n;
+  auto input = CreateRandomTensor(out_dims, 0.f, 3);
+  auto mask = CreateRandomTensor(out_dims, 0.8f, 4);
+
+  auto expected = phi::Matmul<float>(*ref_ctx, x, y, false, false);
+  phi::DenseTensor expected_addmm = phi::EmptyLike<float>(*ref_ctx, input);
+  for (int64_t i = 0; i < input.numel(); ++i) {
+    expected_addmm.data<float>()[i] =
+        0.5f * input.data<float>()[i] + 2.f * expected.data<float>()[i];
+  }
+
+  for (int num_threads : kTestIntraOpNumThreads) {
+    auto dev_ctx = CreateContext(num_threads);
+    auto csr = sparse::DenseToSparseCsr<float>(*dev_ctx, x);
+    auto coo = sparse::DenseToSparseCoo<float>(*dev_ctx, x, x_dims.size());
+
+    phi::DenseTensor out;
+    sparse::MatmulCsrDenseKernel<float>(*dev_ctx, csr, y, &out);
+    ExpectNear(expected, out);
+    sparse::MatmulCooDenseKernel<float>(*dev_ctx, coo, y, &out);
+    ExpectNear(expected, out);
+
+    sparse::AddmmCsrDenseKernel<float>(
+        *dev_ctx, input, csr, y, 2.f, 0.5f, &out);
+    ExpectNear(expected_addmm, out);
+    sparse::AddmmCooDenseKernel<float>(
+        *dev_ctx, input, coo, y, 2.f, 0.5f, &out);
+    ExpectNear(expected_addmm, out);
+
+    // x @ y on the nonzeros of the mask.
+    auto csr_mask = sparse::DenseToSparseCsr<float>(*dev_ctx, mask);
+    SparseCsrTensor masked;
+    sparse::MaskedMatmulCsrKernel<float>(*dev_ctx, x, y, csr_mask, &masked);
+    auto masked_dense = sparse::SparseCsrToDense<float>(*dev_ctx, masked);
+    for (int64_t i = 0; i < mask.numel(); ++i) {
+      float value =
+          mask.data<float>()[i] == 0.f ? 0.f : expected.data<float>()[i];
+      ASSERT_NEAR(value,
+                  masked_dense.data<float>()[i],
+                  1e-4 * std::max(1.f, std::abs(value)));
+    }
+  }
+}
+
+TEST(DEV_API, sparse_matmul) {
+  CheckMatmul(phi::make_ddim({300, 200}), 100);
+  CheckMatmul(phi::make_ddim({3, 100, 200}), 300);
+  CheckMatmul(phi::make_ddim({4, 1, 7}), 5);
+}
+
+TEST(DEV_API, sparse_mv) {
+  auto ref_ctx = CreateContext(1);
+  auto x = CreateRandomTensor(phi::make_ddim({500, 300}), 0.9f, 1);
+  auto vec = CreateRandomTensor(phi::make_ddim({300}), 0.f, 2);
+  auto expected = phi::Matmul<float>(*ref_ctx, x, vec, false, false);
+  for (int num_threads : kTestIntraOpNumThreads) {
+    auto dev_ctx = CreateContext(num_threads);
+    phi::DenseTensor out;
+    sparse::MvCsrKernel<float>(
+        *dev_ctx, sparse::DenseToSparseCsr<float>(*dev_ctx, x), vec, &out);
+    ExpectNear(expected, out);
+    sparse::MvCooKernel<float>(
+        *dev_ctx, sparse::DenseToSparseCoo<float>(*dev_ctx, x, 2), vec, &out);
+    ExpectNear(expected, out);
+  }
+}
+
+// Logs the time of CSR @ DENSE against the dense matmul at a few sparsities.
+TEST(DEV_API, sparse_matmul_speed) {
+  auto dev_ctx = CreateContext(4);
+  auto y = CreateRandomTensor(phi::make_ddim({1024, 256}), 0.f, 2);
+  for (float sparsity : {0.5f, 0.9f, 0.99f}) {
+    auto x = CreateRandomTensor(phi::make_ddim({1024, 1024}), sparsity, 1);
+    auto csr = sparse::DenseToSparseCsr<float>(*dev_ctx, x);
+    phi::DenseTensor out;
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < 10; ++i) {
+      sparse::MatmulCsrDenseKernel<float>(*dev_ctx, csr, y, &out);
+    }
+    auto middle = std::chrono::steady_clock::now();
+    for (int i = 0; i < 10; ++i) {
+      out = phi::Matmul<float>(*dev_ctx, x, y, false, false);
+    }
+    auto end = std::chrono::steady_clock::now();
+    LOG(INFO) << "sparsity " << sparsity << ": csr @ dense "
+              << std::chrono::duration<double, std::milli>(middle - start)
+                         .count() /
+                     10
+              << " ms, dense @ dense "
+              << std::chrono::duration<double, std::milli>(end - middle)
+                         .count() /
+                     10
+              << " ms";
+  }
+}
+
+}  // namespace tests
+}  // namespace phi
@@ -0,0 +1,98 @@
+#   Copyright (c) 2022 PaddlePaddle Authors. All Rights Reserved.
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#     http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+
+from __future__ import print_function
+
+import unittest
+import numpy as np
+from op_test import OpTest
+
+
+class TestFusionElementwiseChainOp(OpTest):
+
+    def setUp(self):
+        self.op_type = 'fusion_elementwise_chain'
+        # Not a multiple of the tile size, so the last tile is partial.
+        self.shape = (33, 50)
+        self.dtype = "float32"
+        self.set_conf()
+        x = np.random.uniform(-1, 1, self.shape).astype(self.dtype)
+        y = np.random.uniform(0.5, 1, self.shape).astype(self.dtype)
+        b = np.random.uniform(-1, 1, self.shape[-1:]).astype(self.dtype)
+
+        # Ids 0, 1, 2 are x, y, b and id 3 + k is the result of the k-th op.
+        self.inputs = {'Inputs': [('x', x), ('y', y), ('b', b)]}
+        self.attrs = {
+            'op_types': self.op_types,
+            'op_operands': self.op_operands,
+            'op_scales': self.op_scales,
+            'op_biases': self.op_biases,
+            'out_ids': self.out_ids,
+            'shape_input': 0,
+        }
+        self.outputs = {'Outs': self.compute(x, y, b)}
+
+    def set_conf(self):
+        # out = 2 * relu(x * y + b) + 0.5, and x * y + b is used outside.
+        self.op_types = ['elementwise_mul', 'elementwise_add', 'relu', 'scale']
+        self.op_operands = [0, 1, 3, 2, 4, -1, 5, -1]
+        self.op_scales = [1.0, 1.0, 1.0, 2.0]
+        self.op_biases = [0.0, 0.0, 0.0, 0.5]
+        self.out_ids = [4, 6]
+
+    def compute(self, x, y, b):
+        tmp = x * y + b
+        out = 2.0 * np.maximum(tmp, 0) + 0.5
+        return [('tmp', tmp), ('out', out.astype(self.dtype))]
+
+    def test_check_output(self):
+        self.check_output()
+
+
+class TestFusionElementwiseChainOpCase1(TestFusionElementwiseChainOp):
+
+    def set_conf(self):
+        # out = sqrt(square(tanh(max(exp(x) / y, b)) - x))
+        self.dtype = "float64"
+        self.op_types = [
+            'exp', 'elementwise_div', 'elementwise_max', 'tanh',
+            'elementwise_sub', 'square', 'sqrt'
+        ]
+        self.op_operands = [0, -1, 3, 1, 4, 2, 5, -1, 6, 0, 7, -1, 8, -1]
+        self.op_scales = [1.0] * 7
+        self.op_biases = [0.0] * 7
+        self.out_ids = [9]
+
+    def compute(self, x, y, b):
+        out = np.sqrt(np.square(np.tanh(np.maximum(np.exp(x) / y, b)) - x))
+        return [('out', out)]
+
+
+class TestFusionElementwiseChainOpLoD(TestFusionElementwiseChainOp):
+
+    def setUp(self):
+        # The outputs share the LoD of x, the input giving their shape.
+        super(TestFusionElementwiseChainOpLoD, self).setUp()
+        self.lod = [[10, 23]]
+        x = self.inputs['Inputs'][0][1]
+        self.inputs['Inputs'][0] = ('x', (x, self.lod))
+        self.outputs['Outs'] = [(name, (value, self.lod))
+                                for name, value in self.outputs['Outs']]
+
+    def test_check_output(self):
+        self.check_output(check_dygraph=False)
+
+
+if __name__ == '__main__':
+    unittest.main()